@@ -316,9 +316,25 @@ struct switch_runtime {
 extern struct switch_runtime runtime;
 
 
+#define SWITCH_SESSION_SHARDS 64
+
+/* one slice of the session table, lookups only take its read lock */
+struct switch_session_shard {
+	switch_hash_t *table;
+	switch_thread_rwlock_t *rwlock;
+	uint32_t count;
+	switch_atomic_t reads;
+	switch_atomic_t contended;
+	switch_atomic_t wait_usec;
+	uint64_t writes;
+	switch_time_t hold_usec;
+	switch_time_t max_hold_usec;
+};
+typedef struct switch_session_shard switch_session_shard_t;
+
 struct switch_session_manager {
 	switch_memory_pool_t *memory_pool;
-	switch_hash_t *session_table;
+	switch_session_shard_t shards[SWITCH_SESSION_SHARDS];
 	uint32_t session_count;
 	uint32_t session_limit;
 	switch_size_t session_id;
@@ -1186,6 +1186,36 @@ SWITCH_DECLARE(switch_status_t) switch_socket_send_nonblock(switch_socket_t *soc
  */
 SWITCH_DECLARE(switch_status_t) switch_socket_recvfrom(switch_sockaddr_t *from, switch_socket_t *sock, int32_t flags, char *buf, size_t *len);
 
+/** One datagram of a batched socket read or write */
+typedef struct switch_socket_msg {
+	/** The buffer to use */
+	char *buf;
+	/** The length of the available buffer or of the data to send, set to the length of the datagram read on return */
+	switch_size_t len;
+	/** The switch_sockaddr_t to fill in the sender info, or describing where to send the data */
+	switch_sockaddr_t *addr;
+} switch_socket_msg_t;
+
+/**
+ * Read as many pending datagrams as will fit in msgs without blocking, with one
+ * system call where the platform has recvmmsg()
+ * @param sock The socket to use
+ * @param msgs The datagrams to fill in
+ * @param count The number of entries in msgs, set to the number read on return
+ * @return SWITCH_STATUS_SUCCESS when at least one datagram was read, SWITCH_STATUS_BREAK when there was nothing to read
+ * @remark without recvmmsg() the datagrams are read one at a time and the socket has to be non blocking
+ */
+SWITCH_DECLARE(switch_status_t) switch_socket_recvmmsg(switch_socket_t *sock, switch_socket_msg_t *msgs, uint32_t *count);
+
+/**
+ * Send several datagrams, with one system call where the platform has sendmmsg()
+ * @param sock The socket to send from
+ * @param msgs The datagrams to send
+ * @param count The number of entries in msgs, set to the number sent on return
+ * @return SWITCH_STATUS_SUCCESS when all of them were sent
+ */
+SWITCH_DECLARE(switch_status_t) switch_socket_sendmmsg(switch_socket_t *sock, switch_socket_msg_t *msgs, uint32_t *count);
+
 SWITCH_DECLARE(switch_status_t) switch_socket_atmark(switch_socket_t *sock, int *atmark);
 
 /**
@@ -1329,6 +1359,11 @@ SWITCH_DECLARE(switch_status_t) switch_mcast_interface(switch_socket_t *sock, sw
 #define SWITCH_POLLHUP 0x020			/**< Hangup occurred */
 #define SWITCH_POLLNVAL 0x040		/**< Descriptior invalid */
 
+/**
+ * Pollset options
+ */
+#define SWITCH_POLLSET_THREADSAFE 0x001	/**< Adding or removing a descriptor is thread safe */
+
 /**
  * Setup a pollset object
  * @param pollset  The pointer in which to return the newly created object
@@ -647,6 +647,42 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_destroy_memory_pool(_Inout_
 SWITCH_DECLARE(void) switch_core_memory_pool_set_data(switch_memory_pool_t *pool, const char *key, void *data);
 SWITCH_DECLARE(void *) switch_core_memory_pool_get_data(switch_memory_pool_t *pool, const char *key);
 
+/*! \brief Counters of the pools created at one place in the code, while pool stats are on */
+typedef struct switch_memory_pool_stats_s {
+	/*! the file:line the pools were created at, their tag until switch_core_memory_pool_tag() changes it */
+	const char *tag;
+	/*! pools not destroyed yet */
+	uint32_t live;
+	/*! pools created */
+	uint64_t created;
+	/*! of those, the ones handed out as a recycled pool */
+	uint64_t recycled;
+	/*! allocations from them */
+	uint64_t allocs;
+	/*! bytes allocated from them */
+	uint64_t bytes;
+} switch_memory_pool_stats_t;
+
+/*!
+  \brief Set how many destroyed pools are cleared and kept to be handed out again instead of creating new ones
+  \param max the number of pools, 0 to destroy them all
+*/
+SWITCH_DECLARE(void) switch_core_memory_pool_set_recycle(uint32_t max);
+
+/*!
+  \brief Turn counting pools and their allocations per tag on or off, for pools created from then on
+  \param on true to count
+*/
+SWITCH_DECLARE(void) switch_core_memory_pool_set_stats(switch_bool_t on);
+
+/*!
+  \brief Get the counters of one of the tags pools were created with
+  \param index the tag, in the order they were first seen, starting at 0
+  \param stats the struct to fill in
+  \return SWITCH_STATUS_FALSE past the last tag
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_memory_pool_get_stats(uint32_t index, switch_memory_pool_stats_t *stats);
+
 
 /*!
   \brief Start the session's state machine
@@ -822,6 +858,38 @@ SWITCH_DECLARE(void) switch_core_session_hangup_state(switch_core_session_t *ses
 */
 SWITCH_DECLARE(uint32_t) switch_core_session_count(void);
 
+/*! \brief Counters of one shard of the session table */
+typedef struct switch_session_shard_stats_s {
+	/*! sessions currently in the shard */
+	uint32_t sessions;
+	/*! lookups and walks that read the shard, wraps */
+	uint32_t reads;
+	/*! reads that had to wait for a writer, wraps */
+	uint32_t contended;
+	/*! total time contended reads waited (us), wraps */
+	uint32_t wait_usec;
+	/*! inserts, removals and renames */
+	uint64_t writes;
+	/*! sum of the time the write lock was held (us) */
+	switch_time_t hold_usec;
+	/*! longest time the write lock was held (us) */
+	switch_time_t max_hold_usec;
+} switch_session_shard_stats_t;
+
+/*!
+  \brief Number of shards the session table is split in, a uuid always hashes to the same one
+  \return the shard count
+*/
+SWITCH_DECLARE(uint32_t) switch_core_session_shard_count(void);
+
+/*!
+  \brief Get the counters of a session table shard
+  \param index the shard index (0 .. switch_core_session_shard_count() - 1)
+  \param stats the struct to fill in
+  \return SWITCH_STATUS_SUCCESS if the shard exists
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_session_get_shard_stats(uint32_t index, switch_session_shard_stats_t *stats);
+
 SWITCH_DECLARE(switch_size_t) switch_core_session_get_id(_In_ switch_core_session_t *session);
 
 /*!
@@ -2433,6 +2501,7 @@ SWITCH_DECLARE(void) switch_time_set_monotonic(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_timerfd(int enable);
 SWITCH_DECLARE(void) switch_time_set_nanosleep(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_matrix(switch_bool_t enable);
+SWITCH_DECLARE(void) switch_time_set_wheel(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_cond_yield(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_use_system_time(switch_bool_t enable);
 SWITCH_DECLARE(uint32_t) switch_core_min_dtmf_duration(uint32_t duration);
@@ -2610,6 +2679,19 @@ SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_callback_err(switch_
 																	 switch_core_db_err_callback_func_t err_callback,
 																	 void *pdata, char **err);
 
+/*!
+ \brief Executes a sql statement with ? placeholders, the values are bound instead of printed into the text
+ \param [in] dbh The handle
+ \param [in] sql - sql to run, on core db handles it is prepared once and kept in a per handle cache
+ \param [in] argc - number of values, must match the placeholders in sql
+ \param [in] argv - the values, a NULL entry is bound as NULL
+ \param [in] callback - optional function pointer to callback for row-by-row processing
+ \param [in] pdata - data to pass to callback
+ \param [out] err - Error if it exists
+*/
+SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_params(switch_cache_db_handle_t *dbh, const char *sql, int argc, const char **argv,
+																   switch_core_db_callback_func_t callback, void *pdata, char **err);
+
 /*!
  \brief Get the affected rows of the last performed query
  \param [in] dbh The handle
@@ -2687,6 +2769,35 @@ SWITCH_DECLARE(switch_status_t) switch_core_del_registration(const char *user, c
 */
 SWITCH_DECLARE(switch_status_t) switch_core_expire_registration(int force);
 
+/*! \brief Row layouts served by the channel registry, named after the core db table or view with the same columns */
+typedef enum {
+	SCR_VIEW_CHANNELS,
+	SCR_VIEW_BASIC_CALLS,
+	SCR_VIEW_DETAILED_CALLS
+} switch_channel_registry_view_t;
+
+typedef struct {
+	/*! only rows with a bridged b leg */
+	switch_bool_t bridged_only;
+	/*! sql LIKE pattern matched against uuid, name, cid_name, cid_num, presence_data or accountcode */
+	const char *like;
+	/*! only channels with this presence_id, served from the presence_id index */
+	const char *presence_id;
+	/*! only channels with this call_uuid, served from the call_uuid index when presence_id is not set */
+	const char *call_uuid;
+} switch_channel_registry_filter_t;
+
+/*!
+ \brief Walk the in-memory registry of the channels and calls on this box
+ \param [in] view the columns to produce, the same as the channels table, basic_calls or detailed_calls view
+ \param [in] filter optional restrictions on the rows
+ \param [in] callback called per row like a database callback, a non-zero return stops the walk, NULL just counts
+ \param [in] pArg user data for the callback
+ \return the number of rows
+*/
+SWITCH_DECLARE(uint32_t) switch_core_channel_registry_query(switch_channel_registry_view_t view, const switch_channel_registry_filter_t *filter,
+															switch_core_db_callback_func_t callback, void *pArg);
+
 /*!
  \brief Get RTP port range start value
  \param[in] void
@@ -2727,6 +2838,13 @@ SWITCH_DECLARE(void) switch_sql_queue_manager_resume(switch_sql_queue_manager_t
 SWITCH_DECLARE(int) switch_sql_queue_manager_size(switch_sql_queue_manager_t *qm, uint32_t index);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_confirm(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup);
+/*!
+ \brief Set how many queued single row INSERTs into the same table and columns are sent as one multi row INSERT
+ \param [in] qm the queue manager
+ \param [in] rows rows per statement, 0 or 1 sends every statement on its own
+ \note on by default except for odbc handles, not every odbc backend takes multi row VALUES lists
+*/
+SWITCH_DECLARE(void) switch_sql_queue_manager_set_bulk_rows(switch_sql_queue_manager_t *qm, uint32_t rows);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_destroy(switch_sql_queue_manager_t **qmp);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *name,
 																   switch_sql_queue_manager_t **qmp,
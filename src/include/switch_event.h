@@ -100,8 +100,40 @@ struct switch_event {
 	unsigned long key;
 	struct switch_event *next;
 	int flags;
+	/*! when the event was handed to a dispatch queue */
+	switch_time_t queued;
+	/*! read only copy shared by the consumers of this event */
+	switch_event_shared_t *shared;
+	/*! number of headers in the list */
+	uint32_t header_count;
+	/*! open addressing index of the first header of each name, built once the event has enough headers */
+	switch_event_header_t **header_index;
+	/*! number of slots in the header index (a power of 2) */
+	uint32_t header_index_size;
 };
 
+/*! \brief Formats a shared event can be rendered in */
+typedef enum {
+	SWITCH_EVENT_SERIAL_PLAIN,
+	SWITCH_EVENT_SERIAL_JSON,
+	SWITCH_EVENT_SERIAL_XML,
+	SWITCH_EVENT_SERIAL_MAX
+} switch_event_serial_format_t;
+
+/*! \brief Counters of one event dispatch queue */
+typedef struct switch_event_dispatch_stats_s {
+	/*! events currently waiting in the queue */
+	uint32_t depth;
+	/*! highest depth seen by the dispatch thread */
+	uint32_t max_depth;
+	/*! events delivered from this queue */
+	uint64_t dispatched;
+	/*! sum of the time events waited in the queue (us) */
+	switch_time_t total_latency;
+	/*! longest time an event waited in the queue (us) */
+	switch_time_t max_latency;
+} switch_event_dispatch_stats_t;
+
 typedef struct switch_serial_event_s {
 	int event_id;
 	int priority;
@@ -303,6 +335,42 @@ SWITCH_DECLARE(switch_status_t) switch_event_reserve_subclass_detailed(const cha
 
 SWITCH_DECLARE(switch_status_t) switch_event_free_subclass_detailed(const char *owner, const char *subclass_name);
 
+/*!
+  \brief Get a reference to a read only copy of an event that many consumers can hold at once
+  \param event the event being delivered
+  \return a shared event to release with switch_event_shared_release()
+  \note the copy is made by the first consumer, call this from the event callback only, not concurrently on the same event
+*/
+SWITCH_DECLARE(switch_event_shared_t *) switch_event_share(switch_event_t *event);
+
+/*!
+  \brief Wrap an event in a shared event without copying it
+  \param event the event to wrap (will be nulled)
+  \return a shared event to release with switch_event_shared_release()
+*/
+SWITCH_DECLARE(switch_event_shared_t *) switch_event_share_take(switch_event_t **event);
+
+/*!
+  \brief Get the read only event of a shared event
+  \param shared the shared event
+  \return the event, it must not be modified
+*/
+SWITCH_DECLARE(switch_event_t *) switch_event_shared_get_event(switch_event_shared_t *shared);
+
+/*!
+  \brief Render a shared event, each format is rendered only once no matter how many consumers ask for it
+  \param shared the shared event
+  \param format the format to render (plain is url encoded like switch_event_serialize())
+  \return the rendered event, valid as long as the reference is held, or NULL on error
+*/
+SWITCH_DECLARE(const char *) switch_event_shared_serialize(switch_event_shared_t *shared, switch_event_serial_format_t format);
+
+/*!
+  \brief Release a reference to a shared event
+  \param shared the shared event (will be nulled)
+*/
+SWITCH_DECLARE(void) switch_event_shared_release(switch_event_shared_t **shared);
+
 /*!
   \brief Render a string representation of an event suitable for printing or network transport
   \param event the event to render
@@ -427,6 +495,20 @@ SWITCH_DECLARE(void) switch_json_add_presence_data_cols(switch_event_t *event, c
 
 SWITCH_DECLARE(void) switch_event_launch_dispatch_threads(uint32_t max);
 
+/*!
+  \brief Number of event dispatch queues, events of the same channel are always dispatched from the same queue
+  \return the queue count or 0 when dispatch is not running
+*/
+SWITCH_DECLARE(uint32_t) switch_event_dispatch_queue_count(void);
+
+/*!
+  \brief Get the counters of an event dispatch queue
+  \param index the queue index (0 .. switch_event_dispatch_queue_count() - 1)
+  \param stats the struct to fill in
+  \return SWITCH_STATUS_SUCCESS if the queue exists
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_get_dispatch_stats(uint32_t index, switch_event_dispatch_stats_t *stats);
+
 SWITCH_DECLARE(switch_status_t) switch_event_channel_broadcast(const char *event_channel, cJSON **json, const char *key, switch_event_channel_id_t id);
 SWITCH_DECLARE(uint32_t) switch_event_channel_unbind(const char *event_channel, switch_event_channel_func_t func);
 SWITCH_DECLARE(switch_status_t) switch_event_channel_bind(const char *event_channel, switch_event_channel_func_t func, switch_event_channel_id_t *id);
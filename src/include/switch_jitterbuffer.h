@@ -34,7 +34,8 @@
 #define SWITCH_VIDDERBUFFER_H
 
 typedef enum {
-	SJB_QUEUE_ONLY = (1 << 0)
+	SJB_QUEUE_ONLY = (1 << 0),
+	SJB_RING = (1 << 1)
 } switch_jb_flag_t;
 
 typedef enum {
@@ -42,6 +42,25 @@ SWITCH_BEGIN_EXTERN_C
  */
 	typedef struct real_pcre switch_regex_t;
 
+/*! \brief Counters of the compiled pattern cache behind switch_regex_perform() and switch_regex_match_partial() */
+typedef struct switch_regex_cache_stats_s {
+	uint32_t entries;
+	uint32_t max;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+} switch_regex_cache_stats_t;
+
+SWITCH_DECLARE(void) switch_regex_init(switch_memory_pool_t *pool);
+SWITCH_DECLARE(void) switch_regex_shutdown(void);
+
+/*!
+ \brief Set how many compiled patterns are kept, 0 compiles every expression each time it is run
+ \param max The number of patterns
+*/
+SWITCH_DECLARE(void) switch_regex_cache_set_max(uint32_t max);
+SWITCH_DECLARE(void) switch_regex_cache_get_stats(switch_regex_cache_stats_t *stats);
+
 SWITCH_DECLARE(switch_regex_t *) switch_regex_compile(const char *pattern, int options, const char **errorptr, int *erroroffset,
 													  const unsigned char *tables);
 
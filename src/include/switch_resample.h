@@ -175,6 +175,31 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels);
 SWITCH_DECLARE(void) switch_mux_channels(int16_t *data, switch_size_t samples, uint32_t orig_channels, uint32_t channels);
 
+/*!
+  \brief Add signed linear audio into a 32 bit mix without clipping
+  \param mix the mix
+  \param data the audio data
+  \param samples the number of 2 byte samples
+ */
+SWITCH_DECLARE(void) switch_mix_accumulate(int32_t *mix, const int16_t *data, uint32_t samples);
+
+/*!
+  \brief Clip a 32 bit mix back to signed linear audio, taking one contribution back out of it first
+  \param data the audio data to write
+  \param mix the mix
+  \param own the audio to take back out of the mix or NULL
+  \param samples the number of 2 byte samples
+ */
+SWITCH_DECLARE(void) switch_mix_pack(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t samples);
+
+/*!
+  \brief Select the audio kernels the mixing helpers run on
+  \param name scalar, sse2, avx2 or neon, NULL for the best one the cpu supports
+  \return SWITCH_STATUS_SUCCESS or SWITCH_STATUS_NOTIMPL when the cpu or the build does not have them
+ */
+SWITCH_DECLARE(switch_status_t) switch_audio_kernels_set(const char *name);
+SWITCH_DECLARE(const char *) switch_audio_kernels_name(void);
+
 #define switch_resample_calc_buffer_size(_to, _from, _srclen) ((uint32_t)(((float)_to / (float)_from) * (float)_srclen) * 2)
 
 SWITCH_DECLARE(void) switch_agc_set(switch_agc_t *agc, uint32_t energy_avg, 
@@ -188,6 +188,35 @@ SWITCH_DECLARE(void) switch_rtp_get_random(void *buf, uint32_t len);
 SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool);
 SWITCH_DECLARE(void) switch_rtp_shutdown(void);
 
+/*! \brief Counters of the RTP io engine */
+typedef struct switch_rtp_io_stats_s {
+	/*! io threads running */
+	uint32_t threads;
+	/*! sessions read by the io threads */
+	uint32_t sessions;
+	/*! pollset waits that returned ready sockets */
+	uint64_t polls;
+	/*! batched socket reads */
+	uint64_t recv_calls;
+	/*! packets handed to sessions */
+	uint64_t packets;
+	/*! packets dropped because the session did not read them in time */
+	uint64_t dropped;
+} switch_rtp_io_stats_t;
+
+/*!
+  \brief Set the number of RTP io threads
+  \param threads how many threads read the sockets of timed audio sessions, 0 to read them from the session threads
+  \note only affects sessions created afterwards
+*/
+SWITCH_DECLARE(void) switch_rtp_set_io_threads(uint32_t threads);
+
+/*!
+  \brief Get the RTP io engine counters
+  \param stats the counters to fill in
+*/
+SWITCH_DECLARE(void) switch_rtp_get_io_stats(switch_rtp_io_stats_t *stats);
+
 /*!
   \brief Set/Get RTP start port
   \param port new value (if > 0)
@@ -377,7 +377,8 @@ typedef enum {
 	SCF_DEBUG_SQL = (1 << 21),
 	SCF_API_EXPANSION = (1 << 22),
 	SCF_SESSION_THREAD_POOL = (1 << 23),
-	SCF_DIALPLAN_TIMESTAMPS = (1 << 24)
+	SCF_DIALPLAN_TIMESTAMPS = (1 << 24),
+	SCF_NO_CHANNEL_SQL = (1 << 25)
 } switch_core_flag_enum_t;
 typedef uint32_t switch_core_flag_t;
 
@@ -799,6 +800,7 @@ typedef enum {
 	SWITCH_RTP_FLAG_PASSTHRU,
 	SWITCH_RTP_FLAG_SECURE_SEND_MKI,
 	SWITCH_RTP_FLAG_SECURE_RECV_MKI,
+	SWITCH_RTP_FLAG_TX_BATCH,
 	SWITCH_RTP_FLAG_INVALID
 } switch_rtp_flag_t;
 
@@ -1896,7 +1898,8 @@ typedef enum {
 	SWITCH_IO_FLAG_NOBLOCK = (1 << 0),
 	SWITCH_IO_FLAG_SINGLE_READ = (1 << 1),
 	SWITCH_IO_FLAG_FORCE = (1 << 2),
-	SWITCH_IO_FLAG_QUEUED = (1 << 3)
+	SWITCH_IO_FLAG_QUEUED = (1 << 3),
+	SWITCH_IO_FLAG_NO_DECODE = (1 << 4)
 } switch_io_flag_enum_t;
 typedef uint32_t switch_io_flag_t;
 
@@ -2241,6 +2244,7 @@ typedef struct switch_rtcp switch_rtcp_t;
 typedef struct switch_core_session_message switch_core_session_message_t;
 typedef struct switch_event_header switch_event_header_t;
 typedef struct switch_event switch_event_t;
+typedef struct switch_event_shared switch_event_shared_t;
 typedef struct switch_event_subclass switch_event_subclass_t;
 typedef struct switch_event_node switch_event_node_t;
 typedef struct switch_loadable_module switch_loadable_module_t;
@@ -2342,6 +2346,7 @@ typedef enum {
 	SCC_VIDEO_RESET,
 	SCC_AUDIO_PACKET_LOSS,
 	SCC_AUDIO_ADJUST_BITRATE,
+	SCC_AUDIO_PACKET_ENERGY,
 	SCC_DEBUG,
 	SCC_CODEC_SPECIFIC
 } switch_codec_control_command_t;
@@ -2491,6 +2496,11 @@ typedef switch_xml_t(*switch_xml_open_root_function_t) (uint8_t reload, const ch
 typedef switch_xml_t(*switch_xml_search_function_t) (const char *section,
 													 const char *tag_name, const char *key_name, const char *key_value, switch_event_t *params,
 													 void *user_data);
+typedef void (*switch_xml_fetch_callback_t) (switch_xml_t xml, void *fetch_data);
+typedef switch_status_t (*switch_xml_async_search_function_t) (const char *section,
+															   const char *tag_name, const char *key_name, const char *key_value, switch_event_t *params,
+															   void *user_data, switch_xml_fetch_callback_t callback, void *fetch_data);
+typedef void (*switch_xml_locate_callback_t) (switch_xml_t root, switch_xml_t node, void *user_data);
 
 struct switch_hashtable;
 struct switch_hashtable_iterator;
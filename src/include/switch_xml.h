@@ -365,6 +365,79 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate(_In_z_ const char *section,
 												  _Out_ switch_xml_t *root,
 												  _Out_ switch_xml_t *node, _In_opt_ switch_event_t *params, _In_ switch_bool_t clone);
 
+///\brief locate an xml pointer in the core registry without waiting for the gateways
+///\param section the section to look in
+///\param tag_name the type of tag in that section
+///\param key_name the name of the key
+///\param key_value the value of the key
+///\param params optional URL formatted params to pass to external gateways
+///\param callback called once with the root and node, both NULL if nothing was found; the root must be freed with \see switch_xml_free
+///\param user_data a pointer to private data to be passed to the callback
+///\return SWITCH_STATUS_SUCCESS if the lookup was started
+///\note the callback may run in the calling thread before this returns or later in a gateway's thread
+SWITCH_DECLARE(switch_status_t) switch_xml_locate_async(_In_z_ const char *section,
+														_In_opt_z_ const char *tag_name,
+														_In_opt_z_ const char *key_name,
+														_In_opt_z_ const char *key_value,
+														_In_opt_ switch_event_t *params, _In_ switch_xml_locate_callback_t callback, _In_opt_ void *user_data);
+
+typedef struct {
+	uint64_t fetches;
+	uint64_t coalesced;
+	uint64_t async_locates;
+	uint32_t in_flight;
+} switch_xml_fetch_stats_t;
+
+///\brief get the counters of the fetches handed to asynchronous gateways
+///\param stats the structure to fill
+SWITCH_DECLARE(void) switch_xml_get_fetch_stats(_Out_ switch_xml_fetch_stats_t *stats);
+
+/*! \brief Counters of the cache of gateway answers behind switch_xml_locate(), one set per section */
+typedef struct {
+	const char *section;
+	uint32_t entries;
+	uint64_t hits;
+	uint64_t stale_hits;
+	uint64_t negative_hits;
+	uint64_t misses;
+	uint64_t stores;
+	uint64_t expired;
+	uint64_t evictions;
+} switch_xml_cache_stats_t;
+
+///\brief set how many gateway answers are kept, 0 asks the gateways every time
+///\param max the number of answers
+///\note a gateway answer is only kept when its document has a cacheable attribute, in milliseconds or anything else for as long as there is room
+SWITCH_DECLARE(void) switch_xml_cache_set_max(uint32_t max);
+
+///\brief set how long to remember that no gateway had an answer, unless their "not found" result says otherwise
+///\param ms the time in milliseconds, 0 to not remember it
+SWITCH_DECLARE(void) switch_xml_cache_set_negative_ttl(uint32_t ms);
+
+///\brief drop every cached gateway answer
+///\return the number of answers dropped
+SWITCH_DECLARE(uint32_t) switch_xml_cache_flush(void);
+
+///\brief get the cache counters of a section
+///\param index the section, starting at 0
+///\param stats the structure to fill
+///\return SWITCH_STATUS_FALSE past the last section
+SWITCH_DECLARE(switch_status_t) switch_xml_cache_get_stats(uint32_t index, _Out_ switch_xml_cache_stats_t *stats);
+
+/*! \brief What the last reloads of the root xml went through */
+typedef struct {
+	uint64_t reloads;
+	uint64_t unchanged;			/* reloads where nothing had changed and the tree was kept */
+	uint32_t files;				/* files the last reload preprocessed */
+	uint32_t reused;			/* of those, the ones copied unchanged from the reload before */
+	switch_time_t preprocess_usec;
+	switch_time_t parse_usec;
+} switch_xml_reload_stats_t;
+
+///\brief get the counters of the root xml reloads
+///\param stats the structure to fill
+SWITCH_DECLARE(void) switch_xml_get_reload_stats(_Out_ switch_xml_reload_stats_t *stats);
+
 SWITCH_DECLARE(switch_status_t) switch_xml_locate_domain(_In_z_ const char *domain_name, _In_opt_ switch_event_t *params, _Out_ switch_xml_t *root,
 														 _Out_ switch_xml_t *domain);
 
@@ -410,6 +483,17 @@ SWITCH_DECLARE(void) switch_xml_set_binding_user_data(_In_ switch_xml_binding_t
 SWITCH_DECLARE(switch_xml_section_t) switch_xml_get_binding_sections(_In_ switch_xml_binding_t *binding);
 SWITCH_DECLARE(void *) switch_xml_get_binding_user_data(_In_ switch_xml_binding_t *binding);
 
+///\brief let a gateway answer lookups asynchronously
+///\param binding the binding to set it on
+///\param function called instead of the search function, it must call the callback exactly once when it returns SWITCH_STATUS_SUCCESS
+///\note params are only valid for the duration of the call to function
+SWITCH_DECLARE(void) switch_xml_set_binding_async_function(_In_ switch_xml_binding_t *binding, _In_opt_ switch_xml_async_search_function_t function);
+
+///\brief share one asynchronous fetch between identical lookups that are in flight at the same time
+///\param binding the binding to set it on
+///\param sections a bitmask of the sections whose answer only depends on the section, tag, key, value and the action and purpose params
+SWITCH_DECLARE(void) switch_xml_set_binding_coalesce_sections(_In_ switch_xml_binding_t *binding, _In_ switch_xml_section_t sections);
+
 SWITCH_DECLARE(switch_status_t) switch_xml_bind_search_function_ret(_In_ switch_xml_search_function_t function, _In_ switch_xml_section_t sections,
 																	_In_opt_ void *user_data, switch_xml_binding_t **ret_binding);
 #define switch_xml_bind_search_function(_f, _s, _u) switch_xml_bind_search_function_ret(_f, _s, _u, NULL)
@@ -2367,6 +2367,14 @@ SWITCH_STANDARD_API(status_function)
 	stream->write_function(stream, "%d session(s) max%s", switch_core_session_limit(0), nl);
 	stream->write_function(stream, "min idle cpu %0.2f/%0.2f%s", switch_core_min_idle_cpu(-1.0), switch_core_idle_cpu(), nl);
 
+	{
+		switch_regex_cache_stats_t regex_stats;
+
+		switch_regex_cache_get_stats(&regex_stats);
+		stream->write_function(stream, "%u/%u regex(es) cached, %" SWITCH_UINT64_T_FMT " hits, %" SWITCH_UINT64_T_FMT " misses%s",
+							   regex_stats.entries, regex_stats.max, regex_stats.hits, regex_stats.misses, nl);
+	}
+
 	if (switch_core_get_stacksizes(&cur, &max) == SWITCH_STATUS_SUCCESS) {		stream->write_function(stream, "Current Stack Size/Max %ldK/%ldK\n", cur / 1024, max / 1024);
 	}
 	return SWITCH_STATUS_SUCCESS;
@@ -5384,6 +5392,8 @@ struct holder {
 	int rows;
 	int justcount;
 	stream_format *format;
+	switch_channel_registry_view_t view;
+	switch_channel_registry_filter_t filter;
 };
 
 static int show_as_json_callback(void *pArg, int argc, char **argv, char **columnNames)
@@ -5536,6 +5546,142 @@ static int show_callback(void *pArg, int argc, char **argv, char **columnNames)
 	return 0;
 }
 
+/* show commands served from core memory instead of the database feed their rows through the same callbacks */
+typedef void (*show_rows_function_t)(switch_core_db_callback_func_t callback, struct holder *holder);
+
+static void show_event_queue_rows(switch_core_db_callback_func_t callback, struct holder *holder)
+{
+	char *names[] = { "queue", "depth", "max_depth", "dispatched", "avg_latency_us", "max_latency_us" };
+	char vals[6][32];
+	char *argv[6];
+	switch_event_dispatch_stats_t stats;
+	uint32_t i, x, count = switch_event_dispatch_queue_count();
+
+	for (x = 0; x < 6; x++) {
+		argv[x] = vals[x];
+	}
+
+	for (i = 0; i < count; i++) {
+		if (switch_event_get_dispatch_stats(i, &stats) != SWITCH_STATUS_SUCCESS) {
+			continue;
+		}
+
+		switch_snprintf(vals[0], sizeof(vals[0]), "%u", i);
+		switch_snprintf(vals[1], sizeof(vals[1]), "%u", stats.depth);
+		switch_snprintf(vals[2], sizeof(vals[2]), "%u", stats.max_depth);
+		switch_snprintf(vals[3], sizeof(vals[3]), "%" SWITCH_UINT64_T_FMT, stats.dispatched);
+		switch_snprintf(vals[4], sizeof(vals[4]), "%" SWITCH_INT64_T_FMT, stats.dispatched ? stats.total_latency / (switch_time_t) stats.dispatched : 0);
+		switch_snprintf(vals[5], sizeof(vals[5]), "%" SWITCH_INT64_T_FMT, stats.max_latency);
+
+		callback(holder, 6, argv, names);
+	}
+}
+
+static void show_session_shard_rows(switch_core_db_callback_func_t callback, struct holder *holder)
+{
+	char *names[] = { "shard", "sessions", "reads", "contended", "wait_us", "writes", "avg_hold_us", "max_hold_us" };
+	char vals[8][32];
+	char *argv[8];
+	switch_session_shard_stats_t stats;
+	uint32_t i, x, count = switch_core_session_shard_count();
+
+	for (x = 0; x < 8; x++) {
+		argv[x] = vals[x];
+	}
+
+	for (i = 0; i < count; i++) {
+		if (switch_core_session_get_shard_stats(i, &stats) != SWITCH_STATUS_SUCCESS) {
+			continue;
+		}
+
+		switch_snprintf(vals[0], sizeof(vals[0]), "%u", i);
+		switch_snprintf(vals[1], sizeof(vals[1]), "%u", stats.sessions);
+		switch_snprintf(vals[2], sizeof(vals[2]), "%u", stats.reads);
+		switch_snprintf(vals[3], sizeof(vals[3]), "%u", stats.contended);
+		switch_snprintf(vals[4], sizeof(vals[4]), "%u", stats.wait_usec);
+		switch_snprintf(vals[5], sizeof(vals[5]), "%" SWITCH_UINT64_T_FMT, stats.writes);
+		switch_snprintf(vals[6], sizeof(vals[6]), "%" SWITCH_INT64_T_FMT, stats.writes ? stats.hold_usec / (switch_time_t) stats.writes : 0);
+		switch_snprintf(vals[7], sizeof(vals[7]), "%" SWITCH_INT64_T_FMT, stats.max_hold_usec);
+
+		callback(holder, 8, argv, names);
+	}
+}
+
+static void show_xml_cache_rows(switch_core_db_callback_func_t callback, struct holder *holder)
+{
+	char *names[] = { "section", "entries", "hits", "stale_hits", "negative_hits", "misses", "stores", "expired", "evictions" };
+	char vals[9][32];
+	char *argv[9];
+	switch_xml_cache_stats_t stats;
+	uint32_t i, x;
+
+	for (x = 0; x < 9; x++) {
+		argv[x] = vals[x];
+	}
+
+	for (i = 0; switch_xml_cache_get_stats(i, &stats) == SWITCH_STATUS_SUCCESS; i++) {
+		switch_snprintf(vals[0], sizeof(vals[0]), "%s", stats.section);
+		switch_snprintf(vals[1], sizeof(vals[1]), "%u", stats.entries);
+		switch_snprintf(vals[2], sizeof(vals[2]), "%" SWITCH_UINT64_T_FMT, stats.hits);
+		switch_snprintf(vals[3], sizeof(vals[3]), "%" SWITCH_UINT64_T_FMT, stats.stale_hits);
+		switch_snprintf(vals[4], sizeof(vals[4]), "%" SWITCH_UINT64_T_FMT, stats.negative_hits);
+		switch_snprintf(vals[5], sizeof(vals[5]), "%" SWITCH_UINT64_T_FMT, stats.misses);
+		switch_snprintf(vals[6], sizeof(vals[6]), "%" SWITCH_UINT64_T_FMT, stats.stores);
+		switch_snprintf(vals[7], sizeof(vals[7]), "%" SWITCH_UINT64_T_FMT, stats.expired);
+		switch_snprintf(vals[8], sizeof(vals[8]), "%" SWITCH_UINT64_T_FMT, stats.evictions);
+
+		callback(holder, 9, argv, names);
+	}
+}
+
+static void show_memory_pool_rows(switch_core_db_callback_func_t callback, struct holder *holder)
+{
+	char *names[] = { "tag", "live", "created", "recycled", "allocs", "bytes" };
+	char vals[6][256];
+	char *argv[6];
+	switch_memory_pool_stats_t stats;
+	uint32_t i, x;
+
+	for (x = 0; x < 6; x++) {
+		argv[x] = vals[x];
+	}
+
+	for (i = 0; switch_core_memory_pool_get_stats(i, &stats) == SWITCH_STATUS_SUCCESS; i++) {
+		switch_snprintf(vals[0], sizeof(vals[0]), "%s", stats.tag);
+		switch_snprintf(vals[1], sizeof(vals[1]), "%u", stats.live);
+		switch_snprintf(vals[2], sizeof(vals[2]), "%" SWITCH_UINT64_T_FMT, stats.created);
+		switch_snprintf(vals[3], sizeof(vals[3]), "%" SWITCH_UINT64_T_FMT, stats.recycled);
+		switch_snprintf(vals[4], sizeof(vals[4]), "%" SWITCH_UINT64_T_FMT, stats.allocs);
+		switch_snprintf(vals[5], sizeof(vals[5]), "%" SWITCH_UINT64_T_FMT, stats.bytes);
+
+		callback(holder, 6, argv, names);
+	}
+}
+
+static void show_channel_registry_rows(switch_core_db_callback_func_t callback, struct holder *holder)
+{
+	if (holder->justcount) {
+		char count[32];
+		char *argv[1] = { count };
+		char *names[1] = { "count(*)" };
+
+		switch_snprintf(count, sizeof(count), "%u", switch_core_channel_registry_query(holder->view, &holder->filter, NULL, NULL));
+		callback(holder, 1, argv, names);
+	} else {
+		switch_core_channel_registry_query(holder->view, &holder->filter, callback, holder);
+	}
+}
+
+static void show_execute(switch_cache_db_handle_t *db, const char *sql, show_rows_function_t rows_func,
+						 switch_core_db_callback_func_t callback, struct holder *holder, char **errmsg)
+{
+	if (rows_func) {
+		rows_func(callback, holder);
+	} else {
+		switch_cache_db_execute_sql_callback(db, sql, callback, holder, errmsg);
+	}
+}
+
 #define COMPLETE_SYNTAX "add <word>|del [<word>|*]"
 SWITCH_STANDARD_API(complete_function)
 {
@@ -5593,12 +5739,14 @@ SWITCH_STANDARD_API(coalesce_function)
 	return status;
 }
 
-#define SHOW_SYNTAX "codec|endpoint|application|api|dialplan|file|timer|calls [count]|channels [count|like <match string>]|calls|detailed_calls|bridged_calls|detailed_bridged_calls|aliases|complete|chat|management|modules|nat_map|say|interfaces|interface_types|tasks|limits|status"
+#define SHOW_SYNTAX "codec|endpoint|application|api|dialplan|file|timer|calls [count]|channels [count|like <match string>|presence_id <presence id>]|calls|detailed_calls|bridged_calls|detailed_bridged_calls|aliases|complete|chat|management|modules|nat_map|say|interfaces|interface_types|tasks|limits|status|event_queues|session_shards|xml_cache|memory_pools"
 SWITCH_STANDARD_API(show_function)
 {
 	char sql[1024];
-	char *errmsg;
-	switch_cache_db_handle_t *db;
+	char like[256];
+	char *errmsg = NULL;
+	switch_cache_db_handle_t *db = NULL;
+	show_rows_function_t rows_func = NULL;
 	struct holder holder = { 0 };
 	int help = 0;
 	char *mydata = NULL, *argv[6] = { 0 };
@@ -5613,16 +5761,6 @@ SWITCH_STANDARD_API(show_function)
 	set_format(holder.format, stream);
 	html = holder.format->html; /* html is just a shortcut */
 
-	if (!(cflags & SCF_USE_SQL)) {
-		stream->write_function(stream, "-ERR SQL disabled, no data available!\n");
-		return SWITCH_STATUS_SUCCESS;
-	}
-
-	if (switch_core_db_handle(&db) != SWITCH_STATUS_SUCCESS) {
-		stream->write_function(stream, "%s", "-ERR Database error!\n");
-		return SWITCH_STATUS_SUCCESS;
-	}
-
 	holder.justcount = 0;
 
 	if (cmd && *cmd && (mydata = strdup(cmd))) {
@@ -5704,6 +5842,14 @@ SWITCH_STANDARD_API(show_function)
 						"	WHEN 0 THEN 'udp' "
 						"	WHEN 1 THEN 'tcp' "
 						"	ELSE 'unknown' " "  END AS proto, " "  proto AS proto_num, " "  sticky " " FROM nat where hostname='%q' ORDER BY port, proto", switch_core_get_hostname());
+	} else if (!strcasecmp(command, "event_queues")) {
+		rows_func = show_event_queue_rows;
+	} else if (!strcasecmp(command, "session_shards")) {
+		rows_func = show_session_shard_rows;
+	} else if (!strcasecmp(command, "xml_cache")) {
+		rows_func = show_xml_cache_rows;
+	} else if (!strcasecmp(command, "memory_pools")) {
+		rows_func = show_memory_pool_rows;
 	} else {
 		/* from here on refreshable commands: calls|registrations|channels||detailed_calls|bridged_calls|detailed_bridged_calls */
 		if (holder.format->api) {
@@ -5722,9 +5868,9 @@ SWITCH_STANDARD_API(show_function)
 		}
 
 		if (!strcasecmp(command, "calls")) {
-			switch_snprintfv(sql, sizeof(sql), "select * from basic_calls where hostname='%q' order by call_created_epoch", switch_core_get_switchname());
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_BASIC_CALLS;
 			if (argv[1] && !strcasecmp(argv[1], "count")) {
-				switch_snprintfv(sql, sizeof(sql), "select count(*) from basic_calls where hostname='%q'", switch_core_get_switchname());
 				holder.justcount = 1;
 				if (argv[3] && !strcasecmp(argv[2], "as")) {
 					as = argv[3];
@@ -5740,49 +5886,54 @@ SWITCH_STANDARD_API(show_function)
 				}
 			}
 		} else if (!strcasecmp(command, "channels") && argv[1] && !strcasecmp(argv[1], "like")) {
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_CHANNELS;
 			if (argv[2]) {
-				char *p;
-				for (p = argv[2]; p && *p; p++) {
-					if (*p == '\'' || *p == ';') {
-						*p = ' ';
-					}
-				}
 				if (strchr(argv[2], '%')) {
-					switch_snprintfv(sql, sizeof(sql),
-						"select * from channels where hostname='%q' and uuid like '%q' or name like '%q' or cid_name like '%q' or cid_num like '%q' or presence_data like '%q' or accountcode like '%q' order by created_epoch",
-						switch_core_get_switchname(), argv[2], argv[2], argv[2], argv[2], argv[2], argv[2]);
+					holder.filter.like = argv[2];
 				} else {
-					switch_snprintfv(sql, sizeof(sql),
-						"select * from channels where hostname='%q' and uuid like '%%%q%%' or name like '%%%q%%' or cid_name like '%%%q%%' or cid_num like '%%%q%%' or presence_data like '%%%q%%' or accountcode like '%%%q%%' order by created_epoch",
-						switch_core_get_switchname(), argv[2], argv[2], argv[2], argv[2], argv[2], argv[2]);
+					switch_snprintf(like, sizeof(like), "%%%s%%", argv[2]);
+					holder.filter.like = like;
 				}
 				if (argv[4] && !strcasecmp(argv[3], "as")) {
 					as = argv[4];
 				}
-			} else {
-				switch_snprintfv(sql, sizeof(sql), "select * from channels where hostname='%q' order by created_epoch", switch_core_get_switchname());
+			}
+		} else if (!strcasecmp(command, "channels") && argv[1] && !strcasecmp(argv[1], "presence_id")) {
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_CHANNELS;
+			if (argv[2]) {
+				holder.filter.presence_id = argv[2];
+				if (argv[4] && !strcasecmp(argv[3], "as")) {
+					as = argv[4];
+				}
 			}
 		} else if (!strcasecmp(command, "channels")) {
-			switch_snprintfv(sql, sizeof(sql), "select * from channels where hostname='%q' order by created_epoch", switch_core_get_switchname());
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_CHANNELS;
 			if (argv[1] && !strcasecmp(argv[1], "count")) {
-				switch_snprintfv(sql, sizeof(sql), "select count(*) from channels where hostname='%q'", switch_core_get_switchname());
 				holder.justcount = 1;
 				if (argv[3] && !strcasecmp(argv[2], "as")) {
 					as = argv[3];
 				}
 			}
 		} else if (!strcasecmp(command, "detailed_calls")) {
-			switch_snprintfv(sql, sizeof(sql), "select * from detailed_calls where hostname='%q' order by created_epoch", switch_core_get_switchname());
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_DETAILED_CALLS;
 			if (argv[2] && !strcasecmp(argv[1], "as")) {
 				as = argv[2];
 			}
 		} else if (!strcasecmp(command, "bridged_calls")) {
-			switch_snprintfv(sql, sizeof(sql), "select * from basic_calls where b_uuid is not null and hostname='%q' order by created_epoch", switch_core_get_switchname());
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_BASIC_CALLS;
+			holder.filter.bridged_only = SWITCH_TRUE;
 			if (argv[2] && !strcasecmp(argv[1], "as")) {
 				as = argv[2];
 			}
 		} else if (!strcasecmp(command, "detailed_bridged_calls")) {
-			switch_snprintfv(sql, sizeof(sql), "select * from detailed_calls where b_uuid is not null and hostname='%q' order by created_epoch", switch_core_get_switchname());
+			rows_func = show_channel_registry_rows;
+			holder.view = SCR_VIEW_DETAILED_CALLS;
+			holder.filter.bridged_only = SWITCH_TRUE;
 			if (argv[2] && !strcasecmp(argv[1], "as")) {
 				as = argv[2];
 			}
@@ -5793,6 +5944,18 @@ SWITCH_STANDARD_API(show_function)
 		}
 	}
 
+	if (!rows_func) {
+		if (!(cflags & SCF_USE_SQL)) {
+			stream->write_function(stream, "-ERR SQL disabled, no data available!\n");
+			goto end;
+		}
+
+		if (switch_core_db_handle(&db) != SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "%s", "-ERR Database error!\n");
+			goto end;
+		}
+	}
+
 	holder.stream = stream;
 	holder.count = 0;
 
@@ -5819,7 +5982,7 @@ SWITCH_STANDARD_API(show_function)
 				holder.delim = ",";
 			}
 		}
-		switch_cache_db_execute_sql_callback(db, sql, show_callback, &holder, &errmsg);
+		show_execute(db, sql, rows_func, show_callback, &holder, &errmsg);
 		if (html) {
 			holder.stream->write_function(holder.stream, "</table>");
 		}
@@ -5835,7 +5998,7 @@ SWITCH_STANDARD_API(show_function)
 			stream->write_function(stream, "%s%u total.%s", nl, holder.count, nl);
 		}
 	} else if (!strcasecmp(as, "xml")) {
-		switch_cache_db_execute_sql_callback(db, sql, show_as_xml_callback, &holder, &errmsg);
+		show_execute(db, sql, rows_func, show_as_xml_callback, &holder, &errmsg);
 
 		if (errmsg) {
 			stream->write_function(stream, "-ERR SQL error [%s]\n", errmsg);
@@ -5863,7 +6026,7 @@ SWITCH_STANDARD_API(show_function)
 		}
 	} else if (!strcasecmp(as, "json")) {
 
-		switch_cache_db_execute_sql_callback(db, sql, show_as_json_callback, &holder, &errmsg);
+		show_execute(db, sql, rows_func, show_as_json_callback, &holder, &errmsg);
 
 		if (errmsg) {
 			stream->write_function(stream, "-ERR SQL Error [%s]\n", errmsg);
@@ -6592,6 +6755,7 @@ SWITCH_STANDARD_API(xml_flush_function)
 		r = switch_xml_clear_user_cache(argv[0], argv[1], argv[2]);
 	} else {
 		r = switch_xml_clear_user_cache(NULL, NULL, NULL);
+		r += switch_xml_cache_flush();
 	}
 
 
@@ -7653,6 +7817,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add show calls");
 	switch_console_set_complete("add show channels");
 	switch_console_set_complete("add show channels count");
+	switch_console_set_complete("add show channels presence_id");
 	switch_console_set_complete("add show chat");
 	switch_console_set_complete("add show codec");
 	switch_console_set_complete("add show complete");
@@ -7661,6 +7826,10 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add show bridged_calls");
 	switch_console_set_complete("add show detailed_bridged_calls");
 	switch_console_set_complete("add show endpoint");
+	switch_console_set_complete("add show event_queues");
+	switch_console_set_complete("add show session_shards");
+	switch_console_set_complete("add show xml_cache");
+	switch_console_set_complete("add show memory_pools");
 	switch_console_set_complete("add show file");
 	switch_console_set_complete("add show interfaces");
 	switch_console_set_complete("add show interface_types");
@@ -44,6 +44,7 @@
 
 api_command_t conference_api_sub_commands[] = {
 	{"count", (void_fn_t) & conference_api_sub_count, CONF_API_SUB_ARGS_SPLIT, "count", ""},
+	{"mix_stats", (void_fn_t) & conference_api_sub_mix_stats, CONF_API_SUB_ARGS_SPLIT, "mix_stats", ""},
 	{"list", (void_fn_t) & conference_api_sub_list, CONF_API_SUB_ARGS_SPLIT, "list", "[delim <string>]|[count]"},
 	{"xml_list", (void_fn_t) & conference_api_sub_xml_list, CONF_API_SUB_ARGS_SPLIT, "xml_list", ""},
 	{"json_list", (void_fn_t) & conference_api_sub_json_list, CONF_API_SUB_ARGS_SPLIT, "json_list", "[compact]"},
@@ -2041,6 +2042,45 @@ switch_status_t conference_api_sub_vid_layout(conference_obj_t *conference, swit
 	return SWITCH_STATUS_SUCCESS;
 }
 
+switch_status_t conference_api_sub_mix_stats(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv)
+{
+	if (!conference) {
+		return SWITCH_STATUS_GENERR;
+	}
+
+	stream->write_function(stream, "Mixer ticks: %"SWITCH_UINT64_T_FMT" (%"SWITCH_UINT64_T_FMT" in parallel, %d extra threads)\n",
+						   conference->mix_ticks, conference->mix_parallel_ticks, conference->mixer ? conference->mixer->thread_count : 0);
+	stream->write_function(stream, "Deadline misses: %"SWITCH_UINT64_T_FMT" over %ums\n", conference->mix_deadline_misses, conference->interval);
+	stream->write_function(stream, "Tick time: %uus last, %uus max\n", conference->mix_last_usec, conference->mix_max_usec);
+	stream->write_function(stream, "Shared encodes: %"SWITCH_UINT64_T_FMT" for %"SWITCH_UINT64_T_FMT" frames\n",
+						   conference->shared_encodes, conference->shared_frames);
+
+	if (conference->active_speakers || conference_utils_test_flag(conference, CFLAG_SKIP_IDLE_DECODE)) {
+		conference_member_t *member;
+		uint64_t skipped = 0;
+		int active = 0, idle = 0;
+
+		switch_mutex_lock(conference->member_mutex);
+		for (member = conference->members; member; member = member->next) {
+			if (conference_utils_member_test_flag(member, MFLAG_ACTIVE_SPEAKER)) {
+				active++;
+			}
+			if (conference_utils_member_test_flag(member, MFLAG_DECODE_IDLE)) {
+				idle++;
+			}
+			skipped += member->skipped_decodes;
+		}
+		switch_mutex_unlock(conference->member_mutex);
+
+		if (conference->active_speakers) {
+			stream->write_function(stream, "Active speakers: %d of %d\n", active, conference->active_speakers);
+		}
+		stream->write_function(stream, "Idle decoders: %d, %"SWITCH_UINT64_T_FMT" frames not decoded\n", idle, skipped);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 switch_status_t conference_api_sub_count(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv)
 {
 
@@ -2202,6 +2242,16 @@ switch_status_t conference_api_sub_list(conference_obj_t *conference, switch_str
 				fcount++;
 			}
 
+			if (conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING)) {
+				stream->write_function(stream, "%sminimize_audio_encoding", fcount ? "|" : "");
+				fcount++;
+			}
+
+			if (conference_utils_test_flag(conference, CFLAG_SKIP_IDLE_DECODE)) {
+				stream->write_function(stream, "%sskip_idle_decode", fcount ? "|" : "");
+				fcount++;
+			}
+
 			if (conference_utils_test_flag(conference, CFLAG_MANAGE_INBOUND_VIDEO_BITRATE)) {
 				stream->write_function(stream, "%smanage_inbound_bitrate", fcount ? "|" : "");
 				fcount++;
@@ -3972,6 +4022,21 @@ switch_status_t conference_api_sub_get(conference_obj_t *conference,
 		} else if (strcasecmp(argv[2], "wait_mod") == 0) {
 			stream->write_function(stream, "%s",
 								   conference_utils_test_flag(conference, CFLAG_WAIT_MOD) ? "true" : "");
+		} else if (strcasecmp(argv[2], "shared_encodes") == 0) {
+			stream->write_function(stream, "%"SWITCH_UINT64_T_FMT,
+								   conference->shared_encodes);
+		} else if (strcasecmp(argv[2], "shared_frames") == 0) {
+			stream->write_function(stream, "%"SWITCH_UINT64_T_FMT,
+								   conference->shared_frames);
+		} else if (strcasecmp(argv[2], "mix_ticks") == 0) {
+			stream->write_function(stream, "%"SWITCH_UINT64_T_FMT,
+								   conference->mix_ticks);
+		} else if (strcasecmp(argv[2], "mix_deadline_misses") == 0) {
+			stream->write_function(stream, "%"SWITCH_UINT64_T_FMT,
+								   conference->mix_deadline_misses);
+		} else if (strcasecmp(argv[2], "mix_max_usec") == 0) {
+			stream->write_function(stream, "%u",
+								   conference->mix_max_usec);
 		} else {
 			ret_status = SWITCH_STATUS_FALSE;
 		}
@@ -800,6 +800,29 @@ static void stop_talking_handler(conference_member_t *member)
 	
 }
 
+static switch_bool_t decode_skip_enabled(conference_obj_t *conference)
+{
+	return (conference->active_speakers || conference_utils_test_flag(conference, CFLAG_SKIP_IDLE_DECODE)) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+/* someone well under their energy level for a while is not worth decoding */
+static void check_decode_idle(conference_member_t *member)
+{
+	conference_obj_t *conference = member->conference;
+
+	if (!decode_skip_enabled(conference) || !member->energy_level || conference_utils_test_flag(conference, CFLAG_AUDIO_ALWAYS) ||
+		conference_utils_member_test_flag(member, MFLAG_TALKING) || conference_utils_member_test_flag(member, MFLAG_ACTIVE_SPEAKER) ||
+		member->score >= member->energy_level / CONF_IDLE_DIVISOR) {
+		member->idle_frames = 0;
+		conference_utils_member_clear_flag(member, MFLAG_DECODE_IDLE);
+		return;
+	}
+
+	if (++member->idle_frames >= CONF_IDLE_FRAMES) {
+		conference_utils_member_set_flag(member, MFLAG_DECODE_IDLE);
+	}
+}
+
 /* marshall frames from the call leg to the conference thread for muxing to other call legs */
 void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *obj)
 {
@@ -812,6 +835,9 @@ void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *ob
 	switch_core_session_t *session = member->session;
 	uint32_t flush_len;
 	switch_frame_t tmp_frame = { 0 };
+	switch_io_flag_t read_flags;
+	uint32_t probe = 0;
+	int inspect;
 
 	if (switch_core_session_read_lock(session) != SWITCH_STATUS_SUCCESS) {
 		goto end;
@@ -839,8 +865,23 @@ void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *ob
 			continue;
 		}
 
+		read_flags = SWITCH_IO_FLAG_NONE;
+		inspect = 0;
+
+		if (decode_skip_enabled(member->conference)) {
+			if (!conference_utils_member_test_flag(member, MFLAG_MUTE_DETECT) &&
+				!(conference_utils_member_test_flag(member, MFLAG_CAN_SPEAK) && !conference_utils_member_test_flag(member, MFLAG_HOLD))) {
+				/* nobody hears a muted member and nothing listens for them talking, their audio is never looked at */
+				read_flags |= SWITCH_IO_FLAG_NO_DECODE;
+			} else if (conference_utils_member_test_flag(member, MFLAG_DECODE_IDLE) && ++probe % CONF_IDLE_PROBE) {
+				/* Idle members only have their packets looked at, every few are still decoded and scored the usual way. */
+				read_flags |= SWITCH_IO_FLAG_NO_DECODE;
+				inspect = 1;
+			}
+		}
+
 		/* Read a frame. */
-		status = switch_core_session_read_frame(session, &read_frame, SWITCH_IO_FLAG_NONE, 0);
+		status = switch_core_session_read_frame(session, &read_frame, read_flags, 0);
 
 		switch_mutex_lock(member->read_mutex);
 
@@ -916,6 +957,32 @@ void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *ob
 			goto do_continue;
 		}
 
+		if ((read_flags & SWITCH_IO_FLAG_NO_DECODE) && switch_test_flag(read_frame, SFF_ENCODED)) {
+			if (inspect) {
+				uint32_t energy = 0;
+
+				if (switch_core_codec_control(read_frame->codec, SCC_AUDIO_PACKET_ENERGY, SCCT_NONE, read_frame,
+											  SCCT_INT, &energy, NULL, NULL) == SWITCH_STATUS_SUCCESS) {
+					/* the score is taken after the input gain so put the same gain on the packet energy */
+					if (member->volume_in_level) {
+						int16_t level = energy > SWITCH_SMAX ? SWITCH_SMAX : (int16_t) energy;
+
+						switch_change_sln_volume(&level, 1, member->volume_in_level);
+						energy = (uint32_t) level;
+					}
+
+					/* loud enough to be worth a proper look, decode again from the next frame on */
+					if (energy >= (uint32_t) member->energy_level / CONF_IDLE_DIVISOR) {
+						member->idle_frames = 0;
+						conference_utils_member_clear_flag(member, MFLAG_DECODE_IDLE);
+					}
+				}
+			}
+
+			member->skipped_decodes++;
+			goto do_continue;
+		}
+
 		if (switch_test_flag(read_frame, SFF_CNG)) {
 			if (hangunder_hits) {
 				hangunder_hits--;
@@ -1189,6 +1256,8 @@ void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *ob
 
 			member->last_score = member->score;
 
+			check_decode_idle(member);
+
 			if (member->id == member->conference->floor_holder) {
 				if (member->id != member->conference->video_floor_holder &&
 					(member->floor_packets > member->conference->video_floor_packets || member->energy_level == 0)) {
@@ -1527,24 +1596,33 @@ void conference_loop_output(conference_member_t *member)
 			low_count = 0;
 
 			if ((write_frame.datalen = (uint32_t) switch_buffer_read(use_buffer, write_frame.data, bytes))) {
+				uint32_t seq = member->mux_frames_out++;
+
 				if (write_frame.datalen) {
+					switch_frame_t shared_frame = { 0 }, *out_frame = &write_frame;
+
 					write_frame.samples = write_frame.datalen / 2 / member->conference->channels;
 
-					if( !conference_utils_member_test_flag(member, MFLAG_CAN_HEAR)) {
-						memset(write_frame.data, 255, write_frame.datalen);
-					} else if (member->volume_out_level) { /* Check for output volume adjustments */
-						switch_change_sln_volume(write_frame.data, write_frame.samples * member->conference->channels, member->volume_out_level);
-					}
+					/* the mix was already encoded once for everyone listening with our codec */
+					if (conference_member_take_shared_frame(member, seq, &shared_frame)) {
+						out_frame = &shared_frame;
+					} else {
+						if( !conference_utils_member_test_flag(member, MFLAG_CAN_HEAR)) {
+							memset(write_frame.data, 255, write_frame.datalen);
+						} else if (member->volume_out_level) { /* Check for output volume adjustments */
+							switch_change_sln_volume(write_frame.data, write_frame.samples * member->conference->channels, member->volume_out_level);
+						}
 
-					//write_frame.timestamp = timer.samplecount;
+						//write_frame.timestamp = timer.samplecount;
 
-					if (member->fnode) {
-						conference_member_add_file_data(member, write_frame.data, write_frame.datalen);
-					}
+						if (member->fnode) {
+							conference_member_add_file_data(member, write_frame.data, write_frame.datalen);
+						}
 
-					conference_member_check_channels(&write_frame, member, SWITCH_FALSE);
+						conference_member_check_channels(&write_frame, member, SWITCH_FALSE);
+					}
 
-					if (switch_core_session_write_frame(member->session, &write_frame, SWITCH_IO_FLAG_NONE, 0) != SWITCH_STATUS_SUCCESS) {
+					if (switch_core_session_write_frame(member->session, out_frame, SWITCH_IO_FLAG_NONE, 0) != SWITCH_STATUS_SUCCESS) {
 						switch_mutex_unlock(member->audio_out_mutex);
 						switch_mutex_unlock(member->write_mutex);
 						break;
@@ -1556,11 +1634,12 @@ void conference_loop_output(conference_member_t *member)
 		}
 
 		if (conference_utils_member_test_flag(member, MFLAG_FLUSH_BUFFER)) {
+			switch_mutex_lock(member->audio_out_mutex);
 			if (switch_buffer_inuse(member->mux_buffer)) {
-				switch_mutex_lock(member->audio_out_mutex);
 				switch_buffer_zero(member->mux_buffer);
-				switch_mutex_unlock(member->audio_out_mutex);
 			}
+			member->mux_frames_out = member->mux_frames_in;
+			switch_mutex_unlock(member->audio_out_mutex);
 			conference_utils_member_clear_flag_locked(member, MFLAG_FLUSH_BUFFER);
 		}
 
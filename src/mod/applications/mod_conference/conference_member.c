@@ -517,6 +517,105 @@ void conference_member_check_channels(switch_frame_t *frame, conference_member_t
 	}
 }
 
+/* the member hears the plain mix, untouched on the way out, at the conference ptime and channels */
+switch_bool_t conference_member_can_share_audio(conference_member_t *member)
+{
+	conference_obj_t *conference = member->conference;
+	switch_codec_implementation_t write_impl = { 0 };
+
+	if (!member->session || !conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING) ||
+		conference_utils_member_test_flag(member, MFLAG_NO_MINIMIZE_ENCODING) ||
+		conference_utils_member_test_flag(member, MFLAG_HAS_AUDIO) ||
+		conference_utils_member_test_flag(member, MFLAG_POSITIONAL) ||
+		!conference_utils_member_test_flag(member, MFLAG_CAN_HEAR) ||
+		member->volume_out_level || member->fnode || member->relationships || conference->relationship_total) {
+		return SWITCH_FALSE;
+	}
+
+	if (member->read_impl.microseconds_per_packet != conference->interval * 1000 || member->read_impl.number_of_channels != conference->channels) {
+		return SWITCH_FALSE;
+	}
+
+	switch_core_session_get_write_impl(member->session, &write_impl);
+
+	if (write_impl.microseconds_per_packet != conference->interval * 1000 || write_impl.number_of_channels != conference->channels) {
+		return SWITCH_FALSE;
+	}
+
+	/* media bugs would decode the shared frame again on the shared codec */
+	if (switch_core_media_bug_count(member->session, NULL)) {
+		return SWITCH_FALSE;
+	}
+
+	return SWITCH_TRUE;
+}
+
+/* queue one mixed frame for the output thread, along with the group's encoding of it when there is one */
+switch_size_t conference_member_write_mux(conference_member_t *member, int16_t *data, uint32_t bytes, audio_codec_set_t *codec_set)
+{
+	switch_size_t ok;
+
+	switch_mutex_lock(member->audio_out_mutex);
+
+	if (codec_set) {
+		conference_shared_frame_t *shared;
+
+		if (!member->shared_frames) {
+			member->shared_frames = switch_core_alloc(member->pool, sizeof(conference_shared_frame_t) * CONF_SHARED_FRAMES);
+		}
+
+		shared = &member->shared_frames[member->mux_frames_in % CONF_SHARED_FRAMES];
+		shared->seq = member->mux_frames_in;
+		shared->codec = &codec_set->codec;
+		shared->datalen = codec_set->datalen;
+		shared->flags = codec_set->flags;
+		memcpy(shared->data, codec_set->data, codec_set->datalen);
+	}
+
+	ok = switch_buffer_write(member->mux_buffer, data, bytes);
+	member->mux_frames_in++;
+
+	switch_mutex_unlock(member->audio_out_mutex);
+
+	return ok;
+}
+
+/* swap the frame just read from the mux_buffer for its shared encoding, if it still applies */
+switch_bool_t conference_member_take_shared_frame(conference_member_t *member, uint32_t seq, switch_frame_t *frame)
+{
+	conference_shared_frame_t *shared;
+	switch_codec_t *write_codec;
+
+	if (!member->shared_frames) {
+		return SWITCH_FALSE;
+	}
+
+	shared = &member->shared_frames[seq % CONF_SHARED_FRAMES];
+
+	if (shared->seq != seq || !shared->codec) {
+		return SWITCH_FALSE;
+	}
+
+	if (member->volume_out_level || member->fnode || !conference_utils_member_test_flag(member, MFLAG_CAN_HEAR)) {
+		return SWITCH_FALSE;
+	}
+
+	if (!(write_codec = switch_core_session_get_write_codec(member->session)) || write_codec->implementation != shared->codec->implementation) {
+		return SWITCH_FALSE;
+	}
+
+	frame->codec = shared->codec;
+	frame->data = shared->data;
+	frame->datalen = shared->datalen;
+	frame->samples = shared->codec->implementation->samples_per_packet;
+	frame->rate = shared->codec->implementation->samples_per_second;
+	/* what the encoder said about the frame, SFF_CNG from a dtx encoder */
+	frame->flags |= shared->flags;
+	shared->codec = NULL;
+
+	return SWITCH_TRUE;
+}
+
 
 void conference_member_add_file_data(conference_member_t *member, int16_t *data, switch_size_t file_data_len)
 {
@@ -204,6 +204,10 @@ void conference_utils_set_cflags(const char *flags, conference_flag_t *f)
 				f[CFLAG_POSITIONAL] = 1;
 			} else if (!strcasecmp(argv[i], "minimize-video-encoding")) {
 				f[CFLAG_MINIMIZE_VIDEO_ENCODING] = 1;
+			} else if (!strcasecmp(argv[i], "minimize-audio-encoding")) {
+				f[CFLAG_MINIMIZE_AUDIO_ENCODING] = 1;
+			} else if (!strcasecmp(argv[i], "skip-idle-decode")) {
+				f[CFLAG_SKIP_IDLE_DECODE] = 1;
 			} else if (!strcasecmp(argv[i], "video-bridge-first-two")) {
 				f[CFLAG_VIDEO_BRIDGE_FIRST_TWO] = 1;
 			} else if (!strcasecmp(argv[i], "video-required-for-canvas")) {
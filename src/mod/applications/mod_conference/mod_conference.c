@@ -204,6 +204,499 @@ void conference_send_notify(conference_obj_t *conference, const char *status, co
 }
 
 
+/* find or open the encoder shared by the listeners with the member's write codec and encode this tick's mix on it once */
+static audio_codec_set_t *conference_audio_codec_group(conference_obj_t *conference, conference_member_t *member, int16_t *data, uint32_t bytes)
+{
+	switch_codec_t *write_codec = switch_core_session_get_write_codec(member->session);
+	const switch_codec_implementation_t *impl;
+	audio_codec_set_t *codec_set = NULL;
+	int i;
+
+	if (!write_codec || !switch_core_codec_ready(write_codec) || switch_test_flag(write_codec, SWITCH_CODEC_FLAG_PASSTHROUGH)) {
+		return NULL;
+	}
+
+	impl = write_codec->implementation;
+
+	switch_mutex_lock(conference->mix_mutex);
+
+	for (i = 0; i < conference->audio_write_codecs_count; i++) {
+		audio_codec_set_t *cs = conference->audio_write_codecs[i];
+
+		if (cs->implementation == impl && !strcmp(cs->fmtp, switch_str_nil(write_codec->fmtp_in))) {
+			codec_set = cs;
+			break;
+		}
+	}
+
+	if (!codec_set) {
+		if (conference->audio_write_codecs_count == MAX_MUX_CODECS) {
+			switch_mutex_unlock(conference->mix_mutex);
+			return NULL;
+		}
+
+		codec_set = switch_core_alloc(conference->pool, sizeof(*codec_set));
+		codec_set->implementation = impl;
+		codec_set->fmtp = switch_core_strdup(conference->pool, switch_str_nil(write_codec->fmtp_in));
+
+		if (switch_core_codec_copy(write_codec, &codec_set->codec, NULL, conference->pool) != SWITCH_STATUS_SUCCESS ||
+			codec_set->codec.implementation != impl) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Conference %s: cannot share a %s encoder, members will encode their own audio\n",
+							  conference->name, impl->iananame);
+			codec_set->failed = SWITCH_TRUE;
+		} else if (impl->actual_samples_per_second != conference->rate &&
+				   switch_resample_create(&codec_set->resampler, conference->rate, impl->actual_samples_per_second,
+										  SWITCH_RECOMMENDED_BUFFER_SIZE, SWITCH_RESAMPLE_QUALITY, conference->channels) != SWITCH_STATUS_SUCCESS) {
+			codec_set->failed = SWITCH_TRUE;
+		} else {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Conference %s: shared %s@%uh encoder for listeners\n",
+							  conference->name, impl->iananame, impl->actual_samples_per_second);
+		}
+
+		conference->audio_write_codecs[conference->audio_write_codecs_count++] = codec_set;
+	}
+
+	if (codec_set->failed) {
+		switch_mutex_unlock(conference->mix_mutex);
+		return NULL;
+	}
+
+	if (codec_set->tick != conference->audio_tick) {
+		uint32_t rate = impl->samples_per_second;
+
+		if (codec_set->resampler) {
+			switch_resample_process(codec_set->resampler, data, bytes / 2 / conference->channels);
+			data = codec_set->resampler->to;
+			bytes = codec_set->resampler->to_len * 2 * conference->channels;
+		}
+
+		codec_set->datalen = sizeof(codec_set->data);
+		codec_set->flags = 0;
+
+		if (switch_core_codec_encode(&codec_set->codec, NULL, data, bytes, impl->actual_samples_per_second,
+									 codec_set->data, &codec_set->datalen, &rate, &codec_set->flags) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Conference %s: shared %s encoder failed, members will encode their own audio\n",
+							  conference->name, impl->iananame);
+			codec_set->failed = SWITCH_TRUE;
+			switch_mutex_unlock(conference->mix_mutex);
+			return NULL;
+		}
+
+		codec_set->tick = conference->audio_tick;
+		conference->shared_encodes++;
+	}
+
+	if (!codec_set->datalen || codec_set->datalen > CONF_SHARED_FRAME_SIZE) {
+		codec_set = NULL;
+	} else {
+		conference->shared_frames++;
+	}
+
+	switch_mutex_unlock(conference->mix_mutex);
+
+	return codec_set;
+}
+
+/* Create write frame once per member who is not deaf for each sample in the main frame
+   check if our audio is involved and if so, subtract it from the sample so we don't hear ourselves.
+   Since main frame was 32 bit int, we did not lose any detail, now that we have to convert to 16 bit we can
+   cut it off at the min and max range if need be and write the frame to the output buffer.
+*/
+static switch_size_t conference_mix_member(conference_obj_t *conference, conference_member_t *omember, int *main_frame, int16_t *shared_frame,
+										   int16_t *write_frame, uint32_t bytes)
+{
+	conference_member_t *imember;
+	int16_t *bptr;
+	uint32_t x;
+	int32_t z;
+
+	if (!conference_utils_member_test_flag(omember, MFLAG_RUNNING)) {
+		return 1;
+	}
+
+	if (!conference_utils_member_test_flag(omember, MFLAG_CAN_HEAR)) {
+		memset(write_frame, 255, bytes);
+		conference_member_write_mux(omember, write_frame, bytes, NULL);
+		return 1;
+	}
+
+	/* Everyone who is not talking hears the same mix, so it only has to be encoded once per codec. */
+	if (shared_frame && conference_member_can_share_audio(omember)) {
+		return conference_member_write_mux(omember, shared_frame, bytes, conference_audio_codec_group(conference, omember, shared_frame, bytes));
+	}
+
+	bptr = (int16_t *) omember->frame;
+
+	if (!conference->relationship_total) {
+		uint32_t own = conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) ? omember->read / 2 : 0;
+
+		/* bptr represents my own contribution to the mix */
+		if (own > bytes / 2) {
+			own = bytes / 2;
+		}
+
+		switch_mix_pack(write_frame, (int32_t *) main_frame, bptr, own);
+		switch_mix_pack(write_frame + own, (int32_t *) main_frame + own, NULL, bytes / 2 - own);
+
+		return conference_member_write_mux(omember, write_frame, bytes, NULL);
+	}
+
+	for (x = 0; x < bytes / 2 ; x++) {
+		z = main_frame[x];
+
+		/* bptr[x] represents my own contribution to this audio sample */
+		if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) && x <= omember->read / 2) {
+			z -= (int32_t) bptr[x];
+		}
+
+		/* when there are relationships, we have to do more work by scouring all the members to see if there are any
+		   reasons why we should not be hearing a paticular member, and if not, delete their samples as well.
+		*/
+		for (imember = conference->members; imember; imember = imember->next) {
+			if (imember != omember && conference_utils_member_test_flag(imember, MFLAG_HAS_AUDIO)) {
+				conference_relationship_t *rel;
+				switch_size_t found = 0;
+				int16_t *rptr = (int16_t *) imember->frame;
+				for (rel = imember->relationships; rel; rel = rel->next) {
+					if ((rel->id == omember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_SPEAK)) {
+						z -= (int32_t) rptr[x];
+						found = 1;
+						break;
+					}
+				}
+				if (!found) {
+					for (rel = omember->relationships; rel; rel = rel->next) {
+						if ((rel->id == imember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_HEAR)) {
+							z -= (int32_t) rptr[x];
+							break;
+						}
+					}
+				}
+
+			}
+		}
+
+		/* Now we can convert to 16 bit. */
+		switch_normalize_to_16bit(z);
+		write_frame[x] = (int16_t) z;
+	}
+
+	return conference_member_write_mux(omember, write_frame, bytes, NULL);
+}
+
+/* the part of a tick one shard does, its members into its own sum or the mix out to its members */
+static void conference_mixer_run_shard(conference_mix_shard_t *shard, int phase)
+{
+	conference_mixer_t *mixer = shard->mixer;
+	conference_obj_t *conference = mixer->conference;
+	uint32_t i;
+
+	if (phase == CONF_MIX_ACCUMULATE) {
+		memset(shard->mix, 0, sizeof(int32_t) * (mixer->bytes / 2));
+
+		for (i = shard->first; i < shard->last; i++) {
+			conference_member_t *member = mixer->members[i];
+
+			if (conference_utils_member_test_flag(member, MFLAG_RUNNING) && conference_utils_member_test_flag(member, MFLAG_HAS_AUDIO)) {
+				switch_mix_accumulate(shard->mix, (int16_t *) member->frame, member->read / 2);
+			}
+		}
+	} else {
+		shard->ok = 1;
+
+		for (i = shard->first; i < shard->last; i++) {
+			if (!conference_mix_member(conference, mixer->members[i], mixer->main_frame, mixer->shared_frame, shard->write_frame, mixer->bytes)) {
+				shard->ok = 0;
+			}
+		}
+	}
+}
+
+/*
+ * take shards of one dispatch until there are none left, the conference thread does this too while it waits,
+ * a thread that comes in late for a dispatch that is already over must not take shards of the next one
+ */
+static void conference_mixer_work(conference_mixer_t *mixer, uint32_t generation)
+{
+	for (;;) {
+		conference_mix_shard_t *shard;
+		int phase;
+
+		switch_mutex_lock(mixer->mutex);
+		if (mixer->generation != generation || mixer->next >= mixer->shard_count) {
+			switch_mutex_unlock(mixer->mutex);
+			break;
+		}
+		shard = &mixer->shards[mixer->next++];
+		phase = mixer->phase;
+		switch_mutex_unlock(mixer->mutex);
+
+		conference_mixer_run_shard(shard, phase);
+
+		switch_mutex_lock(mixer->mutex);
+		if (++mixer->done == mixer->shard_count) {
+			switch_thread_cond_signal(mixer->done_cond);
+		}
+		switch_mutex_unlock(mixer->mutex);
+	}
+}
+
+static void *SWITCH_THREAD_FUNC conference_mixer_thread_run(switch_thread_t *thread, void *obj)
+{
+	conference_mixer_t *mixer = (conference_mixer_t *) obj;
+	uint32_t generation = 0;
+
+	switch_mutex_lock(mixer->mutex);
+	while (mixer->running) {
+		if (generation == mixer->generation) {
+			switch_thread_cond_wait(mixer->cond, mixer->mutex);
+			continue;
+		}
+
+		generation = mixer->generation;
+		switch_mutex_unlock(mixer->mutex);
+		conference_mixer_work(mixer, generation);
+		switch_mutex_lock(mixer->mutex);
+	}
+	switch_mutex_unlock(mixer->mutex);
+
+	return NULL;
+}
+
+/* run one phase of the tick across the shards and come back when all of them are done */
+static void conference_mixer_dispatch(conference_mixer_t *mixer, int phase)
+{
+	uint32_t generation;
+
+	switch_mutex_lock(mixer->mutex);
+	mixer->phase = phase;
+	mixer->next = 0;
+	mixer->done = 0;
+	generation = ++mixer->generation;
+	switch_thread_cond_broadcast(mixer->cond);
+	switch_mutex_unlock(mixer->mutex);
+
+	conference_mixer_work(mixer, generation);
+
+	switch_mutex_lock(mixer->mutex);
+	while (mixer->done < mixer->shard_count) {
+		switch_thread_cond_wait(mixer->done_cond, mixer->mutex);
+	}
+	switch_mutex_unlock(mixer->mutex);
+}
+
+/* split the members into shards for this tick, one is not worth the threads */
+static int conference_mixer_prepare(conference_mixer_t *mixer, uint32_t bytes)
+{
+	conference_obj_t *conference = mixer->conference;
+	conference_member_t *member;
+	uint32_t count = 0, per;
+	int i;
+
+	for (member = conference->members; member; member = member->next) {
+		count++;
+	}
+
+	if (count < CONF_MIX_SHARD_MIN * 2) {
+		return 0;
+	}
+
+	/* the threads still check in under the lock after the last dispatch is done */
+	switch_mutex_lock(mixer->mutex);
+
+	if (count > mixer->member_alloc) {
+		mixer->member_alloc = count * 2;
+		switch_safe_free(mixer->members);
+		switch_zmalloc(mixer->members, sizeof(conference_member_t *) * mixer->member_alloc);
+	}
+
+	count = 0;
+	for (member = conference->members; member; member = member->next) {
+		mixer->members[count++] = member;
+	}
+
+	mixer->member_count = count;
+	mixer->bytes = bytes;
+	mixer->shard_count = mixer->thread_count + 1;
+
+	if ((uint32_t) mixer->shard_count > count / CONF_MIX_SHARD_MIN) {
+		mixer->shard_count = count / CONF_MIX_SHARD_MIN;
+	}
+
+	per = count / mixer->shard_count;
+
+	for (i = 0; i < mixer->shard_count; i++) {
+		mixer->shards[i].first = i * per;
+		mixer->shards[i].last = i == mixer->shard_count - 1 ? count : (i + 1) * per;
+	}
+
+	/* nothing to take until the first dispatch */
+	mixer->next = mixer->shard_count;
+	count = mixer->shard_count;
+
+	switch_mutex_unlock(mixer->mutex);
+
+	return (int) count;
+}
+
+static conference_mixer_t *conference_mixer_create(conference_obj_t *conference, int threads)
+{
+	conference_mixer_t *mixer;
+	switch_threadattr_t *thd_attr = NULL;
+	int i;
+
+	if (threads > CONF_MIX_MAX_THREADS) {
+		threads = CONF_MIX_MAX_THREADS;
+	}
+
+	mixer = switch_core_alloc(conference->pool, sizeof(*mixer));
+	mixer->conference = conference;
+	mixer->running = 1;
+	switch_mutex_init(&mixer->mutex, SWITCH_MUTEX_NESTED, conference->pool);
+	switch_thread_cond_create(&mixer->cond, conference->pool);
+	switch_thread_cond_create(&mixer->done_cond, conference->pool);
+
+	for (i = 0; i <= threads; i++) {
+		mixer->shards[i].mixer = mixer;
+		mixer->shards[i].mix = switch_core_alloc(conference->pool, sizeof(int32_t) * SWITCH_RECOMMENDED_BUFFER_SIZE);
+		mixer->shards[i].write_frame = switch_core_alloc(conference->pool, sizeof(int16_t) * SWITCH_RECOMMENDED_BUFFER_SIZE);
+	}
+
+	switch_threadattr_create(&thd_attr, conference->pool);
+	switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (i = 0; i < threads; i++) {
+		if (switch_thread_create(&mixer->threads[i], thd_attr, conference_mixer_thread_run, mixer, conference->pool) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+		mixer->thread_count++;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Conference %s: %d extra mixer threads for %d or more members\n",
+					  conference->name, mixer->thread_count, CONF_MIX_SHARD_MIN * 2);
+
+	return mixer;
+}
+
+static void conference_mixer_destroy(conference_mixer_t **mixerP)
+{
+	conference_mixer_t *mixer = *mixerP;
+	switch_status_t st;
+	int i;
+
+	*mixerP = NULL;
+
+	switch_mutex_lock(mixer->mutex);
+	mixer->running = 0;
+	switch_thread_cond_broadcast(mixer->cond);
+	switch_mutex_unlock(mixer->mutex);
+
+	for (i = 0; i < mixer->thread_count; i++) {
+		switch_thread_join(&st, mixer->threads[i]);
+	}
+
+	switch_safe_free(mixer->members);
+}
+
+/* Only the loudest few talkers are mixed in an active speaker conference, the rest are left out of this tick.
+   Someone in the mix stays there until they have been quiet for the hold time, and can only be pushed out by
+   a louder talker once they have been in it for as long.
+*/
+static uint32_t conference_select_active_speakers(conference_obj_t *conference)
+{
+	conference_member_t *member, *loudest[CONF_MAX_ACTIVE_SPEAKERS];
+	int active = 0, count = 0, i;
+	uint32_t dropped = 0;
+
+	for (member = conference->members; member; member = member->next) {
+		if (!conference_utils_member_test_flag(member, MFLAG_ACTIVE_SPEAKER)) {
+			continue;
+		}
+
+		member->active_speaker_ticks++;
+
+		if (conference_utils_member_test_flag(member, MFLAG_HAS_AUDIO)) {
+			member->active_speaker_quiet = 0;
+		} else if (++member->active_speaker_quiet >= conference->active_speaker_hold) {
+			conference_utils_member_clear_flag(member, MFLAG_ACTIVE_SPEAKER);
+			continue;
+		}
+
+		active++;
+	}
+
+	/* the loudest of everyone else who has audio this tick, loudest first */
+	for (member = conference->members; member; member = member->next) {
+		if (conference_utils_member_test_flag(member, MFLAG_ACTIVE_SPEAKER) || !conference_utils_member_test_flag(member, MFLAG_HAS_AUDIO)) {
+			continue;
+		}
+
+		for (i = count; i > 0 && loudest[i - 1]->score_iir < member->score_iir; i--) {
+			if (i < conference->active_speakers) {
+				loudest[i] = loudest[i - 1];
+			}
+		}
+
+		if (i < conference->active_speakers) {
+			loudest[i] = member;
+
+			if (count < conference->active_speakers) {
+				count++;
+			}
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		conference_member_t *quietest = NULL;
+
+		if (active < conference->active_speakers) {
+			active++;
+		} else {
+			for (member = conference->members; member; member = member->next) {
+				if (conference_utils_member_test_flag(member, MFLAG_ACTIVE_SPEAKER) && member->active_speaker_ticks >= conference->active_speaker_hold &&
+					(!quietest || member->score_iir < quietest->score_iir)) {
+					quietest = member;
+				}
+			}
+
+			if (!quietest || (uint64_t) loudest[i]->score_iir * 100 <= (uint64_t) quietest->score_iir * CONF_ACTIVE_SPEAKER_MARGIN) {
+				/* nobody further down the list is any louder */
+				break;
+			}
+
+			conference_utils_member_clear_flag(quietest, MFLAG_ACTIVE_SPEAKER);
+		}
+
+		loudest[i]->active_speaker_ticks = loudest[i]->active_speaker_quiet = 0;
+		conference_utils_member_set_flag(loudest[i], MFLAG_ACTIVE_SPEAKER);
+	}
+
+	for (member = conference->members; member; member = member->next) {
+		if (conference_utils_member_test_flag(member, MFLAG_HAS_AUDIO) && !conference_utils_member_test_flag(member, MFLAG_ACTIVE_SPEAKER)) {
+			conference_utils_member_clear_flag_locked(member, MFLAG_HAS_AUDIO);
+			dropped++;
+		}
+	}
+
+	return dropped;
+}
+
+/* a tick that takes longer than the interval means every member hears it late */
+static void conference_update_mix_stats(conference_obj_t *conference, switch_time_t usec)
+{
+	conference->mix_ticks++;
+	conference->mix_last_usec = (uint32_t) usec;
+
+	if (conference->mix_last_usec > conference->mix_max_usec) {
+		conference->mix_max_usec = conference->mix_last_usec;
+	}
+
+	if (usec > conference->interval * 1000) {
+		conference->mix_deadline_misses++;
+	}
+}
+
 /* Main monitor thread (1 per distinct conference room) */
 void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *obj)
 {
@@ -211,16 +704,16 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	conference_member_t *imember, *omember;
 	uint32_t samples = switch_samples_per_packet(conference->rate, conference->interval);
 	uint32_t bytes = samples * 2 * conference->channels;
-	uint8_t ready = 0, total = 0;
+	uint32_t ready = 0, total = 0;
 	switch_timer_t timer = { 0 };
 	switch_event_t *event;
 	uint8_t *file_frame;
 	uint8_t *async_file_frame;
 	int16_t *bptr;
 	uint32_t x = 0;
-	int32_t z = 0;
 	int divisor = 0;
 	conference_cdr_node_t *np;
+	switch_time_t tick_start;
 
 	if (!(divisor = conference->rate / 8000)) {
 		divisor = 1;
@@ -243,6 +736,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	conference->auto_recording = 0;
 	conference->record_count = 0;
 
+	if (conference->mix_threads > 0) {
+		conference->mixer = conference_mixer_create(conference, conference->mix_threads);
+	}
+
 	while (conference_globals.running && !conference_utils_test_flag(conference, CFLAG_DESTRUCT)) {
 		switch_size_t file_sample_len = samples;
 		switch_size_t file_data_len = samples * 2 * conference->channels;
@@ -257,6 +754,9 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			break;
 		}
 
+		conference->audio_tick++;
+		tick_start = switch_micro_time_now();
+
 		switch_mutex_lock(conference->mutex);
 		has_file_data = ready = total = 0;
 
@@ -379,6 +879,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 		conference->members_seeing_video = members_seeing_video;
 		conference->members_with_avatar = members_with_avatar;
 
+		if (conference->active_speakers && ready) {
+			ready -= conference_select_active_speakers(conference);
+		}
+
 		if (floor_holder != conference->floor_holder) {
 			conference_member_set_floor_holder(conference, NULL, floor_holder);
 		}
@@ -546,17 +1050,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					}
 				} else {
 					if (has_file_data) {
-						switch_size_t x;
-						for (x = 0; x < file_sample_len * conference->channels; x++) {
-							int32_t z;
-							int16_t *muxed;
-
-							muxed = (int16_t *) file_frame;
-							bptr = (int16_t *) async_file_frame;
-							z = muxed[x] + bptr[x];
-							switch_normalize_to_16bit(z);
-							muxed[x] = (int16_t) z;
-						}
+						switch_merge_sln((int16_t *) file_frame, (uint32_t) file_sample_len, (int16_t *) async_file_frame, (uint32_t) file_sample_len, conference->channels);
 					} else {
 						memcpy(file_frame, async_file_frame, file_sample_len * 2 * conference->channels);
 						has_file_data = 1;
@@ -570,6 +1064,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			/* Use more bits in the main_frame to preserve the exact sum of the audio samples. */
 			int main_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
 			int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int16_t shared_frame[SWITCH_RECOMMENDED_BUFFER_SIZE];
 
 
 			/* Init the main frame with file data if there is any. */
@@ -588,92 +1083,58 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			conference->mux_loop_count = 0;
 			conference->member_loop_count = 0;
 
+			if (conference->mixer && conference_mixer_prepare(conference->mixer, bytes) > 1) {
+				conference_mixer_t *mixer = conference->mixer;
+				int i;
 
-			/* Copy audio from every member known to be producing audio into the main frame. */
-			for (omember = conference->members; omember; omember = omember->next) {
-				conference->member_loop_count++;
-
-				if (!(conference_utils_member_test_flag(omember, MFLAG_RUNNING) && conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO))) {
-					continue;
-				}
+				/* Each shard sums its own members, the shard sums make the main frame. */
+				conference_mixer_dispatch(mixer, CONF_MIX_ACCUMULATE);
 
-				bptr = (int16_t *) omember->frame;
-				for (x = 0; x < omember->read / 2; x++) {
-					main_frame[x] += (int32_t) bptr[x];
+				for (i = 0; i < mixer->shard_count; i++) {
+					for (x = 0; x < bytes / 2; x++) {
+						main_frame[x] += mixer->shards[i].mix[x];
+					}
 				}
-			}
 
-			/* Create write frame once per member who is not deaf for each sample in the main frame
-			   check if our audio is involved and if so, subtract it from the sample so we don't hear ourselves.
-			   Since main frame was 32 bit int, we did not lose any detail, now that we have to convert to 16 bit we can
-			   cut it off at the min and max range if need be and write the frame to the output buffer.
-			*/
-			for (omember = conference->members; omember; omember = omember->next) {
-				switch_size_t ok = 1;
+				conference->member_loop_count = mixer->member_count;
 
-				if (!conference_utils_member_test_flag(omember, MFLAG_RUNNING)) {
-					continue;
+				if (conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING)) {
+					switch_mix_pack(shared_frame, (int32_t *) main_frame, NULL, bytes / 2);
 				}
 
-				if (!conference_utils_member_test_flag(omember, MFLAG_CAN_HEAR)) {
-					switch_mutex_lock(omember->audio_out_mutex);
-					memset(write_frame, 255, bytes);
-					ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
-					switch_mutex_unlock(omember->audio_out_mutex);
-					continue;
-				}
-
-				bptr = (int16_t *) omember->frame;
+				mixer->main_frame = main_frame;
+				mixer->shared_frame = conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING) ? shared_frame : NULL;
+				conference_mixer_dispatch(mixer, CONF_MIX_OUTPUT);
+				conference->mix_parallel_ticks++;
 
-				for (x = 0; x < bytes / 2 ; x++) {
-					z = main_frame[x];
-
-					/* bptr[x] represents my own contribution to this audio sample */
-					if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) && x <= omember->read / 2) {
-						z -= (int32_t) bptr[x];
+				for (i = 0; i < mixer->shard_count; i++) {
+					if (!mixer->shards[i].ok) {
+						switch_mutex_unlock(conference->mutex);
+						goto end;
 					}
+				}
+			} else {
+				/* Copy audio from every member known to be producing audio into the main frame. */
+				for (omember = conference->members; omember; omember = omember->next) {
+					conference->member_loop_count++;
 
-					/* when there are relationships, we have to do more work by scouring all the members to see if there are any
-					   reasons why we should not be hearing a paticular member, and if not, delete their samples as well.
-					*/
-					if (conference->relationship_total) {
-						for (imember = conference->members; imember; imember = imember->next) {
-							if (imember != omember && conference_utils_member_test_flag(imember, MFLAG_HAS_AUDIO)) {
-								conference_relationship_t *rel;
-								switch_size_t found = 0;
-								int16_t *rptr = (int16_t *) imember->frame;
-								for (rel = imember->relationships; rel; rel = rel->next) {
-									if ((rel->id == omember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_SPEAK)) {
-										z -= (int32_t) rptr[x];
-										found = 1;
-										break;
-									}
-								}
-								if (!found) {
-									for (rel = omember->relationships; rel; rel = rel->next) {
-										if ((rel->id == imember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_HEAR)) {
-											z -= (int32_t) rptr[x];
-											break;
-										}
-									}
-								}
-
-							}
-						}
+					if (!(conference_utils_member_test_flag(omember, MFLAG_RUNNING) && conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO))) {
+						continue;
 					}
 
-					/* Now we can convert to 16 bit. */
-					switch_normalize_to_16bit(z);
-					write_frame[x] = (int16_t) z;
+					switch_mix_accumulate((int32_t *) main_frame, (int16_t *) omember->frame, omember->read / 2);
 				}
 
-				switch_mutex_lock(omember->audio_out_mutex);
-				ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
-				switch_mutex_unlock(omember->audio_out_mutex);
+				if (conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING)) {
+					switch_mix_pack(shared_frame, (int32_t *) main_frame, NULL, bytes / 2);
+				}
 
-				if (!ok) {
-					switch_mutex_unlock(conference->mutex);
-					goto end;
+				for (omember = conference->members; omember; omember = omember->next) {
+					if (!conference_mix_member(conference, omember, main_frame,
+											   conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING) ? shared_frame : NULL, write_frame, bytes)) {
+						switch_mutex_unlock(conference->mutex);
+						goto end;
+					}
 				}
 			}
 		} else { /* There is no source audio.  Push silence into all of the buffers */
@@ -692,9 +1153,11 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					continue;
 				}
 
-				switch_mutex_lock(omember->audio_out_mutex);
-				ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
-				switch_mutex_unlock(omember->audio_out_mutex);
+				if (conference_member_can_share_audio(omember)) {
+					ok = conference_member_write_mux(omember, write_frame, bytes, conference_audio_codec_group(conference, omember, write_frame, bytes));
+				} else {
+					ok = conference_member_write_mux(omember, write_frame, bytes, NULL);
+				}
 
 				if (!ok) {
 					switch_mutex_unlock(conference->mutex);
@@ -754,6 +1217,8 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			conference_utils_set_flag(conference, CFLAG_ENDCONF_FORCED);
 		}
 
+		conference_update_mix_stats(conference, switch_micro_time_now() - tick_start);
+
 		switch_mutex_unlock(conference->mutex);
 	}
 	/* Rinse ... Repeat */
@@ -809,6 +1274,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 		switch_cond_next();
 	}
 
+	if (conference->mixer) {
+		conference_mixer_destroy(&conference->mixer);
+	}
+
 	switch_core_timer_destroy(&timer);
 	switch_mutex_lock(conference_globals.hash_mutex);
 	if (conference_utils_test_flag(conference, CFLAG_INHASH)) {
@@ -835,6 +1304,18 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	switch_thread_rwlock_unlock(conference->rwlock);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Write Lock OFF\n");
 
+	for (x = 0; x < (uint32_t) conference->audio_write_codecs_count; x++) {
+		audio_codec_set_t *codec_set = conference->audio_write_codecs[x];
+
+		if (switch_core_codec_ready(&codec_set->codec)) {
+			switch_core_codec_destroy(&codec_set->codec);
+		}
+
+		if (codec_set->resampler) {
+			switch_resample_destroy(&codec_set->resampler);
+		}
+	}
+
 	if (conference->la) {
 		switch_live_array_destroy(&conference->la);
 	}
@@ -2728,6 +3209,9 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	char *conference_log_dir = NULL;
 	char *cdr_event_mode = NULL;
 	char *terminate_on_silence = NULL;
+	int mix_threads = 0;
+	int active_speakers = 0;
+	int active_speaker_hold = 500;
 	char *endconference_grace_time = NULL;
 	char uuid_str[SWITCH_UUID_FORMATTED_LENGTH+1];
 	switch_uuid_t uuid;
@@ -3059,6 +3543,27 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 				}
 			} else if (!strcasecmp(var, "terminate-on-silence") && !zstr(val)) {
 				terminate_on_silence = val;
+			} else if (!strcasecmp(var, "mix-threads") && !zstr(val)) {
+				mix_threads = atoi(val);
+
+				if (mix_threads < 0 || mix_threads > CONF_MIX_MAX_THREADS) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "mix-threads must be between 0 and %d\n", CONF_MIX_MAX_THREADS);
+					mix_threads = 0;
+				}
+			} else if (!strcasecmp(var, "active-speakers") && !zstr(val)) {
+				active_speakers = atoi(val);
+
+				if (active_speakers < 0 || active_speakers > CONF_MAX_ACTIVE_SPEAKERS) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "active-speakers must be between 0 and %d\n", CONF_MAX_ACTIVE_SPEAKERS);
+					active_speakers = 0;
+				}
+			} else if (!strcasecmp(var, "active-speaker-hold-ms") && !zstr(val)) {
+				active_speaker_hold = atoi(val);
+
+				if (active_speaker_hold < 0 || active_speaker_hold > CONF_ACTIVE_SPEAKER_MAX_HOLD_MS) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "active-speaker-hold-ms must be between 0 and %d\n", CONF_ACTIVE_SPEAKER_MAX_HOLD_MS);
+					active_speaker_hold = 500;
+				}
 			} else if (!strcasecmp(var, "endconf-grace-time") && !zstr(val)) {
 				endconference_grace_time = val;
 			} else if (!strcasecmp(var, "video-quality") && !zstr(val)) {
@@ -3622,6 +4127,12 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	if (!zstr(terminate_on_silence)) {
 		conference->terminate_on_silence = atoi(terminate_on_silence);
 	}
+
+	conference->mix_threads = mix_threads;
+	conference->active_speakers = active_speakers;
+	/* in ticks, a hold shorter than one still holds for one */
+	conference->active_speaker_hold = (active_speaker_hold + conference->interval - 1) / conference->interval;
+
 	if (!zstr(endconference_grace_time)) {
 		conference->endconference_grace_time = atoi(endconference_grace_time);
 	}
@@ -3646,6 +4157,7 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	switch_thread_rwlock_create(&conference->rwlock, conference->pool);
 	switch_mutex_init(&conference->member_mutex, SWITCH_MUTEX_NESTED, conference->pool);
 	switch_mutex_init(&conference->canvas_mutex, SWITCH_MUTEX_NESTED, conference->pool);
+	switch_mutex_init(&conference->mix_mutex, SWITCH_MUTEX_NESTED, conference->pool);
 
 	switch_mutex_lock(conference_globals.hash_mutex);
 	conference_utils_set_flag(conference, CFLAG_INHASH);
@@ -81,6 +81,17 @@
 #define SCORE_IIR_SPEAKING_MAX 300
 /* the threshold below which you cede the floor to someone loud (see above value). */
 #define SCORE_IIR_SPEAKING_MIN 100
+/* the most talkers an active speaker conference will mix at once */
+#define CONF_MAX_ACTIVE_SPEAKERS 32
+/* how much louder, in percent, a talker has to be than the quietest one in the mix to take their place */
+#define CONF_ACTIVE_SPEAKER_MARGIN 150
+/* the longest active-speaker-hold-ms, how long a talker keeps their place in the mix once in or quiet */
+#define CONF_ACTIVE_SPEAKER_MAX_HOLD_MS 10000
+/* a member whose audio stays under their energy level over this many frames in a row stops decoding it */
+#define CONF_IDLE_DIVISOR 4
+#define CONF_IDLE_FRAMES 50
+/* while not decoding, every nth frame still is, packet energy alone can miss what the gain makes loud */
+#define CONF_IDLE_PROBE 5
 /* the FPS of the conference canvas */
 #define FPS 30
 /* max supported layers in one mcu */
@@ -106,6 +117,12 @@
 #define CONFFUNCAPISIZE (sizeof(conference_api_sub_commands)/sizeof(conference_api_sub_commands[0]))
 
 #define MAX_MUX_CODECS 50
+#define CONF_SHARED_FRAMES 8
+#define CONF_SHARED_FRAME_SIZE 640
+#define CONF_MIX_MAX_THREADS 16
+#define CONF_MIX_SHARD_MIN 64
+#define CONF_MIX_ACCUMULATE 0
+#define CONF_MIX_OUTPUT 1
 
 #define ALC_HRTF_SOFT  0x1992
 
@@ -221,6 +238,8 @@ typedef enum {
 	MFLAG_VIDEO_JOIN,
 	MFLAG_DED_VID_LAYER,
 	MFLAG_HOLD,
+	MFLAG_ACTIVE_SPEAKER,
+	MFLAG_DECODE_IDLE,
 	///////////////////////////
 	MFLAG_MAX
 } member_flag_t;
@@ -262,6 +281,8 @@ typedef enum {
 	CFLAG_VIDEO_MUTE_EXIT_CANVAS,
 	CFLAG_NO_MOH,
 	CFLAG_DED_VID_LAYER_AUDIO_FLOOR,
+	CFLAG_MINIMIZE_AUDIO_ENCODING,
+	CFLAG_SKIP_IDLE_DECODE,
 	/////////////////////////////////
 	CFLAG_MAX
 } conference_flag_t;
@@ -540,6 +561,63 @@ typedef struct codec_set_s {
 	char *video_codec_group;
 } codec_set_t;
 
+/* one encoder shared by the listeners with the same write codec */
+typedef struct audio_codec_set_s {
+	switch_codec_t codec;
+	const switch_codec_implementation_t *implementation;
+	char *fmtp;
+	switch_audio_resampler_t *resampler;
+	uint8_t data[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint32_t datalen;
+	uint32_t flags;
+	uint32_t tick;
+	switch_bool_t failed;
+} audio_codec_set_t;
+
+struct conference_mixer_s;
+
+/* a slice of the members mixed by one thread */
+typedef struct conference_mix_shard_s {
+	struct conference_mixer_s *mixer;
+	uint32_t first;
+	uint32_t last;
+	int32_t *mix;
+	int16_t *write_frame;
+	switch_size_t ok;
+} conference_mix_shard_t;
+
+/* the threads that help the conference thread mix very large conferences */
+typedef struct conference_mixer_s {
+	struct conference_obj *conference;
+	switch_thread_t *threads[CONF_MIX_MAX_THREADS];
+	int thread_count;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_thread_cond_t *done_cond;
+	int running;
+	uint32_t generation;
+	int phase;
+	int next;
+	int done;
+	conference_mix_shard_t shards[CONF_MIX_MAX_THREADS + 1];
+	int shard_count;
+	struct conference_member **members;
+	uint32_t member_count;
+	uint32_t member_alloc;
+	int *main_frame;
+	int16_t *shared_frame;
+	uint32_t bytes;
+} conference_mixer_t;
+
+/* an encoded copy of one frame in the member's mux_buffer */
+typedef struct conference_shared_frame_s {
+	uint32_t seq;
+	uint32_t datalen;
+	uint32_t flags;
+	switch_codec_t *codec;
+	uint8_t data[CONF_SHARED_FRAME_SIZE];
+} conference_shared_frame_t;
+
 
 typedef struct mcu_canvas_s {
 	int width;
@@ -765,6 +843,21 @@ typedef struct conference_obj {
 	uint32_t floor_holder_score_iir;
 	char *default_layout_name;
 	int mux_paused;
+	audio_codec_set_t *audio_write_codecs[MAX_MUX_CODECS];
+	int audio_write_codecs_count;
+	uint32_t audio_tick;
+	uint64_t shared_encodes;
+	uint64_t shared_frames;
+	switch_mutex_t *mix_mutex;
+	int mix_threads;
+	conference_mixer_t *mixer;
+	uint64_t mix_ticks;
+	uint64_t mix_parallel_ticks;
+	uint64_t mix_deadline_misses;
+	uint32_t mix_last_usec;
+	uint32_t mix_max_usec;
+	int active_speakers;
+	uint32_t active_speaker_hold;
 } conference_obj_t;
 
 /* Relationship with another member */
@@ -783,11 +876,18 @@ struct conference_member {
 	switch_memory_pool_t *pool;
 	switch_buffer_t *audio_buffer;
 	switch_buffer_t *mux_buffer;
+	uint32_t mux_frames_in;
+	uint32_t mux_frames_out;
+	conference_shared_frame_t *shared_frames;
 	switch_buffer_t *resample_buffer;
 	member_flag_t flags[MFLAG_MAX];
 	int32_t score;
 	int32_t last_score;
 	uint32_t score_iir;
+	uint32_t active_speaker_ticks;
+	uint32_t active_speaker_quiet;
+	uint32_t idle_frames;
+	uint64_t skipped_decodes;
 	switch_mutex_t *flag_mutex;
 	switch_mutex_t *write_mutex;
 	switch_mutex_t *audio_in_mutex;
@@ -1093,6 +1193,9 @@ void conference_video_wake_layer_thread(conference_member_t *member);
 
 int conference_member_noise_gate_check(conference_member_t *member);
 void conference_member_check_channels(switch_frame_t *frame, conference_member_t *member, switch_bool_t in);
+switch_bool_t conference_member_can_share_audio(conference_member_t *member);
+switch_size_t conference_member_write_mux(conference_member_t *member, int16_t *data, uint32_t bytes, audio_codec_set_t *codec_set);
+switch_bool_t conference_member_take_shared_frame(conference_member_t *member, uint32_t seq, switch_frame_t *frame);
 
 void conference_fnode_toggle_pause(conference_file_node_t *fnode, switch_stream_handle_t *stream);
 void conference_fnode_check_status(conference_file_node_t *fnode, switch_stream_handle_t *stream);
@@ -1241,6 +1344,7 @@ switch_status_t conference_api_sub_file_vol(conference_obj_t *conference, switch
 switch_status_t conference_api_sub_recording(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_vid_layout(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_count(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
+switch_status_t conference_api_sub_mix_stats(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_xml_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_json_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
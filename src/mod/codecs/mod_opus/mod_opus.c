@@ -38,6 +38,8 @@
 #define SWITCH_OPUS_MAX_BITRATE 510000
 
 #define SWITCH_OPUS_MIN_FEC_BITRATE 12400
+/* bytes per 20ms under the lowest bitrate opus codes speech at, anything this small is dtx or silence */
+#define SWITCH_OPUS_SILENT_BYTES 8
 
 SWITCH_MODULE_LOAD_FUNCTION(mod_opus_load);
 SWITCH_MODULE_DEFINITION(mod_opus, mod_opus_load, NULL, NULL);
@@ -1253,6 +1255,22 @@ static switch_status_t switch_opus_control(switch_codec_t *codec,
 			context->old_plpct = plpct;
 		}
 		break;
+	case SCC_AUDIO_PACKET_ENERGY:
+		{
+			switch_frame_t *frame = (switch_frame_t *) cmd_data;
+			int samples;
+
+			/* we can only tell silence from the packet itself, how loud anything else is takes decoding it */
+			if (frame->datalen > 2) {
+				if ((samples = opus_packet_get_nb_samples(frame->data, frame->datalen, 48000)) <= 0 ||
+					frame->datalen * 960 / samples > SWITCH_OPUS_SILENT_BYTES) {
+					return SWITCH_STATUS_FALSE;
+				}
+			}
+
+			*((uint32_t *) cmd_arg) = 0;
+		}
+		break;
 	case SCC_AUDIO_ADJUST_BITRATE:
 		{
 			const char *cmd = (const char *)cmd_data;
@@ -35,7 +35,8 @@
 #include <fcntl.h>
 
 SWITCH_MODULE_LOAD_FUNCTION(mod_dialplan_xml_load);
-SWITCH_MODULE_DEFINITION(mod_dialplan_xml, mod_dialplan_xml_load, NULL, NULL);
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_dialplan_xml_shutdown);
+SWITCH_MODULE_DEFINITION(mod_dialplan_xml, mod_dialplan_xml_load, mod_dialplan_xml_shutdown, NULL);
 
 typedef enum {
 	BREAK_ON_TRUE,
@@ -615,6 +616,320 @@ static switch_status_t dialplan_xml_locate(switch_core_session_t *session, switc
 	return status;
 }
 
+/* Compiled contexts.
+ *
+ * A context with compile="true" is indexed once per loaded dialplan: every extension whose first condition is a plain
+ * destination_number regex anchored on a literal prefix is filed in a prefix trie under that prefix, everything else
+ * stays at the root.  Such an extension can only do something when destination_number starts with its prefix, so a hunt
+ * only runs parse_exten() on the extensions found along the destination_number's path through the trie, in their
+ * original order.  Extension and action nodes are still those of the loaded dialplan, the compiled context holds a
+ * reference on it until reloadxml replaces it.
+ */
+
+typedef struct dp_exten_ref_s {
+	uint32_t index;
+	struct dp_exten_ref_s *next;
+} dp_exten_ref_t;
+
+typedef struct dp_trie_s {
+	char c;
+	struct dp_trie_s *child;
+	struct dp_trie_s *sibling;
+	dp_exten_ref_t *head;
+	dp_exten_ref_t *tail;
+} dp_trie_t;
+
+typedef struct dp_context_s {
+	switch_memory_pool_t *pool;
+	switch_xml_t root;
+	switch_xml_t xcontext;
+	switch_xml_t *extens;
+	uint32_t count;
+	uint32_t indexed;
+	dp_trie_t trie;
+	int refs;
+} dp_context_t;
+
+#define DP_PREFIX_LEN 64
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_hash_t *contexts;
+	switch_event_node_t *reload_node;
+} globals;
+
+static int dp_alnum(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/* the literal every match of expression has to start with, or nothing when that cannot be told */
+static switch_bool_t dp_expression_prefix(const char *expression, char *prefix, switch_size_t len)
+{
+	const char *p;
+	switch_size_t i = 0, last = 0;
+
+	if (zstr(expression) || *expression != '^' || strchr(expression, '|') || strstr(expression, "${") || strstr(expression, "$$")) {
+		return SWITCH_FALSE;
+	}
+
+	for (p = expression + 1; *p && i < len - 1; p++) {
+		if (*p == '\\' && *(p + 1) && !dp_alnum(*(p + 1))) {
+			last = i;
+			prefix[i++] = *++p;
+		} else if (dp_alnum(*p) || strchr("#-_@%:=,/!~&", *p)) {
+			last = i;
+			prefix[i++] = *p;
+		} else {
+			break;
+		}
+	}
+
+	/* the last literal may be optional */
+	if (i && (*p == '?' || *p == '*' || *p == '{')) {
+		i = last;
+	}
+
+	prefix[i] = '\0';
+
+	return i ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+/* true when the extension is a no-op unless destination_number starts with prefix */
+static switch_bool_t dp_exten_prefix(switch_xml_t xexten, char *prefix, switch_size_t len)
+{
+	switch_xml_t xcond, xexpression;
+	const char *field, *brk, *expression;
+
+	if (!(xcond = switch_xml_child(xexten, "condition"))) {
+		return SWITCH_FALSE;
+	}
+
+	if (!(field = switch_xml_attr(xcond, "field")) || strcmp(field, "destination_number") || switch_xml_attr(xcond, "regex") ||
+		switch_xml_child(xcond, "anti-action") || switch_xml_std_datetime_check(xcond, NULL, NULL) != -1) {
+		return SWITCH_FALSE;
+	}
+
+	if ((brk = switch_xml_attr(xcond, "break")) && strcasecmp(brk, "on-false")) {
+		return SWITCH_FALSE;
+	}
+
+	if ((xexpression = switch_xml_child(xcond, "expression"))) {
+		expression = xexpression->txt;
+	} else {
+		expression = switch_xml_attr(xcond, "expression");
+	}
+
+	return dp_expression_prefix(expression, prefix, len);
+}
+
+static void dp_trie_add(dp_context_t *dpc, const char *prefix, uint32_t index)
+{
+	dp_trie_t *node = &dpc->trie, *next;
+	dp_exten_ref_t *ref;
+	const char *p;
+
+	for (p = prefix; p && *p; p++) {
+		for (next = node->child; next && next->c != *p; next = next->sibling);
+
+		if (!next) {
+			next = switch_core_alloc(dpc->pool, sizeof(*next));
+			next->c = *p;
+			next->sibling = node->child;
+			node->child = next;
+		}
+
+		node = next;
+	}
+
+	ref = switch_core_alloc(dpc->pool, sizeof(*ref));
+	ref->index = index;
+
+	if (node->tail) {
+		node->tail->next = ref;
+	} else {
+		node->head = ref;
+	}
+	node->tail = ref;
+}
+
+static dp_context_t *dp_context_compile(switch_xml_t root, switch_xml_t xcontext)
+{
+	switch_memory_pool_t *pool;
+	dp_context_t *dpc;
+	switch_xml_t xexten;
+	switch_time_t start = switch_micro_time_now();
+	char prefix[DP_PREFIX_LEN];
+	uint32_t i = 0;
+
+	if (switch_core_new_memory_pool(&pool) != SWITCH_STATUS_SUCCESS) {
+		return NULL;
+	}
+
+	dpc = switch_core_alloc(pool, sizeof(*dpc));
+	dpc->pool = pool;
+	dpc->root = root;
+	dpc->xcontext = xcontext;
+
+	for (xexten = switch_xml_child(xcontext, "extension"); xexten; xexten = xexten->next) {
+		dpc->count++;
+	}
+
+	dpc->extens = switch_core_alloc(pool, sizeof(switch_xml_t) * (dpc->count + 1));
+
+	for (xexten = switch_xml_child(xcontext, "extension"); xexten; xexten = xexten->next, i++) {
+		dpc->extens[i] = xexten;
+
+		if (dp_exten_prefix(xexten, prefix, sizeof(prefix))) {
+			dp_trie_add(dpc, prefix, i);
+			dpc->indexed++;
+		} else {
+			dp_trie_add(dpc, NULL, i);
+		}
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Compiled dialplan context %s: %u extensions, %u indexed by destination_number in %" SWITCH_TIME_T_FMT "us\n",
+					  switch_xml_attr_soft(xcontext, "name"), dpc->count, dpc->indexed, switch_micro_time_now() - start);
+
+	return dpc;
+}
+
+/* call with globals.mutex held */
+static void dp_context_release(dp_context_t *dpc)
+{
+	switch_memory_pool_t *pool;
+
+	if (--dpc->refs > 0) {
+		return;
+	}
+
+	switch_xml_free(dpc->root);
+	pool = dpc->pool;
+	switch_core_destroy_memory_pool(&pool);
+}
+
+static void dp_context_put(dp_context_t *dpc)
+{
+	switch_mutex_lock(globals.mutex);
+	dp_context_release(dpc);
+	switch_mutex_unlock(globals.mutex);
+}
+
+static dp_context_t *dp_context_get(switch_xml_t xml, switch_xml_t xcontext)
+{
+	const char *name = switch_xml_attr_soft(xcontext, "name");
+	dp_context_t *dpc;
+	switch_xml_t root;
+
+	/* only the loaded dialplan is around long enough to be worth compiling, documents from bindings are per call */
+	if ((root = switch_xml_root()) != xml) {
+		switch_xml_free(root);
+		return NULL;
+	}
+
+	switch_mutex_lock(globals.mutex);
+
+	if ((dpc = switch_core_hash_find(globals.contexts, name)) && dpc->xcontext != xcontext) {
+		switch_core_hash_delete(globals.contexts, name);
+		dp_context_release(dpc);
+		dpc = NULL;
+	}
+
+	if (!dpc && (dpc = dp_context_compile(root, xcontext))) {
+		dpc->refs = 1;
+		switch_core_hash_insert(globals.contexts, name, dpc);
+		root = NULL;
+	}
+
+	if (dpc) {
+		dpc->refs++;
+	}
+
+	switch_mutex_unlock(globals.mutex);
+
+	if (root) {
+		switch_xml_free(root);
+	}
+
+	return dpc;
+}
+
+static void dp_context_flush(void)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	switch_mutex_lock(globals.mutex);
+	while ((hi = switch_core_hash_first(globals.contexts))) {
+		const void *key;
+
+		switch_core_hash_this(hi, &key, NULL, &val);
+		switch_safe_free(hi);
+		switch_core_hash_delete(globals.contexts, (const char *) key);
+		dp_context_release((dp_context_t *) val);
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+static void dp_reload_event_handler(switch_event_t *event)
+{
+	dp_context_flush();
+}
+
+/* returns the extensions worth parsing for destination_number as a bitmap over dpc->extens */
+static uint32_t *dp_context_candidates(dp_context_t *dpc, const char *destination_number)
+{
+	uint32_t *bits;
+	dp_trie_t *node = &dpc->trie;
+	dp_exten_ref_t *ref;
+	const char *p = destination_number;
+
+	switch_zmalloc(bits, sizeof(uint32_t) * (dpc->count / 32 + 1));
+
+	while (node) {
+		for (ref = node->head; ref; ref = ref->next) {
+			bits[ref->index / 32] |= (1U << (ref->index % 32));
+		}
+
+		if (!p || !*p) {
+			break;
+		}
+
+		for (node = node->child; node && node->c != *p; node = node->sibling);
+		p++;
+	}
+
+	return bits;
+}
+
+/* returns non-zero when the hunt is over */
+static int hunt_exten(switch_core_session_t *session, switch_caller_profile_t *caller_profile, switch_xml_t xexten, switch_caller_extension_t **extension)
+{
+	switch_channel_t *channel = switch_core_session_get_channel(session);
+	int proceed = 0;
+	const char *cont = switch_xml_attr(xexten, "continue");
+	const char *exten_name = switch_xml_attr(xexten, "name");
+
+	if (!exten_name) {
+		exten_name = "UNKNOWN";
+	}
+
+	if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,
+					  "Dialplan: %s parsing [%s->%s] continue=%s\n",
+					  switch_channel_get_name(channel), caller_profile->context, exten_name, cont ? cont : "false");
+	} else {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(session), SWITCH_LOG_DEBUG,
+					  "Dialplan: %s parsing [%s->%s] continue=%s\n",
+					  switch_channel_get_name(channel), caller_profile->context, exten_name, cont ? cont : "false");
+	}
+
+	proceed = parse_exten(session, caller_profile, xexten, extension, exten_name, 0);
+
+	return proceed && !switch_true(cont);
+}
+
 SWITCH_STANDARD_DIALPLAN(dialplan_hunt)
 {
 	switch_caller_extension_t *extension = NULL;
@@ -622,6 +937,7 @@ SWITCH_STANDARD_DIALPLAN(dialplan_hunt)
 	switch_xml_t alt_root = NULL, cfg, xml = NULL, xcontext, xexten = NULL;
 	char *alt_path = (char *) arg;
 	const char *hunt = NULL;
+	dp_context_t *dpc = NULL;
 
 	if (!caller_profile) {
 		if (!(caller_profile = switch_channel_get_caller_profile(channel))) {
@@ -673,36 +989,35 @@ SWITCH_STANDARD_DIALPLAN(dialplan_hunt)
 		xexten = switch_xml_find_child(xcontext, "extension", "name", caller_profile->destination_number);
 	}
 
-	if (!xexten) {
-		xexten = switch_xml_child(xcontext, "extension");
-	}
+	if (!xexten && !alt_root && switch_true(switch_xml_attr(xcontext, "compile")) && (dpc = dp_context_get(xml, xcontext))) {
+		uint32_t *bits = dp_context_candidates(dpc, caller_profile->destination_number);
+		uint32_t i;
 
-	while (xexten) {
-		int proceed = 0;
-		const char *cont = switch_xml_attr(xexten, "continue");
-		const char *exten_name = switch_xml_attr(xexten, "name");
+		for (i = 0; i < dpc->count; i++) {
+			if (!(i % 32) && !bits[i / 32]) {
+				i += 31;
+				continue;
+			}
 
-		if (!exten_name) {
-			exten_name = "UNKNOWN";
+			if ((bits[i / 32] & (1U << (i % 32))) && hunt_exten(session, caller_profile, dpc->extens[i], &extension)) {
+				break;
+			}
 		}
 
-		if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,
-						  "Dialplan: %s parsing [%s->%s] continue=%s\n",
-						  switch_channel_get_name(channel), caller_profile->context, exten_name, cont ? cont : "false");
-		} else {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(session), SWITCH_LOG_DEBUG,
-						  "Dialplan: %s parsing [%s->%s] continue=%s\n",
-						  switch_channel_get_name(channel), caller_profile->context, exten_name, cont ? cont : "false");
+		free(bits);
+		dp_context_put(dpc);
+	} else {
+		if (!xexten) {
+			xexten = switch_xml_child(xcontext, "extension");
 		}
 
-		proceed = parse_exten(session, caller_profile, xexten, &extension, exten_name, 0);
+		while (xexten) {
+			if (hunt_exten(session, caller_profile, xexten, &extension)) {
+				break;
+			}
 
-		if (proceed && !switch_true(cont)) {
-			break;
+			xexten = xexten->next;
 		}
-
-		xexten = xexten->next;
 	}
 
 	switch_xml_free(xml);
@@ -721,10 +1036,28 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_dialplan_xml_load)
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
 	SWITCH_ADD_DIALPLAN(dp_interface, "XML", dialplan_hunt);
 
+	memset(&globals, 0, sizeof(globals));
+	globals.pool = pool;
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	switch_core_hash_init(&globals.contexts);
+
+	if (switch_event_bind_removable(modname, SWITCH_EVENT_RELOADXML, NULL, dp_reload_event_handler, NULL, &globals.reload_node) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Couldn't bind reloadxml, compiled contexts are rebuilt on their next hunt\n");
+	}
+
 	/* indicate that the module should continue to be loaded */
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_dialplan_xml_shutdown)
+{
+	switch_event_unbind(&globals.reload_node);
+	dp_context_flush();
+	switch_core_hash_destroy(&globals.contexts);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 /* For Emacs:
  * Local Variables:
  * mode:c
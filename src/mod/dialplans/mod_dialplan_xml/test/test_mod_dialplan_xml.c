@@ -0,0 +1,194 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2018, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * test_mod_dialplan_xml.c -- tests for compiled dialplan contexts
+ *
+ */
+
+#include <switch.h>
+#include <test/switch_test.h>
+
+#define BENCH_EXTENSIONS 10000
+#define BENCH_CALLS 200
+
+/* the same extensions twice, once in a plain context and once in a compiled one */
+static switch_status_t write_bench_dialplan(const char *bridge_prefix)
+{
+	char path[1024];
+	FILE *f;
+	int c, x;
+
+	switch_snprintf(path, sizeof(path), "%s%sdialplan_bench.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+
+	if (!(f = fopen(path, "w"))) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	fprintf(f, "<include>\n");
+
+	for (c = 0; c < 2; c++) {
+		fprintf(f, "<context name=\"%s\"%s>\n", c ? "bench_compiled" : "bench", c ? " compile=\"true\"" : "");
+		fprintf(f, "<extension name=\"set_vars\" continue=\"true\"><condition><action application=\"set\" data=\"bench=true\"/></condition></extension>\n");
+
+		for (x = 0; x < BENCH_EXTENSIONS; x++) {
+			fprintf(f, "<extension name=\"ext_%d\"><condition field=\"destination_number\" expression=\"^%d$\">"
+					"<action application=\"bridge\" data=\"%s/%d\"/></condition></extension>\n", x, 10000 + x, bridge_prefix, 10000 + x);
+		}
+
+		fprintf(f, "<extension name=\"star_codes\"><condition field=\"destination_number\" expression=\"^\\*9(\\d+)$\">"
+				"<action application=\"transfer\" data=\"$1\"/></condition></extension>\n");
+		fprintf(f, "<extension name=\"unknown\"><condition field=\"destination_number\" expression=\"^(.+)$\">"
+				"<action application=\"respond\" data=\"404\"/></condition></extension>\n");
+		fprintf(f, "</context>\n");
+	}
+
+	fprintf(f, "</include>\n");
+	fclose(f);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void remove_bench_dialplan(void)
+{
+	char path[1024];
+
+	switch_snprintf(path, sizeof(path), "%s%sdialplan_bench.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+	unlink(path);
+}
+
+static switch_caller_extension_t *hunt(switch_core_session_t *session, const char *context, const char *destination_number)
+{
+	switch_dialplan_interface_t *dp;
+	switch_caller_profile_t *profile;
+	switch_caller_extension_t *extension = NULL;
+
+	profile = switch_caller_profile_clone(session, switch_channel_get_caller_profile(switch_core_session_get_channel(session)));
+	profile->context = switch_core_session_strdup(session, context);
+	profile->destination_number = switch_core_session_strdup(session, destination_number);
+
+	if ((dp = switch_loadable_module_get_dialplan_interface("XML"))) {
+		extension = dp->hunt_function(session, NULL, profile);
+		UNPROTECT_INTERFACE(dp);
+	}
+
+	return extension;
+}
+
+FST_CORE_BEGIN("conf")
+{
+	FST_MODULE_BEGIN(mod_dialplan_xml, test_mod_dialplan_xml)
+	{
+		FST_SETUP_BEGIN()
+		{
+			const char *err = NULL;
+			switch_xml_t xml;
+
+			fst_requires(write_bench_dialplan("user") == SWITCH_STATUS_SUCCESS);
+			fst_requires((xml = switch_xml_open_root(1, &err)));
+			switch_xml_free(xml);
+		}
+		FST_SETUP_END()
+
+		FST_TEARDOWN_BEGIN()
+		{
+			remove_bench_dialplan();
+		}
+		FST_TEARDOWN_END()
+
+		FST_SESSION_BEGIN(compiled_matches_plain)
+		{
+			const char *first[] = { "set", "bench=true", "bridge", "user/10000", NULL };
+			const char *last[] = { "set", "bench=true", "bridge", "user/19999", NULL };
+			const char *star[] = { "set", "bench=true", "transfer", "1234", NULL };
+			const char *unknown[] = { "set", "bench=true", "respond", "404", NULL };
+			const char *contexts[] = { "bench", "bench_compiled" };
+			int c;
+
+			for (c = 0; c < 2; c++) {
+				fst_check_extension_apps(first, hunt(fst_session, contexts[c], "10000"));
+				fst_check_extension_apps(last, hunt(fst_session, contexts[c], "19999"));
+				fst_check_extension_apps(star, hunt(fst_session, contexts[c], "*91234"));
+				fst_check_extension_apps(unknown, hunt(fst_session, contexts[c], "1000"));
+				fst_check_extension_apps(unknown, hunt(fst_session, contexts[c], "100000"));
+			}
+		}
+		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(compiled_rebuilt_on_reloadxml)
+		{
+			const char *before[] = { "set", "bench=true", "bridge", "user/15000", NULL };
+			const char *after[] = { "set", "bench=true", "bridge", "sofia/internal/15000", NULL };
+			const char *err = NULL;
+			switch_xml_t xml;
+
+			fst_check_extension_apps(before, hunt(fst_session, "bench_compiled", "15000"));
+
+			fst_requires(write_bench_dialplan("sofia/internal") == SWITCH_STATUS_SUCCESS);
+			fst_requires((xml = switch_xml_open_root(1, &err)));
+			switch_xml_free(xml);
+
+			fst_check_extension_apps(after, hunt(fst_session, "bench_compiled", "15000"));
+		}
+		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(benchmark)
+		{
+			const char *contexts[] = { "bench", "bench_compiled" };
+			int level = SWITCH_LOG_INFO, old_level = -1;
+			switch_time_t took[2];
+			char dest[16];
+			int c, x;
+
+			/* per extension debug logging would swamp the routing itself */
+			switch_core_session_ctl(SCSC_LOGLEVEL, &old_level);
+			switch_core_session_ctl(SCSC_LOGLEVEL, &level);
+
+			/* warm up, the first hunt on the compiled context builds it */
+			hunt(fst_session, contexts[1], "10000");
+
+			for (c = 0; c < 2; c++) {
+				switch_time_t start = switch_time_now();
+
+				for (x = 0; x < BENCH_CALLS; x++) {
+					switch_snprintf(dest, sizeof(dest), "%d", 10000 + (x * 7919) % BENCH_EXTENSIONS);
+					fst_check(hunt(fst_session, contexts[c], dest) != NULL);
+				}
+
+				took[c] = switch_time_now() - start;
+			}
+
+			switch_core_session_ctl(SCSC_LOGLEVEL, &old_level);
+
+			printf("%d calls through %d extensions: %.1f us per call plain, %.1f us per call compiled\n", BENCH_CALLS, BENCH_EXTENSIONS,
+				   took[0] / (double) BENCH_CALLS, took[1] / (double) BENCH_CALLS);
+
+			fst_check(took[1] < took[0]);
+		}
+		FST_SESSION_END()
+	}
+	FST_MODULE_END()
+}
+FST_CORE_END()
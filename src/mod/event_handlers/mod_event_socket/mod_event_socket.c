@@ -77,7 +77,6 @@ struct listener {
 	switch_mutex_t *filter_mutex;
 	uint32_t flags;
 	switch_log_level_t level;
-	char *ebuf;
 	uint8_t event_list[SWITCH_EVENT_ALL + 1];
 	uint8_t allowed_event_list[SWITCH_EVENT_ALL + 1];
 	switch_hash_t *event_hash;
@@ -215,10 +214,10 @@ static void flush_listener(listener_t *listener, switch_bool_t flush_log, switch
 
 	if (flush_events && listener->event_queue) {
 		while (switch_queue_trypop(listener->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
-			switch_event_t *pevent = (switch_event_t *) pop;
+			switch_event_shared_t *pshared = (switch_event_shared_t *) pop;
 			if (!pop)
 				continue;
-			switch_event_destroy(&pevent);
+			switch_event_shared_release(&pshared);
 		}
 	}
 }
@@ -268,7 +267,7 @@ static switch_status_t expire_listener(listener_t ** listener)
 
 static void event_handler(switch_event_t *event)
 {
-	switch_event_t *clone = NULL;
+	switch_event_shared_t *shared = NULL;
 	listener_t *l, *lp, *last = NULL;
 	time_t now = switch_epoch_time_now(NULL);
 	switch_status_t qstatus;
@@ -378,8 +377,8 @@ static void event_handler(switch_event_t *event)
 		}
 
 		if (send) {
-			if (switch_event_dup(&clone, event) == SWITCH_STATUS_SUCCESS) {
-				qstatus = switch_queue_trypush(l->event_queue, clone); 
+			if ((shared = switch_event_share(event))) {
+				qstatus = switch_queue_trypush(l->event_queue, shared);
 				if (qstatus == SWITCH_STATUS_SUCCESS) {
 					if (l->lost_events) {
 						int le = l->lost_events;
@@ -396,7 +395,7 @@ static void event_handler(switch_event_t *event)
 						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Killing listener because of too many lost events. Lost [%d] Queue size[%u/%u]\n", l->lost_events, qsize, MAX_QUEUE_LEN);
 						kill_listener(l, "killed listener because of lost events\n");
 					}
-					switch_event_destroy(&clone);
+					switch_event_shared_release(&shared);
 				}
 			} else {
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(l->session), SWITCH_LOG_ERROR, "Memory Error!\n");
@@ -1010,7 +1009,8 @@ SWITCH_STANDARD_API(event_sink_function)
 		char *id = switch_event_get_header(stream->param_event, "listen-id");
 		uint32_t idl = 0;
 		void *pop;
-		switch_event_t *pevent = NULL;
+		switch_event_shared_t *pshared = NULL;
+		const char *ebuf;
 		cJSON *cj = NULL, *cjevents = NULL;
 
 		if (id) {
@@ -1073,35 +1073,30 @@ SWITCH_STANDARD_API(event_sink_function)
 
 		while (switch_queue_trypop(listener->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
 			//char *etype;
-			pevent = (switch_event_t *) pop;
+			pshared = (switch_event_shared_t *) pop;
 
 			if (listener->format == EVENT_FORMAT_PLAIN) {
 				//etype = "plain";
-				switch_event_serialize(pevent, &listener->ebuf, SWITCH_TRUE);
-				stream->write_function(stream, "<event type=\"plain\">\n%s</event>", listener->ebuf);
+				ebuf = switch_event_shared_serialize(pshared, SWITCH_EVENT_SERIAL_PLAIN);
+				stream->write_function(stream, "<event type=\"plain\">\n%s</event>", switch_str_nil(ebuf));
 			} else if (listener->format == EVENT_FORMAT_JSON) {
 				//etype = "json";
 				cJSON *cjevent = NULL;
 
-				switch_event_serialize_json_obj(pevent, &cjevent);
+				switch_event_serialize_json_obj(switch_event_shared_get_event(pshared), &cjevent);
 				cJSON_AddItemToArray(cjevents, cjevent);
 			} else {
-				switch_xml_t xml;
 				//etype = "xml";
 
-				if ((xml = switch_event_xmlize(pevent, SWITCH_VA_NONE))) {
-					listener->ebuf = switch_xml_toxml(xml, SWITCH_FALSE);
-					switch_xml_free(xml);
-				} else {
+				if (!(ebuf = switch_event_shared_serialize(pshared, SWITCH_EVENT_SERIAL_XML))) {
 					stream->write_function(stream, "<data><reply type=\"error\">XML Render Error</reply></data>\n");
 					break;
 				}
 
-				stream->write_function(stream, "%s\n", listener->ebuf);
+				stream->write_function(stream, "%s\n", ebuf);
 			}
 
-			switch_safe_free(listener->ebuf);
-			switch_event_destroy(&pevent);
+			switch_event_shared_release(&pshared);
 		}
 
 		if (listener->format == EVENT_FORMAT_JSON) {
@@ -1116,8 +1111,8 @@ SWITCH_STANDARD_API(event_sink_function)
 			stream->write_function(stream, " </events>\n</data>\n");
 		}
 
-		if (pevent) {
-			switch_event_destroy(&pevent);
+		if (pshared) {
+			switch_event_shared_release(&pshared);
 		}
 
 		switch_thread_rwlock_unlock(listener->rwlock);
@@ -1385,8 +1380,12 @@ static switch_status_t read_packet(listener_t *listener, switch_event_t **event,
 				switch_channel_t *chan = switch_core_session_get_channel(listener->session);
 				if (switch_channel_get_state(chan) < CS_HANGUP && switch_channel_test_flag(chan, CF_DIVERT_EVENTS)) {
 					switch_event_t *e = NULL;
+					switch_event_shared_t *shared = NULL;
 					while (switch_core_session_dequeue_event(listener->session, &e, SWITCH_TRUE) == SWITCH_STATUS_SUCCESS) {
-						if (switch_queue_trypush(listener->event_queue, e) != SWITCH_STATUS_SUCCESS) {
+						shared = switch_event_share_take(&e);
+						if (switch_queue_trypush(listener->event_queue, shared) != SWITCH_STATUS_SUCCESS) {
+							switch_event_dup(&e, switch_event_shared_get_event(shared));
+							switch_event_shared_release(&shared);
 							switch_core_session_queue_event(listener->session, &e);
 							break;
 						}
@@ -1397,46 +1396,40 @@ static switch_status_t read_packet(listener_t *listener, switch_event_t **event,
 			if (switch_test_flag(listener, LFLAG_EVENTS)) {
 				while (switch_queue_trypop(listener->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
 					char hbuf[512];
-					switch_event_t *pevent = (switch_event_t *) pop;
+					switch_event_shared_t *pshared = (switch_event_shared_t *) pop;
+					const char *ebuf;
 					char *etype;
 
 					do_sleep = 0;
 					if (listener->format == EVENT_FORMAT_PLAIN) {
 						etype = "plain";
-						switch_event_serialize(pevent, &listener->ebuf, SWITCH_TRUE);
+						ebuf = switch_event_shared_serialize(pshared, SWITCH_EVENT_SERIAL_PLAIN);
 					} else if (listener->format == EVENT_FORMAT_JSON) {
 						etype = "json";
-						switch_event_serialize_json(pevent, &listener->ebuf);
+						ebuf = switch_event_shared_serialize(pshared, SWITCH_EVENT_SERIAL_JSON);
 					} else {
-						switch_xml_t xml;
 						etype = "xml";
-
-						if ((xml = switch_event_xmlize(pevent, SWITCH_VA_NONE))) {
-							listener->ebuf = switch_xml_toxml(xml, SWITCH_FALSE);
-							switch_xml_free(xml);
-						} else {
-							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(listener->session), SWITCH_LOG_ERROR, "XML ERROR!\n");
-							goto endloop;
-						}
+						ebuf = switch_event_shared_serialize(pshared, SWITCH_EVENT_SERIAL_XML);
 					}
 
-					switch_assert(listener->ebuf);
+					if (!ebuf) {
+						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(listener->session), SWITCH_LOG_ERROR, "%s render error!\n", etype);
+						goto endloop;
+					}
 
-					len = strlen(listener->ebuf);
+					len = strlen(ebuf);
 
 					switch_snprintf(hbuf, sizeof(hbuf), "Content-Length: %" SWITCH_SSIZE_T_FMT "\n" "Content-Type: text/event-%s\n" "\n", len, etype);
 
 					len = strlen(hbuf);
 					switch_socket_send(listener->sock, hbuf, &len);
 
-					len = strlen(listener->ebuf);
-					switch_socket_send(listener->sock, listener->ebuf, &len);
-
-					switch_safe_free(listener->ebuf);
+					len = strlen(ebuf);
+					switch_socket_send(listener->sock, ebuf, &len);
 
 				  endloop:
 
-					switch_event_destroy(&pevent);
+					switch_event_shared_release(&pshared);
 				}
 			}
 		}
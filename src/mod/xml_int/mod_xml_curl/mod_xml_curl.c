@@ -59,6 +59,9 @@ struct xml_binding {
 	int use_dynamic_url;
 	long auth_scheme;
 	int timeout;
+	int async_fetch;
+	uint32_t max_fetches;
+	uint32_t active;
 };
 
 static int keep_files_around = 0;
@@ -80,13 +83,25 @@ typedef struct hash_node {
 	struct hash_node *next;
 } hash_node_t;
 
+struct xml_curl_fetch;
+
 static struct {
 	switch_memory_pool_t *pool;
 	hash_node_t *hash_root;
 	hash_node_t *hash_tail;
+	CURLM *multi;
+	switch_thread_t *thread;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	struct xml_curl_fetch *queue;
+	struct xml_curl_fetch *queue_tail;
+	struct xml_curl_fetch *active;
+	uint32_t active_count;
+	uint32_t queued;
+	int running;
 } globals;
 
-#define XML_CURL_SYNTAX "[debug_on|debug_off]"
+#define XML_CURL_SYNTAX "[debug_on|debug_off|status]"
 SWITCH_STANDARD_API(xml_curl_function)
 {
 	if (session) {
@@ -101,6 +116,21 @@ SWITCH_STANDARD_API(xml_curl_function)
 		keep_files_around = 1;
 	} else if (!strcasecmp(cmd, "debug_off")) {
 		keep_files_around = 0;
+	} else if (!strcasecmp(cmd, "status")) {
+		switch_xml_fetch_stats_t stats;
+		uint32_t active, queued;
+
+		switch_xml_get_fetch_stats(&stats);
+
+		switch_mutex_lock(globals.mutex);
+		active = globals.active_count;
+		queued = globals.queued;
+		switch_mutex_unlock(globals.mutex);
+
+		stream->write_function(stream, "%u active, %u queued\n", active, queued);
+		stream->write_function(stream, "%" SWITCH_UINT64_T_FMT " fetches, %" SWITCH_UINT64_T_FMT " coalesced, %u in flight\n",
+							   stats.fetches, stats.coalesced, stats.in_flight);
+		return SWITCH_STATUS_SUCCESS;
 	} else {
 		goto usage;
 	}
@@ -137,53 +167,50 @@ static size_t file_callback(void *ptr, size_t size, size_t nmemb, void *data)
 
 
 
-static switch_xml_t xml_url_fetch(const char *section, const char *tag_name, const char *key_name, const char *key_value, switch_event_t *params,
-								  void *user_data)
+/* one request to a gateway, performed either right away or by the fetch thread */
+typedef struct xml_curl_fetch {
+	xml_binding_t *binding;
+	switch_CURL *curl_handle;
+	switch_curl_slist_t *headers;
+	switch_curl_slist_t *slist;
+	struct config_data config_data;
+	char filename[512];
+	char *data;
+	char *uri;
+	char *dynamic_url;
+	switch_xml_fetch_callback_t callback;
+	void *fetch_data;
+	struct xml_curl_fetch *next;
+} xml_curl_fetch_t;
+
+static xml_curl_fetch_t *xml_curl_fetch_create(xml_binding_t *binding, const char *section, const char *tag_name, const char *key_name,
+											   const char *key_value, switch_event_t *params)
 {
-	char filename[512] = "";
+	xml_curl_fetch_t *fetch;
 	switch_CURL *curl_handle = NULL;
-	switch_CURLcode cc;
-	struct config_data config_data;
-	switch_xml_t xml = NULL;
-	char *data = NULL;
 	switch_uuid_t uuid;
 	char uuid_str[SWITCH_UUID_FORMATTED_LENGTH + 1];
-	xml_binding_t *binding = (xml_binding_t *) user_data;
-	char *file_url;
-	switch_curl_slist_t *slist = NULL;
-	long httpRes = 0;
-	switch_curl_slist_t *headers = NULL;
 	char hostname[256] = "";
 	char basic_data[512];
-	char *uri = NULL;
-	char *dynamic_url = NULL;
 
     strncpy(hostname, switch_core_get_switchname(), sizeof(hostname) - 1);
 
-	if (!binding) {
-		return NULL;
-	}
-
-	if ((file_url = strstr(binding->url, "file:"))) {
-		file_url += 5;
-
-		if (!(xml = switch_xml_parse_file(file_url))) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error Parsing Result!\n");
-		}
-
-		return xml;
-	}
+	switch_zmalloc(fetch, sizeof(*fetch));
+	fetch->binding = binding;
 
 	switch_snprintf(basic_data, sizeof(basic_data), "hostname=%s&section=%s&tag_name=%s&key_name=%s&key_value=%s",
 					hostname, section, switch_str_nil(tag_name), switch_str_nil(key_name), switch_str_nil(key_value));
 
-	data = switch_event_build_param_string(params, basic_data, binding->vars_map);
-	switch_assert(data);
+	fetch->data = switch_event_build_param_string(params, basic_data, binding->vars_map);
+	switch_assert(fetch->data);
 
 	if (binding->use_dynamic_url) {
+		switch_event_t *my_params = NULL;
+
 		if (!params) {
-			switch_event_create(&params, SWITCH_EVENT_REQUEST_PARAMS);
-			switch_assert(params);
+			switch_event_create(&my_params, SWITCH_EVENT_REQUEST_PARAMS);
+			switch_assert(my_params);
+			params = my_params;
 		}
 
 		switch_event_add_header_string(params, SWITCH_STACK_TOP, "hostname", hostname);
@@ -191,150 +218,365 @@ static switch_xml_t xml_url_fetch(const char *section, const char *tag_name, con
 		switch_event_add_header_string(params, SWITCH_STACK_TOP, "tag_name", switch_str_nil(tag_name));
 		switch_event_add_header_string(params, SWITCH_STACK_TOP, "key_name", switch_str_nil(key_name));
 		switch_event_add_header_string(params, SWITCH_STACK_TOP, "key_value", switch_str_nil(key_value));
-		dynamic_url = switch_event_expand_headers(params, binding->url);
-		switch_assert(dynamic_url);
+		fetch->dynamic_url = switch_event_expand_headers(params, binding->url);
+		switch_assert(fetch->dynamic_url);
+
+		switch_event_destroy(&my_params);
 	} else {
-		dynamic_url = binding->url;
+		fetch->dynamic_url = binding->url;
 	}
 
 	if (binding->use_get_style == 1) {
-		uri = malloc(strlen(data) + strlen(dynamic_url) + 16);
-		switch_assert(uri);
-		sprintf(uri, "%s%c%s", dynamic_url, strchr(dynamic_url, '?') != NULL ? '&' : '?', data);
+		fetch->uri = malloc(strlen(fetch->data) + strlen(fetch->dynamic_url) + 16);
+		switch_assert(fetch->uri);
+		sprintf(fetch->uri, "%s%c%s", fetch->dynamic_url, strchr(fetch->dynamic_url, '?') != NULL ? '&' : '?', fetch->data);
 	}
 
 	switch_uuid_get(&uuid);
 	switch_uuid_format(uuid_str, &uuid);
 
-	switch_snprintf(filename, sizeof(filename), "%s%s%s.tmp.xml", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR, uuid_str);
-	curl_handle = switch_curl_easy_init();
-	headers = switch_curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
+	switch_snprintf(fetch->filename, sizeof(fetch->filename), "%s%s%s.tmp.xml", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR, uuid_str);
+	fetch->config_data.name = fetch->filename;
+	fetch->config_data.max_bytes = XML_CURL_MAX_BYTES;
+
+	if ((fetch->config_data.fd = open(fetch->filename, O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR)) < 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error Opening temp file!\n");
+		return fetch;
+	}
+
+	fetch->curl_handle = curl_handle = switch_curl_easy_init();
+	fetch->headers = switch_curl_slist_append(fetch->headers, "Content-Type: application/x-www-form-urlencoded");
 
 	if (!strncasecmp(binding->url, "https", 5)) {
 		switch_curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, 0);
 		switch_curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, 0);
 	}
 
-	memset(&config_data, 0, sizeof(config_data));
+	if (!zstr(binding->cred)) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_HTTPAUTH, binding->auth_scheme);
+		switch_curl_easy_setopt(curl_handle, CURLOPT_USERPWD, binding->cred);
+	}
+	switch_curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, fetch->headers);
+	if (binding->method != NULL)
+		switch_curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, binding->method);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_POST, !binding->use_get_style);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_FOLLOWLOCATION, 1);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_MAXREDIRS, 10);
+	if (!binding->use_get_style)
+		switch_curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, fetch->data);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_URL, binding->use_get_style ? fetch->uri : fetch->dynamic_url);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, file_callback);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &fetch->config_data);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, "freeswitch-xml/1.0");
+	switch_curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1);
+	switch_curl_easy_setopt(curl_handle, CURLOPT_PRIVATE, (void *) fetch);
+
+	if (binding->timeout) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, binding->timeout);
+	}
 
-	config_data.name = filename;
-	config_data.max_bytes = XML_CURL_MAX_BYTES;
+	if (binding->disable100continue) {
+		fetch->slist = switch_curl_slist_append(fetch->slist, "Expect:");
+		switch_curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, fetch->slist);
+	}
 
-	if ((config_data.fd = open(filename, O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR)) > -1) {
-		if (!zstr(binding->cred)) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_HTTPAUTH, binding->auth_scheme);
-			switch_curl_easy_setopt(curl_handle, CURLOPT_USERPWD, binding->cred);
-		}
-		switch_curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-		if (binding->method != NULL)
-			switch_curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, binding->method);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_POST, !binding->use_get_style);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_FOLLOWLOCATION, 1);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_MAXREDIRS, 10);
-		if (!binding->use_get_style)
-			switch_curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_URL, binding->use_get_style ? uri : dynamic_url);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, file_callback);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &config_data);
-		switch_curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, "freeswitch-xml/1.0");
-		switch_curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1);
-
-		if (binding->timeout) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, binding->timeout);
-		}
+	if (binding->enable_cacert_check) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, TRUE);
+	}
 
-		if (binding->disable100continue) {
-			slist = switch_curl_slist_append(slist, "Expect:");
-			switch_curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, slist);
-		}
+	if (binding->ssl_cert_file) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_SSLCERT, binding->ssl_cert_file);
+	}
 
-		if (binding->enable_cacert_check) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, TRUE);
-		}
+	if (binding->ssl_key_file) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_SSLKEY, binding->ssl_key_file);
+	}
 
-		if (binding->ssl_cert_file) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_SSLCERT, binding->ssl_cert_file);
-		}
+	if (binding->ssl_key_password) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_SSLKEYPASSWD, binding->ssl_key_password);
+	}
 
-		if (binding->ssl_key_file) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_SSLKEY, binding->ssl_key_file);
+	if (binding->ssl_version) {
+		if (!strcasecmp(binding->ssl_version, "SSLv3")) {
+			switch_curl_easy_setopt(curl_handle, CURLOPT_SSLVERSION, CURL_SSLVERSION_SSLv3);
+		} else if (!strcasecmp(binding->ssl_version, "TLSv1")) {
+			switch_curl_easy_setopt(curl_handle, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1);
 		}
+	}
 
-		if (binding->ssl_key_password) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_SSLKEYPASSWD, binding->ssl_key_password);
-		}
+	if (binding->ssl_cacert_file) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_CAINFO, binding->ssl_cacert_file);
+	}
 
-		if (binding->ssl_version) {
-			if (!strcasecmp(binding->ssl_version, "SSLv3")) {
-				switch_curl_easy_setopt(curl_handle, CURLOPT_SSLVERSION, CURL_SSLVERSION_SSLv3);
-			} else if (!strcasecmp(binding->ssl_version, "TLSv1")) {
-				switch_curl_easy_setopt(curl_handle, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1);
-			}
-		}
+	if (binding->enable_ssl_verifyhost) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, 2);
+	}
 
-		if (binding->ssl_cacert_file) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_CAINFO, binding->ssl_cacert_file);
-		}
+	if (binding->cookie_file) {
+		switch_curl_easy_setopt(curl_handle, CURLOPT_COOKIEJAR, binding->cookie_file);
+		switch_curl_easy_setopt(curl_handle, CURLOPT_COOKIEFILE, binding->cookie_file);
+	}
 
-		if (binding->enable_ssl_verifyhost) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, 2);
-		}
+	if (binding->bind_local) {
+		curl_easy_setopt(curl_handle, CURLOPT_INTERFACE, binding->bind_local);
+	}
 
-		if (binding->cookie_file) {
-			switch_curl_easy_setopt(curl_handle, CURLOPT_COOKIEJAR, binding->cookie_file);
-			switch_curl_easy_setopt(curl_handle, CURLOPT_COOKIEFILE, binding->cookie_file);
-		}
+	return fetch;
+}
 
-		if (binding->bind_local) {
-			curl_easy_setopt(curl_handle, CURLOPT_INTERFACE, binding->bind_local);
-		}
+/* parses what came back and frees the request */
+static switch_xml_t xml_curl_fetch_finish(xml_curl_fetch_t *fetch, switch_CURLcode cc)
+{
+	xml_binding_t *binding = fetch->binding;
+	switch_xml_t xml = NULL;
+	long httpRes = 0;
 
-		cc = switch_curl_easy_perform(curl_handle);
+	if (fetch->curl_handle) {
 		if (cc && cc != CURLE_WRITE_ERROR) {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "CURL returned error:[%d] %s\n", cc, switch_curl_easy_strerror(cc));
 		}
 
-		switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &httpRes);
-		switch_curl_easy_cleanup(curl_handle);
-		switch_curl_slist_free_all(headers);
-		switch_curl_slist_free_all(slist);
-		close(config_data.fd);
-	} else {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error Opening temp file!\n");
+		switch_curl_easy_getinfo(fetch->curl_handle, CURLINFO_RESPONSE_CODE, &httpRes);
+		switch_curl_easy_cleanup(fetch->curl_handle);
+		switch_curl_slist_free_all(fetch->headers);
+		switch_curl_slist_free_all(fetch->slist);
+		close(fetch->config_data.fd);
 	}
 
-	if (config_data.err) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error encountered! [%s]\ndata: [%s]\n", binding->url, data);
+	if (fetch->config_data.err) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error encountered! [%s]\ndata: [%s]\n", binding->url, fetch->data);
 		xml = NULL;
 	} else {
 		if (httpRes == 200) {
-			if (!(xml = switch_xml_parse_file(filename))) {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error Parsing Result! [%s]\ndata: [%s]\n", binding->url, data);
+			if (!(xml = switch_xml_parse_file(fetch->filename))) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error Parsing Result! [%s]\ndata: [%s]\n", binding->url, fetch->data);
 			}
 		} else {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Received HTTP error %ld trying to fetch %s\ndata: [%s]\n", httpRes, binding->url,
-							  data);
+							  fetch->data);
 			xml = NULL;
 		}
 	}
 
 	/* Debug by leaving the file behind for review */
 	if (keep_files_around) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "XML response is in %s\n", filename);
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "XML response is in %s\n", fetch->filename);
 	} else {
-		if (unlink(filename) != 0) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "XML response file [%s] delete failed\n", filename);
+		if (unlink(fetch->filename) != 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "XML response file [%s] delete failed\n", fetch->filename);
 		}
 	}
 
-	switch_safe_free(data);
+	switch_safe_free(fetch->data);
 	if (binding->use_get_style == 1)
-		switch_safe_free(uri);
-	if (binding->use_dynamic_url && dynamic_url != binding->url)
-		switch_safe_free(dynamic_url);
+		switch_safe_free(fetch->uri);
+	if (binding->use_dynamic_url && fetch->dynamic_url != binding->url)
+		switch_safe_free(fetch->dynamic_url);
+	free(fetch);
+
 	return xml;
 }
 
+static switch_xml_t xml_url_fetch(const char *section, const char *tag_name, const char *key_name, const char *key_value, switch_event_t *params,
+								  void *user_data)
+{
+	xml_binding_t *binding = (xml_binding_t *) user_data;
+	xml_curl_fetch_t *fetch;
+	switch_xml_t xml = NULL;
+	switch_CURLcode cc = 0;
+	char *file_url;
+
+	if (!binding) {
+		return NULL;
+	}
+
+	if ((file_url = strstr(binding->url, "file:"))) {
+		file_url += 5;
+
+		if (!(xml = switch_xml_parse_file(file_url))) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error Parsing Result!\n");
+		}
+
+		return xml;
+	}
+
+	fetch = xml_curl_fetch_create(binding, section, tag_name, key_name, key_value, params);
+
+	if (fetch->curl_handle) {
+		cc = switch_curl_easy_perform(fetch->curl_handle);
+	}
+
+	return xml_curl_fetch_finish(fetch, cc);
+}
+
+/* hands the request to the fetch thread, the caller is called back from there */
+static switch_status_t xml_url_fetch_async(const char *section, const char *tag_name, const char *key_name, const char *key_value,
+										   switch_event_t *params, void *user_data, switch_xml_fetch_callback_t callback, void *fetch_data)
+{
+	xml_binding_t *binding = (xml_binding_t *) user_data;
+	xml_curl_fetch_t *fetch;
+
+	if (!binding || !globals.running) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (strstr(binding->url, "file:")) {
+		callback(xml_url_fetch(section, tag_name, key_name, key_value, params, user_data), fetch_data);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	fetch = xml_curl_fetch_create(binding, section, tag_name, key_name, key_value, params);
+
+	if (!fetch->curl_handle) {
+		callback(xml_curl_fetch_finish(fetch, 0), fetch_data);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	fetch->callback = callback;
+	fetch->fetch_data = fetch_data;
+
+	switch_mutex_lock(globals.mutex);
+
+	if (!globals.running) {
+		switch_mutex_unlock(globals.mutex);
+		callback(xml_curl_fetch_finish(fetch, CURLE_ABORTED_BY_CALLBACK), fetch_data);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (globals.queue_tail) {
+		globals.queue_tail->next = fetch;
+	} else {
+		globals.queue = fetch;
+	}
+	globals.queue_tail = fetch;
+	globals.queued++;
+
+	switch_thread_cond_signal(globals.cond);
+	switch_mutex_unlock(globals.mutex);
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+	curl_multi_wakeup(globals.multi);
+#endif
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* call with globals.mutex held, moves whatever the bindings have room for from the queue into the multi handle */
+static void fetch_queue_start(void)
+{
+	xml_curl_fetch_t *fetch, *last = NULL, *next;
+
+	for (fetch = globals.queue; fetch; fetch = next) {
+		xml_binding_t *binding = fetch->binding;
+
+		next = fetch->next;
+
+		if (binding->max_fetches && binding->active >= binding->max_fetches) {
+			last = fetch;
+			continue;
+		}
+
+		if (last) {
+			last->next = next;
+		} else {
+			globals.queue = next;
+		}
+		if (globals.queue_tail == fetch) {
+			globals.queue_tail = last;
+		}
+		globals.queued--;
+
+		fetch->next = globals.active;
+		globals.active = fetch;
+		globals.active_count++;
+		binding->active++;
+		curl_multi_add_handle(globals.multi, fetch->curl_handle);
+	}
+}
+
+/* call with globals.mutex held */
+static void fetch_active_remove(xml_curl_fetch_t *fetch)
+{
+	xml_curl_fetch_t **ptr;
+
+	for (ptr = &globals.active; *ptr; ptr = &(*ptr)->next) {
+		if (*ptr == fetch) {
+			*ptr = fetch->next;
+			break;
+		}
+	}
+
+	fetch->next = NULL;
+	globals.active_count--;
+	fetch->binding->active--;
+	curl_multi_remove_handle(globals.multi, fetch->curl_handle);
+}
+
+static void *SWITCH_THREAD_FUNC fetch_thread_run(switch_thread_t *thread, void *obj)
+{
+	xml_curl_fetch_t *fetch;
+	CURLMsg *msg;
+	int running_handles = 0, left = 0;
+
+	switch_mutex_lock(globals.mutex);
+
+	while (globals.running) {
+		if (!globals.active && !globals.queue) {
+			switch_thread_cond_wait(globals.cond, globals.mutex);
+			continue;
+		}
+
+		fetch_queue_start();
+		switch_mutex_unlock(globals.mutex);
+
+		curl_multi_perform(globals.multi, &running_handles);
+
+		while ((msg = curl_multi_info_read(globals.multi, &left))) {
+			if (msg->msg != CURLMSG_DONE) {
+				continue;
+			}
+
+			fetch = NULL;
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **) &fetch);
+
+			switch_mutex_lock(globals.mutex);
+			fetch_active_remove(fetch);
+			switch_mutex_unlock(globals.mutex);
+
+			fetch->callback(xml_curl_fetch_finish(fetch, msg->data.result), fetch->fetch_data);
+		}
+
+		if (running_handles) {
+#if LIBCURL_VERSION_NUM >= 0x074400
+			curl_multi_poll(globals.multi, NULL, 0, 1000, NULL);
+#else
+			curl_multi_wait(globals.multi, NULL, 0, 10, NULL);
+#endif
+		}
+
+		switch_mutex_lock(globals.mutex);
+	}
+
+	/* nobody is going to answer these anymore */
+	while ((fetch = globals.active) || (fetch = globals.queue)) {
+		if (fetch == globals.active) {
+			fetch_active_remove(fetch);
+		} else {
+			globals.queue = fetch->next;
+			globals.queued--;
+		}
+
+		switch_mutex_unlock(globals.mutex);
+		fetch->callback(xml_curl_fetch_finish(fetch, CURLE_ABORTED_BY_CALLBACK), fetch->fetch_data);
+		switch_mutex_lock(globals.mutex);
+	}
+	globals.queue_tail = NULL;
+
+	switch_mutex_unlock(globals.mutex);
+
+	return NULL;
+}
+
 #define ENABLE_PARAM_VALUE "enabled"
 static switch_status_t do_config(void)
 {
@@ -364,6 +606,10 @@ static switch_status_t do_config(void)
 		char *method = NULL;
 		int disable100continue = 1;
 		int use_dynamic_url = 0, timeout = 0;
+		int async_fetch = 1;
+		uint32_t max_fetches = 0;
+		char *coalesce_sections = NULL;
+		switch_xml_binding_t *xml_binding = NULL;
 		uint32_t enable_cacert_check = 0;
 		char *ssl_cert_file = NULL;
 		char *ssl_key_file = NULL;
@@ -452,6 +698,17 @@ static switch_status_t do_config(void)
 				}
 			} else if (!strcasecmp(var, "bind-local")) {
 				bind_local = val;
+			} else if (!strcasecmp(var, "async-fetch")) {
+				async_fetch = switch_true(val);
+			} else if (!strcasecmp(var, "max-concurrent-fetches")) {
+				int tmp = atoi(val);
+				if (tmp >= 0) {
+					max_fetches = (uint32_t) tmp;
+				} else {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Can't set a negative max-concurrent-fetches!\n");
+				}
+			} else if (!strcasecmp(var, "coalesce-sections")) {
+				coalesce_sections = val;
 			}
 		}
 
@@ -471,6 +728,8 @@ static switch_status_t do_config(void)
 
 		binding->auth_scheme = auth_scheme;
 		binding->timeout = timeout;
+		binding->async_fetch = async_fetch;
+		binding->max_fetches = max_fetches;
 		binding->url = switch_core_strdup(globals.pool, url);
 		switch_assert(binding->url);
 
@@ -542,7 +801,15 @@ static switch_status_t do_config(void)
 
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Binding [%s] XML Fetch Function [%s] [%s]\n",
 						  zstr(bname) ? "N/A" : bname, binding->url, binding->bindings ? binding->bindings : "all");
-		switch_xml_bind_search_function(xml_url_fetch, switch_xml_parse_section_string(binding->bindings), binding);
+		switch_xml_bind_search_function_ret(xml_url_fetch, switch_xml_parse_section_string(binding->bindings), binding, &xml_binding);
+
+		if (xml_binding && binding->async_fetch) {
+			switch_xml_set_binding_async_function(xml_binding, xml_url_fetch_async);
+
+			if (coalesce_sections) {
+				switch_xml_set_binding_coalesce_sections(xml_binding, switch_xml_parse_section_string(coalesce_sections));
+			}
+		}
 		x++;
 		binding = NULL;
 	}
@@ -556,6 +823,7 @@ static switch_status_t do_config(void)
 SWITCH_MODULE_LOAD_FUNCTION(mod_xml_curl_load)
 {
 	switch_api_interface_t *xml_curl_api_interface;
+	switch_threadattr_t *thd_attr = NULL;
 
 	/* connect my internal structure to the blank pointer passed to me */
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
@@ -565,13 +833,25 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_xml_curl_load)
 	globals.hash_root = NULL;
 	globals.hash_tail = NULL;
 
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&globals.cond, pool);
+	globals.multi = curl_multi_init();
+	globals.running = 1;
+
 	if (do_config() != SWITCH_STATUS_SUCCESS) {
+		globals.running = 0;
+		curl_multi_cleanup(globals.multi);
 		return SWITCH_STATUS_FALSE;
 	}
 
+	switch_threadattr_create(&thd_attr, pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+	switch_thread_create(&globals.thread, thd_attr, fetch_thread_run, NULL, pool);
+
 	SWITCH_ADD_API(xml_curl_api_interface, "xml_curl", "XML Curl", xml_curl_function, XML_CURL_SYNTAX);
 	switch_console_set_complete("add xml_curl debug_on");
 	switch_console_set_complete("add xml_curl debug_off");
+	switch_console_set_complete("add xml_curl status");
 
 	/* indicate that the module should continue to be loaded */
 	return SWITCH_STATUS_SUCCESS;
@@ -580,6 +860,24 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_xml_curl_load)
 SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_xml_curl_shutdown)
 {
 	hash_node_t *ptr = NULL;
+	switch_status_t st;
+
+	switch_xml_unbind_search_function_ptr(xml_url_fetch);
+
+	switch_mutex_lock(globals.mutex);
+	globals.running = 0;
+	switch_thread_cond_signal(globals.cond);
+	switch_mutex_unlock(globals.mutex);
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+	curl_multi_wakeup(globals.multi);
+#endif
+
+	if (globals.thread) {
+		switch_thread_join(&st, globals.thread);
+	}
+
+	curl_multi_cleanup(globals.multi);
 
 	while (globals.hash_root) {
 		ptr = globals.hash_root;
@@ -588,8 +886,6 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_xml_curl_shutdown)
 		switch_safe_free(ptr);
 	}
 
-	switch_xml_unbind_search_function_ptr(xml_url_fetch);
-
 	return SWITCH_STATUS_SUCCESS;
 }
 
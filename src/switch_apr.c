@@ -974,6 +974,151 @@ SWITCH_DECLARE(switch_status_t) switch_socket_recvfrom(switch_sockaddr_t *from,
 	return (switch_status_t)r;
 }
 
+#ifdef HAVE_RECVMMSG
+static void switch_sockaddr_vars_set(switch_sockaddr_t *addr)
+{
+	addr->family = addr->sa.sin.sin_family;
+	addr->port = ntohs(addr->sa.sin.sin_port);
+
+	if (addr->family == APR_INET) {
+		addr->salen = sizeof(struct sockaddr_in);
+		addr->addr_str_len = 16;
+		addr->ipaddr_ptr = &(addr->sa.sin.sin_addr);
+		addr->ipaddr_len = sizeof(struct in_addr);
+	}
+#if APR_HAVE_IPV6
+	else if (addr->family == APR_INET6) {
+		addr->salen = sizeof(struct sockaddr_in6);
+		addr->addr_str_len = 46;
+		addr->ipaddr_ptr = &(addr->sa.sin6.sin6_addr);
+		addr->ipaddr_len = sizeof(struct in6_addr);
+	}
+#endif
+}
+#endif
+
+SWITCH_DECLARE(switch_status_t) switch_socket_recvmmsg(switch_socket_t *sock, switch_socket_msg_t *msgs, uint32_t *count)
+{
+#ifdef HAVE_RECVMMSG
+	struct mmsghdr hdrs[64];
+	struct iovec iovs[64];
+	int fd, r, i;
+	uint32_t want = *count;
+
+	*count = 0;
+
+	if (!sock || (fd = switch_socket_fd_get(sock)) < 0) {
+		return SWITCH_STATUS_GENERR;
+	}
+
+	if (want > 64) {
+		want = 64;
+	}
+
+	memset(hdrs, 0, sizeof(hdrs[0]) * want);
+
+	for (i = 0; i < (int) want; i++) {
+		iovs[i].iov_base = msgs[i].buf;
+		iovs[i].iov_len = msgs[i].len;
+		hdrs[i].msg_hdr.msg_iov = &iovs[i];
+		hdrs[i].msg_hdr.msg_iovlen = 1;
+		hdrs[i].msg_hdr.msg_name = &msgs[i].addr->sa;
+		hdrs[i].msg_hdr.msg_namelen = sizeof(msgs[i].addr->sa);
+	}
+
+	do {
+		r = recvmmsg(fd, hdrs, want, MSG_DONTWAIT, NULL);
+	} while (r == -1 && errno == EINTR);
+
+	if (r <= 0) {
+		return (r == -1 && errno != EAGAIN && errno != EWOULDBLOCK) ? SWITCH_STATUS_GENERR : SWITCH_STATUS_BREAK;
+	}
+
+	for (i = 0; i < r; i++) {
+		msgs[i].len = hdrs[i].msg_len;
+		switch_sockaddr_vars_set(msgs[i].addr);
+	}
+
+	*count = (uint32_t) r;
+
+	return SWITCH_STATUS_SUCCESS;
+#else
+	switch_status_t status = SWITCH_STATUS_BREAK;
+	uint32_t i;
+
+	for (i = 0; i < *count; i++) {
+		if (switch_socket_recvfrom(msgs[i].addr, sock, 0, msgs[i].buf, &msgs[i].len) != SWITCH_STATUS_SUCCESS || !msgs[i].len) {
+			break;
+		}
+		status = SWITCH_STATUS_SUCCESS;
+	}
+
+	*count = i;
+
+	return status;
+#endif
+}
+
+SWITCH_DECLARE(switch_status_t) switch_socket_sendmmsg(switch_socket_t *sock, switch_socket_msg_t *msgs, uint32_t *count)
+{
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr hdrs[64];
+	struct iovec iovs[64];
+	int fd, r, i;
+	uint32_t want = *count, sent = 0, batch;
+
+	*count = 0;
+
+	if (!sock || (fd = switch_socket_fd_get(sock)) < 0) {
+		return SWITCH_STATUS_GENERR;
+	}
+
+	while (sent < want) {
+		batch = want - sent > 64 ? 64 : want - sent;
+
+		memset(hdrs, 0, sizeof(hdrs[0]) * batch);
+
+		for (i = 0; i < (int) batch; i++) {
+			switch_socket_msg_t *msg = &msgs[sent + i];
+
+			iovs[i].iov_base = msg->buf;
+			iovs[i].iov_len = msg->len;
+			hdrs[i].msg_hdr.msg_iov = &iovs[i];
+			hdrs[i].msg_hdr.msg_iovlen = 1;
+			hdrs[i].msg_hdr.msg_name = &msg->addr->sa;
+			hdrs[i].msg_hdr.msg_namelen = msg->addr->salen;
+		}
+
+		do {
+			r = sendmmsg(fd, hdrs, batch, 0);
+		} while (r == -1 && errno == EINTR);
+
+		if (r <= 0) {
+			break;
+		}
+
+		sent += r;
+	}
+
+	*count = sent;
+
+	return sent == want ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_GENERR;
+#else
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	uint32_t i;
+
+	for (i = 0; i < *count; i++) {
+		if ((status = switch_socket_sendto(sock, msgs[i].addr, 0, msgs[i].buf, &msgs[i].len)) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+	}
+
+	*count = i;
+
+	return status;
+#endif
+}
+
 /* poll stubs */
 
 SWITCH_DECLARE(switch_status_t) switch_pollset_create(switch_pollset_t ** pollset, uint32_t size, switch_memory_pool_t *pool, uint32_t flags)
@@ -583,6 +583,7 @@ static int comp_callback(void *pArg, int argc, char **argv, char **columnNames)
 
 struct match_helper {
 	switch_console_callback_match_t *my_matches;
+	const char *prefix;
 };
 
 static int modulename_callback(void *pArg, const char *module_name)
@@ -659,36 +660,20 @@ static int uuid_callback(void *pArg, int argc, char **argv, char **columnNames)
 {
 	struct match_helper *h = (struct match_helper *) pArg;
 
-	switch_console_push_match(&h->my_matches, argv[0]);
+	if (zstr(h->prefix) || !strncmp(argv[0], h->prefix, strlen(h->prefix))) {
+		switch_console_push_match(&h->my_matches, argv[0]);
+	}
 	return 0;
 
 }
 
 SWITCH_DECLARE_NONSTD(switch_status_t) switch_console_list_uuid(const char *line, const char *cursor, switch_console_callback_match_t **matches)
 {
-	char *sql;
 	struct match_helper h = { 0 };
-	switch_cache_db_handle_t *db = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
-	char *errmsg;
 
-
-	if (switch_core_db_handle(&db) != SWITCH_STATUS_SUCCESS) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Database Error\n");
-		return SWITCH_STATUS_GENERR;
-	}
-
-	if (!zstr(cursor)) {
-		sql = switch_mprintf("select distinct uuid from channels where uuid like '%q%%' and hostname='%q' order by uuid",
-							 cursor, switch_core_get_switchname());
-	} else {
-		sql = switch_mprintf("select distinct uuid from channels where hostname='%q' order by uuid", switch_core_get_switchname());
-	}
-
-	switch_cache_db_execute_sql_callback(db, sql, uuid_callback, &h, &errmsg);
-	free(sql);
-
-	switch_cache_db_release_db_handle(&db);
+	h.prefix = cursor;
+	switch_core_channel_registry_query(SCR_VIEW_CHANNELS, NULL, uuid_callback, &h);
 
 	if (h.my_matches) {
 		*matches = h.my_matches;
@@ -1962,6 +1962,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 	switch_core_set_serial();
 #endif
 	switch_console_init(runtime.memory_pool);
+	switch_regex_init(runtime.memory_pool);
 	switch_event_init(runtime.memory_pool);
 	switch_channel_global_init(runtime.memory_pool);
 
@@ -2164,6 +2165,12 @@ static void switch_load_core_config(const char *file)
 					} else {
 						switch_clear_flag((&runtime), SCF_AUTO_SCHEMAS);
 					}
+				} else if (!strcasecmp(var, "core-channels-sql")) {
+					if (switch_true(val)) {
+						switch_clear_flag((&runtime), SCF_NO_CHANNEL_SQL);
+					} else {
+						switch_set_flag((&runtime), SCF_NO_CHANNEL_SQL);
+					}
 				} else if (!strcasecmp(var, "session-thread-pool")) {
 					if (switch_true(val)) {
 						switch_set_flag((&runtime), SCF_SESSION_THREAD_POOL);
@@ -2245,6 +2252,8 @@ static void switch_load_core_config(const char *file)
 					switch_time_set_cond_yield(switch_true(val));
 				} else if (!strcasecmp(var, "enable-timer-matrix")) {
 					switch_time_set_matrix(switch_true(val));
+				} else if (!strcasecmp(var, "enable-softtimer-wheel")) {
+					switch_time_set_wheel(switch_true(val));
 				} else if (!strcasecmp(var, "max-sessions") && !zstr(val)) {
 					switch_core_session_limit(atoi(val));
 				} else if (!strcasecmp(var, "verbose-channel-events") && !zstr(val)) {
@@ -2309,6 +2318,18 @@ static void switch_load_core_config(const char *file)
 					switch_rtp_set_start_port((switch_port_t) atoi(val));
 				} else if (!strcasecmp(var, "rtp-end-port") && !zstr(val)) {
 					switch_rtp_set_end_port((switch_port_t) atoi(val));
+				} else if (!strcasecmp(var, "rtp-io-threads") && !zstr(val)) {
+					switch_rtp_set_io_threads((uint32_t) atoi(val));
+				} else if (!strcasecmp(var, "regex-cache-size") && !zstr(val)) {
+					switch_regex_cache_set_max((uint32_t) atoi(val));
+				} else if (!strcasecmp(var, "xml-cache-size") && !zstr(val)) {
+					switch_xml_cache_set_max((uint32_t) atoi(val));
+				} else if (!strcasecmp(var, "xml-cache-negative-ttl") && !zstr(val)) {
+					switch_xml_cache_set_negative_ttl((uint32_t) atoi(val));
+				} else if (!strcasecmp(var, "memory-pool-recycle") && !zstr(val)) {
+					switch_core_memory_pool_set_recycle((uint32_t) atoi(val));
+				} else if (!strcasecmp(var, "memory-pool-stats")) {
+					switch_core_memory_pool_set_stats(switch_true(val));
 				} else if (!strcasecmp(var, "rtp-port-usage-robustness") && switch_true(val)) {
 					runtime.port_alloc_flags |= SPF_ROBUST_UDP;
 				} else if (!strcasecmp(var, "core-db-name") && !zstr(val)) {
@@ -2966,6 +2987,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_destroy(void)
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Finalizing Shutdown.\n");
 	switch_log_shutdown();
+	switch_regex_shutdown();
 
 	switch_core_session_uninit();
 	switch_core_unset_variables();
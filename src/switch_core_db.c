@@ -38,7 +38,7 @@
 static void db_pick_path(const char *dbname, char *buf, switch_size_t size)
 {
 	memset(buf, 0, size);
-	if (switch_is_file_path(dbname)) {
+	if (switch_is_file_path(dbname) || !strcmp(dbname, ":memory:")) {
 		strncpy(buf, dbname, size);
 	} else {
 		switch_snprintf(buf, size, "%s%s%s.db", SWITCH_GLOBAL_dirs.db_dir, SWITCH_PATH_SEPARATOR, dbname);
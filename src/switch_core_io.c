@@ -404,6 +404,12 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 	}
 
 
+	/* the caller only wants to look at the packet, hand it back as it came in unless a bug needs to hear it */
+	if (status == SWITCH_STATUS_SUCCESS && need_codec && (flags & SWITCH_IO_FLAG_NO_DECODE) && !is_cng && !session->bugs) {
+		switch_set_flag((*frame), SFF_ENCODED);
+		goto done;
+	}
+
 	if (status == SWITCH_STATUS_SUCCESS && need_codec) {
 		switch_frame_t *enc_frame, *read_frame = *frame;
 
@@ -9330,6 +9330,11 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_activate_rtp(switch_core_sessi
 			if (v_engine->tmmbr) {
 				flags[SWITCH_RTP_FLAG_TMMBR]++;
 			}
+
+			if (switch_media_handle_test_media_flag(smh, SCMF_RTP_TX_BATCH)
+				|| ((val = switch_channel_get_variable(session->channel, "rtp_tx_batch")) && switch_true(val))) {
+				flags[SWITCH_RTP_FLAG_TX_BATCH]++;
+			}
 			
 			v_engine->rtp_session = switch_rtp_new(a_engine->local_sdp_ip,
 														 v_engine->local_sdp_port,
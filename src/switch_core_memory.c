@@ -49,6 +49,14 @@
 #ifndef DEBUG_ALLOC_CUTOFF
 #define DEBUG_ALLOC_CUTOFF 500
 #endif
+/* what the allocator of a recycled pool keeps of the blocks it had, the rest goes back to the system */
+#define POOL_RECYCLE_MAX_FREE (256 * 1024)
+#define POOL_STATS_KEY "_pool_stats_"
+
+typedef struct pool_stats_node_s {
+	switch_memory_pool_stats_t stats;
+	struct pool_stats_node_s *next;
+} pool_stats_node_t;
 
 static struct {
 #ifdef USE_MEM_LOCK
@@ -58,8 +66,114 @@ static struct {
 	switch_queue_t *pool_recycle_queue;
 	switch_memory_pool_t *memory_pool;
 	int pool_thread_running;
+	uint32_t recycle_max;		/* cleared pools kept for reuse, at most */
+	switch_mutex_t *stats_mutex;
+	switch_hash_t *stats_hash;	/* pool_stats_node_t by the tag pools were created with */
+	pool_stats_node_t *stats_head;
+	pool_stats_node_t *stats_tail;
+	int stats;
 } memory_manager;
 
+/* the counters of the pool, NULL unless pool stats were on when it was created */
+static switch_memory_pool_stats_t *pool_stats(switch_memory_pool_t *pool)
+{
+	void *data = NULL;
+
+	apr_pool_userdata_get(&data, POOL_STATS_KEY, pool);
+
+	return (switch_memory_pool_stats_t *) data;
+}
+
+static void pool_stats_alloc(switch_memory_pool_t *pool, switch_size_t memory)
+{
+	switch_memory_pool_stats_t *stats;
+
+	if (memory_manager.stats && (stats = pool_stats(pool))) {
+		switch_mutex_lock(memory_manager.stats_mutex);
+		stats->allocs++;
+		stats->bytes += memory;
+		switch_mutex_unlock(memory_manager.stats_mutex);
+	}
+}
+
+static void pool_stats_create(switch_memory_pool_t *pool, const char *tag, switch_bool_t recycled)
+{
+	pool_stats_node_t *node;
+
+	if (!memory_manager.stats) {
+		return;
+	}
+
+	switch_mutex_lock(memory_manager.stats_mutex);
+
+	if (!(node = switch_core_hash_find(memory_manager.stats_hash, tag))) {
+		node = apr_pcalloc(memory_manager.memory_pool, sizeof(*node));
+		node->stats.tag = apr_pstrdup(memory_manager.memory_pool, tag);
+		switch_core_hash_insert(memory_manager.stats_hash, node->stats.tag, node);
+
+		if (memory_manager.stats_tail) {
+			memory_manager.stats_tail->next = node;
+		} else {
+			memory_manager.stats_head = node;
+		}
+		memory_manager.stats_tail = node;
+	}
+
+	node->stats.created++;
+	node->stats.live++;
+	if (recycled) {
+		node->stats.recycled++;
+	}
+
+	switch_mutex_unlock(memory_manager.stats_mutex);
+
+	apr_pool_userdata_setn(&node->stats, POOL_STATS_KEY, NULL, pool);
+}
+
+static void pool_stats_destroy(switch_memory_pool_t *pool)
+{
+	switch_memory_pool_stats_t *stats;
+
+	if ((stats = pool_stats(pool))) {
+		switch_mutex_lock(memory_manager.stats_mutex);
+		if (stats->live) {
+			stats->live--;
+		}
+		switch_mutex_unlock(memory_manager.stats_mutex);
+	}
+}
+
+SWITCH_DECLARE(void) switch_core_memory_pool_set_recycle(uint32_t max)
+{
+	memory_manager.recycle_max = max;
+}
+
+SWITCH_DECLARE(void) switch_core_memory_pool_set_stats(switch_bool_t on)
+{
+	memory_manager.stats = on ? 1 : 0;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_memory_pool_get_stats(uint32_t index, switch_memory_pool_stats_t *stats)
+{
+	pool_stats_node_t *node;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	switch_mutex_lock(memory_manager.stats_mutex);
+
+	for (node = memory_manager.stats_head; node && index; node = node->next) {
+		index--;
+	}
+
+	if (node) {
+		*stats = node->stats;
+		status = SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_unlock(memory_manager.stats_mutex);
+
+	return status;
+}
+
 SWITCH_DECLARE(switch_memory_pool_t *) switch_core_session_get_pool(switch_core_session_t *session)
 {
 	switch_assert(session != NULL);
@@ -92,6 +206,7 @@ SWITCH_DECLARE(void *) switch_core_perform_session_alloc(switch_core_session_t *
 	switch_assert(ptr != NULL);
 
 	memset(ptr, 0, memory);
+	pool_stats_alloc(session->pool, memory);
 
 #ifdef LOCK_MORE
 #ifdef USE_MEM_LOCK
@@ -203,6 +318,9 @@ SWITCH_DECLARE(char *) switch_core_vsprintf(switch_memory_pool_t *pool, const ch
 
 	result = apr_pvsprintf(pool, fmt, ap);
 	switch_assert(result != NULL);
+	if (memory_manager.stats) {
+		pool_stats_alloc(pool, strlen(result) + 1);
+	}
 
 #ifdef LOCK_MORE
 #ifdef USE_MEM_LOCK
@@ -258,6 +376,9 @@ SWITCH_DECLARE(char *) switch_core_perform_session_strdup(switch_core_session_t
 
 	duped = apr_pstrdup(session->pool, todup);
 	switch_assert(duped != NULL);
+	if (memory_manager.stats) {
+		pool_stats_alloc(session->pool, strlen(duped) + 1);
+	}
 
 #ifdef LOCK_MORE
 #ifdef USE_MEM_LOCK
@@ -297,6 +418,7 @@ SWITCH_DECLARE(char *) switch_core_perform_strdup(switch_memory_pool_t *pool, co
 
 	duped = apr_pstrmemdup(pool, todup, len);
 	switch_assert(duped != NULL);
+	pool_stats_alloc(pool, len);
 
 #ifdef LOCK_MORE
 #ifdef USE_MEM_LOCK
@@ -330,7 +452,17 @@ SWITCH_DECLARE(void) switch_pool_clear(switch_memory_pool_t *p)
 {
 #ifdef PER_POOL_LOCK
 	apr_thread_mutex_t *my_mutex;
+	apr_allocator_t *my_allocator = apr_pool_allocator_get(p);
+
+	/* the mutex lives in the pool, so an allocator the pool owns must not use it while the pool is cleared */
+	if (my_allocator && apr_allocator_owner_get(my_allocator) != p) {
+		my_allocator = NULL;
+	}
+
 	apr_pool_mutex_set(p, NULL);
+	if (my_allocator) {
+		apr_allocator_mutex_set(my_allocator, NULL);
+	}
 #endif
 
 	apr_pool_clear(p);
@@ -342,6 +474,9 @@ SWITCH_DECLARE(void) switch_pool_clear(switch_memory_pool_t *p)
 	}
 
 	apr_pool_mutex_set(p, my_mutex);
+	if (my_allocator) {
+		apr_allocator_mutex_set(my_allocator, my_mutex);
+	}
 
 #endif
 
@@ -352,6 +487,7 @@ SWITCH_DECLARE(void) switch_pool_clear(switch_memory_pool_t *p)
 SWITCH_DECLARE(switch_status_t) switch_core_perform_new_memory_pool(switch_memory_pool_t **pool, const char *file, const char *func, int line)
 {
 	char *tmp;
+	switch_bool_t recycled = SWITCH_FALSE;
 #ifdef INSTANTLY_DESTROY_POOLS
 	apr_pool_create(pool, NULL);
 	switch_assert(*pool != NULL);
@@ -360,20 +496,19 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_new_memory_pool(switch_memor
 #ifdef PER_POOL_LOCK
 	apr_allocator_t *my_allocator = NULL;
 	apr_thread_mutex_t *my_mutex;
-#else
-	void *pop = NULL;
 #endif
+	void *pop = NULL;
 
 #ifdef USE_MEM_LOCK
 	switch_mutex_lock(memory_manager.mem_lock);
 #endif
 	switch_assert(pool != NULL);
 
-#ifndef PER_POOL_LOCK
+	/* a pool pool_thread already cleared, with its allocator and the blocks it kept */
 	if (switch_queue_trypop(memory_manager.pool_recycle_queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
 		*pool = (switch_memory_pool_t *) pop;
+		recycled = SWITCH_TRUE;
 	} else {
-#endif
 
 #ifdef PER_POOL_LOCK
 		if ((apr_allocator_create(&my_allocator)) != APR_SUCCESS) {
@@ -396,12 +531,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_new_memory_pool(switch_memor
 #else
 		apr_pool_create(pool, NULL);
 		switch_assert(*pool != NULL);
-	}
 #endif
+	}
 #endif
 
 	tmp = switch_core_sprintf(*pool, "%s:%d", file, line);
 	apr_pool_tag(*pool, tmp);
+	pool_stats_create(*pool, tmp, recycled);
 
 #ifdef DEBUG_ALLOC2
 	switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_CONSOLE, "%p New Pool %s\n", (void *) *pool, apr_pool_tag(*pool, NULL));
@@ -423,6 +559,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_destroy_memory_pool(switch_m
 	switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_CONSOLE, "%p Free Pool %s\n", (void *) *pool, apr_pool_tag(*pool, NULL));
 #endif
 
+	pool_stats_destroy(*pool);
+
 #ifdef INSTANTLY_DESTROY_POOLS
 #ifdef USE_MEM_LOCK
 	switch_mutex_lock(memory_manager.mem_lock);
@@ -470,6 +608,7 @@ SWITCH_DECLARE(void *) switch_core_perform_alloc(switch_memory_pool_t *pool, swi
 	ptr = apr_palloc(pool, memory);
 	switch_assert(ptr != NULL);
 	memset(ptr, 0, memory);
+	pool_stats_alloc(pool, memory);
 
 #ifdef LOCK_MORE
 #ifdef USE_MEM_LOCK
@@ -482,7 +621,7 @@ SWITCH_DECLARE(void *) switch_core_perform_alloc(switch_memory_pool_t *pool, swi
 
 SWITCH_DECLARE(void) switch_core_memory_reclaim(void)
 {
-#if !defined(PER_POOL_LOCK) && !defined(INSTANTLY_DESTROY_POOLS)
+#ifndef INSTANTLY_DESTROY_POOLS
 	switch_memory_pool_t *pool;
 	void *pop = NULL;
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %d recycled memory pool(s)\n",
@@ -505,6 +644,23 @@ SWITCH_DECLARE(void) switch_core_memory_reclaim(void)
 	return;
 }
 
+#if defined(PER_POOL_LOCK) && !defined(INSTANTLY_DESTROY_POOLS)
+/* clears a pool for switch_core_perform_new_memory_pool() to hand out again instead of creating one, while there are fewer than recycle_max */
+static switch_bool_t pool_recycle(switch_memory_pool_t *pool)
+{
+	if (!memory_manager.recycle_max || switch_queue_size(memory_manager.pool_recycle_queue) >= memory_manager.recycle_max) {
+		return SWITCH_FALSE;
+	}
+
+	switch_pool_clear(pool);
+	apr_allocator_max_free_set(apr_pool_allocator_get(pool), POOL_RECYCLE_MAX_FREE);
+
+	return switch_queue_trypush(memory_manager.pool_recycle_queue, pool) == SWITCH_STATUS_SUCCESS;
+}
+#else
+#define pool_recycle(_pool) SWITCH_FALSE
+#endif
+
 static void *SWITCH_THREAD_FUNC pool_thread(switch_thread_t *thread, void *obj)
 {
 	memory_manager.pool_thread_running = 1;
@@ -533,7 +689,9 @@ static void *SWITCH_THREAD_FUNC pool_thread(switch_thread_t *thread, void *obj)
 #ifdef DEBUG_ALLOC
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "%p DESTROY POOL\n", (void *) pop);
 #endif
-				apr_pool_destroy(pop);
+				if (!pool_recycle(pop)) {
+					apr_pool_destroy(pop);
+				}
 #ifdef USE_MEM_LOCK
 				switch_mutex_unlock(memory_manager.mem_lock);
 #endif
@@ -655,6 +813,10 @@ switch_memory_pool_t *switch_core_memory_init(void)
 	switch_mutex_init(&memory_manager.mem_lock, SWITCH_MUTEX_NESTED, memory_manager.memory_pool);
 #endif
 
+	memory_manager.recycle_max = 100;
+	switch_mutex_init(&memory_manager.stats_mutex, SWITCH_MUTEX_NESTED, memory_manager.memory_pool);
+	switch_core_hash_init(&memory_manager.stats_hash);
+
 #ifdef INSTANTLY_DESTROY_POOLS
 	{
 		void *foo;
@@ -118,13 +118,90 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_codec_slin(switch_core_s
 }
 
 
+/* The session table is split by uuid hash so lookups of different sessions do not serialize on one lock.  Lookups
+   and walks take a shard's read lock, only inserts, removals and renames take its write lock. */
+
+static switch_session_shard_t *session_shard(const char *uuid_str)
+{
+	uint32_t hash = 2166136261U;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *) uuid_str; *p; p++) {
+		hash = (hash ^ *p) * 16777619U;
+	}
+
+	return &session_manager.shards[hash % SWITCH_SESSION_SHARDS];
+}
+
+static void session_shard_rdlock(switch_session_shard_t *shard)
+{
+	if (switch_thread_rwlock_tryrdlock(shard->rwlock) != SWITCH_STATUS_SUCCESS) {
+		switch_time_t start = switch_time_ref();
+
+		switch_thread_rwlock_rdlock(shard->rwlock);
+		switch_atomic_inc(&shard->contended);
+		switch_atomic_add(&shard->wait_usec, (uint32_t) (switch_time_ref() - start));
+	}
+
+	switch_atomic_inc(&shard->reads);
+}
+
+static switch_time_t session_shard_wrlock(switch_session_shard_t *shard)
+{
+	switch_thread_rwlock_wrlock(shard->rwlock);
+	return switch_time_ref();
+}
+
+static void session_shard_wrunlock(switch_session_shard_t *shard, switch_time_t locked)
+{
+	switch_time_t held = switch_time_ref() - locked;
+
+	shard->writes++;
+	shard->hold_usec += held;
+	if (held > shard->max_hold_usec) {
+		shard->max_hold_usec = held;
+	}
+
+	switch_thread_rwlock_unlock(shard->rwlock);
+}
+
+SWITCH_DECLARE(uint32_t) switch_core_session_shard_count(void)
+{
+	return SWITCH_SESSION_SHARDS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_session_get_shard_stats(uint32_t index, switch_session_shard_stats_t *stats)
+{
+	switch_session_shard_t *shard;
+
+	if (index >= SWITCH_SESSION_SHARDS || !stats) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	shard = &session_manager.shards[index];
+
+	switch_thread_rwlock_rdlock(shard->rwlock);
+	stats->sessions = shard->count;
+	stats->reads = switch_atomic_read(&shard->reads);
+	stats->contended = switch_atomic_read(&shard->contended);
+	stats->wait_usec = switch_atomic_read(&shard->wait_usec);
+	stats->writes = shard->writes;
+	stats->hold_usec = shard->hold_usec;
+	stats->max_hold_usec = shard->max_hold_usec;
+	switch_thread_rwlock_unlock(shard->rwlock);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_locate(const char *uuid_str, const char *file, const char *func, int line)
 {
 	switch_core_session_t *session = NULL;
 
 	if (uuid_str) {
-		switch_mutex_lock(runtime.session_hash_mutex);
-		if ((session = switch_core_hash_find(session_manager.session_table, uuid_str))) {
+		switch_session_shard_t *shard = session_shard(uuid_str);
+
+		session_shard_rdlock(shard);
+		if ((session = switch_core_hash_find(shard->table, uuid_str))) {
 			/* Acquire a read lock on the session */
 #ifdef SWITCH_DEBUG_RWLOCKS
 			if (switch_core_session_perform_read_lock(session, file, func, line) != SWITCH_STATUS_SUCCESS) {
@@ -138,7 +215,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_locate(const
 				session = NULL;
 			}
 		}
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		switch_thread_rwlock_unlock(shard->rwlock);
 	}
 
 	/* if its not NULL, now it's up to you to rwunlock this */
@@ -155,8 +232,10 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_force_locate
 	switch_status_t status;
 
 	if (uuid_str) {
-		switch_mutex_lock(runtime.session_hash_mutex);
-		if ((session = switch_core_hash_find(session_manager.session_table, uuid_str))) {
+		switch_session_shard_t *shard = session_shard(uuid_str);
+
+		session_shard_rdlock(shard);
+		if ((session = switch_core_hash_find(shard->table, uuid_str))) {
 			/* Acquire a read lock on the session */
 
 			if (switch_test_flag(session, SSF_DESTROYED)) {
@@ -178,7 +257,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_force_locate
 				session = NULL;
 			}
 		}
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		switch_thread_rwlock_unlock(shard->rwlock);
 	}
 
 	/* if its not NULL, now it's up to you to rwunlock this */
@@ -212,6 +291,7 @@ SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_vars_ans(switch_eve
 {
 	switch_hash_index_t *hi;
 	void *val;
+	uint32_t x;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -222,24 +302,26 @@ SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_vars_ans(switch_eve
 	if (!vars || !vars->headers)
 		return r;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				int ans = switch_channel_test_flag(switch_core_session_get_channel(session), CF_ANSWERED);
-				if ((ans && (type & SHT_ANSWERED)) || (!ans && (type & SHT_UNANSWERED))) {
-					np = switch_core_alloc(pool, sizeof(*np));
-					np->str = switch_core_strdup(pool, session->uuid_str);
-					np->next = head;
-					head = np;
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		session_shard_rdlock(&session_manager.shards[x]);
+		for (hi = switch_core_hash_first(session_manager.shards[x].table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			if (val) {
+				session = (switch_core_session_t *) val;
+				if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+					int ans = switch_channel_test_flag(switch_core_session_get_channel(session), CF_ANSWERED);
+					if ((ans && (type & SHT_ANSWERED)) || (!ans && (type & SHT_UNANSWERED))) {
+						np = switch_core_alloc(pool, sizeof(*np));
+						np->str = switch_core_strdup(pool, session->uuid_str);
+						np->next = head;
+						head = np;
+					}
+					switch_core_session_rwunlock(session);
 				}
-				switch_core_session_rwunlock(session);
 			}
 		}
+		switch_thread_rwlock_unlock(session_manager.shards[x].rwlock);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -290,6 +372,7 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_ma
 {
 	switch_hash_index_t *hi;
 	void *val;
+	uint32_t x;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -302,21 +385,23 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_ma
 
 	switch_core_new_memory_pool(&pool);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				np = switch_core_alloc(pool, sizeof(*np));
-				np->str = switch_core_strdup(pool, session->uuid_str);
-				np->next = head;
-				head = np;
-				switch_core_session_rwunlock(session);
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		session_shard_rdlock(&session_manager.shards[x]);
+		for (hi = switch_core_hash_first(session_manager.shards[x].table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			if (val) {
+				session = (switch_core_session_t *) val;
+				if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+					np = switch_core_alloc(pool, sizeof(*np));
+					np->str = switch_core_strdup(pool, session->uuid_str);
+					np->next = head;
+					head = np;
+					switch_core_session_rwunlock(session);
+				}
 			}
 		}
+		switch_thread_rwlock_unlock(session_manager.shards[x].rwlock);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -340,29 +425,32 @@ SWITCH_DECLARE(void) switch_core_session_hupall_endpoint(const switch_endpoint_i
 {
 	switch_hash_index_t *hi;
 	void *val;
+	uint32_t x;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
 
 	switch_core_new_memory_pool(&pool);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				if (session->endpoint_interface == endpoint_interface) {
-					np = switch_core_alloc(pool, sizeof(*np));
-					np->str = switch_core_strdup(pool, session->uuid_str);
-					np->next = head;
-					head = np;
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		session_shard_rdlock(&session_manager.shards[x]);
+		for (hi = switch_core_hash_first(session_manager.shards[x].table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			if (val) {
+				session = (switch_core_session_t *) val;
+				if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+					if (session->endpoint_interface == endpoint_interface) {
+						np = switch_core_alloc(pool, sizeof(*np));
+						np->str = switch_core_strdup(pool, session->uuid_str);
+						np->next = head;
+						head = np;
+					}
+					switch_core_session_rwunlock(session);
 				}
-				switch_core_session_rwunlock(session);
 			}
 		}
+		switch_thread_rwlock_unlock(session_manager.shards[x].rwlock);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -379,6 +467,7 @@ SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 {
 	switch_hash_index_t *hi;
 	void *val;
+	uint32_t x;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -386,21 +475,23 @@ SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 	switch_core_new_memory_pool(&pool);
 
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				np = switch_core_alloc(pool, sizeof(*np));
-				np->str = switch_core_strdup(pool, session->uuid_str);
-				np->next = head;
-				head = np;
-				switch_core_session_rwunlock(session);
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		session_shard_rdlock(&session_manager.shards[x]);
+		for (hi = switch_core_hash_first(session_manager.shards[x].table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			if (val) {
+				session = (switch_core_session_t *) val;
+				if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+					np = switch_core_alloc(pool, sizeof(*np));
+					np->str = switch_core_strdup(pool, session->uuid_str);
+					np->next = head;
+					head = np;
+					switch_core_session_rwunlock(session);
+				}
 			}
 		}
+		switch_thread_rwlock_unlock(session_manager.shards[x].rwlock);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -418,21 +509,24 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall(vo
 {
 	switch_hash_index_t *hi;
 	void *val;
+	uint32_t x;
 	switch_core_session_t *session;
 	switch_console_callback_match_t *my_matches = NULL;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				switch_console_push_match(&my_matches, session->uuid_str);
-				switch_core_session_rwunlock(session);
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		session_shard_rdlock(&session_manager.shards[x]);
+		for (hi = switch_core_hash_first(session_manager.shards[x].table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			if (val) {
+				session = (switch_core_session_t *) val;
+				if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+					switch_console_push_match(&my_matches, session->uuid_str);
+					switch_core_session_rwunlock(session);
+				}
 			}
 		}
+		switch_thread_rwlock_unlock(session_manager.shards[x].rwlock);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return my_matches;
 }
@@ -442,17 +536,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_message_send(const char *uui
 	switch_core_session_t *session = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if ((session = switch_core_hash_find(session_manager.session_table, uuid_str)) != 0) {
-		/* Acquire a read lock on the session or forget it the channel is dead */
-		if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-			if (switch_channel_up_nosig(session->channel)) {
-				status = switch_core_session_receive_message(session, message);
-			}
-			switch_core_session_rwunlock(session);
+	/* the session's own read lock keeps it alive, the shard is not held while it is delivered to */
+	if ((session = switch_core_session_locate(uuid_str))) {
+		if (switch_channel_up_nosig(session->channel)) {
+			status = switch_core_session_receive_message(session, message);
 		}
+		switch_core_session_rwunlock(session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return status;
 }
@@ -462,17 +552,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_event_send(const char *uuid_
 	switch_core_session_t *session = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if ((session = switch_core_hash_find(session_manager.session_table, uuid_str)) != 0) {
-		/* Acquire a read lock on the session or forget it the channel is dead */
-		if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-			if (switch_channel_up_nosig(session->channel)) {
-				status = switch_core_session_queue_event(session, event);
-			}
-			switch_core_session_rwunlock(session);
+	/* the session's own read lock keeps it alive, the shard is not held while it is delivered to */
+	if ((session = switch_core_session_locate(uuid_str))) {
+		if (switch_channel_up_nosig(session->channel)) {
+			status = switch_core_session_queue_event(session, event);
 		}
+		switch_core_session_rwunlock(session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return status;
 }
@@ -1515,6 +1601,8 @@ SWITCH_DECLARE(void) switch_core_session_perform_destroy(switch_core_session_t *
 	switch_memory_pool_t *pool;
 	switch_event_t *event;
 	switch_endpoint_interface_t *endpoint_interface = (*session)->endpoint_interface;
+	switch_session_shard_t *shard;
+	switch_time_t locked;
 	int i;
 
 
@@ -1544,8 +1632,13 @@ SWITCH_DECLARE(void) switch_core_session_perform_destroy(switch_core_session_t *
 
 	switch_scheduler_del_task_group((*session)->uuid_str);
 
+	shard = session_shard((*session)->uuid_str);
+	locked = session_shard_wrlock(shard);
+	switch_core_hash_delete(shard->table, (*session)->uuid_str);
+	shard->count--;
+	session_shard_wrunlock(shard, locked);
+
 	switch_mutex_lock(runtime.session_hash_mutex);
-	switch_core_hash_delete(session_manager.session_table, (*session)->uuid_str);
 	if (session_manager.session_count) {
 		session_manager.session_count--;
 		if (session_manager.session_count == 0) {
@@ -1981,6 +2074,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 	switch_event_t *event;
 	switch_core_session_message_t msg = { 0 };
 	switch_caller_profile_t *profile;
+	switch_session_shard_t *old_shard, *new_shard;
+	switch_time_t old_locked, new_locked;
 
 	switch_assert(use_uuid);
 
@@ -1989,12 +2084,17 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 	}
 
 
+	/* serializes renames, both shards are write locked for the move itself */
 	switch_mutex_lock(runtime.session_hash_mutex);
-	if (switch_core_hash_find(session_manager.session_table, use_uuid)) {
+	new_shard = session_shard(use_uuid);
+	session_shard_rdlock(new_shard);
+	if (switch_core_hash_find(new_shard->table, use_uuid)) {
+		switch_thread_rwlock_unlock(new_shard->rwlock);
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Duplicate UUID!\n");
 		switch_mutex_unlock(runtime.session_hash_mutex);
 		return SWITCH_STATUS_FALSE;
 	}
+	switch_thread_rwlock_unlock(new_shard->rwlock);
 
 	msg.message_id = SWITCH_MESSAGE_INDICATE_UUID_CHANGE;
 	msg.from = switch_channel_get_name(session->channel);
@@ -2011,9 +2111,27 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 
 	switch_event_create(&event, SWITCH_EVENT_CHANNEL_UUID);
 	switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Old-Unique-ID", session->uuid_str);
-	switch_core_hash_delete(session_manager.session_table, session->uuid_str);
+	old_shard = session_shard(session->uuid_str);
+
+	/* always in shard order so two renames cannot deadlock */
+	if (old_shard < new_shard) {
+		old_locked = session_shard_wrlock(old_shard);
+		new_locked = session_shard_wrlock(new_shard);
+	} else {
+		new_locked = session_shard_wrlock(new_shard);
+		old_locked = old_shard == new_shard ? new_locked : session_shard_wrlock(old_shard);
+	}
+
+	switch_core_hash_delete(old_shard->table, session->uuid_str);
+	old_shard->count--;
 	switch_set_string(session->uuid_str, use_uuid);
-	switch_core_hash_insert(session_manager.session_table, session->uuid_str, session);
+	switch_core_hash_insert(new_shard->table, session->uuid_str, session);
+	new_shard->count++;
+
+	if (old_shard != new_shard) {
+		session_shard_wrunlock(old_shard, old_locked);
+	}
+	session_shard_wrunlock(new_shard, new_locked);
 	switch_mutex_unlock(runtime.session_hash_mutex);
 	switch_channel_event_set_data(session->channel, event);
 	switch_event_fire(&event);
@@ -2308,11 +2426,22 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_request_uuid(switch_
 	switch_uuid_t uuid;
 	uint32_t count = 0;
 	int32_t sps = 0;
+	switch_session_shard_t *shard;
+	switch_time_t locked;
 
 
-	if (use_uuid && switch_core_hash_find(session_manager.session_table, use_uuid)) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Duplicate UUID!\n");
-		return NULL;
+	if (use_uuid) {
+		void *dup;
+
+		shard = session_shard(use_uuid);
+		session_shard_rdlock(shard);
+		dup = switch_core_hash_find(shard->table, use_uuid);
+		switch_thread_rwlock_unlock(shard->rwlock);
+
+		if (dup) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Duplicate UUID!\n");
+			return NULL;
+		}
 	}
 
 	if (direction == SWITCH_CALL_DIRECTION_INBOUND && !switch_core_ready_inbound()) {
@@ -2420,8 +2549,13 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_request_uuid(switch_
 	switch_queue_create(&session->private_event_queue, SWITCH_EVENT_QUEUE_LEN, session->pool);
 	switch_queue_create(&session->private_event_queue_pri, SWITCH_EVENT_QUEUE_LEN, session->pool);
 
+	shard = session_shard(session->uuid_str);
+	locked = session_shard_wrlock(shard);
+	switch_core_hash_insert(shard->table, session->uuid_str, session);
+	shard->count++;
+	session_shard_wrunlock(shard, locked);
+
 	switch_mutex_lock(runtime.session_hash_mutex);
-	switch_core_hash_insert(session_manager.session_table, session->uuid_str, session);
 	session->id = session_manager.session_id++;
 	session_manager.session_count++;
 
@@ -2543,11 +2677,16 @@ SWITCH_DECLARE(uint32_t) switch_core_sessions_per_second(uint32_t new_limit)
 
 void switch_core_session_init(switch_memory_pool_t *pool)
 {
+	uint32_t x;
+
 	memset(&session_manager, 0, sizeof(session_manager));
 	session_manager.session_limit = 1000;
 	session_manager.session_id = 1;
 	session_manager.memory_pool = pool;
-	switch_core_hash_init(&session_manager.session_table);
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		switch_core_hash_init(&session_manager.shards[x].table);
+		switch_thread_rwlock_create(&session_manager.shards[x].rwlock, session_manager.memory_pool);
+	}
 	switch_mutex_init(&session_manager.mutex, SWITCH_MUTEX_DEFAULT, session_manager.memory_pool);
 	switch_thread_cond_create(&session_manager.cond, session_manager.memory_pool);
 	switch_queue_create(&session_manager.thread_queue, 100000, session_manager.memory_pool);
@@ -2555,12 +2694,16 @@ void switch_core_session_init(switch_memory_pool_t *pool)
 
 void switch_core_session_uninit(void)
 {
+	uint32_t x;
+
 	switch_queue_term(session_manager.thread_queue);
 	switch_mutex_lock(session_manager.mutex);
 	if (session_manager.running)
 		switch_thread_cond_timedwait(session_manager.cond, session_manager.mutex, 10000000);
 	switch_mutex_unlock(session_manager.mutex);
-	switch_core_hash_destroy(&session_manager.session_table);
+	for (x = 0; x < SWITCH_SESSION_SHARDS; x++) {
+		switch_core_hash_destroy(&session_manager.shards[x].table);
+	}
 }
 
 SWITCH_DECLARE(switch_app_log_t *) switch_core_session_get_app_log(switch_core_session_t *session)
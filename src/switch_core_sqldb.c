@@ -38,6 +38,18 @@
 
 #define SWITCH_SQL_QUEUE_LEN 100000
 #define SWITCH_SQL_QUEUE_PAUSE_LEN 90000
+#define SQL_STMT_CACHE_LEN 64
+#define SQL_BULK_ROWS 100
+#define SQL_BULK_MAX_ROWS 500
+#define SQL_BULK_MAX_LEN 32768
+
+/* a prepared statement in a handle's cache, most recently used first */
+typedef struct sql_stmt_s {
+	char *sql;
+	switch_core_db_stmt_t *stmt;
+	struct sql_stmt_s *prev;
+	struct sql_stmt_s *next;
+} sql_stmt_t;
 
 struct switch_cache_db_handle {
 	char name[CACHE_DB_LEN];
@@ -54,9 +66,38 @@ struct switch_cache_db_handle {
 	char last_user[CACHE_DB_LEN];
 	uint32_t use_count;
 	uint64_t total_used_count;
+	switch_hash_t *stmt_hash;
+	sql_stmt_t *stmt_head;
+	sql_stmt_t *stmt_tail;
+	uint32_t stmt_count;
+	uint64_t stmt_hits;
+	uint64_t stmt_misses;
+	struct sql_pool_s *dsn_pool;
+	struct switch_cache_db_handle *pool_next;
+	struct switch_cache_db_handle *idle_next;
 	struct switch_cache_db_handle *next;
 };
 
+/* every handle opened on one dsn, the idle ones on a free list with the most recently released first */
+typedef struct sql_pool_s {
+	char name[CACHE_DB_LEN];
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_cache_db_handle_t *handles;
+	switch_cache_db_handle_t *idle;
+	uint32_t total;
+	uint32_t used;
+	uint32_t waiting;
+	uint64_t acquired;
+	uint64_t affinity;
+	uint64_t waits;
+	switch_time_t wait_usec;
+	uint64_t timeouts;
+	uint64_t opened;
+	uint64_t dropped;
+} sql_pool_t;
+
 static struct {
 	switch_memory_pool_t *memory_pool;
 	switch_thread_t *db_thread;
@@ -67,7 +108,8 @@ static struct {
 	switch_mutex_t *ctl_mutex;
 	switch_cache_db_handle_t *handle_pool;
 	uint32_t total_handles;
-	uint32_t total_used_handles;
+	switch_hash_t *pool_hash;
+	switch_thread_rwlock_t *pool_rwlock;
 	switch_cache_db_handle_t *dbh;
 	switch_sql_queue_manager_t *qm;
 	int paused;
@@ -91,7 +133,45 @@ static switch_cache_db_handle_t *create_handle(switch_cache_db_handle_type_t typ
 	return new_dbh;
 }
 
-static void add_handle(switch_cache_db_handle_t *dbh, const char *db_str, const char *db_callsite_str, const char *thread_str)
+static sql_pool_t *sql_pool_get(const char *db_str)
+{
+	sql_pool_t *dsn_pool;
+
+	switch_thread_rwlock_rdlock(sql_manager.pool_rwlock);
+	dsn_pool = switch_core_hash_find(sql_manager.pool_hash, db_str);
+	switch_thread_rwlock_unlock(sql_manager.pool_rwlock);
+
+	if (dsn_pool) {
+		return dsn_pool;
+	}
+
+	switch_thread_rwlock_wrlock(sql_manager.pool_rwlock);
+	if (!(dsn_pool = switch_core_hash_find(sql_manager.pool_hash, db_str))) {
+		switch_memory_pool_t *pool = NULL;
+
+		switch_core_new_memory_pool(&pool);
+		dsn_pool = switch_core_alloc(pool, sizeof(*dsn_pool));
+		dsn_pool->pool = pool;
+		switch_set_string(dsn_pool->name, db_str);
+		switch_mutex_init(&dsn_pool->mutex, SWITCH_MUTEX_NESTED, pool);
+		switch_thread_cond_create(&dsn_pool->cond, pool);
+		switch_core_hash_insert(sql_manager.pool_hash, dsn_pool->name, dsn_pool);
+	}
+	switch_thread_rwlock_unlock(sql_manager.pool_rwlock);
+
+	return dsn_pool;
+}
+
+/* a slot get_handle() reserved for a new connection that could not be opened */
+static void sql_pool_unreserve(sql_pool_t *dsn_pool)
+{
+	switch_mutex_lock(dsn_pool->mutex);
+	dsn_pool->total--;
+	switch_thread_cond_signal(dsn_pool->cond);
+	switch_mutex_unlock(dsn_pool->mutex);
+}
+
+static void add_handle(switch_cache_db_handle_t *dbh, sql_pool_t *dsn_pool, const char *db_str, const char *db_callsite_str, const char *thread_str)
 {
 	switch_ssize_t hlen = -1;
 
@@ -105,18 +185,29 @@ static void add_handle(switch_cache_db_handle_t *dbh, const char *db_str, const
 
 	dbh->use_count++;
 	dbh->total_used_count++;
-	sql_manager.total_used_handles++;
 	dbh->next = sql_manager.handle_pool;
 
 	sql_manager.handle_pool = dbh;
 	sql_manager.total_handles++;
 	switch_mutex_lock(dbh->mutex);
+
+	/* its slot in the pool was already counted when get_handle() sent us off to open it */
+	switch_mutex_lock(dsn_pool->mutex);
+	dbh->dsn_pool = dsn_pool;
+	dbh->pool_next = dsn_pool->handles;
+	dsn_pool->handles = dbh;
+	dsn_pool->used++;
+	dsn_pool->acquired++;
+	dsn_pool->opened++;
+	switch_mutex_unlock(dsn_pool->mutex);
+
 	switch_mutex_unlock(sql_manager.dbh_mutex);
 }
 
 static void del_handle(switch_cache_db_handle_t *dbh)
 {
 	switch_cache_db_handle_t *dbh_ptr, *last = NULL;
+	sql_pool_t *dsn_pool = dbh->dsn_pool;
 
 	switch_mutex_lock(sql_manager.dbh_mutex);
 	for (dbh_ptr = sql_manager.handle_pool; dbh_ptr; dbh_ptr = dbh_ptr->next) {
@@ -132,47 +223,136 @@ static void del_handle(switch_cache_db_handle_t *dbh)
 
 		last = dbh_ptr;
 	}
+
+	switch_mutex_lock(dsn_pool->mutex);
+	for (last = NULL, dbh_ptr = dsn_pool->handles; dbh_ptr; last = dbh_ptr, dbh_ptr = dbh_ptr->pool_next) {
+		if (dbh_ptr == dbh) {
+			if (last) {
+				last->pool_next = dbh_ptr->pool_next;
+			} else {
+				dsn_pool->handles = dbh_ptr->pool_next;
+			}
+			break;
+		}
+	}
+	for (last = NULL, dbh_ptr = dsn_pool->idle; dbh_ptr; last = dbh_ptr, dbh_ptr = dbh_ptr->idle_next) {
+		if (dbh_ptr == dbh) {
+			if (last) {
+				last->idle_next = dbh_ptr->idle_next;
+			} else {
+				dsn_pool->idle = dbh_ptr->idle_next;
+			}
+			break;
+		}
+	}
+	if (dbh->use_count) {
+		dsn_pool->used--;
+	}
+	dsn_pool->total--;
+	dsn_pool->dropped++;
+	switch_thread_cond_signal(dsn_pool->cond);
+	switch_mutex_unlock(dsn_pool->mutex);
+
 	switch_mutex_unlock(sql_manager.dbh_mutex);
 }
 
-static switch_cache_db_handle_t *get_handle(const char *db_str, const char *user_str, const char *thread_str)
+static switch_cache_db_handle_t *sql_pool_take(sql_pool_t *dsn_pool, unsigned long thread_hash)
+{
+	switch_cache_db_handle_t *dbh, *last;
+
+	/* the handle this thread released last, it still has its statements prepared */
+	for (last = NULL, dbh = dsn_pool->idle; dbh; last = dbh, dbh = dbh->idle_next) {
+		if (dbh->thread_hash == thread_hash && !switch_test_flag(dbh, CDF_PRUNE) && switch_mutex_trylock(dbh->mutex) == SWITCH_STATUS_SUCCESS) {
+			dsn_pool->affinity++;
+			goto found;
+		}
+	}
+
+	for (last = NULL, dbh = dsn_pool->idle; dbh; last = dbh, dbh = dbh->idle_next) {
+		if (!switch_test_flag(dbh, CDF_PRUNE) && switch_mutex_trylock(dbh->mutex) == SWITCH_STATUS_SUCCESS) {
+			goto found;
+		}
+	}
+
+	/* a thread asking again for a dsn it already holds gets the same handle back, the handle mutex is nested */
+	for (dbh = dsn_pool->handles; dbh; dbh = dbh->pool_next) {
+		if (dbh->use_count && dbh->type != SCDB_TYPE_PGSQL && !switch_test_flag(dbh, CDF_PRUNE) &&
+			switch_mutex_trylock(dbh->mutex) == SWITCH_STATUS_SUCCESS) {
+			return dbh;
+		}
+	}
+
+	return NULL;
+
+ found:
+
+	if (last) {
+		last->idle_next = dbh->idle_next;
+	} else {
+		dsn_pool->idle = dbh->idle_next;
+	}
+	dbh->idle_next = NULL;
+
+	return dbh;
+}
+
+/*
+  An idle handle of the dsn's pool, NULL with *reserved set when the caller should open a new one into the pool,
+  or NULL alone when the pool stayed full past db-handle-timeout.
+*/
+static switch_cache_db_handle_t *get_handle(const char *db_str, const char *user_str, const char *thread_str, sql_pool_t **reserved)
 {
 	switch_ssize_t hlen = -1;
-	unsigned long hash = 0, thread_hash = 0;
-	switch_cache_db_handle_t *dbh_ptr, *r = NULL;
+	unsigned long thread_hash = 0;
+	switch_cache_db_handle_t *r = NULL;
+	sql_pool_t *dsn_pool = sql_pool_get(db_str);
+	switch_time_t waited = 0;
 
-	hash = switch_ci_hashfunc_default(db_str, &hlen);
+	*reserved = NULL;
 	thread_hash = switch_ci_hashfunc_default(thread_str, &hlen);
 
-	switch_mutex_lock(sql_manager.dbh_mutex);
+	switch_mutex_lock(dsn_pool->mutex);
 
-	for (dbh_ptr = sql_manager.handle_pool; dbh_ptr; dbh_ptr = dbh_ptr->next) {
-		if (dbh_ptr->thread_hash == thread_hash && dbh_ptr->hash == hash && !dbh_ptr->use_count &&
-			!switch_test_flag(dbh_ptr, CDF_PRUNE) && switch_mutex_trylock(dbh_ptr->mutex) == SWITCH_STATUS_SUCCESS) {
-			r = dbh_ptr;
+	while (!(r = sql_pool_take(dsn_pool, thread_hash))) {
+		switch_time_t start;
+
+		if (!runtime.max_db_handles || dsn_pool->total < runtime.max_db_handles) {
+			dsn_pool->total++;
+			*reserved = dsn_pool;
+			break;
 		}
-	}
 
-	if (!r) {
-		for (dbh_ptr = sql_manager.handle_pool; dbh_ptr; dbh_ptr = dbh_ptr->next) {
-			if (dbh_ptr->hash == hash && (dbh_ptr->type != SCDB_TYPE_PGSQL || !dbh_ptr->use_count) && !switch_test_flag(dbh_ptr, CDF_PRUNE) &&
-				switch_mutex_trylock(dbh_ptr->mutex) == SWITCH_STATUS_SUCCESS) {
-				r = dbh_ptr;
-				break;
-			}
+		if (!waited) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Max handles %u exceeded for %s, blocking....\n", runtime.max_db_handles, user_str);
+			dsn_pool->waits++;
+		}
+
+		start = switch_time_now();
+		dsn_pool->waiting++;
+		switch_thread_cond_timedwait(dsn_pool->cond, dsn_pool->mutex, 100000);
+		dsn_pool->waiting--;
+		start = switch_time_now() - start;
+		waited += start;
+		dsn_pool->wait_usec += start;
+
+		if (runtime.db_handle_timeout && waited > runtime.db_handle_timeout) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Timed out waiting for a db handle for %s\n", user_str);
+			dsn_pool->timeouts++;
+			break;
 		}
 	}
 
 	if (r) {
-		r->use_count++;
+		if (!r->use_count++) {
+			dsn_pool->used++;
+		}
+		dsn_pool->acquired++;
 		r->total_used_count++;
-		sql_manager.total_used_handles++;
-		r->hash = switch_ci_hashfunc_default(db_str, &hlen);
 		r->thread_hash = thread_hash;
 		switch_set_string(r->last_user, user_str);
 	}
 
-	switch_mutex_unlock(sql_manager.dbh_mutex);
+	switch_mutex_unlock(dsn_pool->mutex);
 
 	return r;
 
@@ -209,6 +389,139 @@ SWITCH_DECLARE(switch_status_t) _switch_core_db_handle(switch_cache_db_handle_t
 #define SQL_REG_TIMEOUT 15
 
 
+static void stmt_cache_unlink(switch_cache_db_handle_t *dbh, sql_stmt_t *st)
+{
+	if (st->prev) {
+		st->prev->next = st->next;
+	} else {
+		dbh->stmt_head = st->next;
+	}
+
+	if (st->next) {
+		st->next->prev = st->prev;
+	} else {
+		dbh->stmt_tail = st->prev;
+	}
+
+	st->prev = st->next = NULL;
+}
+
+static void stmt_cache_push(switch_cache_db_handle_t *dbh, sql_stmt_t *st)
+{
+	st->prev = NULL;
+	st->next = dbh->stmt_head;
+
+	if (dbh->stmt_head) {
+		dbh->stmt_head->prev = st;
+	} else {
+		dbh->stmt_tail = st;
+	}
+
+	dbh->stmt_head = st;
+}
+
+static void stmt_cache_free(switch_cache_db_handle_t *dbh, sql_stmt_t *st)
+{
+	stmt_cache_unlink(dbh, st);
+	switch_core_hash_delete(dbh->stmt_hash, st->sql);
+	switch_core_db_finalize(st->stmt);
+	dbh->stmt_count--;
+	free(st->sql);
+	free(st);
+}
+
+/* the statements have to be finalized before their connection can be closed */
+static void stmt_cache_flush(switch_cache_db_handle_t *dbh)
+{
+	while (dbh->stmt_head) {
+		stmt_cache_free(dbh, dbh->stmt_head);
+	}
+
+	if (dbh->stmt_hash) {
+		switch_core_hash_destroy(&dbh->stmt_hash);
+	}
+}
+
+static switch_core_db_stmt_t *stmt_cache_get(switch_cache_db_handle_t *dbh, const char *sql, char **err)
+{
+	sql_stmt_t *st;
+	switch_core_db_stmt_t *stmt = NULL;
+
+	if (!dbh->stmt_hash) {
+		switch_core_hash_init(&dbh->stmt_hash);
+	}
+
+	if ((st = switch_core_hash_find(dbh->stmt_hash, sql))) {
+		dbh->stmt_hits++;
+		stmt_cache_unlink(dbh, st);
+		stmt_cache_push(dbh, st);
+		return st->stmt;
+	}
+
+	dbh->stmt_misses++;
+
+	if (switch_core_db_prepare(dbh->native_handle.core_db_dbh, sql, -1, &stmt, NULL) != SWITCH_CORE_DB_OK || !stmt) {
+		if (err) {
+			*err = strdup(switch_core_db_errmsg(dbh->native_handle.core_db_dbh));
+		}
+		switch_core_db_finalize(stmt);
+		return NULL;
+	}
+
+	switch_zmalloc(st, sizeof(*st));
+	st->sql = strdup(sql);
+	st->stmt = stmt;
+	stmt_cache_push(dbh, st);
+	switch_core_hash_insert(dbh->stmt_hash, st->sql, st);
+
+	if (++dbh->stmt_count > SQL_STMT_CACHE_LEN) {
+		stmt_cache_free(dbh, dbh->stmt_tail);
+	}
+
+	return stmt;
+}
+
+/* closes a handle the caller holds the mutex of */
+static void destroy_handle(switch_cache_db_handle_t *dbh)
+{
+	switch (dbh->type) {
+	case SCDB_TYPE_PGSQL:
+		{
+			switch_pgsql_handle_destroy(&dbh->native_handle.pgsql_dbh);
+		}
+		break;
+	case SCDB_TYPE_ODBC:
+		{
+			switch_odbc_handle_destroy(&dbh->native_handle.odbc_dbh);
+		}
+		break;
+	case SCDB_TYPE_CORE_DB:
+		{
+			stmt_cache_flush(dbh);
+			switch_core_db_close(dbh->native_handle.core_db_dbh);
+			dbh->native_handle.core_db_dbh = NULL;
+		}
+		break;
+	}
+
+	del_handle(dbh);
+	switch_mutex_unlock(dbh->mutex);
+	switch_core_destroy_memory_pool(&dbh->pool);
+}
+
+/* a connection the driver already saw drop is not handed out again */
+static switch_bool_t handle_healthy(switch_cache_db_handle_t *dbh)
+{
+	switch (dbh->type) {
+	case SCDB_TYPE_PGSQL:
+		return switch_pgsql_handle_get_state(dbh->native_handle.pgsql_dbh) == SWITCH_PGSQL_STATE_CONNECTED;
+	case SCDB_TYPE_ODBC:
+		return switch_odbc_handle_get_state(dbh->native_handle.odbc_dbh) == SWITCH_ODBC_STATE_CONNECTED;
+	default:
+		return SWITCH_TRUE;
+	}
+}
+
 static void sql_close(time_t prune)
 {
 	switch_cache_db_handle_t *dbh = NULL;
@@ -232,29 +545,7 @@ static void sql_close(time_t prune)
 
 		if (switch_mutex_trylock(dbh->mutex) == SWITCH_STATUS_SUCCESS) {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG10, "Dropping idle DB connection %s\n", dbh->name);
-
-			switch (dbh->type) {
-			case SCDB_TYPE_PGSQL:
-				{
-					switch_pgsql_handle_destroy(&dbh->native_handle.pgsql_dbh);
-				}
-				break;
-			case SCDB_TYPE_ODBC:
-				{
-					switch_odbc_handle_destroy(&dbh->native_handle.odbc_dbh);
-				}
-				break;
-			case SCDB_TYPE_CORE_DB:
-				{
-					switch_core_db_close(dbh->native_handle.core_db_dbh);
-					dbh->native_handle.core_db_dbh = NULL;
-				}
-				break;
-			}
-
-			del_handle(dbh);
-			switch_mutex_unlock(dbh->mutex);
-			switch_core_destroy_memory_pool(&dbh->pool);
+			destroy_handle(dbh);
 			goto top;
 
 		} else {
@@ -297,6 +588,7 @@ SWITCH_DECLARE(void) switch_cache_db_flush_handles(void)
 SWITCH_DECLARE(void) switch_cache_db_release_db_handle(switch_cache_db_handle_t **dbh)
 {
 	if (dbh && *dbh) {
+		sql_pool_t *dsn_pool;
 
 		switch((*dbh)->type) {
 		case SCDB_TYPE_PGSQL:
@@ -308,20 +600,25 @@ SWITCH_DECLARE(void) switch_cache_db_release_db_handle(switch_cache_db_handle_t
 			break;
 		}
 
-		switch_mutex_lock(sql_manager.dbh_mutex);
+		dsn_pool = (*dbh)->dsn_pool;
+
+		switch_mutex_lock(dsn_pool->mutex);
 		(*dbh)->last_used = switch_epoch_time_now(NULL);
 
 		(*dbh)->io_mutex = NULL;
 
-		if ((*dbh)->use_count) {
-			if (--(*dbh)->use_count == 0) {
-				(*dbh)->thread_hash = 1;
+		/* back on the free list, thread_hash is kept so the same thread gets it again first */
+		if ((*dbh)->use_count && --(*dbh)->use_count == 0) {
+			(*dbh)->idle_next = dsn_pool->idle;
+			dsn_pool->idle = *dbh;
+			dsn_pool->used--;
+			if (dsn_pool->waiting) {
+				switch_thread_cond_signal(dsn_pool->cond);
 			}
 		}
 		switch_mutex_unlock((*dbh)->mutex);
-		sql_manager.total_used_handles--;
 		*dbh = NULL;
-		switch_mutex_unlock(sql_manager.dbh_mutex);
+		switch_mutex_unlock(dsn_pool->mutex);
 	}
 }
 
@@ -391,30 +688,13 @@ SWITCH_DECLARE(switch_status_t) _switch_cache_db_get_db_handle(switch_cache_db_h
 	char db_str[CACHE_DB_LEN] = "";
 	char db_callsite_str[CACHE_DB_LEN] = "";
 	switch_cache_db_handle_t *new_dbh = NULL;
-	int waiting = 0;
-	uint32_t yield_len = 100000, total_yield = 0;
+	sql_pool_t *reserved = NULL;
 
 	const char *db_name = NULL;
 	const char *odbc_user = NULL;
 	const char *odbc_pass = NULL;
 	const char *db_type = NULL;
 
-	while(runtime.max_db_handles && sql_manager.total_handles >= runtime.max_db_handles && sql_manager.total_used_handles >= sql_manager.total_handles) {
-		if (!waiting++) {
-			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_WARNING, "Max handles %u exceeded, blocking....\n",
-							  runtime.max_db_handles);
-		}
-
-		switch_yield(yield_len);
-		total_yield += yield_len;
-
-		if (runtime.db_handle_timeout && total_yield > runtime.db_handle_timeout) {
-			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_ERROR, "Error connecting\n");
-			*dbh = NULL;
-			return SWITCH_STATUS_FALSE;
-		}
-	}
-
 	switch (type) {
 	case SCDB_TYPE_PGSQL:
 		{
@@ -453,9 +733,19 @@ SWITCH_DECLARE(switch_status_t) _switch_cache_db_get_db_handle(switch_cache_db_h
 	snprintf(db_callsite_str, sizeof(db_callsite_str) - 1, "%s:%d", file, line);
 	snprintf(thread_str, sizeof(thread_str) - 1, "thread=\"%lu\"",  (unsigned long) (intptr_t) self);
 
-	if ((new_dbh = get_handle(db_str, db_callsite_str, thread_str))) {
+	while ((new_dbh = get_handle(db_str, db_callsite_str, thread_str, &reserved)) && new_dbh->use_count == 1 && !handle_healthy(new_dbh)) {
+		switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_WARNING,
+						  "Dropping disconnected DB handle %s [%s]\n", new_dbh->name, switch_cache_db_type_name(new_dbh->type));
+		switch_mutex_lock(sql_manager.dbh_mutex);
+		destroy_handle(new_dbh);
+		switch_mutex_unlock(sql_manager.dbh_mutex);
+	}
+
+	if (new_dbh) {
 		switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_DEBUG10,
 						  "Reuse Unused Cached DB handle %s [%s]\n", new_dbh->name, switch_cache_db_type_name(new_dbh->type));
+	} else if (!reserved) {
+		switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_ERROR, "Error connecting\n");
 	} else {
 		switch_core_db_t *db = NULL;
 		switch_odbc_handle_t *odbc_dbh = NULL;
@@ -522,11 +812,16 @@ SWITCH_DECLARE(switch_status_t) _switch_cache_db_get_db_handle(switch_cache_db_h
 			new_dbh->native_handle.pgsql_dbh = pgsql_dbh;
 		}
 
-		add_handle(new_dbh, db_str, db_callsite_str, thread_str);
+		add_handle(new_dbh, reserved, db_str, db_callsite_str, thread_str);
+		reserved = NULL;
 	}
 
  end:
 
+	if (reserved) {
+		sql_pool_unreserve(reserved);
+	}
+
 	if (new_dbh) {
 		new_dbh->last_used = switch_epoch_time_now(NULL);
 	}
@@ -1268,6 +1563,135 @@ SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_callback_err(switch_
 	return status;
 }
 
+/* backends without a statement cache get the values quoted into the text */
+static char *sql_expand_params(const char *sql, int argc, const char **argv)
+{
+	switch_stream_handle_t stream = { 0 };
+	const char *p, *s = sql;
+	int quoted = 0, x = 0;
+
+	SWITCH_STANDARD_STREAM(stream);
+
+	for (p = sql; *p; p++) {
+		if (*p == '\'') {
+			quoted = !quoted;
+		} else if (*p == '?' && !quoted && x < argc) {
+			char *val = switch_mprintf("%Q", argv[x++]);
+
+			stream.raw_write_function(&stream, (uint8_t *) s, p - s);
+			stream.raw_write_function(&stream, (uint8_t *) val, strlen(val));
+			switch_safe_free(val);
+			s = p + 1;
+		}
+	}
+
+	stream.write_function(&stream, "%s", s);
+
+	return (char *) stream.data;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_cache_db_execute_sql_params(switch_cache_db_handle_t *dbh, const char *sql, int argc, const char **argv,
+																   switch_core_db_callback_func_t callback, void *pdata, char **err)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	switch_mutex_t *io_mutex = dbh->io_mutex;
+	char *errmsg = NULL;
+
+	if (err) {
+		*err = NULL;
+	}
+
+	if (io_mutex) switch_mutex_lock(io_mutex);
+
+	switch (dbh->type) {
+	case SCDB_TYPE_CORE_DB:
+		{
+			switch_core_db_stmt_t *stmt;
+			int ret, x, rows = 0, sane = 300;
+
+			if (!(stmt = stmt_cache_get(dbh, sql, &errmsg))) {
+				break;
+			}
+
+			for (x = 0; x < argc; x++) {
+				switch_core_db_bind_text(stmt, x + 1, argv[x], -1, SWITCH_CORE_DB_TRANSIENT);
+			}
+
+			/* same as switch_core_db_exec(), wait out another writer as long as no row went to the callback yet */
+			while ((ret = switch_core_db_step(stmt)) == SWITCH_CORE_DB_ROW ||
+				   ((ret == SWITCH_CORE_DB_BUSY || ret == SWITCH_CORE_DB_LOCKED) && !rows && --sane > 0)) {
+				int col, cols;
+				char **vals, **names;
+
+				if (ret != SWITCH_CORE_DB_ROW) {
+					switch_core_db_reset(stmt);
+					switch_yield(100000);
+					continue;
+				}
+
+				rows++;
+
+				if (!callback) {
+					continue;
+				}
+
+				cols = switch_core_db_column_count(stmt);
+				vals = malloc(sizeof(char *) * cols * 2);
+				switch_assert(vals);
+				names = vals + cols;
+
+				for (col = 0; col < cols; col++) {
+					vals[col] = (char *) switch_core_db_column_text(stmt, col);
+					names[col] = (char *) switch_core_db_column_name(stmt, col);
+				}
+
+				ret = callback(pdata, cols, vals, names);
+				free(vals);
+
+				if (ret) {
+					ret = SWITCH_CORE_DB_DONE;
+					break;
+				}
+			}
+
+			if (ret == SWITCH_CORE_DB_DONE) {
+				status = SWITCH_STATUS_SUCCESS;
+			} else {
+				errmsg = strdup(switch_core_db_errmsg(dbh->native_handle.core_db_dbh));
+			}
+
+			switch_core_db_reset(stmt);
+		}
+		break;
+	default:
+		{
+			char *expanded = sql_expand_params(sql, argc, argv);
+
+			if (callback) {
+				status = switch_cache_db_execute_sql_callback(dbh, expanded, callback, pdata, err);
+			} else {
+				status = switch_cache_db_execute_sql(dbh, expanded, err);
+			}
+
+			free(expanded);
+		}
+		break;
+	}
+
+	if (errmsg) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "NATIVE SQL ERR [%s]\n%s\n", errmsg, sql);
+		if (err) {
+			*err = errmsg;
+		} else {
+			free(errmsg);
+		}
+	}
+
+	if (io_mutex) switch_mutex_unlock(io_mutex);
+
+	return status;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_cache_db_create_schema(switch_cache_db_handle_t *dbh, char *sql, char **err)
 {
 	switch_status_t r = SWITCH_STATUS_SUCCESS;
@@ -1424,6 +1848,8 @@ struct switch_sql_queue_manager {
 	uint32_t max_trans;
 	uint32_t confirm;
 	uint8_t paused;
+	uint32_t bulk_rows;
+	switch_bool_t bulk_rows_set;
 };
 
 static int qm_wake(switch_sql_queue_manager_t *qm)
@@ -1871,6 +2297,7 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *n
 	qm->dsn = switch_core_strdup(qm->pool, dsn);
 	qm->name = switch_core_strdup(qm->pool, name);
 	qm->max_trans = max_trans;
+	qm->bulk_rows = SQL_BULK_ROWS;
 
 	switch_mutex_init(&qm->cond_mutex, SWITCH_MUTEX_NESTED, qm->pool);
 	switch_mutex_init(&qm->cond2_mutex, SWITCH_MUTEX_NESTED, qm->pool);
@@ -1904,14 +2331,176 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *n
 
 }
 
-static uint32_t do_trans(switch_sql_queue_manager_t *qm)
+SWITCH_DECLARE(void) switch_sql_queue_manager_set_bulk_rows(switch_sql_queue_manager_t *qm, uint32_t rows)
 {
-	char *errmsg = NULL;
-	void *pop;
-	switch_status_t status;
-	uint32_t ttl = 0;
-	switch_mutex_t *io_mutex = qm->event_db->io_mutex;
+	qm->bulk_rows = rows > SQL_BULK_MAX_ROWS ? SQL_BULK_MAX_ROWS : rows;
+	qm->bulk_rows_set = SWITCH_TRUE;
+}
+
+/*
+  Where the row of a plain "insert into t (cols) values (...)" starts, 0 for anything else, including several
+  statements in one string.  Two inserts with the same text up to there only differ in their row.
+*/
+static switch_size_t sql_insert_row(const char *sql, switch_size_t *row_len)
+{
+	const char *p = sql, *v, *row;
+	int depth = 0, quoted = 0;
+
+	while (*p == ' ' || *p == '\t' || *p == '\n') p++;
+
+	if (strncasecmp(p, "insert into ", 12)) {
+		return 0;
+	}
+
+	for (v = p + 12; (v = switch_stristr("values", v)); v += 6) {
+		if ((v[-1] == ' ' || v[-1] == ')') && (v[6] == ' ' || v[6] == '(')) {
+			break;
+		}
+	}
+
+	if (!v) {
+		return 0;
+	}
+
+	for (row = v + 6; *row == ' '; row++);
+
+	if (*row != '(') {
+		return 0;
+	}
+
+	for (p = row; *p; p++) {
+		if (*p == '\'') {
+			quoted = !quoted;
+		} else if (quoted) {
+			continue;
+		} else if (*p == '(') {
+			depth++;
+		} else if (*p == ')' && --depth == 0) {
+			break;
+		} else if (*p == ';') {
+			return 0;
+		}
+	}
+
+	if (!*p) {
+		return 0;
+	}
+
+	*row_len = p + 1 - row;
+
+	for (p++; *p; p++) {
+		if (*p != ';' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+			return 0;
+		}
+	}
+
+	return row - sql;
+}
+
+/*
+  Pops the inserts queued behind batch[0] that share its table and columns, up to max rows, and returns how many
+  statements are in the batch.  The first one that does not fit is handed back in *next.
+*/
+static uint32_t qm_pop_inserts(switch_sql_queue_manager_t *qm, uint32_t i, char **batch, switch_size_t *rows, uint32_t max, char **next)
+{
+	switch_size_t prefix, len;
+	uint32_t n = 1;
+
+	if (!(prefix = sql_insert_row(batch[0], &rows[0]))) {
+		return 1;
+	}
+
+	len = prefix + rows[0];
+
+	while (n < max) {
+		void *pop = NULL;
+		switch_size_t row_len;
+
+		switch_mutex_lock(qm->mutex);
+		switch_queue_trypop(qm->sql_queue[i], &pop);
+		switch_mutex_unlock(qm->mutex);
+
+		if (!pop) {
+			break;
+		}
+
+		if (sql_insert_row((char *) pop, &row_len) != prefix || strncmp((char *) pop, batch[0], prefix) ||
+			len + row_len + 1 > SQL_BULK_MAX_LEN) {
+			*next = (char *) pop;
+			break;
+		}
+
+		batch[n] = (char *) pop;
+		rows[n++] = row_len;
+		len += row_len + 1;
+	}
+
+	return n;
+}
+
+static char *sql_join_inserts(char **batch, switch_size_t *rows, uint32_t n)
+{
+	switch_size_t prefix, len, row_len;
+	uint32_t x;
+	char *sql, *p;
+
+	prefix = sql_insert_row(batch[0], &row_len);
+
+	for (len = prefix, x = 0; x < n; x++) {
+		len += rows[x] + 1;
+	}
+
+	switch_malloc(sql, len + 1);
+	memcpy(sql, batch[0], prefix);
+	p = sql + prefix;
+
+	for (x = 0; x < n; x++) {
+		if (x) {
+			*p++ = ',';
+		}
+		memcpy(p, batch[x] + prefix, rows[x]);
+		p += rows[x];
+	}
+
+	*p = '\0';
+
+	return sql;
+}
+
+/*
+ * runs sql inside a savepoint so a failure only rolls back that statement, on pgsql a failed statement
+ * aborts the whole transaction and everything after it would fail too
+ */
+static switch_status_t qm_execute_savepoint(switch_sql_queue_manager_t *qm, const char *sql)
+{
+	switch_status_t status;
+	switch_bool_t savepoint;
+
+	savepoint = switch_cache_db_execute_sql_real(qm->event_db, "SAVEPOINT sql_bulk", NULL) == SWITCH_STATUS_SUCCESS;
+
+	if ((status = switch_cache_db_execute_sql(qm->event_db, (char *) sql, NULL)) != SWITCH_STATUS_SUCCESS && savepoint) {
+		switch_cache_db_execute_sql_real(qm->event_db, "ROLLBACK TO SAVEPOINT sql_bulk", NULL);
+	}
+
+	if (savepoint) {
+		switch_cache_db_execute_sql_real(qm->event_db, "RELEASE SAVEPOINT sql_bulk", NULL);
+	}
+
+	return status;
+}
+
+static uint32_t do_trans(switch_sql_queue_manager_t *qm)
+{
+	char *errmsg = NULL;
+	void *pop;
+	switch_status_t status;
+	uint32_t ttl = 0;
+	switch_mutex_t *io_mutex = qm->event_db->io_mutex;
 	uint32_t i;
+	char *batch[SQL_BULK_MAX_ROWS];
+	switch_size_t rows[SQL_BULK_MAX_ROWS];
+	char *next = NULL;
+	uint32_t next_i = 0;
 
 	if (io_mutex) switch_mutex_lock(io_mutex);
 
@@ -1969,25 +2558,74 @@ static uint32_t do_trans(switch_sql_queue_manager_t *qm)
 	}
 
 
-	while(qm->max_trans == 0 || ttl <= qm->max_trans) {
+	while(next || qm->max_trans == 0 || ttl <= qm->max_trans) {
 		pop = NULL;
 
-		for (i = 0; (qm->max_trans == 0 || ttl <= qm->max_trans) && (i < qm->numq); i++) {
-			switch_mutex_lock(qm->mutex);
-			switch_queue_trypop(qm->sql_queue[i], &pop);
-			switch_mutex_unlock(qm->mutex);
-			if (pop) break;
+		if (next) {
+			pop = next;
+			i = next_i;
+			next = NULL;
+		} else {
+			for (i = 0; (qm->max_trans == 0 || ttl <= qm->max_trans) && (i < qm->numq); i++) {
+				switch_mutex_lock(qm->mutex);
+				switch_queue_trypop(qm->sql_queue[i], &pop);
+				switch_mutex_unlock(qm->mutex);
+				if (pop) break;
+			}
 		}
 
 		if (pop) {
-			if ((status = switch_cache_db_execute_sql(qm->event_db, (char *) pop, NULL)) == SWITCH_STATUS_SUCCESS) {
+			uint32_t n = 1, x, done = 0, max = qm->bulk_rows;
+
+			batch[0] = (char *) pop;
+
+			if (qm->max_trans) {
+				uint32_t left = ttl < qm->max_trans ? qm->max_trans - ttl + 1 : 1;
+
+				if (max > left) {
+					max = left;
+				}
+			}
+
+			/* same shaped inserts queued back to back go out as one multi row insert */
+			if (max > 1) {
+				n = qm_pop_inserts(qm, i, batch, rows, max, &next);
+				next_i = i;
+			}
+
+			if (n > 1) {
+				char *sql = sql_join_inserts(batch, rows, n);
+
+				if (qm_execute_savepoint(qm, sql) == SWITCH_STATUS_SUCCESS) {
+					done = n;
+				} else {
+					/* one bad row should not take the others down with it */
+					for (x = 0; x < n; x++) {
+						if (qm_execute_savepoint(qm, batch[x]) == SWITCH_STATUS_SUCCESS) {
+							done++;
+						}
+					}
+				}
+
+				status = done == n ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+
+				free(sql);
+			} else if ((status = switch_cache_db_execute_sql(qm->event_db, batch[0], NULL)) == SWITCH_STATUS_SUCCESS) {
+				done = 1;
+			}
+
+			if (done) {
 				switch_mutex_lock(qm->mutex);
-				qm->pre_written[i]++;
+				qm->pre_written[i] += done;
 				switch_mutex_unlock(qm->mutex);
-				ttl++;
+				ttl += done;
 			}
-			switch_safe_free(pop);
-			if (status != SWITCH_STATUS_SUCCESS) break;
+
+			for (x = 0; x < n; x++) {
+				switch_safe_free(batch[x]);
+			}
+
+			if (status != SWITCH_STATUS_SUCCESS && !next) break;
 		} else {
 			break;
 		}
@@ -2069,6 +2707,10 @@ static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread,
 
 	qm->thread_running = 1;
 
+	if (qm->event_db->type == SCDB_TYPE_ODBC && !qm->bulk_rows_set) {
+		qm->bulk_rows = 0;
+	}
+
 	switch_mutex_lock(qm->cond_mutex);
 
 	switch (qm->event_db->type) {
@@ -2244,6 +2886,31 @@ static void core_event_handler(switch_event_t *event)
 		break;
 	}
 
+	/* the channel registry has these, the tables are only kept when something still reads them */
+	if (switch_test_flag((&runtime), SCF_NO_CHANNEL_SQL)) {
+		switch (event->event_id) {
+		case SWITCH_EVENT_CHANNEL_UUID:
+		case SWITCH_EVENT_CHANNEL_CREATE:
+		case SWITCH_EVENT_CHANNEL_DESTROY:
+		case SWITCH_EVENT_CHANNEL_ANSWER:
+		case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
+		case SWITCH_EVENT_CODEC:
+		case SWITCH_EVENT_CHANNEL_HOLD:
+		case SWITCH_EVENT_CHANNEL_UNHOLD:
+		case SWITCH_EVENT_CHANNEL_EXECUTE:
+		case SWITCH_EVENT_CHANNEL_ORIGINATE:
+		case SWITCH_EVENT_CALL_UPDATE:
+		case SWITCH_EVENT_CHANNEL_CALLSTATE:
+		case SWITCH_EVENT_CHANNEL_STATE:
+		case SWITCH_EVENT_CHANNEL_BRIDGE:
+		case SWITCH_EVENT_CHANNEL_UNBRIDGE:
+		case SWITCH_EVENT_CALL_SECURE:
+			return;
+		default:
+			break;
+		}
+	}
+
 	switch (event->event_id) {
 	case SWITCH_EVENT_ADD_SCHEDULE:
 		{
@@ -2513,155 +3180,971 @@ static void core_event_handler(switch_event_t *event)
 				}
 				break;
 			default:
-				new_sql() = switch_mprintf("update channels set state='%q' where uuid='%q'",
-										   switch_event_get_header_nil(event, "channel-state"),
-										   switch_event_get_header_nil(event, "unique-id"));
+				new_sql() = switch_mprintf("update channels set state='%q' where uuid='%q'",
+										   switch_event_get_header_nil(event, "channel-state"),
+										   switch_event_get_header_nil(event, "unique-id"));
+				break;
+			}
+
+			break;
+
+
+		}
+	case SWITCH_EVENT_CHANNEL_BRIDGE:
+		{
+			const char *a_uuid, *b_uuid, *uuid;
+
+			a_uuid = switch_event_get_header(event, "Bridge-A-Unique-ID");
+			b_uuid = switch_event_get_header(event, "Bridge-B-Unique-ID");
+			uuid = switch_event_get_header(event, "unique-id");
+
+			if (zstr(a_uuid) || zstr(b_uuid)) {
+				a_uuid = switch_event_get_header_nil(event, "caller-unique-id");
+				b_uuid = switch_event_get_header_nil(event, "other-leg-unique-id");
+			}
+
+			if (uuid && (extra_cols = parse_presence_data_cols(event))) {
+				new_sql() = switch_mprintf("update channels set %s where uuid='%q'", extra_cols, uuid);
+				switch_safe_free(extra_cols);
+			}
+
+			new_sql() = switch_mprintf("update channels set call_uuid='%q' where uuid='%q' or uuid='%q'",
+									   switch_event_get_header_nil(event, "channel-call-uuid"), a_uuid, b_uuid);
+
+
+			new_sql() = switch_mprintf("insert into calls (call_uuid,call_created,call_created_epoch,"
+									   "caller_uuid,callee_uuid,hostname) "
+									   "values ('%q','%q','%ld','%q','%q','%q')",
+									   switch_event_get_header_nil(event, "channel-call-uuid"),
+									   switch_event_get_header_nil(event, "event-date-local"),
+									   (long) switch_epoch_time_now(NULL),
+									   a_uuid,
+									   b_uuid,
+									   switch_core_get_switchname()
+									   );
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_UNBRIDGE:
+		{
+			char *cuuid = switch_event_get_header_nil(event, "caller-unique-id");
+			char *uuid = switch_event_get_header(event, "unique-id");
+
+			if (uuid && (extra_cols = parse_presence_data_cols(event))) {
+				new_sql() = switch_mprintf("update channels set %s where uuid='%q'", extra_cols, uuid);
+				switch_safe_free(extra_cols);
+			}
+
+			new_sql() = switch_mprintf("update channels set call_uuid=uuid where call_uuid='%q'",
+									   switch_event_get_header_nil(event, "channel-call-uuid"));
+
+			new_sql() = switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')",
+									   cuuid, cuuid);
+			break;
+		}
+	case SWITCH_EVENT_SHUTDOWN:
+		new_sql() = switch_mprintf("delete from channels where hostname='%q';"
+								   "delete from interfaces where hostname='%q';"
+								   "delete from calls where hostname='%q'",
+								   switch_core_get_switchname(), switch_core_get_hostname(), switch_core_get_switchname()
+								   );
+		break;
+	case SWITCH_EVENT_LOG:
+		return;
+	case SWITCH_EVENT_MODULE_LOAD:
+		{
+			const char *type = switch_event_get_header_nil(event, "type");
+			const char *name = switch_event_get_header_nil(event, "name");
+			const char *description = switch_event_get_header_nil(event, "description");
+			const char *syntax = switch_event_get_header_nil(event, "syntax");
+			const char *key = switch_event_get_header_nil(event, "key");
+			const char *filename = switch_event_get_header_nil(event, "filename");
+			if (!zstr(type) && !zstr(name)) {
+				new_sql() =
+					switch_mprintf
+					("insert into interfaces (type,name,description,syntax,ikey,filename,hostname) values('%q','%q','%q','%q','%q','%q','%q')", type, name,
+					 switch_str_nil(description), switch_str_nil(syntax), switch_str_nil(key), switch_str_nil(filename),
+					 switch_core_get_hostname()
+					 );
+			}
+			break;
+		}
+	case SWITCH_EVENT_MODULE_UNLOAD:
+		{
+			const char *type = switch_event_get_header_nil(event, "type");
+			const char *name = switch_event_get_header_nil(event, "name");
+			if (!zstr(type) && !zstr(name)) {
+				new_sql() = switch_mprintf("delete from interfaces where type='%q' and name='%q' and hostname='%q'", type, name,
+										   switch_core_get_hostname());
+			}
+			break;
+		}
+	case SWITCH_EVENT_CALL_SECURE:
+		{
+			const char *type = switch_event_get_header_nil(event, "secure_type");
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Secure Type: %s\n", type);
+			if (zstr(type)) {
+				break;
+			}
+			new_sql() = switch_mprintf("update channels set secure='%q' where uuid='%q'",
+									   type, switch_event_get_header_nil(event, "caller-unique-id")
+									   );
+			break;
+		}
+	case SWITCH_EVENT_NAT:
+		{
+			const char *op = switch_event_get_header_nil(event, "op");
+			switch_bool_t sticky = switch_true(switch_event_get_header_nil(event, "sticky"));
+			if (!strcmp("add", op)) {
+				new_sql() = switch_mprintf("insert into nat (port, proto, sticky, hostname) values (%q, %q, %d,'%q')",
+										   switch_event_get_header_nil(event, "port"),
+										   switch_event_get_header_nil(event, "proto"), sticky, switch_core_get_hostname()
+										   );
+			} else if (!strcmp("del", op)) {
+				new_sql() = switch_mprintf("delete from nat where port=%q and proto=%q and hostname='%q'",
+										   switch_event_get_header_nil(event, "port"),
+										   switch_event_get_header_nil(event, "proto"), switch_core_get_hostname());
+			} else if (!strcmp("status", op)) {
+				/* call show nat api */
+			} else if (!strcmp("status_response", op)) {
+				/* ignore */
+			} else {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Unknown op for SWITCH_EVENT_NAT: %s\n", op);
+			}
+			break;
+		}
+	default:
+		break;
+	}
+
+	if (sql_idx) {
+		int i = 0;
+
+
+		for (i = 0; i < sql_idx; i++) {
+			if (switch_stristr("update channels", sql[i]) || switch_stristr("delete from channels", sql[i])) {
+				switch_sql_queue_manager_push(sql_manager.qm, sql[i], 1, SWITCH_FALSE);
+			} else {
+				switch_sql_queue_manager_push(sql_manager.qm, sql[i], 0, SWITCH_FALSE);
+			}
+			sql[i] = NULL;
+		}
+	}
+}
+
+
+/* In-memory channel registry.
+ *
+ * Mirrors the channels and calls tables from the same events core_event_handler() turns into sql, so show channels,
+ * show calls and lookups by presence_id or call_uuid are answered without a database round trip, and the tables
+ * themselves can be turned off with core-channels-sql=false.  Only channels on this box are kept so there is no
+ * hostname to index on, every row carries switchname like the tables do.
+ */
+
+typedef enum {
+	CRC_UUID,
+	CRC_DIRECTION,
+	CRC_CREATED,
+	CRC_CREATED_EPOCH,
+	CRC_NAME,
+	CRC_STATE,
+	CRC_CID_NAME,
+	CRC_CID_NUM,
+	CRC_IP_ADDR,
+	CRC_DEST,
+	CRC_APPLICATION,
+	CRC_APPLICATION_DATA,
+	CRC_DIALPLAN,
+	CRC_CONTEXT,
+	CRC_READ_CODEC,
+	CRC_READ_RATE,
+	CRC_READ_BIT_RATE,
+	CRC_WRITE_CODEC,
+	CRC_WRITE_RATE,
+	CRC_WRITE_BIT_RATE,
+	CRC_SECURE,
+	CRC_HOSTNAME,
+	CRC_PRESENCE_ID,
+	CRC_PRESENCE_DATA,
+	CRC_ACCOUNTCODE,
+	CRC_CALLSTATE,
+	CRC_CALLEE_NAME,
+	CRC_CALLEE_NUM,
+	CRC_CALLEE_DIRECTION,
+	CRC_CALL_UUID,
+	CRC_SENT_CALLEE_NAME,
+	CRC_SENT_CALLEE_NUM,
+	CRC_INITIAL_CID_NAME,
+	CRC_INITIAL_CID_NUM,
+	CRC_INITIAL_IP_ADDR,
+	CRC_INITIAL_DEST,
+	CRC_INITIAL_DIALPLAN,
+	CRC_INITIAL_CONTEXT,
+	CRC_COUNT
+} channel_registry_col_t;
+
+/* same order as create_channels_sql */
+static char *channel_registry_cols[CRC_COUNT] = {
+	"uuid", "direction", "created", "created_epoch", "name", "state", "cid_name", "cid_num", "ip_addr", "dest",
+	"application", "application_data", "dialplan", "context", "read_codec", "read_rate", "read_bit_rate",
+	"write_codec", "write_rate", "write_bit_rate", "secure", "hostname", "presence_id", "presence_data", "accountcode",
+	"callstate", "callee_name", "callee_num", "callee_direction", "call_uuid", "sent_callee_name", "sent_callee_num",
+	"initial_cid_name", "initial_cid_num", "initial_ip_addr", "initial_dest", "initial_dialplan", "initial_context"
+};
+
+/* the a and b leg columns of the basic_calls view, detailed_calls has everything up to sent_callee_num */
+static const channel_registry_col_t basic_calls_a_cols[] = {
+	CRC_UUID, CRC_DIRECTION, CRC_CREATED, CRC_CREATED_EPOCH, CRC_NAME, CRC_STATE, CRC_CID_NAME, CRC_CID_NUM, CRC_IP_ADDR, CRC_DEST,
+	CRC_PRESENCE_ID, CRC_PRESENCE_DATA, CRC_ACCOUNTCODE, CRC_CALLSTATE, CRC_CALLEE_NAME, CRC_CALLEE_NUM, CRC_CALLEE_DIRECTION,
+	CRC_CALL_UUID, CRC_HOSTNAME, CRC_SENT_CALLEE_NAME, CRC_SENT_CALLEE_NUM
+};
+
+static const channel_registry_col_t basic_calls_b_cols[] = {
+	CRC_UUID, CRC_DIRECTION, CRC_CREATED, CRC_CREATED_EPOCH, CRC_NAME, CRC_STATE, CRC_CID_NAME, CRC_CID_NUM, CRC_IP_ADDR, CRC_DEST,
+	CRC_PRESENCE_ID, CRC_PRESENCE_DATA, CRC_ACCOUNTCODE, CRC_CALLSTATE, CRC_CALLEE_NAME, CRC_CALLEE_NUM, CRC_CALLEE_DIRECTION,
+	CRC_SENT_CALLEE_NAME, CRC_SENT_CALLEE_NUM
+};
+
+#define CR_INDEX_PRESENCE_ID 0
+#define CR_INDEX_CALL_UUID 1
+#define CR_INDEX_COUNT 2
+
+static const channel_registry_col_t channel_registry_index_cols[CR_INDEX_COUNT] = { CRC_PRESENCE_ID, CRC_CALL_UUID };
+
+typedef struct registry_channel_s {
+	char *cols[CRC_COUNT];
+	struct registry_channel_s *prev;
+	struct registry_channel_s *next;
+	struct registry_channel_s *index_next[CR_INDEX_COUNT];
+} registry_channel_t;
+
+typedef struct registry_call_s {
+	char *call_uuid;
+	char *call_created;
+	char *call_created_epoch;
+	char *caller_uuid;
+	char *callee_uuid;
+} registry_call_t;
+
+static struct {
+	switch_thread_rwlock_t *rwlock;
+	switch_hash_t *by_uuid;
+	switch_hash_t *index[CR_INDEX_COUNT];
+	switch_hash_t *calls_by_caller;
+	switch_hash_t *calls_by_callee;
+	registry_channel_t *head;
+	registry_channel_t *tail;
+	char *b_cols[CRC_COUNT];
+} channel_registry;
+
+static void registry_index_del(int i, registry_channel_t *chan)
+{
+	const char *key = chan->cols[channel_registry_index_cols[i]];
+	registry_channel_t *cur, *last = NULL;
+
+	if (zstr(key)) {
+		return;
+	}
+
+	for (cur = switch_core_hash_find(channel_registry.index[i], key); cur && cur != chan; cur = cur->index_next[i]) {
+		last = cur;
+	}
+
+	if (!cur) {
+		return;
+	}
+
+	if (last) {
+		last->index_next[i] = chan->index_next[i];
+	} else if (chan->index_next[i]) {
+		switch_core_hash_insert(channel_registry.index[i], key, chan->index_next[i]);
+	} else {
+		switch_core_hash_delete(channel_registry.index[i], key);
+	}
+
+	chan->index_next[i] = NULL;
+}
+
+/* appended so a lookup lists the channels in the order they got the key, like the walk of the whole list */
+static void registry_index_add(int i, registry_channel_t *chan)
+{
+	const char *key = chan->cols[channel_registry_index_cols[i]];
+	registry_channel_t *cur;
+
+	chan->index_next[i] = NULL;
+
+	if (zstr(key)) {
+		return;
+	}
+
+	if (!(cur = switch_core_hash_find(channel_registry.index[i], key))) {
+		switch_core_hash_insert(channel_registry.index[i], key, chan);
+		return;
+	}
+
+	while (cur->index_next[i]) {
+		cur = cur->index_next[i];
+	}
+
+	cur->index_next[i] = chan;
+}
+
+static void registry_set(registry_channel_t *chan, channel_registry_col_t col, const char *val)
+{
+	int i;
+
+	for (i = 0; i < CR_INDEX_COUNT; i++) {
+		if (channel_registry_index_cols[i] == col) {
+			registry_index_del(i, chan);
+		}
+	}
+
+	switch_safe_free(chan->cols[col]);
+	chan->cols[col] = val ? strdup(val) : NULL;
+
+	for (i = 0; i < CR_INDEX_COUNT; i++) {
+		if (channel_registry_index_cols[i] == col) {
+			registry_index_add(i, chan);
+		}
+	}
+}
+
+#define registry_set_header(chan, col, header) registry_set(chan, col, switch_event_get_header_nil(event, header))
+
+/* the presence-data-cols the sql gets as extra assignments, columns the table does not have by default are ignored */
+static void registry_set_presence_data_cols(registry_channel_t *chan, switch_event_t *event)
+{
+	const char *data = switch_event_get_header(event, "presence-data-cols");
+	char *data_copy, *cols[128] = { 0 };
+	char col_name[128] = "";
+	int col_count, i, c;
+
+	if (zstr(data)) {
+		return;
+	}
+
+	data_copy = strdup(data);
+	col_count = switch_split(data_copy, ':', cols);
+
+	for (i = 0; i < col_count; i++) {
+		const char *val;
+
+		switch_snprintf(col_name, sizeof(col_name), "PD-%s", cols[i]);
+		val = switch_event_get_header(event, col_name);
+
+		for (c = 0; c < CRC_COUNT; c++) {
+			if (!strcasecmp(cols[i], channel_registry_cols[c])) {
+				registry_set(chan, (channel_registry_col_t) c, zstr(val) ? NULL : val);
+				break;
+			}
+		}
+	}
+
+	free(data_copy);
+}
+
+/* update channels set call_uuid=<to, or the channel's own uuid> where call_uuid=<from> */
+static void registry_move_call_uuid(const char *from, const char *to)
+{
+	registry_channel_t *chan, *next;
+
+	if (zstr(from)) {
+		return;
+	}
+
+	for (chan = switch_core_hash_find(channel_registry.index[CR_INDEX_CALL_UUID], from); chan; chan = next) {
+		const char *val = to ? to : chan->cols[CRC_UUID];
+
+		next = chan->index_next[CR_INDEX_CALL_UUID];
+
+		if (strcmp(val, from)) {
+			registry_set(chan, CRC_CALL_UUID, val);
+		}
+	}
+}
+
+static void registry_call_destroy(registry_call_t *call)
+{
+	if (call->caller_uuid && switch_core_hash_find(channel_registry.calls_by_caller, call->caller_uuid) == call) {
+		switch_core_hash_delete(channel_registry.calls_by_caller, call->caller_uuid);
+	}
+
+	if (call->callee_uuid && switch_core_hash_find(channel_registry.calls_by_callee, call->callee_uuid) == call) {
+		switch_core_hash_delete(channel_registry.calls_by_callee, call->callee_uuid);
+	}
+
+	switch_safe_free(call->call_uuid);
+	switch_safe_free(call->call_created);
+	switch_safe_free(call->call_created_epoch);
+	switch_safe_free(call->caller_uuid);
+	switch_safe_free(call->callee_uuid);
+	free(call);
+}
+
+/* delete from calls where (caller_uuid=<uuid> or callee_uuid=<uuid>) */
+static void registry_calls_del(const char *uuid)
+{
+	registry_call_t *call;
+
+	if (zstr(uuid)) {
+		return;
+	}
+
+	if ((call = switch_core_hash_find(channel_registry.calls_by_caller, uuid))) {
+		registry_call_destroy(call);
+	}
+
+	if ((call = switch_core_hash_find(channel_registry.calls_by_callee, uuid))) {
+		registry_call_destroy(call);
+	}
+}
+
+static void registry_calls_add(switch_event_t *event, const char *a_uuid, const char *b_uuid)
+{
+	registry_call_t *call, *old;
+	char epoch[32];
+
+	switch_zmalloc(call, sizeof(*call));
+	switch_snprintf(epoch, sizeof(epoch), "%ld", (long) switch_epoch_time_now(NULL));
+
+	call->call_uuid = strdup(switch_event_get_header_nil(event, "channel-call-uuid"));
+	call->call_created = strdup(switch_event_get_header_nil(event, "event-date-local"));
+	call->call_created_epoch = strdup(epoch);
+	call->caller_uuid = strdup(a_uuid);
+	call->callee_uuid = strdup(b_uuid);
+
+	if ((old = switch_core_hash_find(channel_registry.calls_by_caller, a_uuid))) {
+		registry_call_destroy(old);
+	}
+
+	if ((old = switch_core_hash_find(channel_registry.calls_by_callee, b_uuid))) {
+		registry_call_destroy(old);
+	}
+
+	switch_core_hash_insert(channel_registry.calls_by_caller, a_uuid, call);
+	switch_core_hash_insert(channel_registry.calls_by_callee, b_uuid, call);
+}
+
+static registry_channel_t *registry_channel_create(const char *uuid)
+{
+	registry_channel_t *chan;
+
+	switch_zmalloc(chan, sizeof(*chan));
+	chan->cols[CRC_UUID] = strdup(uuid);
+	switch_core_hash_insert(channel_registry.by_uuid, uuid, chan);
+
+	if ((chan->prev = channel_registry.tail)) {
+		chan->prev->next = chan;
+	} else {
+		channel_registry.head = chan;
+	}
+	channel_registry.tail = chan;
+
+	return chan;
+}
+
+static void registry_channel_destroy(registry_channel_t *chan)
+{
+	int i;
+
+	for (i = 0; i < CR_INDEX_COUNT; i++) {
+		registry_index_del(i, chan);
+	}
+
+	switch_core_hash_delete(channel_registry.by_uuid, chan->cols[CRC_UUID]);
+
+	if (chan->prev) {
+		chan->prev->next = chan->next;
+	} else {
+		channel_registry.head = chan->next;
+	}
+
+	if (chan->next) {
+		chan->next->prev = chan->prev;
+	} else {
+		channel_registry.tail = chan->prev;
+	}
+
+	for (i = 0; i < CRC_COUNT; i++) {
+		switch_safe_free(chan->cols[i]);
+	}
+
+	free(chan);
+}
+
+static void registry_clear(void)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	while (channel_registry.head) {
+		registry_channel_destroy(channel_registry.head);
+	}
+
+	while ((hi = switch_core_hash_first(channel_registry.calls_by_caller))) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		switch_safe_free(hi);
+		registry_call_destroy((registry_call_t *) val);
+	}
+
+	while ((hi = switch_core_hash_first(channel_registry.calls_by_callee))) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		switch_safe_free(hi);
+		registry_call_destroy((registry_call_t *) val);
+	}
+}
+
+static void channel_registry_event_handler(switch_event_t *event)
+{
+	registry_channel_t *chan = NULL;
+	const char *uuid = switch_event_get_header(event, "unique-id");
+
+	switch (event->event_id) {
+	case SWITCH_EVENT_CHANNEL_UUID:
+	case SWITCH_EVENT_CHANNEL_CREATE:
+	case SWITCH_EVENT_CHANNEL_ANSWER:
+	case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
+	case SWITCH_EVENT_CHANNEL_HOLD:
+	case SWITCH_EVENT_CHANNEL_UNHOLD:
+	case SWITCH_EVENT_CHANNEL_EXECUTE:
+	case SWITCH_EVENT_CHANNEL_ORIGINATE:
+	case SWITCH_EVENT_CALL_UPDATE:
+	case SWITCH_EVENT_CHANNEL_CALLSTATE:
+	case SWITCH_EVENT_CHANNEL_STATE:
+	case SWITCH_EVENT_CHANNEL_BRIDGE:
+	case SWITCH_EVENT_CHANNEL_UNBRIDGE:
+	case SWITCH_EVENT_CALL_SECURE:
+		/* late events for a channel that is already gone must not bring it back */
+		if (uuid && !switch_ivr_uuid_exists(uuid)) {
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch_thread_rwlock_wrlock(channel_registry.rwlock);
+
+	if (uuid) {
+		chan = switch_core_hash_find(channel_registry.by_uuid, uuid);
+	}
+
+	switch (event->event_id) {
+	case SWITCH_EVENT_CHANNEL_CREATE:
+		if (!chan && uuid) {
+			char epoch[32];
+
+			switch_snprintf(epoch, sizeof(epoch), "%ld", (long) switch_epoch_time_now(NULL));
+
+			chan = registry_channel_create(uuid);
+			registry_set_header(chan, CRC_DIRECTION, "call-direction");
+			registry_set_header(chan, CRC_CREATED, "event-date-local");
+			registry_set(chan, CRC_CREATED_EPOCH, epoch);
+			registry_set_header(chan, CRC_NAME, "channel-name");
+			registry_set_header(chan, CRC_STATE, "channel-state");
+			registry_set_header(chan, CRC_CALLSTATE, "channel-call-state");
+			registry_set_header(chan, CRC_DIALPLAN, "caller-dialplan");
+			registry_set_header(chan, CRC_CONTEXT, "caller-context");
+			registry_set(chan, CRC_HOSTNAME, switch_core_get_switchname());
+			registry_set_header(chan, CRC_INITIAL_CID_NAME, "caller-caller-id-name");
+			registry_set_header(chan, CRC_INITIAL_CID_NUM, "caller-caller-id-number");
+			registry_set_header(chan, CRC_INITIAL_IP_ADDR, "caller-network-addr");
+			registry_set_header(chan, CRC_INITIAL_DEST, "caller-destination-number");
+			registry_set_header(chan, CRC_INITIAL_DIALPLAN, "caller-dialplan");
+			registry_set_header(chan, CRC_INITIAL_CONTEXT, "caller-context");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_DESTROY:
+		registry_calls_del(uuid);
+		if (chan) {
+			registry_channel_destroy(chan);
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_UUID:
+		{
+			const char *old_uuid = switch_event_get_header(event, "old-unique-id");
+			registry_channel_t *old;
+
+			if (uuid && old_uuid && !chan && (old = switch_core_hash_find(channel_registry.by_uuid, old_uuid))) {
+				switch_core_hash_delete(channel_registry.by_uuid, old_uuid);
+				registry_set(old, CRC_UUID, uuid);
+				switch_core_hash_insert(channel_registry.by_uuid, uuid, old);
+			}
+
+			if (uuid) {
+				registry_move_call_uuid(old_uuid, uuid);
+			}
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_ANSWER:
+	case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
+	case SWITCH_EVENT_CODEC:
+		if (chan) {
+			registry_set_header(chan, CRC_READ_CODEC, "channel-read-codec-name");
+			registry_set_header(chan, CRC_READ_RATE, "channel-read-codec-rate");
+			registry_set_header(chan, CRC_READ_BIT_RATE, "channel-read-codec-bit-rate");
+			registry_set_header(chan, CRC_WRITE_CODEC, "channel-write-codec-name");
+			registry_set_header(chan, CRC_WRITE_RATE, "channel-write-codec-rate");
+			registry_set_header(chan, CRC_WRITE_BIT_RATE, "channel-write-codec-bit-rate");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_HOLD:
+	case SWITCH_EVENT_CHANNEL_UNHOLD:
+	case SWITCH_EVENT_CHANNEL_EXECUTE:
+		if (chan) {
+			registry_set_header(chan, CRC_APPLICATION, "application");
+			registry_set_header(chan, CRC_APPLICATION_DATA, "application-data");
+			registry_set_header(chan, CRC_PRESENCE_ID, "channel-presence-id");
+			registry_set_header(chan, CRC_PRESENCE_DATA, "channel-presence-data");
+			registry_set_header(chan, CRC_ACCOUNTCODE, "variable_accountcode");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_ORIGINATE:
+		if (chan) {
+			registry_set_header(chan, CRC_PRESENCE_ID, "channel-presence-id");
+			registry_set_header(chan, CRC_PRESENCE_DATA, "channel-presence-data");
+			registry_set_header(chan, CRC_ACCOUNTCODE, "variable_accountcode");
+			registry_set_header(chan, CRC_CALL_UUID, "channel-call-uuid");
+			registry_set_presence_data_cols(chan, event);
+		}
+		break;
+	case SWITCH_EVENT_CALL_UPDATE:
+		if (chan) {
+			registry_set_header(chan, CRC_CALLEE_NAME, "caller-callee-id-name");
+			registry_set_header(chan, CRC_CALLEE_NUM, "caller-callee-id-number");
+			registry_set_header(chan, CRC_SENT_CALLEE_NAME, "sent-callee-id-name");
+			registry_set_header(chan, CRC_SENT_CALLEE_NUM, "sent-callee-id-number");
+			registry_set_header(chan, CRC_CALLEE_DIRECTION, "direction");
+			registry_set_header(chan, CRC_CID_NAME, "caller-caller-id-name");
+			registry_set_header(chan, CRC_CID_NUM, "caller-caller-id-number");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_CALLSTATE:
+		if (chan) {
+			const char *num = switch_event_get_header(event, "channel-call-state-number");
+			switch_channel_callstate_t callstate = num ? (switch_channel_callstate_t) atoi(num) : CCS_DOWN;
+
+			if (callstate != CCS_DOWN && callstate != CCS_HANGUP) {
+				registry_set_header(chan, CRC_CALLSTATE, "channel-call-state");
+				registry_set_presence_data_cols(chan, event);
+			}
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_STATE:
+		if (chan) {
+			const char *state = switch_event_get_header(event, "channel-state-number");
+			switch_channel_state_t state_i = zstr(state) ? CS_DESTROY : (switch_channel_state_t) atoi(state);
+
+			switch (state_i) {
+			case CS_NEW:
+			case CS_DESTROY:
+			case CS_REPORTING:
+#ifndef SWITCH_DEPRECATED_CORE_DB
+			case CS_HANGUP:
+#endif
+			case CS_INIT:
+				break;
+			case CS_EXECUTE:
+				registry_set_header(chan, CRC_STATE, "channel-state");
+				registry_set_presence_data_cols(chan, event);
+				break;
+			case CS_ROUTING:
+				registry_set_header(chan, CRC_STATE, "channel-state");
+				registry_set_header(chan, CRC_CID_NAME, "caller-caller-id-name");
+				registry_set_header(chan, CRC_CID_NUM, "caller-caller-id-number");
+				registry_set_header(chan, CRC_CALLEE_NAME, "caller-callee-id-name");
+				registry_set_header(chan, CRC_CALLEE_NUM, "caller-callee-id-number");
+				registry_set_header(chan, CRC_SENT_CALLEE_NAME, "sent-callee-id-name");
+				registry_set_header(chan, CRC_SENT_CALLEE_NUM, "sent-callee-id-number");
+				registry_set_header(chan, CRC_IP_ADDR, "caller-network-addr");
+				registry_set_header(chan, CRC_DEST, "caller-destination-number");
+				registry_set_header(chan, CRC_DIALPLAN, "caller-dialplan");
+				registry_set_header(chan, CRC_CONTEXT, "caller-context");
+				registry_set_header(chan, CRC_PRESENCE_ID, "channel-presence-id");
+				registry_set_header(chan, CRC_PRESENCE_DATA, "channel-presence-data");
+				registry_set_header(chan, CRC_ACCOUNTCODE, "variable_accountcode");
+				registry_set_presence_data_cols(chan, event);
+				break;
+			default:
+				registry_set_header(chan, CRC_STATE, "channel-state");
 				break;
 			}
-
-			break;
-
-
 		}
+		break;
 	case SWITCH_EVENT_CHANNEL_BRIDGE:
 		{
-			const char *a_uuid, *b_uuid, *uuid;
-
-			a_uuid = switch_event_get_header(event, "Bridge-A-Unique-ID");
-			b_uuid = switch_event_get_header(event, "Bridge-B-Unique-ID");
-			uuid = switch_event_get_header(event, "unique-id");
+			const char *a_uuid = switch_event_get_header(event, "Bridge-A-Unique-ID");
+			const char *b_uuid = switch_event_get_header(event, "Bridge-B-Unique-ID");
+			const char *call_uuid = switch_event_get_header_nil(event, "channel-call-uuid");
+			registry_channel_t *leg;
 
 			if (zstr(a_uuid) || zstr(b_uuid)) {
 				a_uuid = switch_event_get_header_nil(event, "caller-unique-id");
 				b_uuid = switch_event_get_header_nil(event, "other-leg-unique-id");
 			}
 
-			if (uuid && (extra_cols = parse_presence_data_cols(event))) {
-				new_sql() = switch_mprintf("update channels set %s where uuid='%q'", extra_cols, uuid);
-				switch_safe_free(extra_cols);
+			if (chan) {
+				registry_set_presence_data_cols(chan, event);
 			}
 
-			new_sql() = switch_mprintf("update channels set call_uuid='%q' where uuid='%q' or uuid='%q'",
-									   switch_event_get_header_nil(event, "channel-call-uuid"), a_uuid, b_uuid);
+			if ((leg = switch_core_hash_find(channel_registry.by_uuid, a_uuid))) {
+				registry_set(leg, CRC_CALL_UUID, call_uuid);
+			}
 
+			if ((leg = switch_core_hash_find(channel_registry.by_uuid, b_uuid))) {
+				registry_set(leg, CRC_CALL_UUID, call_uuid);
+			}
 
-			new_sql() = switch_mprintf("insert into calls (call_uuid,call_created,call_created_epoch,"
-									   "caller_uuid,callee_uuid,hostname) "
-									   "values ('%q','%q','%ld','%q','%q','%q')",
-									   switch_event_get_header_nil(event, "channel-call-uuid"),
-									   switch_event_get_header_nil(event, "event-date-local"),
-									   (long) switch_epoch_time_now(NULL),
-									   a_uuid,
-									   b_uuid,
-									   switch_core_get_switchname()
-									   );
+			registry_calls_add(event, a_uuid, b_uuid);
 		}
 		break;
 	case SWITCH_EVENT_CHANNEL_UNBRIDGE:
+		if (chan) {
+			registry_set_presence_data_cols(chan, event);
+		}
+
+		registry_move_call_uuid(switch_event_get_header(event, "channel-call-uuid"), NULL);
+		registry_calls_del(switch_event_get_header(event, "caller-unique-id"));
+		break;
+	case SWITCH_EVENT_CALL_SECURE:
 		{
-			char *cuuid = switch_event_get_header_nil(event, "caller-unique-id");
-			char *uuid = switch_event_get_header(event, "unique-id");
+			const char *type = switch_event_get_header(event, "secure_type");
+			const char *caller_uuid = switch_event_get_header(event, "caller-unique-id");
 
-			if (uuid && (extra_cols = parse_presence_data_cols(event))) {
-				new_sql() = switch_mprintf("update channels set %s where uuid='%q'", extra_cols, uuid);
-				switch_safe_free(extra_cols);
+			if (!zstr(type) && caller_uuid && (chan = switch_core_hash_find(channel_registry.by_uuid, caller_uuid))) {
+				registry_set(chan, CRC_SECURE, type);
 			}
-
-			new_sql() = switch_mprintf("update channels set call_uuid=uuid where call_uuid='%q'",
-									   switch_event_get_header_nil(event, "channel-call-uuid"));
-
-			new_sql() = switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')",
-									   cuuid, cuuid);
-			break;
 		}
+		break;
 	case SWITCH_EVENT_SHUTDOWN:
-		new_sql() = switch_mprintf("delete from channels where hostname='%q';"
-								   "delete from interfaces where hostname='%q';"
-								   "delete from calls where hostname='%q'",
-								   switch_core_get_switchname(), switch_core_get_hostname(), switch_core_get_switchname()
-								   );
+		registry_clear();
 		break;
-	case SWITCH_EVENT_LOG:
-		return;
-	case SWITCH_EVENT_MODULE_LOAD:
-		{
-			const char *type = switch_event_get_header_nil(event, "type");
-			const char *name = switch_event_get_header_nil(event, "name");
-			const char *description = switch_event_get_header_nil(event, "description");
-			const char *syntax = switch_event_get_header_nil(event, "syntax");
-			const char *key = switch_event_get_header_nil(event, "key");
-			const char *filename = switch_event_get_header_nil(event, "filename");
-			if (!zstr(type) && !zstr(name)) {
-				new_sql() =
-					switch_mprintf
-					("insert into interfaces (type,name,description,syntax,ikey,filename,hostname) values('%q','%q','%q','%q','%q','%q','%q')", type, name,
-					 switch_str_nil(description), switch_str_nil(syntax), switch_str_nil(key), switch_str_nil(filename),
-					 switch_core_get_hostname()
-					 );
+	default:
+		break;
+	}
+
+	switch_thread_rwlock_unlock(channel_registry.rwlock);
+}
+
+/* sql LIKE, % and _ wildcards, case insensitive like sqlite does for ascii */
+static switch_bool_t registry_like(const char *pattern, const char *str)
+{
+	if (!str) {
+		return SWITCH_FALSE;
+	}
+
+	while (*pattern) {
+		if (*pattern == '%') {
+			while (*pattern == '%') {
+				pattern++;
 			}
-			break;
-		}
-	case SWITCH_EVENT_MODULE_UNLOAD:
-		{
-			const char *type = switch_event_get_header_nil(event, "type");
-			const char *name = switch_event_get_header_nil(event, "name");
-			if (!zstr(type) && !zstr(name)) {
-				new_sql() = switch_mprintf("delete from interfaces where type='%q' and name='%q' and hostname='%q'", type, name,
-										   switch_core_get_hostname());
+
+			if (!*pattern) {
+				return SWITCH_TRUE;
 			}
-			break;
-		}
-	case SWITCH_EVENT_CALL_SECURE:
-		{
-			const char *type = switch_event_get_header_nil(event, "secure_type");
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Secure Type: %s\n", type);
-			if (zstr(type)) {
-				break;
+
+			for (; *str; str++) {
+				if (registry_like(pattern, str)) {
+					return SWITCH_TRUE;
+				}
 			}
-			new_sql() = switch_mprintf("update channels set secure='%q' where uuid='%q'",
-									   type, switch_event_get_header_nil(event, "caller-unique-id")
-									   );
-			break;
+
+			return SWITCH_FALSE;
 		}
-	case SWITCH_EVENT_NAT:
-		{
-			const char *op = switch_event_get_header_nil(event, "op");
-			switch_bool_t sticky = switch_true(switch_event_get_header_nil(event, "sticky"));
-			if (!strcmp("add", op)) {
-				new_sql() = switch_mprintf("insert into nat (port, proto, sticky, hostname) values (%q, %q, %d,'%q')",
-										   switch_event_get_header_nil(event, "port"),
-										   switch_event_get_header_nil(event, "proto"), sticky, switch_core_get_hostname()
-										   );
-			} else if (!strcmp("del", op)) {
-				new_sql() = switch_mprintf("delete from nat where port=%q and proto=%q and hostname='%q'",
-										   switch_event_get_header_nil(event, "port"),
-										   switch_event_get_header_nil(event, "proto"), switch_core_get_hostname());
-			} else if (!strcmp("status", op)) {
-				/* call show nat api */
-			} else if (!strcmp("status_response", op)) {
-				/* ignore */
-			} else {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Unknown op for SWITCH_EVENT_NAT: %s\n", op);
-			}
-			break;
+
+		if (!*str || (*pattern != '_' && switch_tolower(*pattern) != switch_tolower(*str))) {
+			return SWITCH_FALSE;
 		}
-	default:
-		break;
+
+		pattern++;
+		str++;
 	}
 
-	if (sql_idx) {
-		int i = 0;
+	return *str ? SWITCH_FALSE : SWITCH_TRUE;
+}
 
+static switch_bool_t registry_match(registry_channel_t *chan, const switch_channel_registry_filter_t *filter)
+{
+	if (!filter) {
+		return SWITCH_TRUE;
+	}
 
-		for (i = 0; i < sql_idx; i++) {
-			if (switch_stristr("update channels", sql[i]) || switch_stristr("delete from channels", sql[i])) {
-				switch_sql_queue_manager_push(sql_manager.qm, sql[i], 1, SWITCH_FALSE);
-			} else {
-				switch_sql_queue_manager_push(sql_manager.qm, sql[i], 0, SWITCH_FALSE);
+	if (filter->presence_id && (!chan->cols[CRC_PRESENCE_ID] || strcmp(filter->presence_id, chan->cols[CRC_PRESENCE_ID]))) {
+		return SWITCH_FALSE;
+	}
+
+	if (filter->call_uuid && (!chan->cols[CRC_CALL_UUID] || strcmp(filter->call_uuid, chan->cols[CRC_CALL_UUID]))) {
+		return SWITCH_FALSE;
+	}
+
+	if (filter->like && !registry_like(filter->like, chan->cols[CRC_UUID]) && !registry_like(filter->like, chan->cols[CRC_NAME]) &&
+		!registry_like(filter->like, chan->cols[CRC_CID_NAME]) && !registry_like(filter->like, chan->cols[CRC_CID_NUM]) &&
+		!registry_like(filter->like, chan->cols[CRC_PRESENCE_DATA]) && !registry_like(filter->like, chan->cols[CRC_ACCOUNTCODE])) {
+		return SWITCH_FALSE;
+	}
+
+	return SWITCH_TRUE;
+}
+
+static int registry_row(switch_channel_registry_view_t view, registry_channel_t *a, registry_channel_t *b, registry_call_t *call,
+						char **argv, char **names)
+{
+	const channel_registry_col_t *a_cols = basic_calls_a_cols, *b_cols = basic_calls_b_cols;
+	int a_count = sizeof(basic_calls_a_cols) / sizeof(basic_calls_a_cols[0]);
+	int b_count = sizeof(basic_calls_b_cols) / sizeof(basic_calls_b_cols[0]);
+	int argc = 0, i;
+
+	if (view == SCR_VIEW_CHANNELS) {
+		for (i = 0; i < CRC_COUNT; i++) {
+			names[argc] = channel_registry_cols[i];
+			argv[argc++] = a->cols[i];
+		}
+		return argc;
+	}
+
+	if (view == SCR_VIEW_DETAILED_CALLS) {
+		a_cols = b_cols = NULL;
+		a_count = b_count = CRC_SENT_CALLEE_NUM + 1;
+	}
+
+	for (i = 0; i < a_count; i++) {
+		channel_registry_col_t col = a_cols ? a_cols[i] : (channel_registry_col_t) i;
+
+		names[argc] = channel_registry_cols[col];
+		argv[argc++] = a->cols[col];
+	}
+
+	for (i = 0; i < b_count; i++) {
+		channel_registry_col_t col = b_cols ? b_cols[i] : (channel_registry_col_t) i;
+
+		names[argc] = channel_registry.b_cols[col];
+		argv[argc++] = b ? b->cols[col] : NULL;
+	}
+
+	names[argc] = "call_created_epoch";
+	argv[argc++] = call ? call->call_created_epoch : NULL;
+
+	return argc;
+}
+
+SWITCH_DECLARE(uint32_t) switch_core_channel_registry_query(switch_channel_registry_view_t view, const switch_channel_registry_filter_t *filter,
+															switch_core_db_callback_func_t callback, void *pArg)
+{
+	registry_channel_t *chan;
+	char *argv[CRC_COUNT * 2 + 1];
+	char *names[CRC_COUNT * 2 + 1];
+	uint32_t rows = 0;
+	int idx = -1;
+
+	if (!channel_registry.rwlock) {
+		return 0;
+	}
+
+	/* an exact presence_id or call_uuid only walks the channels in that index bucket */
+	if (filter && !zstr(filter->presence_id)) {
+		idx = CR_INDEX_PRESENCE_ID;
+	} else if (filter && !zstr(filter->call_uuid)) {
+		idx = CR_INDEX_CALL_UUID;
+	}
+
+	switch_thread_rwlock_rdlock(channel_registry.rwlock);
+
+	if (idx < 0) {
+		chan = channel_registry.head;
+	} else {
+		chan = switch_core_hash_find(channel_registry.index[idx], idx == CR_INDEX_PRESENCE_ID ? filter->presence_id : filter->call_uuid);
+	}
+
+	for (; chan; chan = idx < 0 ? chan->next : chan->index_next[idx]) {
+		registry_call_t *call = NULL;
+		registry_channel_t *b = NULL;
+		int argc;
+
+		if (!registry_match(chan, filter)) {
+			continue;
+		}
+
+		if (view != SCR_VIEW_CHANNELS) {
+			/* a call is listed once, under its caller */
+			if ((call = switch_core_hash_find(channel_registry.calls_by_caller, chan->cols[CRC_UUID]))) {
+				b = switch_core_hash_find(channel_registry.by_uuid, call->callee_uuid);
+			} else if (switch_core_hash_find(channel_registry.calls_by_callee, chan->cols[CRC_UUID])) {
+				continue;
+			}
+		}
+
+		if (filter && filter->bridged_only && !b) {
+			continue;
+		}
+
+		rows++;
+
+		if (callback) {
+			argc = registry_row(view, chan, b, call, argv, names);
+
+			if (callback(pArg, argc, argv, names)) {
+				break;
 			}
-			sql[i] = NULL;
 		}
 	}
+
+	switch_thread_rwlock_unlock(channel_registry.rwlock);
+
+	return rows;
+}
+
+static switch_event_types_t channel_registry_events[] = {
+	SWITCH_EVENT_CHANNEL_CREATE, SWITCH_EVENT_CHANNEL_DESTROY, SWITCH_EVENT_CHANNEL_UUID, SWITCH_EVENT_CHANNEL_ANSWER,
+	SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA, SWITCH_EVENT_CODEC, SWITCH_EVENT_CHANNEL_HOLD, SWITCH_EVENT_CHANNEL_UNHOLD,
+	SWITCH_EVENT_CHANNEL_EXECUTE, SWITCH_EVENT_CHANNEL_ORIGINATE, SWITCH_EVENT_CALL_UPDATE, SWITCH_EVENT_CHANNEL_CALLSTATE,
+	SWITCH_EVENT_CHANNEL_STATE, SWITCH_EVENT_CHANNEL_BRIDGE, SWITCH_EVENT_CHANNEL_UNBRIDGE, SWITCH_EVENT_CALL_SECURE,
+	SWITCH_EVENT_SHUTDOWN
+};
+
+static void channel_registry_start(switch_memory_pool_t *pool)
+{
+	int i;
+
+	switch_thread_rwlock_create(&channel_registry.rwlock, pool);
+	switch_core_hash_init(&channel_registry.by_uuid);
+	switch_core_hash_init(&channel_registry.calls_by_caller);
+	switch_core_hash_init(&channel_registry.calls_by_callee);
+
+	for (i = 0; i < CR_INDEX_COUNT; i++) {
+		switch_core_hash_init(&channel_registry.index[i]);
+	}
+
+	for (i = 0; i < CRC_COUNT; i++) {
+		channel_registry.b_cols[i] = switch_core_sprintf(pool, "b_%s", channel_registry_cols[i]);
+	}
+
+	for (i = 0; i < (int) (sizeof(channel_registry_events) / sizeof(channel_registry_events[0])); i++) {
+		switch_event_bind("core_registry", channel_registry_events[i], SWITCH_EVENT_SUBCLASS_ANY, channel_registry_event_handler, NULL);
+	}
+}
+
+static void channel_registry_stop(void)
+{
+	int i;
+
+	if (!channel_registry.rwlock) {
+		return;
+	}
+
+	switch_event_unbind_callback(channel_registry_event_handler);
+
+	switch_thread_rwlock_wrlock(channel_registry.rwlock);
+	registry_clear();
+	switch_thread_rwlock_unlock(channel_registry.rwlock);
+
+	switch_core_hash_destroy(&channel_registry.by_uuid);
+	switch_core_hash_destroy(&channel_registry.calls_by_caller);
+	switch_core_hash_destroy(&channel_registry.calls_by_callee);
+
+	for (i = 0; i < CR_INDEX_COUNT; i++) {
+		switch_core_hash_destroy(&channel_registry.index[i]);
+	}
+
+	channel_registry.rwlock = NULL;
 }
 
 
@@ -3366,6 +4849,10 @@ switch_status_t switch_core_sqldb_start(switch_memory_pool_t *pool, switch_bool_
 	switch_mutex_init(&sql_manager.dbh_mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
 	switch_mutex_init(&sql_manager.io_mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
 	switch_mutex_init(&sql_manager.ctl_mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
+	switch_thread_rwlock_create(&sql_manager.pool_rwlock, sql_manager.memory_pool);
+	switch_core_hash_init(&sql_manager.pool_hash);
+
+	channel_registry_start(sql_manager.memory_pool);
 
 	if (!sql_manager.manage) goto skip;
 
@@ -3716,6 +5203,7 @@ void switch_core_sqldb_stop(void)
 	switch_status_t st;
 
 	switch_event_unbind_callback(core_event_handler);
+	channel_registry_stop();
 
 	if (sql_manager.db_thread && sql_manager.db_thread_running) {
 		sql_manager.db_thread_running = -1;
@@ -3728,6 +5216,40 @@ void switch_core_sqldb_stop(void)
 	sql_close(0);
 }
 
+/* sanitize password */
+static void sql_clean_name(const char *name, char *cleankey_str)
+{
+	char *needles[3];
+	const char *pos1 = NULL;
+	const char *pos2 = NULL;
+	int i = 0;
+
+	needles[0] = "pass=\"";
+	needles[1] = "password=";
+	needles[2] = "password='";
+
+	memset(cleankey_str, 0, CACHE_DB_LEN);
+	for (i = 0; i < 3; i++) {
+		if((pos1 = strstr(name, needles[i]))) {
+			pos1 += strlen(needles[i]);
+
+			if (!(pos2 = strstr(pos1, "\""))) {
+				if (!(pos2 = strstr(pos1, "'"))) {
+					if (!(pos2 = strstr(pos1, " "))) {
+						pos2 = pos1 + strlen(pos1);
+					}
+				}
+			}
+			strncpy(cleankey_str, name, pos1 - name);
+			strcpy(&cleankey_str[pos1 - name], pos2);
+			break;
+		}
+	}
+	if (i == 3) {
+		strncpy(cleankey_str, name, strlen(name));
+	}
+}
+
 SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 {
 	/* return some status info suitable for the cli */
@@ -3735,20 +5257,14 @@ SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 	switch_bool_t locked = SWITCH_FALSE;
 	time_t now = switch_epoch_time_now(NULL);
 	char cleankey_str[CACHE_DB_LEN];
-	char *pos1 = NULL;
-	char *pos2 = NULL;
+	switch_hash_index_t *hi;
+	void *val;
 	int count = 0, used = 0;
 
 	switch_mutex_lock(sql_manager.dbh_mutex);
 
 	for (dbh = sql_manager.handle_pool; dbh; dbh = dbh->next) {
-		char *needles[3];
 		time_t diff = 0;
-		int i = 0;
-
-		needles[0] = "pass=\"";
-		needles[1] = "password=";
-		needles[2] = "password='";
 
 		diff = now - dbh->last_used;
 
@@ -3759,27 +5275,7 @@ SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 			locked = SWITCH_TRUE;
 		}
 
-		/* sanitize password */
-		memset(cleankey_str, 0, sizeof(cleankey_str));
-		for (i = 0; i < 3; i++) {
-			if((pos1 = strstr(dbh->name, needles[i]))) {
-				pos1 += strlen(needles[i]);
-
-				if (!(pos2 = strstr(pos1, "\""))) {
-					if (!(pos2 = strstr(pos1, "'"))) {
-						if (!(pos2 = strstr(pos1, " "))) {
-							pos2 = pos1 + strlen(pos1);
-						}
-					}
-				}
-				strncpy(cleankey_str, dbh->name, pos1 - dbh->name);
-				strcpy(&cleankey_str[pos1 - dbh->name], pos2);
-				break;
-			}
-		}
-		if (i == 3) {
-			strncpy(cleankey_str, dbh->name, strlen(dbh->name));
-		}
+		sql_clean_name(dbh->name, cleankey_str);
 
 		count++;
 
@@ -3795,11 +5291,36 @@ SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 							   dbh->total_used_count,
 							   locked ? "Locked" : "Unlocked",
 							   dbh->use_count ? "Attached" : "Detached", dbh->use_count, dbh->creator, dbh->last_user);
+
+		if (dbh->stmt_hits || dbh->stmt_misses) {
+			stream->write_function(stream, "\tPrepared: %u cached, %" SWITCH_UINT64_T_FMT " hits, %" SWITCH_UINT64_T_FMT " misses\n",
+								   dbh->stmt_count, dbh->stmt_hits, dbh->stmt_misses);
+		}
 	}
 
 	stream->write_function(stream, "%d total. %d in use.\n", count, used);
 
 	switch_mutex_unlock(sql_manager.dbh_mutex);
+
+	switch_thread_rwlock_rdlock(sql_manager.pool_rwlock);
+	for (hi = switch_core_hash_first(sql_manager.pool_hash); hi; hi = switch_core_hash_next(&hi)) {
+		sql_pool_t *dsn_pool;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		dsn_pool = (sql_pool_t *) val;
+		sql_clean_name(dsn_pool->name, cleankey_str);
+
+		switch_mutex_lock(dsn_pool->mutex);
+		stream->write_function(stream, "Pool %s\n\tHandles: %u, %u in use, %u waiting\n"
+							   "\tAcquired: %" SWITCH_UINT64_T_FMT ", %" SWITCH_UINT64_T_FMT " by the same thread\n"
+							   "\tWaits: %" SWITCH_UINT64_T_FMT ", %" SWITCH_INT64_T_FMT " us, %" SWITCH_UINT64_T_FMT " timed out\n"
+							   "\tOpened: %" SWITCH_UINT64_T_FMT ", dropped: %" SWITCH_UINT64_T_FMT "\n",
+							   cleankey_str, dsn_pool->total, dsn_pool->used, dsn_pool->waiting,
+							   dsn_pool->acquired, dsn_pool->affinity, dsn_pool->waits, dsn_pool->wait_usec, dsn_pool->timeouts,
+							   dsn_pool->opened, dsn_pool->dropped);
+		switch_mutex_unlock(dsn_pool->mutex);
+	}
+	switch_thread_rwlock_unlock(sql_manager.pool_rwlock);
 }
 
 SWITCH_DECLARE(char*)switch_sql_concat(void)
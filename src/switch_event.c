@@ -38,8 +38,18 @@
 #include "tpl.h"
 #include "private/switch_core_pvt.h"
 
-//#define SWITCH_EVENT_RECYCLE
 #define DISPATCH_QUEUE_LEN 10000
+/* bytes stored in every header allocation for a short name and value, saving the strdup()s */
+#define EVENT_HEADER_INLINE_LEN 96
+#define EVENT_CACHE_SHARDS 16
+#define EVENT_CACHE_MAX_EVENTS 128
+#define EVENT_CACHE_MAX_HEADERS 2048
+/* header names shorter than this are interned in a global table instead of being copied into each header */
+#define EVENT_INTERN_MAX_NAME 64
+#define EVENT_INTERN_SLOTS 8192
+#define EVENT_INTERN_ARENA_LEN (256 * 1024)
+/* events with this many headers get a hashed lookup index instead of walking the list */
+#define EVENT_HEADER_INDEX_MIN 16
 //#define DEBUG_DISPATCH_QUEUES
 
 /*! \brief A node to store binded events */
@@ -57,6 +67,46 @@ struct switch_event_node {
 	struct switch_event_node *next;
 };
 
+/*! \brief A precomputed list of the bindings an event may be delivered to */
+typedef struct switch_event_dispatch_list {
+	switch_event_node_t **nodes;
+	uint32_t count;
+} switch_event_dispatch_list_t;
+
+/*! \brief Per event id delivery index, rebuilt under RWLOCK whenever the bindings change */
+typedef struct switch_event_dispatch_index {
+	/*! bindings for events that carry no subclass */
+	switch_event_dispatch_list_t plain;
+	/*! bindings for subclassed events nobody bound to by exact subclass name */
+	switch_event_dispatch_list_t subclass;
+	/*! subclass name -> switch_event_dispatch_list_t for subclasses with exact bindings */
+	switch_hash_t *subclass_hash;
+} switch_event_dispatch_index_t;
+
+/*! \brief A cache of released events and headers, the calling thread picks one by its id */
+typedef struct switch_event_cache {
+	switch_mutex_t *mutex;
+	/*! released events linked by their next pointer */
+	switch_event_t *events;
+	uint32_t event_count;
+	/*! released headers linked by their next pointer */
+	switch_event_header_t *headers;
+	uint32_t header_count;
+} switch_event_cache_t;
+
+/*! \brief A read only event copy and its renderings, shared by reference between consumers */
+struct switch_event_shared {
+	switch_event_t *event;
+	char *serialized[SWITCH_EVENT_SERIAL_MAX];
+	volatile switch_atomic_t refs;
+};
+
+/*! \brief An interned header name */
+typedef struct switch_event_intern {
+	const char *name;
+	unsigned long hash;
+} switch_event_intern_t;
+
 /*! \brief A registered custom event subclass  */
 struct switch_event_subclass {
 	/*! the owner of the subclass */
@@ -83,6 +133,7 @@ static unsigned int SOFT_MAX_DISPATCH = 0;
 static char guess_ip_v4[80] = "";
 static char guess_ip_v6[80] = "";
 static switch_event_node_t *EVENT_NODES[SWITCH_EVENT_ALL + 1] = { NULL };
+static switch_event_dispatch_index_t *EVENT_INDEX[SWITCH_EVENT_ALL + 1] = { NULL };
 static switch_thread_rwlock_t *RWLOCK = NULL;
 static switch_mutex_t *BLOCK = NULL;
 static switch_mutex_t *POOL_LOCK = NULL;
@@ -90,10 +141,12 @@ static switch_memory_pool_t *RUNTIME_POOL = NULL;
 static switch_memory_pool_t *THRUNTIME_POOL = NULL;
 static switch_thread_t *EVENT_DISPATCH_QUEUE_THREADS[MAX_DISPATCH_VAL] = { 0 };
 static uint8_t EVENT_DISPATCH_QUEUE_RUNNING[MAX_DISPATCH_VAL] = { 0 };
-static switch_queue_t *EVENT_DISPATCH_QUEUE = NULL;
+static switch_queue_t *EVENT_DISPATCH_QUEUES[MAX_DISPATCH_VAL] = { 0 };
+static switch_event_dispatch_stats_t EVENT_DISPATCH_STATS[MAX_DISPATCH_VAL];
 static switch_queue_t *EVENT_CHANNEL_DISPATCH_QUEUE = NULL;
 static switch_mutex_t *EVENT_QUEUE_MUTEX = NULL;
 static switch_mutex_t *CUSTOM_HASH_MUTEX = NULL;
+static switch_mutex_t *SHARED_MUTEX = NULL;
 static switch_hash_t *CUSTOM_HASH = NULL;
 static int THREAD_COUNT = 0;
 static int DISPATCH_THREAD_COUNT = 0;
@@ -101,10 +154,13 @@ static int EVENT_CHANNEL_DISPATCH_THREAD_COUNT = 0;
 static int EVENT_CHANNEL_DISPATCH_THREAD_STARTING = 0;
 static int SYSTEM_RUNNING = 0;
 static uint64_t EVENT_SEQUENCE_NR = 0;
-#ifdef SWITCH_EVENT_RECYCLE
-static switch_queue_t *EVENT_RECYCLE_QUEUE = NULL;
-static switch_queue_t *EVENT_HEADER_RECYCLE_QUEUE = NULL;
-#endif
+static switch_event_cache_t EVENT_CACHE[EVENT_CACHE_SHARDS];
+static int EVENT_CACHE_RUNNING = 0;
+static switch_thread_rwlock_t *INTERN_RWLOCK = NULL;
+static switch_event_intern_t *INTERN_TABLE = NULL;
+static uint32_t INTERN_COUNT = 0;
+static char *INTERN_ARENA = NULL;
+static switch_size_t INTERN_ARENA_USED = 0;
 
 static void unsub_all_switch_event_channel(void);
 
@@ -127,6 +183,300 @@ static char *my_dup(const char *s)
 #define FREE(ptr) switch_safe_free(ptr)
 #endif
 
+#define HEADER_INLINE(_h) ((char *) ((_h) + 1))
+
+static switch_event_cache_t *switch_event_get_cache(void)
+{
+	unsigned long id;
+
+	if (!EVENT_CACHE_RUNNING) {
+		return NULL;
+	}
+
+	id = (unsigned long) switch_thread_self() * 2654435761UL;
+
+	return &EVENT_CACHE[(id >> 16) % EVENT_CACHE_SHARDS];
+}
+
+static switch_event_t *switch_event_alloc(void)
+{
+	switch_event_cache_t *cache = switch_event_get_cache();
+	switch_event_t *event = NULL;
+
+	if (cache) {
+		switch_mutex_lock(cache->mutex);
+		if ((event = cache->events)) {
+			cache->events = event->next;
+			cache->event_count--;
+		}
+		switch_mutex_unlock(cache->mutex);
+	}
+
+	if (!event) {
+		event = ALLOC(sizeof(switch_event_t));
+		switch_assert(event);
+	}
+
+	memset(event, 0, sizeof(switch_event_t));
+
+	return event;
+}
+
+static void switch_event_release(switch_event_t *event)
+{
+	switch_event_cache_t *cache = switch_event_get_cache();
+
+	if (cache) {
+		switch_mutex_lock(cache->mutex);
+		if (EVENT_CACHE_RUNNING && cache->event_count < EVENT_CACHE_MAX_EVENTS) {
+			event->next = cache->events;
+			cache->events = event;
+			cache->event_count++;
+			event = NULL;
+		}
+		switch_mutex_unlock(cache->mutex);
+	}
+
+	FREE(event);
+}
+
+static switch_event_header_t *switch_event_header_alloc(void)
+{
+	switch_event_cache_t *cache = switch_event_get_cache();
+	switch_event_header_t *header = NULL;
+
+	if (cache) {
+		switch_mutex_lock(cache->mutex);
+		if ((header = cache->headers)) {
+			cache->headers = header->next;
+			cache->header_count--;
+		}
+		switch_mutex_unlock(cache->mutex);
+	}
+
+	if (!header) {
+		header = ALLOC(sizeof(switch_event_header_t) + EVENT_HEADER_INLINE_LEN);
+		switch_assert(header);
+	}
+
+	memset(header, 0, sizeof(switch_event_header_t));
+
+	return header;
+}
+
+static void switch_event_header_release(switch_event_header_t *header)
+{
+	switch_event_cache_t *cache = switch_event_get_cache();
+
+	if (cache) {
+		switch_mutex_lock(cache->mutex);
+		if (EVENT_CACHE_RUNNING && cache->header_count < EVENT_CACHE_MAX_HEADERS) {
+			header->next = cache->headers;
+			cache->headers = header;
+			cache->header_count++;
+			header = NULL;
+		}
+		switch_mutex_unlock(cache->mutex);
+	}
+
+	FREE(header);
+}
+
+static int switch_event_header_is_inline(switch_event_header_t *header, const char *str)
+{
+	return str >= HEADER_INLINE(header) && str < HEADER_INLINE(header) + EVENT_HEADER_INLINE_LEN;
+}
+
+static int switch_event_name_is_interned(const char *str)
+{
+	return INTERN_ARENA && str >= INTERN_ARENA && str < INTERN_ARENA + EVENT_INTERN_ARENA_LEN;
+}
+
+static void switch_event_header_free_str(switch_event_header_t *header, char *str)
+{
+	if (str && !switch_event_header_is_inline(header, str) && !switch_event_name_is_interned(str)) {
+		free(str);
+	}
+}
+
+static switch_event_intern_t *switch_event_intern_find(const char *name, unsigned long hash)
+{
+	uint32_t i = (uint32_t) (hash & (EVENT_INTERN_SLOTS - 1));
+
+	while (INTERN_TABLE[i].name) {
+		if (INTERN_TABLE[i].hash == hash && !strcmp(INTERN_TABLE[i].name, name)) {
+			return &INTERN_TABLE[i];
+		}
+		i = (i + 1) & (EVENT_INTERN_SLOTS - 1);
+	}
+
+	return NULL;
+}
+
+/*
+ * header names come from a small vocabulary so keep one read only copy of each of them,
+ * entries are never removed and once the table or its arena is full names are copied as before
+ */
+static const char *switch_event_intern(const char *name, unsigned long hash)
+{
+	switch_event_intern_t *ip;
+	const char *r = NULL;
+	size_t len;
+
+	if (!INTERN_TABLE || (len = strlen(name) + 1) > EVENT_INTERN_MAX_NAME) {
+		return NULL;
+	}
+
+	switch_thread_rwlock_rdlock(INTERN_RWLOCK);
+	if ((ip = switch_event_intern_find(name, hash))) {
+		r = ip->name;
+	}
+	switch_thread_rwlock_unlock(INTERN_RWLOCK);
+
+	if (r) {
+		return r;
+	}
+
+	switch_thread_rwlock_wrlock(INTERN_RWLOCK);
+	if ((ip = switch_event_intern_find(name, hash))) {
+		r = ip->name;
+	} else if (INTERN_COUNT < EVENT_INTERN_SLOTS / 2 && INTERN_ARENA_USED + len <= EVENT_INTERN_ARENA_LEN) {
+		uint32_t i = (uint32_t) (hash & (EVENT_INTERN_SLOTS - 1));
+
+		while (INTERN_TABLE[i].name) {
+			i = (i + 1) & (EVENT_INTERN_SLOTS - 1);
+		}
+
+		r = memcpy(INTERN_ARENA + INTERN_ARENA_USED, name, len);
+		INTERN_ARENA_USED += len;
+		INTERN_TABLE[i].hash = hash;
+		INTERN_TABLE[i].name = r;
+		INTERN_COUNT++;
+	}
+	switch_thread_rwlock_unlock(INTERN_RWLOCK);
+
+	return r;
+}
+
+static switch_event_header_t *switch_event_index_find(switch_event_t *event, unsigned long hash, const char *header_name)
+{
+	uint32_t mask = event->header_index_size - 1;
+	uint32_t i = (uint32_t) (hash & mask);
+	switch_event_header_t *hp;
+
+	while ((hp = event->header_index[i])) {
+		if (hp->hash == hash && !strcasecmp(hp->name, header_name)) {
+			return hp;
+		}
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+/* point the slot of a header name at header, replacing what was there when replace is set */
+static void switch_event_index_insert(switch_event_t *event, switch_event_header_t *header, switch_bool_t replace)
+{
+	uint32_t mask = event->header_index_size - 1;
+	uint32_t i = (uint32_t) (header->hash & mask);
+	switch_event_header_t *hp;
+
+	while ((hp = event->header_index[i])) {
+		if (hp->hash == header->hash && !strcasecmp(hp->name, header->name)) {
+			if (replace) {
+				event->header_index[i] = header;
+			}
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+
+	event->header_index[i] = header;
+}
+
+/* drop the slot of a header name, shifting back the entries that probed past it */
+static void switch_event_index_remove(switch_event_t *event, unsigned long hash, const char *header_name)
+{
+	uint32_t mask = event->header_index_size - 1;
+	uint32_t i = (uint32_t) (hash & mask), j, k;
+	switch_event_header_t *hp;
+
+	while ((hp = event->header_index[i])) {
+		if (hp->hash == hash && !strcasecmp(hp->name, header_name)) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+
+	if (!hp) {
+		return;
+	}
+
+	for (j = (i + 1) & mask; (hp = event->header_index[j]); j = (j + 1) & mask) {
+		k = (uint32_t) (hp->hash & mask);
+
+		if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+			event->header_index[i] = hp;
+			i = j;
+		}
+	}
+
+	event->header_index[i] = NULL;
+}
+
+static void switch_event_index_destroy(switch_event_t *event)
+{
+	FREE(event->header_index);
+	event->header_index_size = 0;
+}
+
+static void switch_event_index_build(switch_event_t *event)
+{
+	switch_event_header_t *hp;
+	uint32_t size = 64;
+
+	while (size < event->header_count * 4) {
+		size <<= 1;
+	}
+
+	FREE(event->header_index);
+	event->header_index = calloc(size, sizeof(switch_event_header_t *));
+	switch_assert(event->header_index);
+	event->header_index_size = size;
+
+	/* the first header of each name wins, just like the list walk */
+	for (hp = event->headers; hp; hp = hp->next) {
+		switch_event_index_insert(event, hp, SWITCH_FALSE);
+	}
+}
+
+/* take ownership of data or, when it's borrowed, copy it into the inline space behind the name if it fits */
+static void switch_event_header_set_value(switch_event_header_t *header, char *data, switch_bool_t borrowed)
+{
+	char *space = HEADER_INLINE(header);
+	size_t len;
+
+	switch_event_header_free_str(header, header->value);
+	header->value = NULL;
+
+	if (!borrowed) {
+		header->value = data;
+		return;
+	}
+
+	if (switch_event_header_is_inline(header, header->name)) {
+		space += strlen(header->name) + 1;
+	}
+
+	len = strlen(data) + 1;
+
+	if (space + len <= HEADER_INLINE(header) + EVENT_HEADER_INLINE_LEN) {
+		header->value = memcpy(space, data, len);
+	} else {
+		header->value = DUP(data);
+	}
+}
+
 /* make sure this is synced with the switch_event_types_t enum in switch_types.h
    also never put any new ones before EVENT_ALL
 */
@@ -262,6 +612,139 @@ static int switch_events_match(switch_event_t *event, switch_event_node_t *node)
 	return match;
 }
 
+static int switch_event_node_is_filter(switch_event_node_t *node)
+{
+	return node->subclass_name && (!strncasecmp(node->subclass_name, "file:", 5) || !strncasecmp(node->subclass_name, "func:", 5));
+}
+
+/*
+ * Collect, in delivery order, every binding of event_id (followed by the SWITCH_EVENT_ALL bindings)
+ * that can possibly match an event with the given subclass.  "file:" and "func:" bindings depend on
+ * the event headers so they are kept and re-checked with switch_events_match() at delivery time.
+ */
+static void switch_event_dispatch_list_build(switch_event_dispatch_list_t *list, switch_event_types_t event_id,
+											 switch_bool_t has_subclass, const char *subclass_name)
+{
+	switch_event_types_t e;
+	switch_event_node_t *node;
+	uint32_t total = 0;
+
+	for (e = event_id;; e = SWITCH_EVENT_ALL) {
+		for (node = EVENT_NODES[e]; node; node = node->next) {
+			total++;
+		}
+
+		if (e == SWITCH_EVENT_ALL) {
+			break;
+		}
+	}
+
+	list->count = 0;
+	list->nodes = NULL;
+
+	if (!total) {
+		return;
+	}
+
+	list->nodes = malloc(sizeof(switch_event_node_t *) * total);
+	switch_assert(list->nodes);
+
+	for (e = event_id;; e = SWITCH_EVENT_ALL) {
+		for (node = EVENT_NODES[e]; node; node = node->next) {
+			if (!node->subclass_name ||
+				(has_subclass && (switch_event_node_is_filter(node) || (subclass_name && !strcmp(node->subclass_name, subclass_name))))) {
+				list->nodes[list->count++] = node;
+			}
+		}
+
+		if (e == SWITCH_EVENT_ALL) {
+			break;
+		}
+	}
+}
+
+static void switch_event_dispatch_list_destroy(void *ptr)
+{
+	switch_event_dispatch_list_t *list = (switch_event_dispatch_list_t *) ptr;
+
+	if (list) {
+		switch_safe_free(list->nodes);
+		free(list);
+	}
+}
+
+static void switch_event_dispatch_index_destroy(switch_event_dispatch_index_t **indexp)
+{
+	switch_event_dispatch_index_t *index = *indexp;
+
+	if (index) {
+		switch_safe_free(index->plain.nodes);
+		switch_safe_free(index->subclass.nodes);
+
+		if (index->subclass_hash) {
+			switch_core_hash_destroy(&index->subclass_hash);
+		}
+
+		free(index);
+	}
+
+	*indexp = NULL;
+}
+
+static switch_event_dispatch_index_t *switch_event_dispatch_index_create(switch_event_types_t event_id)
+{
+	switch_event_dispatch_index_t *index;
+	switch_event_dispatch_list_t *list;
+	switch_event_types_t e;
+	switch_event_node_t *node;
+
+	switch_zmalloc(index, sizeof(*index));
+
+	switch_event_dispatch_list_build(&index->plain, event_id, SWITCH_FALSE, NULL);
+	switch_event_dispatch_list_build(&index->subclass, event_id, SWITCH_TRUE, NULL);
+
+	for (e = event_id;; e = SWITCH_EVENT_ALL) {
+		for (node = EVENT_NODES[e]; node; node = node->next) {
+			if (!node->subclass_name || switch_event_node_is_filter(node)) {
+				continue;
+			}
+
+			if (!index->subclass_hash) {
+				switch_core_hash_init(&index->subclass_hash);
+			} else if (switch_core_hash_find(index->subclass_hash, node->subclass_name)) {
+				continue;
+			}
+
+			switch_zmalloc(list, sizeof(*list));
+			switch_event_dispatch_list_build(list, event_id, SWITCH_TRUE, node->subclass_name);
+			switch_core_hash_insert_destructor(index->subclass_hash, node->subclass_name, list, switch_event_dispatch_list_destroy);
+		}
+
+		if (e == SWITCH_EVENT_ALL) {
+			break;
+		}
+	}
+
+	return index;
+}
+
+/* must be called with RWLOCK held for writing */
+static void switch_event_rebuild_dispatch_index(void)
+{
+	int e;
+
+	for (e = 0; e <= SWITCH_EVENT_ALL; e++) {
+		switch_event_dispatch_index_destroy(&EVENT_INDEX[e]);
+	}
+
+	/* event ids nobody bound to directly share the SWITCH_EVENT_ALL index */
+	for (e = 0; e <= SWITCH_EVENT_ALL; e++) {
+		if (e == SWITCH_EVENT_ALL || EVENT_NODES[e]) {
+			EVENT_INDEX[e] = switch_event_dispatch_index_create((switch_event_types_t) e);
+		}
+	}
+}
+
 
 static void *SWITCH_THREAD_FUNC switch_event_deliver_thread(switch_thread_t *thread, void *obj)
 {
@@ -293,6 +776,7 @@ static void switch_event_deliver_thread_pool(switch_event_t **event)
 static void *SWITCH_THREAD_FUNC switch_event_dispatch_thread(switch_thread_t *thread, void *obj)
 {
 	switch_queue_t *queue = (switch_queue_t *) obj;
+	switch_event_dispatch_stats_t *stats;
 	int my_id = 0;
 
 	switch_mutex_lock(EVENT_QUEUE_MUTEX);
@@ -311,12 +795,15 @@ static void *SWITCH_THREAD_FUNC switch_event_dispatch_thread(switch_thread_t *th
 	}
 
 	EVENT_DISPATCH_QUEUE_RUNNING[my_id] = 1;
+	stats = &EVENT_DISPATCH_STATS[my_id];
 	switch_mutex_unlock(EVENT_QUEUE_MUTEX);
 
 
 	for (;;) {
 		void *pop = NULL;
 		switch_event_t *event = NULL;
+		switch_time_t latency;
+		uint32_t depth;
 
 		if (!SYSTEM_RUNNING) {
 			break;
@@ -331,6 +818,19 @@ static void *SWITCH_THREAD_FUNC switch_event_dispatch_thread(switch_thread_t *th
 		}
 
 		event = (switch_event_t *) pop;
+
+		/* only this thread writes the stats of its own queue */
+		if ((depth = switch_queue_size(queue) + 1) > stats->max_depth) {
+			stats->max_depth = depth;
+		}
+
+		latency = switch_micro_time_now() - event->queued;
+		stats->total_latency += latency;
+		if (latency > stats->max_latency) {
+			stats->max_latency = latency;
+		}
+		stats->dispatched++;
+
 		switch_event_deliver(&event);
 		switch_os_yield();
 	}
@@ -347,69 +847,70 @@ static void *SWITCH_THREAD_FUNC switch_event_dispatch_thread(switch_thread_t *th
 
 }
 
-static int PENDING = 0;
+/*
+ * Events of the same channel always land on the same queue so the single thread draining it
+ * delivers them in the order they were fired. Events without a channel are spread by name.
+ */
+static uint32_t switch_event_dispatch_queue_index(switch_event_t *event)
+{
+	const char *key;
+	switch_ssize_t klen = -1;
+
+	if (!(key = switch_event_get_header(event, "Unique-ID")) && !(key = event->subclass_name)) {
+		key = EVENT_NAMES[event->event_id];
+	}
+
+	return switch_hashfunc_default(key, &klen) % MAX_DISPATCH;
+}
 
 static switch_status_t switch_event_queue_dispatch_event(switch_event_t **eventp)
 {
 
 	switch_event_t *event = *eventp;
+	switch_queue_t *queue;
 
 	if (!SYSTEM_RUNNING) {
 		return SWITCH_STATUS_FALSE;
 	}
 
-	while (event) {
-		int launch = 0;
-
-		switch_mutex_lock(EVENT_QUEUE_MUTEX);
-
-		if (!PENDING && switch_queue_size(EVENT_DISPATCH_QUEUE) > (unsigned int)(DISPATCH_QUEUE_LEN * DISPATCH_THREAD_COUNT)) {
-			if (SOFT_MAX_DISPATCH + 1 < MAX_DISPATCH) {
-				launch++;
-				PENDING++;
-			}
-		}
-
-		switch_mutex_unlock(EVENT_QUEUE_MUTEX);
-
-		if (launch) {
-			if (SOFT_MAX_DISPATCH + 1 < MAX_DISPATCH) {
-				switch_event_launch_dispatch_threads(SOFT_MAX_DISPATCH + 1);
-			}
-
-			switch_mutex_lock(EVENT_QUEUE_MUTEX);
-			PENDING--;
-			switch_mutex_unlock(EVENT_QUEUE_MUTEX);
-		}
-
-		*eventp = NULL;
-		switch_queue_push(EVENT_DISPATCH_QUEUE, event);
-		event = NULL;
-
+	if (!(queue = EVENT_DISPATCH_QUEUES[switch_event_dispatch_queue_index(event)])) {
+		return SWITCH_STATUS_FALSE;
 	}
 
+	*eventp = NULL;
+	event->queued = switch_micro_time_now();
+	switch_queue_push(queue, event);
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
 SWITCH_DECLARE(void) switch_event_deliver(switch_event_t **event)
 {
-	switch_event_types_t e;
+	switch_event_dispatch_index_t *index;
+	switch_event_dispatch_list_t *list = NULL;
 	switch_event_node_t *node;
+	uint32_t i;
 
 	if (SYSTEM_RUNNING) {
 		switch_thread_rwlock_rdlock(RWLOCK);
-		for (e = (*event)->event_id;; e = SWITCH_EVENT_ALL) {
-			for (node = EVENT_NODES[e]; node; node = node->next) {
-				if (switch_events_match(*event, node)) {
+
+		if ((index = EVENT_INDEX[(*event)->event_id]) || (index = EVENT_INDEX[SWITCH_EVENT_ALL])) {
+			if (!(*event)->subclass_name) {
+				list = &index->plain;
+			} else if (!index->subclass_hash || !(list = switch_core_hash_find(index->subclass_hash, (*event)->subclass_name))) {
+				list = &index->subclass;
+			}
+
+			for (i = 0; i < list->count; i++) {
+				node = list->nodes[i];
+
+				if (!node->subclass_name || switch_events_match(*event, node)) {
 					(*event)->bind_user_data = node->user_data;
 					node->callback(*event);
 				}
 			}
-
-			if (e == SWITCH_EVENT_ALL) {
-				break;
-			}
 		}
+
 		switch_thread_rwlock_unlock(RWLOCK);
 	}
 
@@ -511,27 +1012,35 @@ end:
 
 SWITCH_DECLARE(void) switch_core_memory_reclaim_events(void)
 {
-#ifdef SWITCH_EVENT_RECYCLE
+	switch_event_t *event;
+	switch_event_header_t *header;
+	uint32_t x, events = 0, headers = 0;
 
-	void *pop;
-	int size;
-	size = switch_queue_size(EVENT_RECYCLE_QUEUE);
+	if (!EVENT_CACHE[0].mutex) {
+		return;
+	}
 
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %d recycled event(s) %d bytes\n", size, (int) sizeof(switch_event_t) * size);
-	size = switch_queue_size(EVENT_HEADER_RECYCLE_QUEUE);
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %d recycled event header(s) %d bytes\n",
-					  size, (int) sizeof(switch_event_header_t) * size);
+	for (x = 0; x < EVENT_CACHE_SHARDS; x++) {
+		switch_event_cache_t *cache = &EVENT_CACHE[x];
 
-	while (switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		free(pop);
-	}
-	while (switch_queue_trypop(EVENT_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		free(pop);
+		switch_mutex_lock(cache->mutex);
+		while ((event = cache->events)) {
+			cache->events = event->next;
+			free(event);
+			events++;
+		}
+		while ((header = cache->headers)) {
+			cache->headers = header->next;
+			free(header);
+			headers++;
+		}
+		cache->event_count = cache->header_count = 0;
+		switch_mutex_unlock(cache->mutex);
 	}
-#else
-	return;
-#endif
 
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %u cached event(s) %d bytes\n", events, (int) sizeof(switch_event_t) * events);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %u cached event header(s) %d bytes\n",
+					  headers, (int) (sizeof(switch_event_header_t) + EVENT_HEADER_INLINE_LEN) * headers);
 }
 
 SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
@@ -560,18 +1069,21 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 	if (runtime.events_use_dispatch) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Stopping dispatch queues\n");
 
-		for(x = 0; x < (uint32_t)DISPATCH_THREAD_COUNT; x++) {
-			switch_queue_trypush(EVENT_DISPATCH_QUEUE, NULL);
+		for(x = 0; x < SOFT_MAX_DISPATCH; x++) {
+			if (EVENT_DISPATCH_QUEUES[x]) {
+				switch_queue_trypush(EVENT_DISPATCH_QUEUES[x], NULL);
+				switch_queue_interrupt_all(EVENT_DISPATCH_QUEUES[x]);
+			}
 		}
 
-
-		switch_queue_interrupt_all(EVENT_DISPATCH_QUEUE);
-
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Stopping dispatch threads\n");
 
-		for(x = 0; x < (uint32_t)DISPATCH_THREAD_COUNT; x++) {
+		for(x = 0; x < SOFT_MAX_DISPATCH; x++) {
 			switch_status_t st;
-			switch_thread_join(&st, EVENT_DISPATCH_QUEUE_THREADS[x]);
+
+			if (EVENT_DISPATCH_QUEUE_THREADS[x]) {
+				switch_thread_join(&st, EVENT_DISPATCH_QUEUE_THREADS[x]);
+			}
 		}
 	}
 
@@ -588,9 +1100,15 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 		void *pop = NULL;
 		switch_event_t *event = NULL;
 
-		while (switch_queue_trypop(EVENT_DISPATCH_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-			event = (switch_event_t *) pop;
-			switch_event_destroy(&event);
+		for(x = 0; x < SOFT_MAX_DISPATCH; x++) {
+			if (!EVENT_DISPATCH_QUEUES[x]) {
+				continue;
+			}
+
+			while (switch_queue_trypop(EVENT_DISPATCH_QUEUES[x], &pop) == SWITCH_STATUS_SUCCESS && pop) {
+				event = (switch_event_t *) pop;
+				switch_event_destroy(&event);
+			}
 		}
 	}
 
@@ -609,19 +1127,71 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 	switch_core_hash_destroy(&event_channel_manager.perm_hash);
 
 	switch_core_hash_destroy(&CUSTOM_HASH);
+
+	/* whatever is released from now on is freed right away, so nothing is left behind in the caches */
+	EVENT_CACHE_RUNNING = 0;
 	switch_core_memory_reclaim_events();
 
+	switch_thread_rwlock_wrlock(RWLOCK);
+	for (x = 0; x <= SWITCH_EVENT_ALL; x++) {
+		switch_event_dispatch_index_destroy(&EVENT_INDEX[x]);
+	}
+	switch_thread_rwlock_unlock(RWLOCK);
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/* call with BLOCK held, starts the threads, and the queues they drain, up to max */
+static void launch_dispatch_threads(uint32_t max)
+{
+	switch_threadattr_t *thd_attr;
+	uint32_t index = 0;
+	uint32_t sanity = 200;
+
+	switch_memory_pool_t *pool = RUNTIME_POOL;
+
+	for (index = SOFT_MAX_DISPATCH; index < max && index < MAX_DISPATCH_VAL; index++) {
+		if (EVENT_DISPATCH_QUEUE_THREADS[index]) {
+			continue;
+		}
+
+		if (!EVENT_DISPATCH_QUEUES[index]) {
+			switch_queue_create(&EVENT_DISPATCH_QUEUES[index], DISPATCH_QUEUE_LEN, THRUNTIME_POOL);
+		}
+
+		switch_threadattr_create(&thd_attr, pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+		switch_thread_create(&EVENT_DISPATCH_QUEUE_THREADS[index], thd_attr, switch_event_dispatch_thread, EVENT_DISPATCH_QUEUES[index], pool);
+		while(--sanity && !EVENT_DISPATCH_QUEUE_RUNNING[index]) switch_yield(10000);
+
+		if (index == 1) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Create event dispatch thread %d\n", index);
+		} else {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Create additional event dispatch thread %d\n", index);
+		}
+	}
+
+	if (index > SOFT_MAX_DISPATCH) {
+		SOFT_MAX_DISPATCH = index;
+	}
+}
+
 static void check_dispatch(void)
 {
-	if (!EVENT_DISPATCH_QUEUE) {
+	if (!EVENT_DISPATCH_QUEUES[0]) {
 		switch_mutex_lock(BLOCK);
 
-		if (!EVENT_DISPATCH_QUEUE) {
-			switch_queue_create(&EVENT_DISPATCH_QUEUE, DISPATCH_QUEUE_LEN * MAX_DISPATCH, THRUNTIME_POOL);
-			switch_event_launch_dispatch_threads(1);
+		if (!EVENT_DISPATCH_QUEUES[0]) {
+			uint32_t x;
+
+			/* one queue per dispatch thread, the first one is created last since it flags the set as ready */
+			for (x = MAX_DISPATCH; x > 0; x--) {
+				switch_queue_create(&EVENT_DISPATCH_QUEUES[x - 1], DISPATCH_QUEUE_LEN, THRUNTIME_POOL);
+			}
+
+			/* every queue needs its consumer so they are all started up front */
+			launch_dispatch_threads(MAX_DISPATCH);
 
 			while (!THREAD_COUNT) {
 				switch_cond_next();
@@ -633,49 +1203,48 @@ static void check_dispatch(void)
 
 
 
+/*
+ * Routes events over the first max queues from now on, starting their threads as needed.
+ * The threads of queues left out drain what they hold and wait, so it is meant for startup.
+ */
 SWITCH_DECLARE(void) switch_event_launch_dispatch_threads(uint32_t max)
 {
-	switch_threadattr_t *thd_attr;
-	uint32_t index = 0;
-	int launched = 0;
-	uint32_t sanity = 200;
-
-	switch_memory_pool_t *pool = RUNTIME_POOL;
-
 	check_dispatch();
 
-	if (max > MAX_DISPATCH) {
+	if (!max || max > MAX_DISPATCH_VAL) {
 		return;
 	}
 
-	if (max < SOFT_MAX_DISPATCH) {
-		return;
-	}
+	switch_mutex_lock(BLOCK);
+	launch_dispatch_threads(max);
 
-	for (index = SOFT_MAX_DISPATCH; index < max && index < MAX_DISPATCH; index++) {
-		if (EVENT_DISPATCH_QUEUE_THREADS[index]) {
-			continue;
-		}
+	if (max != MAX_DISPATCH) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Dispatching events over %u queues\n", max);
+		MAX_DISPATCH = max;
+	}
+	switch_mutex_unlock(BLOCK);
+}
 
-		switch_threadattr_create(&thd_attr, pool);
-		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
-		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
-		switch_thread_create(&EVENT_DISPATCH_QUEUE_THREADS[index], thd_attr, switch_event_dispatch_thread, EVENT_DISPATCH_QUEUE, pool);
-		while(--sanity && !EVENT_DISPATCH_QUEUE_RUNNING[index]) switch_yield(10000);
+SWITCH_DECLARE(uint32_t) switch_event_dispatch_queue_count(void)
+{
+	return EVENT_DISPATCH_QUEUES[0] ? MAX_DISPATCH : 0;
+}
 
-		if (index == 1) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Create event dispatch thread %d\n", index);
-		} else {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Create additional event dispatch thread %d\n", index);
-		}
-		launched++;
+SWITCH_DECLARE(switch_status_t) switch_event_get_dispatch_stats(uint32_t index, switch_event_dispatch_stats_t *stats)
+{
+	if (index >= MAX_DISPATCH || !EVENT_DISPATCH_QUEUES[index]) {
+		return SWITCH_STATUS_FALSE;
 	}
 
-	SOFT_MAX_DISPATCH = index;
+	*stats = EVENT_DISPATCH_STATS[index];
+	stats->depth = switch_queue_size(EVENT_DISPATCH_QUEUES[index]);
+
+	return SWITCH_STATUS_SUCCESS;
 }
 
 SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 {
+	uint32_t x;
 
 	/* don't need any more dispatch threads than we have CPU's*/
 	MAX_DISPATCH = (switch_core_cpu_count() / 2) + 1;
@@ -683,6 +1252,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 		MAX_DISPATCH = 2;
 	}
 
+	if (MAX_DISPATCH > MAX_DISPATCH_VAL) {
+		MAX_DISPATCH = MAX_DISPATCH_VAL;
+	}
+
 	switch_assert(pool != NULL);
 	THRUNTIME_POOL = RUNTIME_POOL = pool;
 	switch_thread_rwlock_create(&RWLOCK, RUNTIME_POOL);
@@ -690,8 +1263,22 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 	switch_mutex_init(&POOL_LOCK, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_mutex_init(&EVENT_QUEUE_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_mutex_init(&CUSTOM_HASH_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
+	switch_mutex_init(&SHARED_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_core_hash_init(&CUSTOM_HASH);
 
+	switch_thread_rwlock_create(&INTERN_RWLOCK, RUNTIME_POOL);
+	INTERN_ARENA = switch_core_alloc(RUNTIME_POOL, EVENT_INTERN_ARENA_LEN);
+	INTERN_TABLE = switch_core_alloc(RUNTIME_POOL, sizeof(switch_event_intern_t) * EVENT_INTERN_SLOTS);
+
+	for (x = EVENT_CACHE_SHARDS; x > 0; x--) {
+		switch_mutex_init(&EVENT_CACHE[x - 1].mutex, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
+	}
+	EVENT_CACHE_RUNNING = 1;
+
+	switch_thread_rwlock_wrlock(RWLOCK);
+	switch_event_rebuild_dispatch_index();
+	switch_thread_rwlock_unlock(RWLOCK);
+
 	if (switch_core_test_flag(SCF_MINIMAL)) {
 		return SWITCH_STATUS_SUCCESS;
 	}
@@ -715,11 +1302,6 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 	switch_find_local_ip(guess_ip_v6, sizeof(guess_ip_v6), NULL, AF_INET6);
 
 
-#ifdef SWITCH_EVENT_RECYCLE
-	switch_queue_create(&EVENT_RECYCLE_QUEUE, 250000, THRUNTIME_POOL);
-	switch_queue_create(&EVENT_HEADER_RECYCLE_QUEUE, 250000, THRUNTIME_POOL);
-#endif
-
 	check_dispatch();
 
 	switch_mutex_lock(EVENT_QUEUE_MUTEX);
@@ -732,27 +1314,13 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 SWITCH_DECLARE(switch_status_t) switch_event_create_subclass_detailed(const char *file, const char *func, int line,
 																	  switch_event_t **event, switch_event_types_t event_id, const char *subclass_name)
 {
-#ifdef SWITCH_EVENT_RECYCLE
-	void *pop;
-#endif
-
 	*event = NULL;
 
 	if ((event_id != SWITCH_EVENT_CLONE && event_id != SWITCH_EVENT_CUSTOM) && subclass_name) {
 		return SWITCH_STATUS_GENERR;
 	}
-#ifdef SWITCH_EVENT_RECYCLE
-	if (EVENT_RECYCLE_QUEUE && switch_queue_trypop(EVENT_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		*event = (switch_event_t *) pop;
-	} else {
-#endif
-		*event = ALLOC(sizeof(switch_event_t));
-		switch_assert(*event);
-#ifdef SWITCH_EVENT_RECYCLE
-	}
-#endif
 
-	memset(*event, 0, sizeof(switch_event_t));
+	*event = switch_event_alloc();
 
 	if (event_id == SWITCH_EVENT_REQUEST_PARAMS || event_id == SWITCH_EVENT_CHANNEL_DATA || event_id == SWITCH_EVENT_MESSAGE) {
 		(*event)->flags |= EF_UNIQ_HEADERS;
@@ -795,14 +1363,20 @@ SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event
 
 	for (hp = event->headers; hp; hp = hp->next) {
 		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
-			FREE(hp->name);
-			hp->name = DUP(new_header_name);
+			switch_event_header_free_str(hp, hp->name);
 			hlen = -1;
-			hp->hash = switch_ci_hashfunc_default(hp->name, &hlen);
+			hp->hash = switch_ci_hashfunc_default(new_header_name, &hlen);
+			if (!(hp->name = (char *) switch_event_intern(new_header_name, hp->hash))) {
+				hp->name = DUP(new_header_name);
+			}
 			x++;
 		}
 	}
 
+	if (x && event->header_index) {
+		switch_event_index_build(event);
+	}
+
 	return x ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
 }
 
@@ -820,6 +1394,10 @@ SWITCH_DECLARE(switch_event_header_t *) switch_event_get_header_ptr(switch_event
 
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
 
+	if (event->header_index) {
+		return switch_event_index_find(event, hash, header_name);
+	}
+
 	for (hp = event->headers; hp; hp = hp->next) {
 		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
 			return hp;
@@ -856,7 +1434,7 @@ SWITCH_DECLARE(char *) switch_event_get_body(switch_event_t *event)
 
 SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *event, const char *header_name, const char *val)
 {
-	switch_event_header_t *hp, *lp = NULL, *tp;
+	switch_event_header_t *hp, *lp = NULL, *tp, *first = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	int x = 0;
 	switch_ssize_t hlen = -1;
@@ -864,6 +1442,11 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 
 	tp = event->headers;
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
+
+	if (event->header_index && !switch_event_index_find(event, hash, header_name)) {
+		return status;
+	}
+
 	while (tp) {
 		hp = tp;
 		tp = tp->next;
@@ -880,7 +1463,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 			if (hp == event->last_header || !hp->next) {
 				event->last_header = lp;
 			}
-			FREE(hp->name);
+			switch_event_header_free_str(hp, hp->name);
 
 			if (hp->idx) {
 				int i = 0;
@@ -891,46 +1474,49 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 				FREE(hp->array);
 			}
 
-			FREE(hp->value);
-
-			memset(hp, 0, sizeof(*hp));
-#ifdef SWITCH_EVENT_RECYCLE
-			if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, hp) != SWITCH_STATUS_SUCCESS) {
-				FREE(hp);
-			}
-#else
-			FREE(hp);
-#endif
+			switch_event_header_free_str(hp, hp->value);
+			switch_event_header_release(hp);
+			event->header_count--;
 			status = SWITCH_STATUS_SUCCESS;
 		} else {
+			if (!first && (!hp->hash || hash == hp->hash) && !strcasecmp(header_name, hp->name)) {
+				first = hp;
+			}
 			lp = hp;
 		}
 	}
 
+	if (status == SWITCH_STATUS_SUCCESS && event->header_index) {
+		if (first) {
+			switch_event_index_insert(event, first, SWITCH_TRUE);
+		} else {
+			switch_event_index_remove(event, hash, header_name);
+		}
+	}
+
 	return status;
 }
 
 static switch_event_header_t *new_header(const char *header_name)
 {
 	switch_event_header_t *header;
+	switch_ssize_t hlen = -1;
+	size_t len = strlen(header_name) + 1;
 
-#ifdef SWITCH_EVENT_RECYCLE
-		void *pop;
-		if (EVENT_HEADER_RECYCLE_QUEUE && switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS) {
-			header = (switch_event_header_t *) pop;
-		} else {
-#endif
-			header = ALLOC(sizeof(*header));
-			switch_assert(header);
-#ifdef SWITCH_EVENT_RECYCLE
-		}
-#endif
-
-		memset(header, 0, sizeof(*header));
-		header->name = DUP(header_name);
+	header = switch_event_header_alloc();
+	header->hash = switch_ci_hashfunc_default(header_name, &hlen);
 
+	if ((header->name = (char *) switch_event_intern(header_name, header->hash))) {
 		return header;
+	}
+
+	if (len <= EVENT_HEADER_INLINE_LEN) {
+		header->name = memcpy(HEADER_INLINE(header), header_name, len);
+	} else {
+		header->name = DUP(header_name);
+	}
 
+	return header;
 }
 
 SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *var, const char *val)
@@ -979,10 +1565,13 @@ SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *va
 	return 0;
 }
 
-static switch_status_t switch_event_base_add_header(switch_event_t *event, switch_stack_t stack, const char *header_name, char *data)
+/*
+ * data is owned by the event from here on unless borrowed is set, borrowed data is
+ * copied, inline in the header when it is short enough
+ */
+static switch_status_t switch_event_base_add_header(switch_event_t *event, switch_stack_t stack, const char *header_name, char *data, switch_bool_t borrowed)
 {
 	switch_event_header_t *header = NULL;
-	switch_ssize_t hlen = -1;
 	int exists = 0, fly = 0;
 	char *index_ptr;
 	int index = 0;
@@ -1005,6 +1594,12 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 	if (index_ptr || (stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT)) {
 
+		/* array values always live in their own allocation */
+		if (borrowed) {
+			data = DUP(data);
+			borrowed = SWITCH_FALSE;
+		}
+
 		if (!(header = switch_event_get_header_ptr(event, header_name)) && index_ptr) {
 
 			header = new_header(header_name);
@@ -1022,7 +1617,8 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 				if (index > -1 && index <= 4000) {
 					if (index < header->idx) {
 						FREE(header->array[index]);
-						header->array[index] = DUP(data);
+						header->array[index] = data;
+						data = NULL;
 					} else {
 						int i;
 						char **m;
@@ -1033,7 +1629,8 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 						for (i = header->idx; i < index; i++) {
 							m[i] = DUP("");
 						}
-						m[index] = DUP(data);
+						m[index] = data;
+						data = NULL;
 						header->idx = index + 1;
 						if (!fly) {
 							exists = 1;
@@ -1042,6 +1639,7 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 						goto redraw;
 					}
 				}
+				FREE(data);
 				goto end;
 			} else {
 				if ((stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT)) {
@@ -1059,22 +1657,38 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (zstr(data)) {
 			switch_event_del_header(event, header_name);
-			FREE(data);
+			if (!borrowed) {
+				FREE(data);
+			}
 			goto end;
 		}
 
-		if (switch_test_flag(event, EF_UNIQ_HEADERS)) {
-			switch_event_del_header(event, header_name);
-		}
-
 		if (!strncmp(data, "ARRAY::", 7)) {
+			if (borrowed) {
+				data = DUP(data);
+				borrowed = SWITCH_FALSE;
+			}
+
+			if (switch_test_flag(event, EF_UNIQ_HEADERS)) {
+				switch_event_del_header(event, header_name);
+			}
+
 			switch_event_add_array(event, header_name, data);
 			FREE(data);
 			goto end;
 		}
 
-
 		header = new_header(header_name);
+
+		if (!((stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT))) {
+			/* borrowed data may belong to the header we are replacing so copy it before the delete */
+			switch_event_header_set_value(header, data, borrowed);
+			data = NULL;
+		}
+
+		if (switch_test_flag(event, EF_UNIQ_HEADERS)) {
+			switch_event_del_header(event, header_name);
+		}
 	}
 
 	if ((stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT)) {
@@ -1086,7 +1700,11 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 		if (header->value && !header->idx) {
 			m = malloc(sizeof(char *));
 			switch_assert(m);
-			m[0] = header->value;
+			if (switch_event_header_is_inline(header, header->value)) {
+				m[0] = DUP(header->value);
+			} else {
+				m[0] = header->value;
+			}
 			header->value = NULL;
 			header->array = m;
 			header->idx++;
@@ -1117,6 +1735,9 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (len) {
 			len += 8;
+			if (switch_event_header_is_inline(header, header->value)) {
+				header->value = NULL;
+			}
 			hv = realloc(header->value, len);
 			switch_assert(hv);
 			header->value = hv;
@@ -1139,14 +1760,9 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 			*hv = '\0';
 		}
 
-	} else {
-		switch_safe_free(header->value);
-		header->value = data;
 	}
 
 	if (!exists) {
-		header->hash = switch_ci_hashfunc_default(header->name, &hlen);
-
 		if ((stack & SWITCH_STACK_TOP)) {
 			header->next = event->headers;
 			event->headers = header;
@@ -1162,6 +1778,14 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 			}
 			event->last_header = header;
 		}
+
+		/* index on write so readers sharing the event never modify it */
+		event->header_count++;
+		if (event->header_index && event->header_count * 2 <= event->header_index_size) {
+			switch_event_index_insert(event, header, (stack & SWITCH_STACK_TOP) ? SWITCH_TRUE : SWITCH_FALSE);
+		} else if (event->header_count >= EVENT_HEADER_INDEX_MIN) {
+			switch_event_index_build(event);
+		}
 	}
 
  end:
@@ -1174,9 +1798,19 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 SWITCH_DECLARE(switch_status_t) switch_event_add_header(switch_event_t *event, switch_stack_t stack, const char *header_name, const char *fmt, ...)
 {
 	int ret = 0;
+	char buf[256];
 	char *data;
 	va_list ap;
 
+	/* most formatted values are short, keep them off the heap */
+	va_start(ap, fmt);
+	ret = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	if (ret > -1 && ret < (int) sizeof(buf)) {
+		return switch_event_base_add_header(event, stack, header_name, buf, SWITCH_TRUE);
+	}
+
 	va_start(ap, fmt);
 	ret = switch_vasprintf(&data, fmt, ap);
 	va_end(ap);
@@ -1185,7 +1819,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_add_header(switch_event_t *event, s
 		return SWITCH_STATUS_MEMERR;
 	}
 
-	return switch_event_base_add_header(event, stack, header_name, data);
+	return switch_event_base_add_header(event, stack, header_name, data, SWITCH_FALSE);
 }
 
 SWITCH_DECLARE(switch_status_t) switch_event_set_subclass_name(switch_event_t *event, const char *subclass_name)
@@ -1203,7 +1837,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_set_subclass_name(switch_event_t *e
 SWITCH_DECLARE(switch_status_t) switch_event_add_header_string(switch_event_t *event, switch_stack_t stack, const char *header_name, const char *data)
 {
 	if (data) {
-		return switch_event_base_add_header(event, stack, header_name, (stack & SWITCH_STACK_NODUP) ? (char *)data : DUP(data));
+		return switch_event_base_add_header(event, stack, header_name, (char *) data, !(stack & SWITCH_STACK_NODUP));
 	}
 	return SWITCH_STATUS_GENERR;
 }
@@ -1265,29 +1899,15 @@ SWITCH_DECLARE(void) switch_event_destroy(switch_event_t **event)
 				}
 			}
 
-			FREE(this->name);
-			FREE(this->value);
-
-
-#ifdef SWITCH_EVENT_RECYCLE
-			if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, this) != SWITCH_STATUS_SUCCESS) {
-				FREE(this);
-			}
-#else
-			FREE(this);
-#endif
-
-
+			switch_event_header_free_str(this, this->name);
+			switch_event_header_free_str(this, this->value);
+			switch_event_header_release(this);
 		}
 		FREE(ep->body);
 		FREE(ep->subclass_name);
-#ifdef SWITCH_EVENT_RECYCLE
-		if (switch_queue_trypush(EVENT_RECYCLE_QUEUE, ep) != SWITCH_STATUS_SUCCESS) {
-			FREE(ep);
-		}
-#else
-		FREE(ep);
-#endif
+		switch_event_index_destroy(ep);
+		switch_event_shared_release(&ep->shared);
+		switch_event_release(ep);
 
 	}
 	*event = NULL;
@@ -1498,6 +2118,107 @@ SWITCH_DECLARE(switch_status_t) switch_event_binary_serialize(switch_event_t *ev
 }
 
 
+SWITCH_DECLARE(switch_event_shared_t *) switch_event_share_take(switch_event_t **event)
+{
+	switch_event_shared_t *shared;
+
+	switch_zmalloc(shared, sizeof(*shared));
+	shared->event = *event;
+	*event = NULL;
+	switch_atomic_set(&shared->refs, 1);
+
+	return shared;
+}
+
+SWITCH_DECLARE(switch_event_shared_t *) switch_event_share(switch_event_t *event)
+{
+	switch_event_t *clone = NULL;
+
+	if (!event->shared) {
+		/* one copy for every consumer, the delivered event itself is destroyed once delivery is done */
+		if (switch_event_dup(&clone, event) != SWITCH_STATUS_SUCCESS) {
+			return NULL;
+		}
+
+		event->shared = switch_event_share_take(&clone);
+	}
+
+	switch_atomic_inc(&event->shared->refs);
+
+	return event->shared;
+}
+
+SWITCH_DECLARE(switch_event_t *) switch_event_shared_get_event(switch_event_shared_t *shared)
+{
+	return shared->event;
+}
+
+SWITCH_DECLARE(const char *) switch_event_shared_serialize(switch_event_shared_t *shared, switch_event_serial_format_t format)
+{
+	char *str = NULL;
+	switch_xml_t xml;
+
+	if (format >= SWITCH_EVENT_SERIAL_MAX) {
+		return NULL;
+	}
+
+	if (shared->serialized[format]) {
+		return shared->serialized[format];
+	}
+
+	/* render without the lock, if another consumer beat us to it keep theirs */
+	switch (format) {
+	case SWITCH_EVENT_SERIAL_PLAIN:
+		switch_event_serialize(shared->event, &str, SWITCH_TRUE);
+		break;
+	case SWITCH_EVENT_SERIAL_JSON:
+		switch_event_serialize_json(shared->event, &str);
+		break;
+	case SWITCH_EVENT_SERIAL_XML:
+		if ((xml = switch_event_xmlize(shared->event, SWITCH_VA_NONE))) {
+			str = switch_xml_toxml(xml, SWITCH_FALSE);
+			switch_xml_free(xml);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (!str) {
+		return NULL;
+	}
+
+	switch_mutex_lock(SHARED_MUTEX);
+	if (!shared->serialized[format]) {
+		shared->serialized[format] = str;
+		str = NULL;
+	}
+	switch_mutex_unlock(SHARED_MUTEX);
+
+	switch_safe_free(str);
+
+	return shared->serialized[format];
+}
+
+SWITCH_DECLARE(void) switch_event_shared_release(switch_event_shared_t **shared)
+{
+	switch_event_shared_t *sp = *shared;
+	int i;
+
+	*shared = NULL;
+
+	if (!sp || switch_atomic_dec(&sp->refs)) {
+		return;
+	}
+
+	for (i = 0; i < SWITCH_EVENT_SERIAL_MAX; i++) {
+		switch_safe_free(sp->serialized[i]);
+	}
+
+	switch_event_destroy(&sp->event);
+	free(sp);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_event_serialize(switch_event_t *event, char **str, switch_bool_t encode)
 {
 	switch_size_t len = 0;
@@ -2077,6 +2798,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, swit
 		}
 
 		EVENT_NODES[event] = event_node;
+		switch_event_rebuild_dispatch_index();
 		switch_mutex_unlock(BLOCK);
 		switch_thread_rwlock_unlock(RWLOCK);
 		/* </LOCKED> ----------------------------------------------- */
@@ -2131,6 +2853,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind_callback(switch_event_callba
 			}
 		}
 	}
+
+	if (status == SWITCH_STATUS_SUCCESS) {
+		switch_event_rebuild_dispatch_index();
+	}
 	switch_mutex_unlock(BLOCK);
 	switch_thread_rwlock_unlock(RWLOCK);
 	/* </LOCKED> ----------------------------------------------- */
@@ -2171,6 +2897,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind(switch_event_node_t **node)
 		}
 		lnp = np;
 	}
+
+	if (status == SWITCH_STATUS_SUCCESS) {
+		switch_event_rebuild_dispatch_index();
+	}
 	switch_mutex_unlock(BLOCK);
 	switch_thread_rwlock_unlock(RWLOCK);
 	/* </LOCKED> ----------------------------------------------- */
@@ -37,6 +37,9 @@
 #define PERIOD_LEN 250
 #define MAX_FRAME_PADDING 2
 #define MAX_MISSING_SEQ 20
+#define RING_MIN_LEN 1024
+#define RING_MAX_LEN 32768
+#define RING_PACKETS_PER_FRAME 32
 #define jb_debug(_jb, _level, _format, ...) if (_jb->debug_level >= _level) switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(_jb->session), SWITCH_LOG_ALERT, "JB:%p:%s:%d/%d lv:%d ln:%.4d sz:%.3u/%.3u/%.3u/%.3u c:%.3u %.3u/%.3u/%.3u/%.3u %.2f%% ->" _format, (void *) _jb, (jb->type == SJB_TEXT ? "txt" : (jb->type == SJB_AUDIO ? "aud" : "vid")), _jb->allocated_nodes, _jb->visible_nodes, _level, __LINE__,  _jb->min_frame_len, _jb->max_frame_len, _jb->frame_len, _jb->complete_frames, _jb->period_count, _jb->consec_good_count, _jb->period_good_count, _jb->consec_miss_count, _jb->period_miss_count, _jb->period_miss_pct, __VA_ARGS__)
 
 //const char *TOKEN_1 = "ONE";
@@ -52,8 +55,16 @@ typedef struct switch_jb_node_s {
 	uint8_t bad_hits;
 	struct switch_jb_node_s *prev;
 	struct switch_jb_node_s *next;
+	struct switch_jb_node_s *free_next;
 } switch_jb_node_t;
 
+/* a seq we are waiting for in SJB_RING mode, then is 1 until it was nacked */
+typedef struct switch_jb_missing_s {
+	switch_time_t then;
+	uint16_t seq;
+	uint8_t used;
+} switch_jb_missing_t;
+
 struct switch_jb_s {
 	struct switch_jb_node_s *node_list;
 	uint32_t last_target_seq;
@@ -107,8 +118,25 @@ struct switch_jb_s {
 	uint32_t flush;
 	uint32_t packet_count;
 	uint32_t max_packet_len;
+	/* SJB_RING: visible nodes indexed by seq modulo ring_len, hidden ones on free_list */
+	switch_jb_node_t **ring;
+	switch_jb_missing_t *ring_missing;
+	uint32_t ring_len;
+	uint16_t ring_low;
+	uint16_t missing_low;
+	uint32_t missing_count;
+	switch_jb_node_t *free_list;
 };
 
+#define jb_ring_mode(_jb) switch_test_flag(_jb, SJB_RING)
+#define jb_ring_slot(_jb, _seq) ((_seq) & ((_jb)->ring_len - 1))
+
+/* wrap aware distance between two host order seqs */
+static inline int seq_diff(uint16_t a, uint16_t b)
+{
+	return (int16_t)(a - b);
+}
+
 
 static int node_cmp(const void *l, const void *r)
 {
@@ -209,9 +237,16 @@ static inline switch_jb_node_t *new_node(switch_jb_t *jb)
 
 	switch_mutex_lock(jb->list_mutex);
 
-	for (np = jb->node_list; np; np = np->next) {
-		if (!np->visible) {
-			break;
+	if (jb_ring_mode(jb)) {
+		if ((np = jb->free_list)) {
+			jb->free_list = np->free_next;
+			np->free_next = NULL;
+		}
+	} else {
+		for (np = jb->node_list; np; np = np->next) {
+			if (!np->visible) {
+				break;
+			}
 		}
 	}
 
@@ -282,6 +317,7 @@ static inline void push_to_top(switch_jb_t *jb, switch_jb_node_t *node)
 static inline void hide_node(switch_jb_node_t *node, switch_bool_t pop)
 {
 	switch_jb_t *jb = node->parent;
+	int indexed = 0;
 
 	switch_mutex_lock(jb->list_mutex);
 
@@ -290,7 +326,10 @@ static inline void hide_node(switch_jb_node_t *node, switch_bool_t pop)
 		node->bad_hits = 0;
 		jb->visible_nodes--;
 
-		if (pop) {
+		if (jb_ring_mode(jb)) {
+			node->free_next = jb->free_list;
+			jb->free_list = node;
+		} else if (pop) {
 			push_to_top(jb, node);
 		}
 	}
@@ -299,7 +338,18 @@ static inline void hide_node(switch_jb_node_t *node, switch_bool_t pop)
 		switch_core_inthash_delete(jb->node_hash_ts, node->packet.header.ts);
 	}
 
-	if (switch_core_inthash_delete(jb->node_hash, node->packet.header.seq)) {
+	if (jb_ring_mode(jb)) {
+		switch_jb_node_t **slot = &jb->ring[jb_ring_slot(jb, ntohs(node->packet.header.seq))];
+
+		if (*slot == node) {
+			*slot = NULL;
+			indexed = 1;
+		}
+	} else {
+		indexed = switch_core_inthash_delete(jb->node_hash, node->packet.header.seq) != NULL;
+	}
+
+	if (indexed) {
 		if (node->packet.header.version == 1 && jb->type == SJB_VIDEO) {
 			jb->complete_frames--;
 		}
@@ -326,12 +376,211 @@ static inline void hide_nodes(switch_jb_t *jb)
 	switch_mutex_unlock(jb->list_mutex);
 }
 
+static inline switch_jb_node_t *jb_find_seq(switch_jb_t *jb, uint16_t seq)
+{
+	switch_jb_node_t *node;
+
+	if (!jb_ring_mode(jb)) {
+		return switch_core_inthash_find(jb->node_hash, seq);
+	}
+
+	node = jb->ring[jb_ring_slot(jb, ntohs(seq))];
+
+	return (node && node->packet.header.seq == seq) ? node : NULL;
+}
+
+/* the buffer outgrew the ring, double it, what was in distinct slots stays in distinct slots */
+static void jb_ring_grow(switch_jb_t *jb)
+{
+	switch_jb_node_t **ring = jb->ring;
+	switch_jb_missing_t *ring_missing = jb->ring_missing;
+	uint32_t i, len = jb->ring_len;
+
+	jb->ring_len <<= 1;
+	jb->ring = switch_core_alloc(jb->pool, sizeof(*jb->ring) * jb->ring_len);
+
+	for (i = 0; i < len; i++) {
+		if (ring[i]) {
+			jb->ring[jb_ring_slot(jb, ntohs(ring[i]->packet.header.seq))] = ring[i];
+		}
+	}
+
+	if (ring_missing) {
+		jb->ring_missing = switch_core_alloc(jb->pool, sizeof(*jb->ring_missing) * jb->ring_len);
+
+		for (i = 0; i < len; i++) {
+			if (ring_missing[i].used) {
+				jb->ring_missing[jb_ring_slot(jb, ring_missing[i].seq)] = ring_missing[i];
+			}
+		}
+	}
+
+	jb_debug(jb, 2, "RING GROW %u slots\n", jb->ring_len);
+}
+
+static inline void jb_index_node(switch_jb_t *jb, switch_jb_node_t *node)
+{
+	uint16_t seq;
+	switch_jb_node_t **slot;
+
+	if (!jb_ring_mode(jb)) {
+		switch_core_inthash_insert(jb->node_hash, node->packet.header.seq, node);
+		return;
+	}
+
+	seq = ntohs(node->packet.header.seq);
+	slot = &jb->ring[jb_ring_slot(jb, seq)];
+
+	while (*slot && (*slot)->packet.header.seq != node->packet.header.seq && jb->ring_len < RING_MAX_LEN) {
+		jb_ring_grow(jb);
+		slot = &jb->ring[jb_ring_slot(jb, seq)];
+	}
+
+	if (*slot) {
+		/* a duplicate, or a seq a whole ring older once the ring can't grow any more */
+		jb_debug(jb, 2, "REPLACE seq:%u with seq:%u\n", ntohs((*slot)->packet.header.seq), seq);
+		hide_node(*slot, SWITCH_FALSE);
+	}
+
+	*slot = node;
+
+	if (jb->visible_nodes == 1 || seq_diff(seq, jb->ring_low) < 0) {
+		jb->ring_low = seq;
+	}
+}
+
+static inline switch_jb_node_t *jb_ring_find_lowest(switch_jb_t *jb)
+{
+	switch_jb_node_t *node, *lowest = NULL;
+	uint32_t i;
+
+	if (!jb->visible_nodes) {
+		return NULL;
+	}
+
+	/* ring_low only ever trails the oldest node we hold, so this stops right away once the buffer is moving */
+	for (i = 0; i < jb->ring_len; i++) {
+		uint16_t seq = (uint16_t)(jb->ring_low + i);
+
+		if ((node = jb->ring[jb_ring_slot(jb, seq)]) && ntohs(node->packet.header.seq) == seq) {
+			jb->ring_low = seq;
+			return node;
+		}
+	}
+
+	/* ring_low fell more than a ring behind */
+	for (i = 0; i < jb->ring_len; i++) {
+		if ((node = jb->ring[i]) && (!lowest || seq_diff(ntohs(node->packet.header.seq), ntohs(lowest->packet.header.seq)) < 0)) {
+			lowest = node;
+		}
+	}
+
+	if (lowest) {
+		jb->ring_low = ntohs(lowest->packet.header.seq);
+	}
+
+	return lowest;
+}
+
+static inline void jb_ring_drop_ts(switch_jb_t *jb, uint32_t ts)
+{
+	switch_jb_node_t *node;
+	uint32_t i, seen = 0, visible = jb->visible_nodes;
+	uint16_t low;
+
+	if (!jb_ring_find_lowest(jb)) {
+		return;
+	}
+
+	low = jb->ring_low;
+
+	for (i = 0; i < jb->ring_len && seen < visible; i++) {
+		uint16_t seq = (uint16_t)(low + i);
+
+		if (!(node = jb->ring[jb_ring_slot(jb, seq)]) || ntohs(node->packet.header.seq) != seq) {
+			continue;
+		}
+
+		seen++;
+
+		if (node->packet.header.ts == ts) {
+			hide_node(node, SWITCH_FALSE);
+		}
+	}
+}
+
+static inline void jb_missing_add(switch_jb_t *jb, uint16_t seq)
+{
+	switch_jb_missing_t *missing;
+
+	if (!jb_ring_mode(jb)) {
+		switch_core_inthash_insert(jb->missing_seq_hash, (uint32_t)htons(seq), (void *)(intptr_t)1);
+		return;
+	}
+
+	missing = &jb->ring_missing[jb_ring_slot(jb, seq)];
+
+	while (missing->used && missing->seq != seq && jb->ring_len < RING_MAX_LEN) {
+		jb_ring_grow(jb);
+		missing = &jb->ring_missing[jb_ring_slot(jb, seq)];
+	}
+
+	if (!missing->used) {
+		if (!jb->missing_count++ || seq_diff(seq, jb->missing_low) < 0) {
+			jb->missing_low = seq;
+		}
+	} else if (seq_diff(seq, jb->missing_low) < 0) {
+		jb->missing_low = seq;
+	}
+
+	missing->seq = seq;
+	missing->used = 1;
+	missing->then = 1;
+}
+
+static inline int jb_missing_del(switch_jb_t *jb, uint16_t seq)
+{
+	switch_jb_missing_t *missing;
+
+	if (!jb_ring_mode(jb)) {
+		return switch_core_inthash_delete(jb->missing_seq_hash, (uint32_t)htons(seq)) != NULL;
+	}
+
+	missing = &jb->ring_missing[jb_ring_slot(jb, seq)];
+
+	if (missing->used && missing->seq == seq) {
+		missing->used = 0;
+		jb->missing_count--;
+		return 1;
+	}
+
+	return 0;
+}
+
+static inline void jb_missing_clear(switch_jb_t *jb)
+{
+	if (jb->ring_missing) {
+		memset(jb->ring_missing, 0, sizeof(*jb->ring_missing) * jb->ring_len);
+	}
+
+	jb->missing_count = 0;
+	switch_core_inthash_destroy(&jb->missing_seq_hash);
+	switch_core_inthash_init(&jb->missing_seq_hash);
+}
+
 static inline void drop_ts(switch_jb_t *jb, uint32_t ts)
 {
 	switch_jb_node_t *np;
 	int x = 0;
 
 	switch_mutex_lock(jb->list_mutex);
+
+	if (jb_ring_mode(jb)) {
+		jb_ring_drop_ts(jb, ts);
+		switch_mutex_unlock(jb->list_mutex);
+		return;
+	}
+
 	for (np = jb->node_list; np; np = np->next) {
 		if (!np->visible) continue;
 
@@ -353,6 +602,13 @@ static inline switch_jb_node_t *jb_find_lowest_seq(switch_jb_t *jb, uint32_t ts)
 	switch_jb_node_t *np, *lowest = NULL;
 
 	switch_mutex_lock(jb->list_mutex);
+
+	if (jb_ring_mode(jb) && !ts) {
+		lowest = jb_ring_find_lowest(jb);
+		switch_mutex_unlock(jb->list_mutex);
+		return lowest;
+	}
+
 	for (np = jb->node_list; np; np = np->next) {
 		if (!np->visible) continue;
 
@@ -372,6 +628,14 @@ static inline switch_jb_node_t *jb_find_lowest_node(switch_jb_t *jb)
 	switch_jb_node_t *np, *lowest = NULL;
 
 	switch_mutex_lock(jb->list_mutex);
+
+	if (jb_ring_mode(jb)) {
+		/* the oldest seq we hold carries the oldest ts */
+		lowest = jb_ring_find_lowest(jb);
+		switch_mutex_unlock(jb->list_mutex);
+		return lowest;
+	}
+
 	for (np = jb->node_list; np; np = np->next) {
 		if (!np->visible) continue;
 
@@ -636,7 +900,7 @@ static inline void add_node(switch_jb_t *jb, switch_rtp_packet_t *packet, switch
 	node->len = len;
 	memcpy(node->packet.body, packet->body, len);
 
-	switch_core_inthash_insert(jb->node_hash, node->packet.header.seq, node);
+	jb_index_node(jb, node);
 
 	if (jb->node_hash_ts) {
 		switch_core_inthash_insert(jb->node_hash_ts, node->packet.header.ts, node);
@@ -756,7 +1020,7 @@ static inline switch_status_t jb_next_packet_by_seq(switch_jb_t *jb, switch_jb_n
 	}
 
 	if (!jb->target_seq) {
-		if ((node = switch_core_inthash_find(jb->node_hash, jb->target_seq))) {
+		if ((node = jb_find_seq(jb, jb->target_seq))) {
 			jb_debug(jb, 2, "FOUND rollover seq: %u\n", ntohs(jb->target_seq));
 		} else if ((node = jb_find_lowest_seq(jb, 0))) {
 			jb_debug(jb, 2, "No target seq using seq: %u as a starting point\n", ntohs(node->packet.header.seq));
@@ -764,7 +1028,7 @@ static inline switch_status_t jb_next_packet_by_seq(switch_jb_t *jb, switch_jb_n
 			jb_debug(jb, 1, "%s", "No nodes available....\n");
 		}
 		jb_hit(jb);
-	} else if ((node = switch_core_inthash_find(jb->node_hash, jb->target_seq))) {
+	} else if ((node = jb_find_seq(jb, jb->target_seq))) {
 		jb_debug(jb, 2, "FOUND desired seq: %u\n", ntohs(jb->target_seq));
 		jb_hit(jb);
 	} else {
@@ -785,7 +1049,7 @@ static inline switch_status_t jb_next_packet_by_seq(switch_jb_t *jb, switch_jb_n
 
 			for (x = 0; x < 10; x++) {
 				increment_seq(jb);
-				if ((node = switch_core_inthash_find(jb->node_hash, jb->target_seq))) {
+				if ((node = jb_find_seq(jb, jb->target_seq))) {
 					jb_debug(jb, 2, "FOUND incremental seq: %u\n", ntohs(jb->target_seq));
 
 					if (node->packet.header.m ||  node->packet.header.ts == jb->highest_read_ts) {
@@ -892,14 +1156,78 @@ SWITCH_DECLARE(void) switch_jb_set_session(switch_jb_t *jb, switch_core_session_
 
 }
 
+static void jb_ring_enable(switch_jb_t *jb)
+{
+	switch_jb_node_t *np;
+	uint32_t want = jb->max_frame_len * RING_PACKETS_PER_FRAME;
+
+	switch_jb_reset(jb);
+
+	if (!jb->ring) {
+		jb->ring_len = RING_MIN_LEN;
+
+		while (jb->ring_len < want && jb->ring_len < RING_MAX_LEN) {
+			jb->ring_len <<= 1;
+		}
+
+		jb->ring = switch_core_alloc(jb->pool, sizeof(*jb->ring) * jb->ring_len);
+
+		if (jb->type == SJB_VIDEO) {
+			jb->ring_missing = switch_core_alloc(jb->pool, sizeof(*jb->ring_missing) * jb->ring_len);
+		}
+	}
+
+	switch_mutex_lock(jb->list_mutex);
+	memset(jb->ring, 0, sizeof(*jb->ring) * jb->ring_len);
+	jb->free_list = NULL;
+
+	for (np = jb->node_list; np; np = np->next) {
+		np->free_next = jb->free_list;
+		jb->free_list = np;
+	}
+
+	switch_set_flag(jb, SJB_RING);
+	switch_mutex_unlock(jb->list_mutex);
+
+	if (jb->type == SJB_VIDEO) {
+		jb_missing_clear(jb);
+	}
+
+	jb_debug(jb, 2, "RING MODE %u slots\n", jb->ring_len);
+}
+
+static void jb_ring_disable(switch_jb_t *jb)
+{
+	switch_jb_reset(jb);
+
+	switch_mutex_lock(jb->list_mutex);
+	switch_clear_flag(jb, SJB_RING);
+	jb->free_list = NULL;
+	switch_mutex_unlock(jb->list_mutex);
+}
+
 SWITCH_DECLARE(void) switch_jb_set_flag(switch_jb_t *jb, switch_jb_flag_t flag)
 {
+	switch_mutex_lock(jb->mutex);
+
+	if ((flag & SJB_RING) && !jb_ring_mode(jb)) {
+		jb_ring_enable(jb);
+	}
+
 	switch_set_flag(jb, flag);
+	switch_mutex_unlock(jb->mutex);
 }
 
 SWITCH_DECLARE(void) switch_jb_clear_flag(switch_jb_t *jb, switch_jb_flag_t flag)
 {
+	switch_mutex_lock(jb->mutex);
+
+	if ((flag & SJB_RING) && jb_ring_mode(jb)) {
+		jb_ring_disable(jb);
+	}
+
 	switch_clear_flag(jb, flag);
+	switch_mutex_unlock(jb->mutex);
 }
 
 SWITCH_DECLARE(int) switch_jb_poll(switch_jb_t *jb)
@@ -933,8 +1261,7 @@ SWITCH_DECLARE(void) switch_jb_reset(switch_jb_t *jb)
 
 	if (jb->type == SJB_VIDEO) {
 		switch_mutex_lock(jb->mutex);
-		switch_core_inthash_destroy(&jb->missing_seq_hash);
-		switch_core_inthash_init(&jb->missing_seq_hash);
+		jb_missing_clear(jb);
 		switch_mutex_unlock(jb->mutex);
 
 		if (jb->session) {
@@ -976,7 +1303,7 @@ SWITCH_DECLARE(switch_status_t) switch_jb_peek_frame(switch_jb_t *jb, uint32_t t
 	switch_jb_node_t *node = NULL;
 	if (seq) {
 		uint16_t want_seq = seq + peek;
-		node = switch_core_inthash_find(jb->node_hash, htons(want_seq));
+		node = jb_find_seq(jb, htons(want_seq));
 	} else if (ts && jb->samples_per_frame) {
 		uint32_t want_ts = ts + (peek * jb->samples_per_frame);
 		node = switch_core_inthash_find(jb->node_hash_ts, htonl(want_ts));
@@ -1105,6 +1432,99 @@ SWITCH_DECLARE(switch_status_t) switch_jb_destroy(switch_jb_t **jbp)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+static inline switch_jb_missing_t *jb_ring_missing(switch_jb_t *jb, uint16_t seq)
+{
+	switch_jb_missing_t *missing = &jb->ring_missing[jb_ring_slot(jb, seq)];
+
+	return (missing->used && missing->seq == seq) ? missing : NULL;
+}
+
+/* walks up from the oldest missing seq, so the first one we may nack is also the least */
+static uint32_t jb_ring_pop_nack(switch_jb_t *jb)
+{
+	switch_jb_missing_t *missing;
+	switch_time_t now;
+	uint16_t expired = (uint16_t)(ntohs(jb->target_seq) - jb->frame_len), least = 0;
+	uint32_t i, seen = 0, nack = 0;
+	uint16_t blp = 0;
+	int found = 0, low_set = 0;
+
+	if (!jb->missing_count) {
+		return 0;
+	}
+
+	now = switch_time_now();
+
+	for (i = 0; i < jb->ring_len && seen < jb->missing_count; i++) {
+		uint16_t seq = (uint16_t)(jb->missing_low + i);
+
+		if (!(missing = jb_ring_missing(jb, seq))) {
+			continue;
+		}
+
+		if (seq_diff(seq, expired) < 0) {
+			jb_debug(jb, 3, "NACKABLE seq %u expired\n", seq);
+			missing->used = 0;
+			jb->missing_count--;
+			continue;
+		}
+
+		if (!low_set) {
+			jb->missing_low = seq;
+			low_set = 1;
+		}
+
+		seen++;
+
+		if (missing->then != 1 && now - missing->then < RENACK_TIME) {
+			continue;
+		}
+
+		least = seq;
+		found = 1;
+		break;
+	}
+
+	if (!found && seen < jb->missing_count) {
+		/* missing_low fell more than a ring behind, start over from the oldest entry */
+		uint16_t next = ntohs(jb->next_seq);
+
+		for (i = 0, seen = 0; i < jb->ring_len; i++) {
+			missing = &jb->ring_missing[i];
+
+			if (!missing->used) continue;
+
+			if (!seen++ || seq_diff(next, missing->seq) > seq_diff(next, jb->missing_low)) {
+				jb->missing_low = missing->seq;
+			}
+		}
+
+		jb->missing_count = seen;
+		return 0;
+	}
+
+	if (!found) {
+		return 0;
+	}
+
+	jb_debug(jb, 3, "Found NACKABLE seq %u\n", least);
+	nack = (uint32_t) htons(least);
+	missing->then = now;
+
+	for (i = 0; i < 16; i++) {
+		if ((missing = jb_ring_missing(jb, (uint16_t)(least + i + 1)))) {
+			missing->then = now;
+			jb_debug(jb, 3, "Found addtl NACKABLE seq %u\n", least + i + 1);
+			blp |= (1 << i);
+		}
+	}
+
+	blp = htons(blp);
+	nack |= (uint32_t) blp << 16;
+
+	return nack;
+}
+
 SWITCH_DECLARE(uint32_t) switch_jb_pop_nack(switch_jb_t *jb)
 {
 	switch_hash_index_t *hi = NULL;
@@ -1121,6 +1541,12 @@ SWITCH_DECLARE(uint32_t) switch_jb_pop_nack(switch_jb_t *jb)
 
 	switch_mutex_lock(jb->mutex);
 
+	if (jb_ring_mode(jb)) {
+		nack = jb_ring_pop_nack(jb);
+		switch_mutex_unlock(jb->mutex);
+		return nack;
+	}
+
  top:
 
 	for (hi = switch_core_hash_first_iter(jb->missing_seq_hash, hi); hi; hi = switch_core_hash_next(&hi)) {
@@ -1215,7 +1641,7 @@ SWITCH_DECLARE(switch_status_t) switch_jb_put_packet(switch_jb_t *jb, switch_rtp
 		jb->next_seq = htons(got + 1);
 	} else {
 
-		if (switch_core_inthash_delete(jb->missing_seq_hash, (uint32_t)htons(got))) {
+		if (jb_missing_del(jb, got)) {
 			if (got < ntohs(jb->target_seq)) {
 				jb_debug(jb, 2, "got nacked seq %u too late\n", got);
 				jb_frame_inc(jb, 1);
@@ -1238,7 +1664,7 @@ SWITCH_DECLARE(switch_status_t) switch_jb_put_packet(switch_jb_t *jb, switch_rtp
 
 				for (i = want; i < got; i++) {
 					jb_debug(jb, 2, "MARK MISSING %u ts:%u\n", i, ntohl(packet->header.ts));
-					switch_core_inthash_insert(jb->missing_seq_hash, (uint32_t)htons(i), (void *)(intptr_t)1);
+					jb_missing_add(jb, (uint16_t)i);
 				}
 			}
 		}
@@ -1266,7 +1692,7 @@ SWITCH_DECLARE(switch_status_t) switch_jb_get_packet_by_seq(switch_jb_t *jb, uin
 	switch_status_t status = SWITCH_STATUS_NOTFOUND;
 
 	switch_mutex_lock(jb->mutex);
-	if ((node = switch_core_inthash_find(jb->node_hash, seq))) {
+	if ((node = jb_find_seq(jb, seq))) {
 		jb_debug(jb, 2, "Found buffered seq: %u\n", ntohs(seq));
 		*packet = node->packet;
 		*len = node->len;
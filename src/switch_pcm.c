@@ -196,6 +196,40 @@ static switch_status_t switch_g711u_destroy(switch_codec_t *codec)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/* the average sample level of a packet, read straight from the encoded bytes */
+static switch_status_t switch_g711_packet_energy(switch_codec_control_command_t cmd, void *cmd_data, void *cmd_arg, int16_t (*to_linear)(uint8_t))
+{
+	switch_frame_t *frame = (switch_frame_t *) cmd_data;
+	unsigned char *ebuf;
+	uint32_t i, energy = 0;
+
+	if (cmd != SCC_AUDIO_PACKET_ENERGY || !frame || !frame->datalen) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	ebuf = frame->data;
+
+	for (i = 0; i < frame->datalen; i++) {
+		energy += abs(to_linear(ebuf[i]));
+	}
+
+	*((uint32_t *) cmd_arg) = energy / frame->datalen;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t switch_g711u_control(switch_codec_t *codec,
+											switch_codec_control_command_t cmd,
+											switch_codec_control_type_t ctype,
+											void *cmd_data,
+											switch_codec_control_type_t atype,
+											void *cmd_arg,
+											switch_codec_control_type_t *rtype,
+											void **ret_data)
+{
+	return switch_g711_packet_energy(cmd, cmd_data, cmd_arg, ulaw_to_linear);
+}
+
 
 static switch_status_t switch_g711a_init(switch_codec_t *codec, switch_codec_flag_t flags, const switch_codec_settings_t *codec_settings)
 {
@@ -267,6 +301,18 @@ static switch_status_t switch_g711a_destroy(switch_codec_t *codec)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+static switch_status_t switch_g711a_control(switch_codec_t *codec,
+											switch_codec_control_command_t cmd,
+											switch_codec_control_type_t ctype,
+											void *cmd_data,
+											switch_codec_control_type_t atype,
+											void *cmd_arg,
+											switch_codec_control_type_t *rtype,
+											void **ret_data)
+{
+	return switch_g711_packet_energy(cmd, cmd_data, cmd_arg, alaw_to_linear);
+}
+
 
 static void mod_g711_load(switch_loadable_module_interface_t ** module_interface, switch_memory_pool_t *pool)
 {
@@ -292,6 +338,7 @@ static void mod_g711_load(switch_loadable_module_interface_t ** module_interface
 											 switch_g711u_encode,	/* function to encode raw data into encoded data */
 											 switch_g711u_decode,	/* function to decode encoded data into raw data */
 											 switch_g711u_destroy);	/* deinitalize a codec handle using this implementation */
+		codec_interface->implementations->codec_control = switch_g711u_control;
 
 		if (count > 4) continue;
 
@@ -312,6 +359,7 @@ static void mod_g711_load(switch_loadable_module_interface_t ** module_interface
 											 switch_g711u_encode,	/* function to encode raw data into encoded data */
 											 switch_g711u_decode,	/* function to decode encoded data into raw data */
 											 switch_g711u_destroy);	/* deinitalize a codec handle using this implementation */
+		codec_interface->implementations->codec_control = switch_g711u_control;
 
 		switch_core_codec_add_implementation(pool, codec_interface, SWITCH_CODEC_TYPE_AUDIO,	/* enumeration defining the type of the codec */
 											 0,	/* the IANA code number */
@@ -330,6 +378,7 @@ static void mod_g711_load(switch_loadable_module_interface_t ** module_interface
 											 switch_g711u_encode,	/* function to encode raw data into encoded data */
 											 switch_g711u_decode,	/* function to decode encoded data into raw data */
 											 switch_g711u_destroy);	/* deinitalize a codec handle using this implementation */
+		codec_interface->implementations->codec_control = switch_g711u_control;
 	}
 
 	SWITCH_ADD_CODEC(codec_interface, "G.711 alaw");
@@ -351,6 +400,7 @@ static void mod_g711_load(switch_loadable_module_interface_t ** module_interface
 											 switch_g711a_encode,	/* function to encode raw data into encoded data */
 											 switch_g711a_decode,	/* function to decode encoded data into raw data */
 											 switch_g711a_destroy);	/* deinitalize a codec handle using this implementation */
+		codec_interface->implementations->codec_control = switch_g711a_control;
 	}
 }
 
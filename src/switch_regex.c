@@ -33,6 +33,295 @@
 #include <switch.h>
 #include <pcre.h>
 
+#define REGEX_CACHE_MAX 1024
+
+/* a compiled pattern, shared by everyone running the same expression and freed once it was evicted and is no longer in use */
+typedef struct regex_cache_entry_s {
+	char *key;
+	pcre *re;
+	pcre_extra *extra;
+	uint32_t refs;
+	switch_bool_t evicted;
+	struct regex_cache_entry_s *prev;
+	struct regex_cache_entry_s *next;
+} regex_cache_entry_t;
+
+static struct {
+	switch_mutex_t *mutex;
+	switch_hash_t *entries;
+	switch_hash_t *compiled;
+	regex_cache_entry_t *head;
+	regex_cache_entry_t *tail;
+	uint32_t count;
+	uint32_t max;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+} REGEX_CACHE;
+
+static void regex_cache_compiled_key(pcre *re, char *buf, switch_size_t len)
+{
+	switch_snprintf(buf, len, "%p", (void *) re);
+}
+
+static void regex_cache_unlink(regex_cache_entry_t *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		REGEX_CACHE.head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		REGEX_CACHE.tail = entry->prev;
+	}
+
+	entry->prev = entry->next = NULL;
+}
+
+static void regex_cache_link(regex_cache_entry_t *entry)
+{
+	entry->prev = NULL;
+	entry->next = REGEX_CACHE.head;
+
+	if (REGEX_CACHE.head) {
+		REGEX_CACHE.head->prev = entry;
+	} else {
+		REGEX_CACHE.tail = entry;
+	}
+
+	REGEX_CACHE.head = entry;
+}
+
+static void regex_free_compiled(pcre *re, pcre_extra *extra)
+{
+	if (extra) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study(extra);
+#else
+		pcre_free(extra);
+#endif
+	}
+
+	if (re) {
+		pcre_free(re);
+	}
+}
+
+static void regex_cache_free_entry(regex_cache_entry_t *entry)
+{
+	char pkey[32];
+
+	regex_cache_compiled_key(entry->re, pkey, sizeof(pkey));
+	switch_core_hash_delete(REGEX_CACHE.compiled, pkey);
+
+	regex_free_compiled(entry->re, entry->extra);
+	free(entry->key);
+	free(entry);
+}
+
+/* drop the least recently used patterns, the ones still running are freed by the last one to let go of them */
+static void regex_cache_trim(void)
+{
+	while (REGEX_CACHE.count > REGEX_CACHE.max && REGEX_CACHE.tail) {
+		regex_cache_entry_t *entry = REGEX_CACHE.tail;
+
+		regex_cache_unlink(entry);
+		switch_core_hash_delete(REGEX_CACHE.entries, entry->key);
+		REGEX_CACHE.count--;
+		REGEX_CACHE.evictions++;
+
+		if (entry->refs) {
+			entry->evicted = SWITCH_TRUE;
+		} else {
+			regex_cache_free_entry(entry);
+		}
+	}
+}
+
+/* studying (and jit compiling) only pays off for patterns the cache keeps */
+static pcre *regex_compile(const char *expression, uint32_t flags, switch_bool_t study, pcre_extra **extra, const char **error, int *erroffset)
+{
+	pcre *re = pcre_compile(expression,	/* the pattern */
+							flags,	/* default options */
+							error,	/* for error message */
+							erroffset,	/* for error offset */
+							NULL);	/* use default character tables */
+
+	*extra = NULL;
+
+	if (*error) {
+		switch_regex_safe_free(re);
+		return NULL;
+	}
+
+	if (re && study) {
+		const char *study_error = NULL;
+#ifdef PCRE_STUDY_JIT_COMPILE
+		*extra = pcre_study(re, PCRE_STUDY_JIT_COMPILE, &study_error);
+#else
+		*extra = pcre_study(re, 0, &study_error);
+#endif
+	}
+
+	return re;
+}
+
+/*
+ * the compiled pattern for expression and flags, from the cache when it is running.
+ * the entry is held until regex_cache_release(), entry is NULL when the pattern was compiled just for this call.
+ */
+static pcre *regex_cache_acquire(const char *expression, uint32_t flags, regex_cache_entry_t **entryp, pcre_extra **extra,
+								 const char **error, int *erroffset)
+{
+	regex_cache_entry_t *entry, *found;
+	char kbuf[256], pkey[32];
+	char *key = kbuf;
+	switch_size_t len = strlen(expression);
+	pcre *re;
+
+	*entryp = NULL;
+
+	if (!REGEX_CACHE.mutex || !REGEX_CACHE.max) {
+		return regex_compile(expression, flags, SWITCH_FALSE, extra, error, erroffset);
+	}
+
+	if (len + 10 > sizeof(kbuf)) {
+		key = switch_mprintf("%x:%s", flags, expression);
+	} else {
+		switch_snprintf(kbuf, sizeof(kbuf), "%x:%s", flags, expression);
+	}
+
+	switch_mutex_lock(REGEX_CACHE.mutex);
+	if ((entry = switch_core_hash_find(REGEX_CACHE.entries, key))) {
+		REGEX_CACHE.hits++;
+		entry->refs++;
+		regex_cache_unlink(entry);
+		regex_cache_link(entry);
+		switch_mutex_unlock(REGEX_CACHE.mutex);
+		goto end;
+	}
+	REGEX_CACHE.misses++;
+	switch_mutex_unlock(REGEX_CACHE.mutex);
+
+	if (!(re = regex_compile(expression, flags, SWITCH_TRUE, extra, error, erroffset))) {
+		goto end;
+	}
+
+	switch_zmalloc(entry, sizeof(*entry));
+	entry->key = strdup(key);
+	entry->re = re;
+	entry->extra = *extra;
+	entry->refs = 1;
+
+	switch_mutex_lock(REGEX_CACHE.mutex);
+	if ((found = switch_core_hash_find(REGEX_CACHE.entries, key))) {
+		/* someone else compiled it meanwhile */
+		found->refs++;
+		switch_mutex_unlock(REGEX_CACHE.mutex);
+		regex_free_compiled(entry->re, entry->extra);
+		free(entry->key);
+		free(entry);
+		entry = found;
+		goto end;
+	}
+
+	switch_core_hash_insert(REGEX_CACHE.entries, entry->key, entry);
+	regex_cache_compiled_key(entry->re, pkey, sizeof(pkey));
+	switch_core_hash_insert(REGEX_CACHE.compiled, pkey, entry);
+	regex_cache_link(entry);
+	REGEX_CACHE.count++;
+	regex_cache_trim();
+	switch_mutex_unlock(REGEX_CACHE.mutex);
+
+ end:
+
+	if (key != kbuf) {
+		free(key);
+	}
+
+	if (!entry) {
+		return NULL;
+	}
+
+	*entryp = entry;
+	*extra = entry->extra;
+
+	return entry->re;
+}
+
+static void regex_cache_release(regex_cache_entry_t *entry)
+{
+	if (!REGEX_CACHE.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(REGEX_CACHE.mutex);
+	if (!--entry->refs && entry->evicted) {
+		regex_cache_free_entry(entry);
+	}
+	switch_mutex_unlock(REGEX_CACHE.mutex);
+}
+
+SWITCH_DECLARE(void) switch_regex_init(switch_memory_pool_t *pool)
+{
+	memset(&REGEX_CACHE, 0, sizeof(REGEX_CACHE));
+	switch_core_hash_init(&REGEX_CACHE.entries);
+	switch_core_hash_init(&REGEX_CACHE.compiled);
+	REGEX_CACHE.max = REGEX_CACHE_MAX;
+	switch_mutex_init(&REGEX_CACHE.mutex, SWITCH_MUTEX_NESTED, pool);
+}
+
+SWITCH_DECLARE(void) switch_regex_shutdown(void)
+{
+	switch_mutex_t *mutex = REGEX_CACHE.mutex;
+
+	if (!mutex) {
+		return;
+	}
+
+	switch_mutex_lock(mutex);
+	REGEX_CACHE.max = 0;
+	regex_cache_trim();
+	REGEX_CACHE.mutex = NULL;
+	switch_mutex_unlock(mutex);
+
+	/* whatever is still held by someone goes with the process */
+	switch_core_hash_destroy(&REGEX_CACHE.entries);
+	switch_core_hash_destroy(&REGEX_CACHE.compiled);
+}
+
+SWITCH_DECLARE(void) switch_regex_cache_set_max(uint32_t max)
+{
+	if (!REGEX_CACHE.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(REGEX_CACHE.mutex);
+	REGEX_CACHE.max = max;
+	regex_cache_trim();
+	switch_mutex_unlock(REGEX_CACHE.mutex);
+}
+
+SWITCH_DECLARE(void) switch_regex_cache_get_stats(switch_regex_cache_stats_t *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	if (!REGEX_CACHE.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(REGEX_CACHE.mutex);
+	stats->entries = REGEX_CACHE.count;
+	stats->max = REGEX_CACHE.max;
+	stats->hits = REGEX_CACHE.hits;
+	stats->misses = REGEX_CACHE.misses;
+	stats->evictions = REGEX_CACHE.evictions;
+	switch_mutex_unlock(REGEX_CACHE.mutex);
+}
+
 SWITCH_DECLARE(switch_regex_t *) switch_regex_compile(const char *pattern,
 													  int options, const char **errorptr, int *erroroffset, const unsigned char *tables)
 {
@@ -48,8 +337,24 @@ SWITCH_DECLARE(int) switch_regex_copy_substring(const char *subject, int *ovecto
 
 SWITCH_DECLARE(void) switch_regex_free(void *data)
 {
-	pcre_free(data);
+	regex_cache_entry_t *entry = NULL;
+	char pkey[32];
+
+	if (REGEX_CACHE.mutex) {
+		regex_cache_compiled_key((pcre *) data, pkey, sizeof(pkey));
+
+		switch_mutex_lock(REGEX_CACHE.mutex);
+		if ((entry = switch_core_hash_find(REGEX_CACHE.compiled, pkey))) {
+			if (!--entry->refs && entry->evicted) {
+				regex_cache_free_entry(entry);
+			}
+		}
+		switch_mutex_unlock(REGEX_CACHE.mutex);
+	}
 
+	if (!entry) {
+		pcre_free(data);
+	}
 }
 
 SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expression, switch_regex_t **new_re, int *ovector, uint32_t olen)
@@ -57,6 +362,8 @@ SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expressi
 	const char *error = NULL;
 	int erroffset = 0;
 	pcre *re = NULL;
+	pcre_extra *extra = NULL;
+	regex_cache_entry_t *entry = NULL;
 	int match_count = 0;
 	char *tmp = NULL;
 	uint32_t flags = 0;
@@ -95,19 +402,14 @@ SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expressi
 		}
 	}
 
-	re = pcre_compile(expression,	/* the pattern */
-					  flags,	/* default options */
-					  &error,	/* for error message */
-					  &erroffset,	/* for error offset */
-					  NULL);	/* use default character tables */
+	re = regex_cache_acquire(expression, flags, &entry, &extra, &error, &erroffset);
 	if (error) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "COMPILE ERROR: %d [%s][%s]\n", erroffset, error, expression);
-		switch_regex_safe_free(re);
 		goto end;
 	}
 
 	match_count = pcre_exec(re,	/* result of pcre_compile() */
-							NULL,	/* we didn't study the pattern */
+							extra,	/* the study data, if any */
 							field,	/* the subject string */
 							(int) strlen(field),	/* the length of the subject string */
 							0,	/* start at offset 0 in the subject */
@@ -117,8 +419,17 @@ SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expressi
 
 
 	if (match_count <= 0) {
-		switch_regex_safe_free(re);
+		if (entry) {
+			regex_cache_release(entry);
+			re = NULL;
+		} else {
+			regex_free_compiled(re, extra);
+			re = NULL;
+		}
 		match_count = 0;
+	} else if (!entry) {
+		/* the caller only gets the pattern to free */
+		regex_free_compiled(NULL, extra);
 	}
 
 	*new_re = (switch_regex_t *) re;
@@ -217,6 +528,8 @@ SWITCH_DECLARE(switch_status_t) switch_regex_match_partial(const char *target, c
 	const char *error = NULL;	/* Used to hold any errors                                           */
 	int error_offset = 0;		/* Holds the offset of an error                                      */
 	pcre *pcre_prepared = NULL;	/* Holds the compiled regex                                          */
+	pcre_extra *extra = NULL;	/* Holds the study data                                              */
+	regex_cache_entry_t *entry = NULL;	/* Holds the cache entry of the compiled regex               */
 	int match_count = 0;		/* Number of times the regex was matched                             */
 	int offset_vectors[255];	/* not used, but has to exist or pcre won't even try to find a match */
 	int pcre_flags = 0;
@@ -247,16 +560,11 @@ SWITCH_DECLARE(switch_status_t) switch_regex_match_partial(const char *target, c
 		}
 	}
 
-	/* Compile the expression */
-	pcre_prepared = pcre_compile(expression, flags, &error, &error_offset, NULL);
+	/* Compile the expression, or find it already compiled */
+	pcre_prepared = regex_cache_acquire(expression, flags, &entry, &extra, &error, &error_offset);
 
 	/* See if there was an error in the expression */
 	if (error != NULL) {
-		/* Clean up after ourselves */
-		if (pcre_prepared) {
-			pcre_free(pcre_prepared);
-			pcre_prepared = NULL;
-		}
 		/* Note our error */
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR,
 						  "Regular Expression Error expression[%s] error[%s] location[%d]\n", expression, error, error_offset);
@@ -271,13 +579,15 @@ SWITCH_DECLARE(switch_status_t) switch_regex_match_partial(const char *target, c
 
 	/* So far so good, run the regex */
 	match_count =
-		pcre_exec(pcre_prepared, NULL, target, (int) strlen(target), 0, pcre_flags, offset_vectors, sizeof(offset_vectors) / sizeof(offset_vectors[0]));
+		pcre_exec(pcre_prepared, extra, target, (int) strlen(target), 0, pcre_flags, offset_vectors, sizeof(offset_vectors) / sizeof(offset_vectors[0]));
 
 	/* Clean up */
-	if (pcre_prepared) {
-		pcre_free(pcre_prepared);
-		pcre_prepared = NULL;
+	if (entry) {
+		regex_cache_release(entry);
+	} else {
+		regex_free_compiled(pcre_prepared, extra);
 	}
+	pcre_prepared = NULL;
 
 	/* switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "number of matches: %d\n", match_count); */
 
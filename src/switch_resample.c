@@ -52,6 +52,545 @@
 
 #define resample_buffer(a, b, c) a > b ? ((a / 1000) / 2) * c : ((b / 1000) / 2) * c
 
+/* Mixing kernels
+ *
+ * The helpers below run on a table of kernels picked once for the cpu we are on.  Every kernel
+ * gives the same result as the scalar one down to the last bit, the vector ones just do 8 or 16
+ * samples at a time.  Gains are fixed point with VOLUME_SHIFT fractional bits.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define AUDIO_KERNELS_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AUDIO_KERNELS_AVX2
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AUDIO_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#define VOLUME_SHIFT 12
+#define VOLUME_ROUND (1 << (VOLUME_SHIFT - 1))
+
+typedef struct audio_kernels_s {
+	const char *name;
+	void (*accumulate)(int32_t *mix, const int16_t *data, uint32_t len);
+	void (*pack)(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t len);
+	void (*add)(int16_t *data, const int16_t *other, uint32_t len);
+	void (*sub)(int16_t *data, const int16_t *other, uint32_t len);
+	void (*gain)(int16_t *data, uint32_t len, int16_t gain);
+	void (*downmix)(int16_t *data, uint32_t samples);
+	void (*upmix)(int16_t *data, uint32_t samples);
+} audio_kernels_t;
+
+static void scalar_accumulate(int32_t *mix, const int16_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		mix[i] += data[i];
+	}
+}
+
+static void scalar_pack(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t len)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = 0; i < len; i++) {
+		z = own ? mix[i] - own[i] : mix[i];
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static void scalar_add(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = 0; i < len; i++) {
+		z = data[i] + other[i];
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static void scalar_sub(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		data[i] -= other[i];
+	}
+}
+
+static void scalar_gain(int16_t *data, uint32_t len, int16_t gain)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = 0; i < len; i++) {
+		z = (data[i] * gain + VOLUME_ROUND) >> VOLUME_SHIFT;
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+/* stereo to mono in place, the sum of both channels */
+static void scalar_downmix(int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = 0; i < samples; i++) {
+		z = data[i * 2] + data[i * 2 + 1];
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+/* mono to stereo in place, from the end so nothing is overwritten before it is read */
+static void scalar_upmix(int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = samples; i > 0; i--) {
+		data[i * 2 - 1] = data[i * 2 - 2] = data[i - 1];
+	}
+}
+
+static const audio_kernels_t scalar_kernels = {
+	"scalar", scalar_accumulate, scalar_pack, scalar_add, scalar_sub, scalar_gain, scalar_downmix, scalar_upmix
+};
+
+#ifdef AUDIO_KERNELS_SSE2
+static inline __m128i sse2_widen_lo(__m128i x)
+{
+	return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+static inline __m128i sse2_widen_hi(__m128i x)
+{
+	return _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+}
+
+static void sse2_accumulate(int32_t *mix, const int16_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+
+		_mm_storeu_si128((__m128i *) (mix + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (mix + i)), sse2_widen_lo(x)));
+		_mm_storeu_si128((__m128i *) (mix + i + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (mix + i + 4)), sse2_widen_hi(x)));
+	}
+
+	scalar_accumulate(mix + i, data + i, len - i);
+}
+
+static void sse2_pack(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m128i m0 = _mm_loadu_si128((const __m128i *) (mix + i));
+		__m128i m1 = _mm_loadu_si128((const __m128i *) (mix + i + 4));
+
+		if (own) {
+			__m128i o = _mm_loadu_si128((const __m128i *) (own + i));
+
+			m0 = _mm_sub_epi32(m0, sse2_widen_lo(o));
+			m1 = _mm_sub_epi32(m1, sse2_widen_hi(o));
+		}
+
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(m0, m1));
+	}
+
+	scalar_pack(data + i, mix + i, own ? own + i : NULL, len - i);
+}
+
+static void sse2_add(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+
+		_mm_storeu_si128((__m128i *) (data + i), _mm_adds_epi16(x, _mm_loadu_si128((const __m128i *) (other + i))));
+	}
+
+	scalar_add(data + i, other + i, len - i);
+}
+
+static void sse2_sub(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+
+		_mm_storeu_si128((__m128i *) (data + i), _mm_sub_epi16(x, _mm_loadu_si128((const __m128i *) (other + i))));
+	}
+
+	scalar_sub(data + i, other + i, len - i);
+}
+
+static void sse2_gain(int16_t *data, uint32_t len, int16_t gain)
+{
+	__m128i g = _mm_set1_epi16(gain), round = _mm_set1_epi32(VOLUME_ROUND);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i lo = _mm_mullo_epi16(x, g), hi = _mm_mulhi_epi16(x, g);
+		__m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), VOLUME_SHIFT);
+		__m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), VOLUME_SHIFT);
+
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(p0, p1));
+	}
+
+	scalar_gain(data + i, len - i, gain);
+}
+
+static void sse2_downmix(int16_t *data, uint32_t samples)
+{
+	__m128i ones = _mm_set1_epi16(1);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_madd_epi16(_mm_loadu_si128((const __m128i *) (data + i * 2)), ones);
+		__m128i b = _mm_madd_epi16(_mm_loadu_si128((const __m128i *) (data + i * 2 + 8)), ones);
+
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(a, b));
+	}
+
+	for (; i < samples; i++) {
+		int32_t z = data[i * 2] + data[i * 2 + 1];
+
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static void sse2_upmix(int16_t *data, uint32_t samples)
+{
+	uint32_t i = samples;
+
+	while (i >= 8) {
+		__m128i x;
+
+		i -= 8;
+		x = _mm_loadu_si128((const __m128i *) (data + i));
+		_mm_storeu_si128((__m128i *) (data + i * 2 + 8), _mm_unpackhi_epi16(x, x));
+		_mm_storeu_si128((__m128i *) (data + i * 2), _mm_unpacklo_epi16(x, x));
+	}
+
+	scalar_upmix(data, i);
+}
+
+static const audio_kernels_t sse2_kernels = {
+	"sse2", sse2_accumulate, sse2_pack, sse2_add, sse2_sub, sse2_gain, sse2_downmix, sse2_upmix
+};
+#endif
+
+#ifdef AUDIO_KERNELS_AVX2
+AVX2_TARGET static void avx2_accumulate(int32_t *mix, const int16_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m256i x0 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i)));
+		__m256i x1 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i + 8)));
+
+		_mm256_storeu_si256((__m256i *) (mix + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (mix + i)), x0));
+		_mm256_storeu_si256((__m256i *) (mix + i + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (mix + i + 8)), x1));
+	}
+
+	sse2_accumulate(mix + i, data + i, len - i);
+}
+
+/* packs works on each 128 bit half, the permute puts the halves back in sample order */
+AVX2_TARGET static void avx2_pack(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m256i m0 = _mm256_loadu_si256((const __m256i *) (mix + i));
+		__m256i m1 = _mm256_loadu_si256((const __m256i *) (mix + i + 8));
+
+		if (own) {
+			m0 = _mm256_sub_epi32(m0, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (own + i))));
+			m1 = _mm256_sub_epi32(m1, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (own + i + 8))));
+		}
+
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(m0, m1), 0xd8));
+	}
+
+	sse2_pack(data + i, mix + i, own ? own + i : NULL, len - i);
+}
+
+AVX2_TARGET static void avx2_add(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_adds_epi16(x, _mm256_loadu_si256((const __m256i *) (other + i))));
+	}
+
+	sse2_add(data + i, other + i, len - i);
+}
+
+AVX2_TARGET static void avx2_sub(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_sub_epi16(x, _mm256_loadu_si256((const __m256i *) (other + i))));
+	}
+
+	sse2_sub(data + i, other + i, len - i);
+}
+
+AVX2_TARGET static void avx2_gain(int16_t *data, uint32_t len, int16_t gain)
+{
+	__m256i g = _mm256_set1_epi16(gain), round = _mm256_set1_epi32(VOLUME_ROUND);
+	uint32_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+		__m256i lo = _mm256_mullo_epi16(x, g), hi = _mm256_mulhi_epi16(x, g);
+		__m256i p0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(lo, hi), round), VOLUME_SHIFT);
+		__m256i p1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(lo, hi), round), VOLUME_SHIFT);
+
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_packs_epi32(p0, p1));
+	}
+
+	sse2_gain(data + i, len - i, gain);
+}
+
+AVX2_TARGET static void avx2_downmix(int16_t *data, uint32_t samples)
+{
+	__m256i ones = _mm256_set1_epi16(1);
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i a = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *) (data + i * 2)), ones);
+		__m256i b = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *) (data + i * 2 + 16)), ones);
+
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8));
+	}
+
+	for (; i < samples; i++) {
+		int32_t z = data[i * 2] + data[i * 2 + 1];
+
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static const audio_kernels_t avx2_kernels = {
+	"avx2", avx2_accumulate, avx2_pack, avx2_add, avx2_sub, avx2_gain, avx2_downmix, sse2_upmix
+};
+#endif
+
+#ifdef AUDIO_KERNELS_NEON
+static void neon_accumulate(int32_t *mix, const int16_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		int16x8_t x = vld1q_s16(data + i);
+
+		vst1q_s32(mix + i, vaddw_s16(vld1q_s32(mix + i), vget_low_s16(x)));
+		vst1q_s32(mix + i + 4, vaddw_s16(vld1q_s32(mix + i + 4), vget_high_s16(x)));
+	}
+
+	scalar_accumulate(mix + i, data + i, len - i);
+}
+
+static void neon_pack(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		int32x4_t m0 = vld1q_s32(mix + i), m1 = vld1q_s32(mix + i + 4);
+
+		if (own) {
+			int16x8_t o = vld1q_s16(own + i);
+
+			m0 = vsubw_s16(m0, vget_low_s16(o));
+			m1 = vsubw_s16(m1, vget_high_s16(o));
+		}
+
+		vst1q_s16(data + i, vcombine_s16(vqmovn_s32(m0), vqmovn_s32(m1)));
+	}
+
+	scalar_pack(data + i, mix + i, own ? own + i : NULL, len - i);
+}
+
+static void neon_add(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		vst1q_s16(data + i, vqaddq_s16(vld1q_s16(data + i), vld1q_s16(other + i)));
+	}
+
+	scalar_add(data + i, other + i, len - i);
+}
+
+static void neon_sub(int16_t *data, const int16_t *other, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		vst1q_s16(data + i, vsubq_s16(vld1q_s16(data + i), vld1q_s16(other + i)));
+	}
+
+	scalar_sub(data + i, other + i, len - i);
+}
+
+static void neon_gain(int16_t *data, uint32_t len, int16_t gain)
+{
+	int16x4_t g = vdup_n_s16(gain);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		int16x8_t x = vld1q_s16(data + i);
+		int32x4_t p0 = vrshrq_n_s32(vmull_s16(vget_low_s16(x), g), VOLUME_SHIFT);
+		int32x4_t p1 = vrshrq_n_s32(vmull_s16(vget_high_s16(x), g), VOLUME_SHIFT);
+
+		vst1q_s16(data + i, vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1)));
+	}
+
+	scalar_gain(data + i, len - i, gain);
+}
+
+static void neon_downmix(int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		int16x8x2_t x = vld2q_s16(data + i * 2);
+
+		vst1q_s16(data + i, vqaddq_s16(x.val[0], x.val[1]));
+	}
+
+	for (; i < samples; i++) {
+		int32_t z = data[i * 2] + data[i * 2 + 1];
+
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static void neon_upmix(int16_t *data, uint32_t samples)
+{
+	uint32_t i = samples;
+
+	while (i >= 8) {
+		int16x8x2_t x;
+
+		i -= 8;
+		x.val[0] = x.val[1] = vld1q_s16(data + i);
+		vst2q_s16(data + i * 2, x);
+	}
+
+	scalar_upmix(data, i);
+}
+
+static const audio_kernels_t neon_kernels = {
+	"neon", neon_accumulate, neon_pack, neon_add, neon_sub, neon_gain, neon_downmix, neon_upmix
+};
+#endif
+
+static const audio_kernels_t *audio_kernels = NULL;
+
+static const audio_kernels_t *audio_kernels_best(void)
+{
+#ifdef AUDIO_KERNELS_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return &avx2_kernels;
+	}
+#endif
+#ifdef AUDIO_KERNELS_SSE2
+	return &sse2_kernels;
+#elif defined(AUDIO_KERNELS_NEON)
+	return &neon_kernels;
+#else
+	return &scalar_kernels;
+#endif
+}
+
+static inline const audio_kernels_t *kernels(void)
+{
+	if (!audio_kernels) {
+		audio_kernels = audio_kernels_best();
+	}
+
+	return audio_kernels;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_audio_kernels_set(const char *name)
+{
+	const audio_kernels_t *set = NULL;
+
+	if (zstr(name)) {
+		set = audio_kernels_best();
+	} else if (!strcasecmp(name, "scalar")) {
+		set = &scalar_kernels;
+#ifdef AUDIO_KERNELS_SSE2
+	} else if (!strcasecmp(name, "sse2")) {
+		set = &sse2_kernels;
+#endif
+#ifdef AUDIO_KERNELS_AVX2
+	} else if (!strcasecmp(name, "avx2")) {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			set = &avx2_kernels;
+		}
+#endif
+#ifdef AUDIO_KERNELS_NEON
+	} else if (!strcasecmp(name, "neon")) {
+		set = &neon_kernels;
+#endif
+	}
+
+	if (!set) {
+		return SWITCH_STATUS_NOTIMPL;
+	}
+
+	audio_kernels = set;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(const char *) switch_audio_kernels_name(void)
+{
+	return kernels()->name;
+}
+
+SWITCH_DECLARE(void) switch_mix_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	kernels()->accumulate(mix, data, samples);
+}
+
+SWITCH_DECLARE(void) switch_mix_pack(int16_t *data, const int32_t *mix, const int16_t *own, uint32_t samples)
+{
+	kernels()->pack(data, mix, own, samples);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_resample_perform_create(switch_audio_resampler_t **new_resampler,
 															   uint32_t from_rate, uint32_t to_rate,
 															   uint32_t to_size,
@@ -230,8 +769,7 @@ SWITCH_DECLARE(void) switch_generate_sln_silence(int16_t *data, uint32_t samples
 
 SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels)
 {
-	int i;
-	int32_t x, z;
+	uint32_t x;
 
 	if (channels == 0) channels = 1;
 
@@ -241,11 +779,7 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 		x = samples;
 	}
 
-	for (i = 0; i < x * channels; i++) {
-		z = data[i] + other_data[i];
-		switch_normalize_to_16bit(z);
-		data[i] = (int16_t) z;
-	}
+	kernels()->add(data, other_data, x * channels);
 
 	return x;
 }
@@ -253,8 +787,7 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 
 SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels)
 {
-	int i;
-	int32_t x;
+	uint32_t x;
 
 	if (channels == 0) channels = 1;
 
@@ -264,9 +797,7 @@ SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int
 		x = samples;
 	}
 
-	for (i = 0; i < x * channels; i++) {
-		data[i] -= other_data[i];
-	}
+	kernels()->sub(data, other_data, x * channels);
 
 	return x;
 }
@@ -278,7 +809,11 @@ SWITCH_DECLARE(void) switch_mux_channels(int16_t *data, switch_size_t samples, u
 
 	switch_assert(channels < 11);
 
-	if (orig_channels > channels) {
+	if (orig_channels == 2 && channels == 1) {
+		kernels()->downmix(data, (uint32_t) samples);
+	} else if (orig_channels == 1 && channels == 2) {
+		kernels()->upmix(data, (uint32_t) samples);
+	} else if (orig_channels > channels) {
 		for (i = 0; i < samples; i++) {
 			int32_t z = 0;
 			for (j = 0; j < orig_channels; j++) {
@@ -325,10 +860,11 @@ SWITCH_DECLARE(void) switch_mux_channels(int16_t *data, switch_size_t samples, u
 
 SWITCH_DECLARE(void) switch_change_sln_volume_granular(int16_t *data, uint32_t samples, int32_t vol)
 {
-	double newrate = 0;
-	double pos[13] = {1.25, 1.50, 1.75, 2.0, 2.25, 2.50, 2.75, 3.0, 3.25, 3.50, 3.75, 4.0, 4.5};
-	double neg[13] = {.917, .834, .751, .668, .585, .502, .419, .336, .253, .087, .017, .004, 0.0};
-	double *chart;
+	int16_t newrate = 0;
+	/* 1.25 .. 4.5 and .917 .. 0 in 1/4096ths */
+	int16_t pos[13] = {5120, 6144, 7168, 8192, 9216, 10240, 11264, 12288, 13312, 14336, 15360, 16384, 18432};
+	int16_t neg[13] = {3756, 3416, 3076, 2736, 2396, 2056, 1716, 1376, 1036, 356, 70, 16, 0};
+	int16_t *chart;
 	uint32_t i;
 
 	if (vol == 0) return;
@@ -348,15 +884,7 @@ SWITCH_DECLARE(void) switch_change_sln_volume_granular(int16_t *data, uint32_t s
 	newrate = chart[i];
 
 	if (newrate) {
-		int32_t tmp;
-		uint32_t x;
-		int16_t *fp = data;
-
-		for (x = 0; x < samples; x++) {
-			tmp = (int32_t) (fp[x] * newrate);
-			switch_normalize_to_16bit(tmp);
-			fp[x] = (int16_t) tmp;
-		}
+		kernels()->gain(data, samples, newrate);
 	} else {
 		memset(data, 0, samples * 2);
 	}
@@ -364,10 +892,11 @@ SWITCH_DECLARE(void) switch_change_sln_volume_granular(int16_t *data, uint32_t s
 
 SWITCH_DECLARE(void) switch_change_sln_volume(int16_t *data, uint32_t samples, int32_t vol)
 {
-	double newrate = 0;
-	double pos[4] = {1.3, 2.3, 3.3, 4.3};
-	double neg[4] = {.80, .60, .40, .20};
-	double *chart;
+	int16_t newrate = 0;
+	/* 1.3 .. 4.3 and .8 .. .2 in 1/4096ths */
+	int16_t pos[4] = {5325, 9421, 13517, 17613};
+	int16_t neg[4] = {3277, 2458, 1638, 819};
+	int16_t *chart;
 	uint32_t i;
 
 	if (vol == 0) return;
@@ -387,15 +916,7 @@ SWITCH_DECLARE(void) switch_change_sln_volume(int16_t *data, uint32_t samples, i
 	newrate = chart[i];
 
 	if (newrate) {
-		int32_t tmp;
-		uint32_t x;
-		int16_t *fp = data;
-
-		for (x = 0; x < samples; x++) {
-			tmp = (int32_t) (fp[x] * newrate);
-			switch_normalize_to_16bit(tmp);
-			fp[x] = (int16_t) tmp;
-		}
+		kernels()->gain(data, samples, newrate);
 	}
 }
 
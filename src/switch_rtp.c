@@ -76,6 +76,12 @@
 #define MAX_SRTP_ERRS 100
 #define NTP_TIME_OFFSET 2208988800UL
 #define ZRTP_MAGIC_COOKIE 0x5a525450
+#define RTP_IO_MAX_THREADS 16
+#define RTP_IO_MAX_SESSIONS 4096
+#define RTP_IO_RING_LEN 16
+#define RTP_IO_PACKET_LEN 1536
+#define RTP_TX_BATCH_LEN 32
+#define RTP_TX_BATCH_MAX_USEC 20000
 static const switch_payload_t INVALID_PT = 255;
 
 #define DTMF_SANITY (rtp_session->one_second * 30)
@@ -112,6 +118,57 @@ static int zrtp_on = 0;
 
 static switch_hash_t *alloc_hash = NULL;
 
+/* packets the io engine read for one session, the io thread only moves head and the reader only moves tail */
+typedef struct rtp_io_packet_s {
+	char buf[RTP_IO_PACKET_LEN];
+	switch_size_t len;
+	switch_sockaddr_t *from;
+} rtp_io_packet_t;
+
+typedef struct rtp_io_ring_s {
+	rtp_io_packet_t packets[RTP_IO_RING_LEN];
+	volatile switch_atomic_t head;
+	volatile switch_atomic_t tail;
+	volatile int waiting;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_socket_t *sock;
+	switch_pollfd_t *pollfd;
+	uint32_t slot;
+} rtp_io_ring_t;
+
+typedef struct rtp_io_thread_s {
+	switch_thread_t *thread;
+	switch_memory_pool_t *pool;
+	switch_pollset_t *pollset;
+	switch_mutex_t *mutex;
+	rtp_io_ring_t *rings[RTP_IO_MAX_SESSIONS];
+	uint32_t ring_count;
+	uint32_t next_slot;
+	rtp_io_packet_t scratch;
+	int running;
+	uint64_t polls;
+	uint64_t recv_calls;
+	uint64_t packets;
+	uint64_t dropped;
+} rtp_io_thread_t;
+
+/* packets of one video frame waiting to go out with a single sendmmsg() */
+typedef struct rtp_tx_batch_s {
+	rtp_io_packet_t packets[RTP_TX_BATCH_LEN];
+	uint32_t count;
+	uint32_t ts;
+	switch_time_t started;
+} rtp_tx_batch_t;
+
+static struct {
+	rtp_io_thread_t *threads[RTP_IO_MAX_THREADS];
+	uint32_t thread_count;
+	uint32_t next;
+	switch_mutex_t *mutex;
+	switch_memory_pool_t *pool;
+} rtp_io;
+
 typedef struct {
 	srtp_hdr_t header;
 	char body[SWITCH_RTP_MAX_BUF_LEN+4+sizeof(char *)];
@@ -424,6 +481,9 @@ struct switch_rtp {
 	switch_payload_t cng_pt;
 	switch_mutex_t *flag_mutex;
 	switch_mutex_t *read_mutex;
+	rtp_io_ring_t *io_ring;
+	rtp_io_thread_t *io_thread;
+	rtp_tx_batch_t *tx_batch;
 	switch_mutex_t *write_mutex;
 	switch_mutex_t *ice_mutex;
 	switch_timer_t timer;
@@ -1467,6 +1527,410 @@ static void zrtp_logger(int level, const char *data, int len, int offset)
 }
 #endif
 
+static void rtp_io_ring_fill(rtp_io_thread_t *io, rtp_io_ring_t *ring)
+{
+	switch_socket_msg_t msgs[RTP_IO_RING_LEN];
+	uint32_t head = switch_atomic_read(&ring->head);
+	uint32_t space = RTP_IO_RING_LEN - (head - switch_atomic_read(&ring->tail));
+	uint32_t i, count = space;
+
+	if (!space) {
+		/* the reader fell behind, drop the packet just like a full socket buffer would */
+		msgs[0].buf = io->scratch.buf;
+		msgs[0].len = sizeof(io->scratch.buf);
+		msgs[0].addr = io->scratch.from;
+		count = 1;
+		io->recv_calls++;
+		if (switch_socket_recvmmsg(ring->sock, msgs, &count) == SWITCH_STATUS_SUCCESS) {
+			io->dropped += count;
+		}
+		return;
+	}
+
+	for (i = 0; i < space; i++) {
+		rtp_io_packet_t *packet = &ring->packets[(head + i) & (RTP_IO_RING_LEN - 1)];
+
+		msgs[i].buf = packet->buf;
+		msgs[i].len = sizeof(packet->buf);
+		msgs[i].addr = packet->from;
+	}
+
+	io->recv_calls++;
+
+	if (switch_socket_recvmmsg(ring->sock, msgs, &count) != SWITCH_STATUS_SUCCESS || !count) {
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		ring->packets[(head + i) & (RTP_IO_RING_LEN - 1)].len = msgs[i].len;
+	}
+
+	io->packets += count;
+	switch_atomic_add(&ring->head, count);
+
+	if (ring->waiting) {
+		switch_mutex_lock(ring->mutex);
+		switch_thread_cond_signal(ring->cond);
+		switch_mutex_unlock(ring->mutex);
+	}
+}
+
+static void *SWITCH_THREAD_FUNC rtp_io_thread(switch_thread_t *thread, void *obj)
+{
+	rtp_io_thread_t *io = (rtp_io_thread_t *) obj;
+	const switch_pollfd_t *fds;
+	int32_t num = 0, i;
+
+	while (io->running) {
+		if (switch_pollset_poll(io->pollset, 100000, &num, &fds) != SWITCH_STATUS_SUCCESS) {
+			continue;
+		}
+
+		io->polls++;
+
+		/* descriptors removed while we were polling can still be reported so only trust the slot table */
+		switch_mutex_lock(io->mutex);
+		for (i = 0; i < num; i++) {
+			uint32_t slot = (uint32_t) (intptr_t) fds[i].client_data;
+			rtp_io_ring_t *ring = slot < RTP_IO_MAX_SESSIONS ? io->rings[slot] : NULL;
+
+			if (ring && ring->sock == fds[i].desc.s) {
+				rtp_io_ring_fill(io, ring);
+			}
+		}
+		switch_mutex_unlock(io->mutex);
+	}
+
+	return NULL;
+}
+
+static rtp_io_thread_t *rtp_io_thread_get(void)
+{
+	rtp_io_thread_t *io = NULL;
+	switch_threadattr_t *thd_attr = NULL;
+	switch_memory_pool_t *pool = NULL;
+	uint32_t x;
+
+	switch_mutex_lock(rtp_io.mutex);
+
+	if (!rtp_io.thread_count) {
+		goto end;
+	}
+
+	x = rtp_io.next++ % rtp_io.thread_count;
+
+	if ((io = rtp_io.threads[x])) {
+		goto end;
+	}
+
+	switch_core_new_memory_pool(&pool);
+	io = switch_core_alloc(pool, sizeof(*io));
+	io->pool = pool;
+
+	if (switch_pollset_create(&io->pollset, RTP_IO_MAX_SESSIONS, pool, SWITCH_POLLSET_THREADSAFE) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot create RTP io pollset, reading RTP from the session threads.\n");
+		switch_core_destroy_memory_pool(&pool);
+		rtp_io.thread_count = 0;
+		io = NULL;
+		goto end;
+	}
+
+	switch_mutex_init(&io->mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_sockaddr_create(&io->scratch.from, pool);
+	io->running = 1;
+
+	switch_threadattr_create(&thd_attr, pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+	switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+	switch_thread_create(&io->thread, thd_attr, rtp_io_thread, io, pool);
+
+	rtp_io.threads[x] = io;
+
+ end:
+
+	switch_mutex_unlock(rtp_io.mutex);
+
+	return io;
+}
+
+/* only timed audio, everything else relies on blocking reads of the socket */
+static int rtp_io_usable(switch_rtp_t *rtp_session)
+{
+	return rtp_session->flags[SWITCH_RTP_FLAG_USE_TIMER] && !rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] &&
+		!rtp_session->flags[SWITCH_RTP_FLAG_TEXT] && !rtp_session->flags[SWITCH_RTP_FLAG_PROXY_MEDIA] &&
+		!rtp_session->flags[SWITCH_RTP_FLAG_UDPTL];
+}
+
+static void rtp_io_attach(switch_rtp_t *rtp_session)
+{
+	rtp_io_thread_t *io;
+	rtp_io_ring_t *ring;
+	uint32_t x, slot;
+
+	if (rtp_session->io_ring || !rtp_io.thread_count || !rtp_io_usable(rtp_session) || !(io = rtp_io_thread_get())) {
+		return;
+	}
+
+	/* the ring lives as long as the session so a reader racing a detach never touches freed memory */
+	ring = switch_core_alloc(rtp_session->pool, sizeof(*ring));
+	switch_mutex_init(&ring->mutex, SWITCH_MUTEX_NESTED, rtp_session->pool);
+	switch_thread_cond_create(&ring->cond, rtp_session->pool);
+	for (x = 0; x < RTP_IO_RING_LEN; x++) {
+		switch_sockaddr_create(&ring->packets[x].from, rtp_session->pool);
+	}
+	ring->sock = rtp_session->sock_input;
+
+	switch_mutex_lock(io->mutex);
+
+	if (io->ring_count == RTP_IO_MAX_SESSIONS) {
+		switch_mutex_unlock(io->mutex);
+		return;
+	}
+
+	for (slot = io->next_slot; io->rings[slot]; slot = (slot + 1) % RTP_IO_MAX_SESSIONS);
+	io->next_slot = (slot + 1) % RTP_IO_MAX_SESSIONS;
+	ring->slot = slot;
+
+	switch_socket_create_pollfd(&ring->pollfd, ring->sock, SWITCH_POLLIN | SWITCH_POLLERR, (void *) (intptr_t) slot, rtp_session->pool);
+
+	if (switch_pollset_add(io->pollset, ring->pollfd) == SWITCH_STATUS_SUCCESS) {
+		io->rings[slot] = ring;
+		io->ring_count++;
+		rtp_session->io_thread = io;
+		rtp_session->io_ring = ring;
+	}
+
+	switch_mutex_unlock(io->mutex);
+}
+
+static void rtp_io_detach(switch_rtp_t *rtp_session)
+{
+	rtp_io_thread_t *io = rtp_session->io_thread;
+	rtp_io_ring_t *ring = rtp_session->io_ring;
+
+	if (!ring) {
+		return;
+	}
+
+	switch_mutex_lock(io->mutex);
+	if (rtp_session->io_ring != ring) {
+		switch_mutex_unlock(io->mutex);
+		return;
+	}
+	switch_pollset_remove(io->pollset, ring->pollfd);
+	io->rings[ring->slot] = NULL;
+	io->ring_count--;
+	rtp_session->io_ring = NULL;
+	rtp_session->io_thread = NULL;
+	switch_mutex_unlock(io->mutex);
+
+	/* wake up a reader waiting for the ring */
+	switch_mutex_lock(ring->mutex);
+	switch_thread_cond_signal(ring->cond);
+	switch_mutex_unlock(ring->mutex);
+}
+
+static rtp_io_ring_t *rtp_io_ring(switch_rtp_t *rtp_session)
+{
+	if (rtp_session->io_ring && !rtp_io_usable(rtp_session)) {
+		/* the session changed mode (t38, proxy media...), go back to reading the socket */
+		rtp_io_detach(rtp_session);
+	}
+
+	return rtp_session->io_ring;
+}
+
+/* switch_poll() on the rtp socket, or on the io engine ring when the session has one */
+static switch_status_t rtp_read_poll(switch_rtp_t *rtp_session, int *fdr, switch_interval_time_t timeout)
+{
+	rtp_io_ring_t *ring;
+	switch_status_t status = SWITCH_STATUS_TIMEOUT;
+
+	if (!(ring = rtp_io_ring(rtp_session))) {
+		return switch_poll(rtp_session->read_pollfd, 1, fdr, timeout);
+	}
+
+	if (switch_atomic_read(&ring->head) != switch_atomic_read(&ring->tail)) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (timeout > 0) {
+		switch_mutex_lock(ring->mutex);
+		ring->waiting = 1;
+		if (switch_atomic_read(&ring->head) == switch_atomic_read(&ring->tail) && rtp_session->io_ring) {
+			switch_thread_cond_timedwait(ring->cond, ring->mutex, timeout);
+		}
+		ring->waiting = 0;
+		switch_mutex_unlock(ring->mutex);
+
+		if (switch_atomic_read(&ring->head) != switch_atomic_read(&ring->tail)) {
+			status = SWITCH_STATUS_SUCCESS;
+		}
+	}
+
+	return status;
+}
+
+/* switch_socket_recvfrom() into recv_msg, from the io engine ring when the session has one */
+static switch_status_t rtp_read_packet(switch_rtp_t *rtp_session, switch_size_t *bytes)
+{
+	rtp_io_ring_t *ring;
+	rtp_io_packet_t *packet;
+	uint32_t tail;
+
+	if (!(ring = rtp_io_ring(rtp_session))) {
+		return switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, bytes);
+	}
+
+	tail = switch_atomic_read(&ring->tail);
+
+	if (switch_atomic_read(&ring->head) == tail) {
+		*bytes = 0;
+		return SWITCH_STATUS_BREAK;
+	}
+
+	packet = &ring->packets[tail & (RTP_IO_RING_LEN - 1)];
+
+	if (*bytes > packet->len) {
+		*bytes = packet->len;
+	}
+
+	memcpy(&rtp_session->recv_msg, packet->buf, *bytes);
+	switch_cp_addr(rtp_session->from_addr, packet->from);
+	switch_atomic_inc(&ring->tail);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t rtp_tx_batch_flush(switch_rtp_t *rtp_session)
+{
+	rtp_tx_batch_t *batch = rtp_session->tx_batch;
+	switch_socket_msg_t msgs[RTP_TX_BATCH_LEN];
+	switch_status_t status;
+	uint32_t i, count;
+
+	if (!batch || !(count = batch->count)) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	for (i = 0; i < count; i++) {
+		msgs[i].buf = batch->packets[i].buf;
+		msgs[i].len = batch->packets[i].len;
+		msgs[i].addr = rtp_session->remote_addr;
+	}
+
+	batch->count = 0;
+
+	if ((status = switch_socket_sendmmsg(rtp_session->sock_output, msgs, &count)) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "%s sent %u of %u batched packets\n",
+						  rtp_session_name(rtp_session), count, i);
+	}
+
+	return status;
+}
+
+/* a frame that never gets its marker must not sit in the batch forever, called from the read side */
+static void rtp_tx_batch_expire(switch_rtp_t *rtp_session)
+{
+	rtp_tx_batch_t *batch = rtp_session->tx_batch;
+
+	if (!batch || !batch->count) {
+		return;
+	}
+
+	if (switch_mutex_trylock(rtp_session->write_mutex) == SWITCH_STATUS_SUCCESS) {
+		if (batch->count && switch_micro_time_now() - batch->started >= RTP_TX_BATCH_MAX_USEC) {
+			rtp_tx_batch_flush(rtp_session);
+		}
+		switch_mutex_unlock(rtp_session->write_mutex);
+	}
+}
+
+/*
+ * switch_socket_sendto() of an rtp packet, video packets are held back while TX_BATCH is set
+ * and go out together once the frame is complete (marker bit or a new timestamp), the batch is full
+ * or it has been waiting longer than RTP_TX_BATCH_MAX_USEC
+ */
+static switch_status_t rtp_send_packet(switch_rtp_t *rtp_session, rtp_msg_t *send_msg, switch_size_t *bytes)
+{
+	rtp_tx_batch_t *batch = rtp_session->tx_batch;
+	rtp_io_packet_t *packet;
+	uint32_t ts = ntohl(send_msg->header.ts);
+
+	if (!rtp_session->flags[SWITCH_RTP_FLAG_TX_BATCH] || !rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] ||
+		*bytes < rtp_header_len || *bytes > RTP_IO_PACKET_LEN) {
+		rtp_tx_batch_flush(rtp_session);
+		return switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, bytes);
+	}
+
+	if (!batch) {
+		batch = rtp_session->tx_batch = switch_core_alloc(rtp_session->pool, sizeof(*batch));
+	}
+
+	if (batch->count && (batch->ts != ts || switch_micro_time_now() - batch->started >= RTP_TX_BATCH_MAX_USEC)) {
+		/* the previous frame never got its marker */
+		rtp_tx_batch_flush(rtp_session);
+	}
+
+	if (!batch->count) {
+		batch->started = switch_micro_time_now();
+	}
+
+	packet = &batch->packets[batch->count++];
+	memcpy(packet->buf, send_msg, *bytes);
+	packet->len = *bytes;
+	batch->ts = ts;
+
+	if (send_msg->header.m || batch->count == RTP_TX_BATCH_LEN) {
+		return rtp_tx_batch_flush(rtp_session);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_rtp_set_io_threads(uint32_t threads)
+{
+	if (threads > RTP_IO_MAX_THREADS) {
+		threads = RTP_IO_MAX_THREADS;
+	}
+
+	if (rtp_io.mutex) {
+		switch_mutex_lock(rtp_io.mutex);
+	}
+	rtp_io.thread_count = threads;
+	if (rtp_io.mutex) {
+		switch_mutex_unlock(rtp_io.mutex);
+	}
+}
+
+SWITCH_DECLARE(void) switch_rtp_get_io_stats(switch_rtp_io_stats_t *stats)
+{
+	uint32_t x;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!rtp_io.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(rtp_io.mutex);
+	for (x = 0; x < RTP_IO_MAX_THREADS; x++) {
+		rtp_io_thread_t *io = rtp_io.threads[x];
+
+		if (!io) {
+			continue;
+		}
+
+		stats->threads++;
+		stats->sessions += io->ring_count;
+		stats->polls += io->polls;
+		stats->recv_calls += io->recv_calls;
+		stats->packets += io->packets;
+		stats->dropped += io->dropped;
+	}
+	switch_mutex_unlock(rtp_io.mutex);
+}
+
 SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 {
 #ifdef ENABLE_ZRTP
@@ -1512,6 +1976,8 @@ SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 	srtp_init();
 #endif
 	switch_mutex_init(&port_lock, SWITCH_MUTEX_NESTED, pool);
+	switch_mutex_init(&rtp_io.mutex, SWITCH_MUTEX_NESTED, pool);
+	rtp_io.pool = pool;
 	global_init = 1;
 }
 
@@ -2429,6 +2895,7 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 	switch_hash_index_t *hi;
 	const void *var;
 	void *val;
+	uint32_t x;
 
 	if (!global_init) {
 		return;
@@ -2447,6 +2914,21 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 	switch_core_hash_destroy(&alloc_hash);
 	switch_mutex_unlock(port_lock);
 
+	switch_mutex_lock(rtp_io.mutex);
+	rtp_io.thread_count = 0;
+	for (x = 0; x < RTP_IO_MAX_THREADS; x++) {
+		rtp_io_thread_t *io;
+		switch_status_t st;
+
+		if ((io = rtp_io.threads[x])) {
+			rtp_io.threads[x] = NULL;
+			io->running = 0;
+			switch_thread_join(&st, io->thread);
+			switch_core_destroy_memory_pool(&io->pool);
+		}
+	}
+	switch_mutex_unlock(rtp_io.mutex);
+
 #ifdef ENABLE_ZRTP
 	if (zrtp_on) {
 		zrtp_status_t status = zrtp_status_ok;
@@ -2797,6 +3279,7 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_local_address(switch_rtp_t *rtp_s
 	}
 
 	switch_socket_create_pollset(&rtp_session->read_pollfd, rtp_session->sock_input, SWITCH_POLLIN | SWITCH_POLLERR, rtp_session->pool);
+	rtp_io_attach(rtp_session);
 
 	if (rtp_session->flags[SWITCH_RTP_FLAG_ENABLE_RTCP]) {
 		if ((status = enable_local_rtcp_socket(rtp_session, err)) == SWITCH_STATUS_SUCCESS) {
@@ -2934,6 +3417,8 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_udptl_mode(switch_rtp_t *rtp_session)
 	READ_INC(rtp_session);
 	WRITE_INC(rtp_session);
 
+	rtp_io_detach(rtp_session);
+
 	if (rtp_session->flags[SWITCH_RTP_FLAG_USE_TIMER] || rtp_session->timer.timer_interface) {
 		switch_core_timer_destroy(&rtp_session->timer);
 		memset(&rtp_session->timer, 0, sizeof(rtp_session->timer));
@@ -4596,6 +5081,10 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_video_buffer_size(switch_rtp_t *r
 
 	if (!rtp_session->vb) {
 		switch_jb_create(&rtp_session->vb, rtp_session->flags[SWITCH_RTP_FLAG_TEXT] ? SJB_TEXT : SJB_VIDEO, frames, max_frames, rtp_session->pool);
+		if (!rtp_session->flags[SWITCH_RTP_FLAG_TEXT] && rtp_session->session &&
+			switch_true(switch_channel_get_variable(switch_core_session_get_channel(rtp_session->session), "jb_video_ring"))) {
+			switch_jb_set_flag(rtp_session->vb, SJB_RING);
+		}
 		switch_jb_set_session(rtp_session->vb, rtp_session->session);
 	} else {
 		switch_jb_set_frames(rtp_session->vb, frames, max_frames);
@@ -4915,6 +5404,12 @@ SWITCH_DECLARE(void) switch_rtp_kill_socket(switch_rtp_t *rtp_session)
 	switch_mutex_lock(rtp_session->flag_mutex);
 	if (rtp_session->flags[SWITCH_RTP_FLAG_IO]) {
 		rtp_session->flags[SWITCH_RTP_FLAG_IO] = 0;
+		rtp_io_detach(rtp_session);
+		/* a writer may be waiting on flag_mutex with write_mutex held, don't block on it */
+		if (rtp_session->tx_batch && switch_mutex_trylock(rtp_session->write_mutex) == SWITCH_STATUS_SUCCESS) {
+			rtp_tx_batch_flush(rtp_session);
+			switch_mutex_unlock(rtp_session->write_mutex);
+		}
 		if (rtp_session->sock_input) {
 			ping_socket(rtp_session);
 			switch_socket_shutdown(rtp_session->sock_input, SWITCH_SHUTDOWN_READWRITE);
@@ -4992,6 +5487,7 @@ SWITCH_DECLARE(void) switch_rtp_destroy(switch_rtp_t **rtp_session)
 	READ_INC((*rtp_session));
 	WRITE_INC((*rtp_session));
 
+	rtp_tx_batch_flush(*rtp_session);
 	(*rtp_session)->ready = 0;
 
 	WRITE_DEC((*rtp_session));
@@ -5038,6 +5534,8 @@ SWITCH_DECLARE(void) switch_rtp_destroy(switch_rtp_t **rtp_session)
 	}
 
 
+	rtp_io_detach(*rtp_session);
+
 	sock = (*rtp_session)->sock_input;
 	(*rtp_session)->sock_input = NULL;
 	switch_socket_close(sock);
@@ -5543,7 +6041,7 @@ static switch_size_t do_flush(switch_rtp_t *rtp_session, int force, switch_size_
 		do {
 			if (switch_rtp_ready(rtp_session)) {
 				bytes = sizeof(rtp_msg_t);
-				switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, &bytes);
+				rtp_read_packet(rtp_session, &bytes);
 
 				if (bytes) {
 					int do_cng = 0;
@@ -5682,7 +6180,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 			}
 		}
 
-		poll_status = switch_poll(rtp_session->read_pollfd, 1, &fdr, to);
+		poll_status = rtp_read_poll(rtp_session, &fdr, to);
 
 		if (rtp_session->flags[SWITCH_RTP_FLAG_USE_TIMER] && rtp_session->timer.interval) {
 			switch_core_timer_sync(&rtp_session->timer);
@@ -5708,7 +6206,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 	memset(&rtp_session->last_rtp_hdr, 0, sizeof(rtp_session->last_rtp_hdr));
 
 	if (poll_status == SWITCH_STATUS_SUCCESS) {
-		status = switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, bytes);
+		status = rtp_read_packet(rtp_session, bytes);
 	} else {
 		*bytes = 0;
 	}
@@ -7023,6 +7521,8 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 		return -1;
 	}
 
+	rtp_tx_batch_expire(rtp_session);
+
 	if (rtp_session->session) {
 		channel = switch_core_session_get_channel(rtp_session->session);
 	}
@@ -7050,7 +7550,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 			rtp_session->read_pollfd) {
 
 			if (rtp_session->jb && !rtp_session->pause_jb && jb_valid(rtp_session)) {
-				while (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+				while (rtp_read_poll(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 					status = read_rtp_packet(rtp_session, &bytes, flags, pmapP, SWITCH_STATUS_SUCCESS, SWITCH_FALSE);
 
 					if (status == SWITCH_STATUS_GENERR) {
@@ -7073,7 +7573,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 
 			} else if ((rtp_session->flags[SWITCH_RTP_FLAG_AUTOFLUSH] || rtp_session->flags[SWITCH_RTP_FLAG_STICKY_FLUSH])) {
 
-				if (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+				if (rtp_read_poll(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 					status = read_rtp_packet(rtp_session, &bytes, flags, pmapP, SWITCH_STATUS_SUCCESS, SWITCH_FALSE);
 					if (status == SWITCH_STATUS_GENERR) {
 						ret = -1;
@@ -7092,7 +7592,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 					}
 
 					if (bytes) {
-						if (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+						if (rtp_read_poll(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 							rtp_session->hot_hits++;//+= rtp_session->samples_per_interval;
 
 							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG10, "%s Hot Hit %d\n",
@@ -7202,7 +7702,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 				pt = 0;
 			}
 
-			poll_status = switch_poll(rtp_session->read_pollfd, 1, &fdr, pt);
+			poll_status = rtp_read_poll(rtp_session, &fdr, pt);
 
 			if (!rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] && rtp_session->dtmf_data.out_digit_dur > 0) {
 				return_cng_frame();
@@ -8505,6 +9005,9 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 
 				if (rtp_session->vbw) {
 					switch_jb_set_flag(rtp_session->vbw, SJB_QUEUE_ONLY);
+					if (switch_true(switch_channel_get_variable(channel, "jb_video_ring"))) {
+						switch_jb_set_flag(rtp_session->vbw, SJB_RING);
+					}
 					//switch_jb_debug_level(rtp_session->vbw, 10);
 				}
 			}
@@ -8519,7 +9022,7 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ALERT,
 								  "Simulate dropping packet ......... ts: %u seq: %u\n", ntohl(send_msg->header.ts), ntohs(send_msg->header.seq));
 			} else {
-				if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
+				if (rtp_send_packet(rtp_session, send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
 					rtp_session->seq--;
 					ret = -1;
 					goto end;
@@ -8533,7 +9036,7 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 		//
 		//	//switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "SEND %u\n", ntohs(send_msg->header.seq));
 		//}
-		if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
+		if (rtp_send_packet(rtp_session, send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
 			rtp_session->seq -= delta;
 
 			ret = -1;
@@ -9040,7 +9543,7 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_write_raw(switch_rtp_t *rtp_session,
 #endif
 	}
 
-	status = switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, data, bytes);
+	status = rtp_send_packet(rtp_session, (rtp_msg_t *) data, bytes);
 #if defined(ENABLE_SRTP) || defined(ENABLE_ZRTP)
  end:
 #endif
@@ -87,6 +87,8 @@ static int COND = 1;
 
 static int MATRIX = 1;
 
+static int WHEEL = 0;
+
 #ifdef WIN32
 static CRITICAL_SECTION timer_section;
 static switch_time_t win32_tick_time_since_start = -1;
@@ -362,6 +364,11 @@ SWITCH_DECLARE(void) switch_time_set_matrix(switch_bool_t enable)
 	switch_time_sync();
 }
 
+SWITCH_DECLARE(void) switch_time_set_wheel(switch_bool_t enable)
+{
+	WHEEL = enable ? 1 : 0;
+}
+
 SWITCH_DECLARE(void) switch_time_set_nanosleep(switch_bool_t enable)
 {
 #if defined(HAVE_CLOCK_NANOSLEEP)
@@ -684,6 +691,420 @@ SWITCH_DECLARE(void) switch_cond_yield(switch_interval_time_t t)
 
 }
 
+static void timer_check_resolution(switch_timer_t *timer)
+{
+	if (runtime.microseconds_per_tick > 10000  && (timer->interval % (int)(runtime.microseconds_per_tick / 1000)) != 0 && (timer->interval % 10) == 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Increasing global timer resolution to 10ms to handle interval %d\n", timer->interval);
+		runtime.microseconds_per_tick = 10000;
+	}
+
+	if (timer->interval > 0 && (timer->interval < (int)(runtime.microseconds_per_tick / 1000) || (timer->interval % 10) != 0)) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Increasing global timer resolution to 1ms to handle interval %d\n", timer->interval);
+		runtime.microseconds_per_tick = 1000;
+		switch_time_sync();
+	}
+}
+
+/* Timing wheel.
+ *
+ * The soft timer parks every timer of an interval on one condition and broadcasts it each tick, so one tick wakes
+ * every session thread on that interval at once.  The wheel timer instead hangs a waiting timer in the slot of the
+ * millisecond it is due and the runtime thread signals exactly the timers whose slot comes up.  Timers are spread
+ * over one wheel per cpu, each with its own lock, so threads going back to sleep do not all contend on one mutex.
+ *
+ * The inner level has a slot per ms for the next WHEEL_SIZE ms, the outer level a slot per WHEEL_SIZE ms that is
+ * cascaded into the inner one as the clock reaches it, enough for any interval up to MAX_ELEMENTS.
+ */
+
+#define WHEEL_BITS 8
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_OUTER_SIZE 64
+#define WHEEL_OUTER_MASK (WHEEL_OUTER_SIZE - 1)
+#define WHEEL_INNER_SLOT(_ms) ((_ms) & WHEEL_MASK)
+#define WHEEL_OUTER_SLOT(_ms) (WHEEL_SIZE + (((_ms) >> WHEEL_BITS) & WHEEL_OUTER_MASK))
+#define MAX_WHEELS 64
+
+struct wheel;
+
+struct wheel_timer {
+	/* wheel ms the first tick was counted from */
+	uint64_t origin;
+	switch_size_t reference;
+	switch_size_t start;
+	/* wheel ms the pending wait ends at */
+	uint64_t due;
+	uint32_t ready;
+	uint32_t queued;
+	uint32_t fired;
+	switch_thread_cond_t *cond;
+	struct wheel *wheel;
+	struct wheel_timer *prev;
+	struct wheel_timer *next;
+};
+typedef struct wheel_timer wheel_timer_t;
+
+struct wheel {
+	switch_mutex_t *mutex;
+	/* ms this wheel has been run up to */
+	uint64_t now;
+	uint32_t count;
+	/* WHEEL_SIZE inner slots followed by the outer ones */
+	wheel_timer_t *slots[WHEEL_SIZE + WHEEL_OUTER_SIZE];
+};
+typedef struct wheel wheel_t;
+
+static struct {
+	wheel_t wheels[MAX_WHEELS];
+	uint32_t count;
+	uint32_t next;
+	uint64_t now;
+} WHEELS;
+
+static switch_status_t timer_init(switch_timer_t *timer);
+static switch_status_t timer_step(switch_timer_t *timer);
+static switch_status_t timer_sync(switch_timer_t *timer);
+static switch_status_t timer_next(switch_timer_t *timer);
+static switch_status_t timer_check(switch_timer_t *timer, switch_bool_t step);
+static switch_status_t timer_destroy(switch_timer_t *timer);
+
+static void wheels_init(void)
+{
+	uint32_t x;
+
+	WHEELS.count = switch_core_cpu_count();
+
+	if (WHEELS.count < 1) {
+		WHEELS.count = 1;
+	} else if (WHEELS.count > MAX_WHEELS) {
+		WHEELS.count = MAX_WHEELS;
+	}
+
+	for (x = 0; x < WHEELS.count; x++) {
+		switch_mutex_init(&WHEELS.wheels[x].mutex, SWITCH_MUTEX_NESTED, module_pool);
+	}
+}
+
+static void wheel_unlink(wheel_t *wheel, wheel_timer_t *wt)
+{
+	if (!wt->queued) {
+		return;
+	}
+
+	if (wt->prev) {
+		wt->prev->next = wt->next;
+	} else {
+		wheel->slots[wt->queued - 1] = wt->next;
+	}
+
+	if (wt->next) {
+		wt->next->prev = wt->prev;
+	}
+
+	wt->prev = wt->next = NULL;
+	wt->queued = 0;
+}
+
+static void wheel_fire(wheel_timer_t *wt)
+{
+	wt->queued = 0;
+	wt->fired = 1;
+	switch_thread_cond_signal(wt->cond);
+}
+
+/* call with the wheel locked, a timer that is already due fires right away */
+static void wheel_queue(wheel_t *wheel, wheel_timer_t *wt)
+{
+	uint64_t delta;
+	uint32_t slot;
+
+	if (wt->due <= wheel->now) {
+		wheel_fire(wt);
+		return;
+	}
+
+	delta = wt->due - wheel->now;
+
+	if (delta < WHEEL_SIZE) {
+		slot = WHEEL_INNER_SLOT(wt->due);
+	} else if (delta < (uint64_t) WHEEL_SIZE * WHEEL_OUTER_SIZE) {
+		slot = WHEEL_OUTER_SLOT(wt->due);
+	} else {
+		/* farther than the outer level reaches, park it in the last slot and look again when that one cascades */
+		slot = WHEEL_OUTER_SLOT(wheel->now + (uint64_t) WHEEL_SIZE * (WHEEL_OUTER_SIZE - 1));
+	}
+
+	wt->prev = NULL;
+	if ((wt->next = wheel->slots[slot])) {
+		wt->next->prev = wt;
+	}
+	wheel->slots[slot] = wt;
+	wt->queued = slot + 1;
+}
+
+/* run one wheel up to the ms given, signalling the timers due on the way */
+static void wheel_run(wheel_t *wheel, uint64_t to)
+{
+	switch_mutex_lock(wheel->mutex);
+
+	if (!wheel->count) {
+		wheel->now = to;
+	}
+
+	while (wheel->now < to) {
+		wheel_timer_t *wt, *next;
+
+		wheel->now++;
+
+		if (!(wheel->now & WHEEL_MASK)) {
+			wt = wheel->slots[WHEEL_OUTER_SLOT(wheel->now)];
+			wheel->slots[WHEEL_OUTER_SLOT(wheel->now)] = NULL;
+
+			for (; wt; wt = next) {
+				next = wt->next;
+				wt->prev = wt->next = NULL;
+				wheel_queue(wheel, wt);
+			}
+		}
+
+		wt = wheel->slots[WHEEL_INNER_SLOT(wheel->now)];
+		wheel->slots[WHEEL_INNER_SLOT(wheel->now)] = NULL;
+
+		for (; wt; wt = next) {
+			next = wt->next;
+			wt->prev = wt->next = NULL;
+			wheel_fire(wt);
+		}
+	}
+
+	switch_mutex_unlock(wheel->mutex);
+}
+
+/* wake everything still waiting, the runtime is going away */
+static void wheel_flush(wheel_t *wheel)
+{
+	wheel_timer_t *wt, *next;
+	int x;
+
+	switch_mutex_lock(wheel->mutex);
+
+	for (x = 0; x < WHEEL_SIZE + WHEEL_OUTER_SIZE; x++) {
+		wt = wheel->slots[x];
+		wheel->slots[x] = NULL;
+
+		for (; wt; wt = next) {
+			next = wt->next;
+			wt->prev = wt->next = NULL;
+			wheel_fire(wt);
+		}
+	}
+
+	switch_mutex_unlock(wheel->mutex);
+}
+
+static void wheels_advance(uint32_t ms)
+{
+	uint32_t x;
+
+	WHEELS.now += ms;
+
+	for (x = 0; x < WHEELS.count; x++) {
+		wheel_run(&WHEELS.wheels[x], WHEELS.now);
+	}
+}
+
+static switch_size_t wheel_tick(switch_timer_t *timer, wheel_timer_t *wt)
+{
+	return (switch_size_t) ((wt->wheel->now - wt->origin) / timer->interval);
+}
+
+static switch_status_t wheel_timer_init(switch_timer_t *timer)
+{
+	wheel_timer_t *wt;
+	wheel_t *wheel;
+	int sanity = 0;
+
+	if (timer->interval == 1) {
+		return timer_init(timer);
+	}
+
+	while (globals.STARTED == 0) {
+		do_sleep(100000);
+		if (++sanity == 300) {
+			abort();
+		}
+	}
+
+	if (globals.RUNNING != 1 || !globals.mutex || timer->interval < 1 || timer->interval > MAX_ELEMENTS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!(wt = switch_core_alloc(timer->memory_pool, sizeof(*wt)))) {
+		return SWITCH_STATUS_MEMERR;
+	}
+
+	switch_thread_cond_create(&wt->cond, timer->memory_pool);
+
+	switch_mutex_lock(globals.mutex);
+	wheel = &WHEELS.wheels[WHEELS.next++ % WHEELS.count];
+	globals.timer_count++;
+	switch_mutex_unlock(globals.mutex);
+
+	switch_mutex_lock(wheel->mutex);
+	wheel->count++;
+	wt->wheel = wheel;
+	/* timers on the same interval share their phase like they do on the matrix, and so their slots */
+	wt->origin = wheel->now - (wheel->now % timer->interval);
+	wt->start = wt->reference = wheel_tick(timer, wt);
+	wt->start -= 2; /* same as the soft timer, the first next() steps once */
+	wt->ready = 1;
+	switch_mutex_unlock(wheel->mutex);
+
+	timer_check_resolution(timer);
+
+	timer->private_info = wt;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t wheel_timer_step(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+	uint64_t samples;
+
+	if (timer->interval == 1) {
+		return timer_step(timer);
+	}
+
+	if (globals.RUNNING != 1 || !wt->ready) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	samples = (uint64_t) timer->samples * (wt->reference - wt->start);
+
+	if (samples > UINT32_MAX) {
+		wt->start = wt->reference - 1; /* Must have a diff */
+		samples = timer->samples;
+	}
+
+	timer->samplecount = (uint32_t) samples;
+	wt->reference++;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t wheel_timer_sync(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+
+	if (timer->interval == 1) {
+		return timer_sync(timer);
+	}
+
+	if (globals.RUNNING != 1 || !wt->ready) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	wt->reference = timer->tick = wheel_tick(timer, wt);
+	wheel_timer_step(timer);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t wheel_timer_next(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+	wheel_t *wheel;
+
+	if (timer->interval == 1) {
+		return timer_next(timer);
+	}
+
+	wheel = wt->wheel;
+
+	/* sync up timer if it's not been called for a while otherwise it will return instantly several times until it catches up */
+	if ((int64_t) (wt->reference - wheel_tick(timer, wt)) < -1) {
+		wt->reference = timer->tick = wheel_tick(timer, wt);
+	}
+	wheel_timer_step(timer);
+
+	switch_mutex_lock(wheel->mutex);
+
+	if (globals.RUNNING == 1 && wt->ready) {
+		wt->due = wt->origin + (uint64_t) wt->reference * timer->interval;
+		wt->fired = 0;
+		wheel_queue(wheel, wt);
+
+		while (globals.RUNNING == 1 && wt->ready && !wt->fired) {
+			switch_thread_cond_wait(wt->cond, wheel->mutex);
+		}
+
+		wheel_unlink(wheel, wt);
+	}
+
+	switch_mutex_unlock(wheel->mutex);
+
+	return globals.RUNNING == 1 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+static switch_status_t wheel_timer_check(switch_timer_t *timer, switch_bool_t step)
+{
+	wheel_timer_t *wt = timer->private_info;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (timer->interval == 1) {
+		return timer_check(timer, step);
+	}
+
+	if (globals.RUNNING != 1 || !wt->ready) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	timer->tick = wheel_tick(timer, wt);
+
+	if (timer->tick < wt->reference) {
+		timer->diff = (switch_size_t) (wt->reference - timer->tick);
+	} else {
+		timer->diff = 0;
+	}
+
+	if (timer->diff) {
+		status = SWITCH_STATUS_FALSE;
+	} else if (step) {
+		wheel_timer_step(timer);
+	}
+
+	return status;
+}
+
+static switch_status_t wheel_timer_destroy(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+
+	if (timer->interval == 1) {
+		return timer_destroy(timer);
+	}
+
+	if (wt) {
+		wheel_t *wheel = wt->wheel;
+
+		switch_mutex_lock(wheel->mutex);
+		wheel_unlink(wheel, wt);
+		wt->ready = 0;
+		switch_thread_cond_signal(wt->cond);
+		wheel->count--;
+		switch_mutex_unlock(wheel->mutex);
+	}
+
+	switch_mutex_lock(globals.mutex);
+	if (globals.timer_count) {
+		globals.timer_count--;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 static switch_status_t timer_init(switch_timer_t *timer)
 {
 	timer_private_t *private_info;
@@ -699,6 +1120,10 @@ static switch_status_t timer_init(switch_timer_t *timer)
 		return SWITCH_STATUS_SUCCESS;
 	}
 
+	if (WHEEL) {
+		return wheel_timer_init(timer);
+	}
+
 #ifdef HAVE_TIMERFD_CREATE
 	if (TFD == 2) {
 		return _timerfd_init(timer);
@@ -730,16 +1155,7 @@ static switch_status_t timer_init(switch_timer_t *timer)
 		private_info->roll = TIMER_MATRIX[timer->interval].roll;
 		private_info->ready = 1;
 
-		if (runtime.microseconds_per_tick > 10000  && (timer->interval % (int)(runtime.microseconds_per_tick / 1000)) != 0 && (timer->interval % 10) == 0) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Increasing global timer resolution to 10ms to handle interval %d\n", timer->interval);
-			runtime.microseconds_per_tick = 10000;
-		}
-
-		if (timer->interval > 0 && (timer->interval < (int)(runtime.microseconds_per_tick / 1000) || (timer->interval % 10) != 0)) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Increasing global timer resolution to 1ms to handle interval %d\n", timer->interval);
-			runtime.microseconds_per_tick = 1000;
-			switch_time_sync();
-		}
+		timer_check_resolution(timer);
 
 		switch_mutex_lock(globals.mutex);
 		globals.timer_count++;
@@ -770,6 +1186,10 @@ static switch_status_t timer_step(switch_timer_t *timer)
 		return SWITCH_STATUS_FALSE;
 	}
 
+	if (WHEEL) {
+		return wheel_timer_step(timer);
+	}
+
 #ifdef HAVE_TIMERFD_CREATE
 	if (TFD == 2) {
 		return _timerfd_step(timer);
@@ -804,6 +1224,10 @@ static switch_status_t timer_sync(switch_timer_t *timer)
 		return timer_generic_sync(timer);
 	}
 
+	if (WHEEL) {
+		return wheel_timer_sync(timer);
+	}
+
 #ifdef HAVE_TIMERFD_CREATE
 	if (TFD == 2) {
 		return timer_generic_sync(timer);
@@ -841,6 +1265,10 @@ static switch_status_t timer_next(switch_timer_t *timer)
 		return SWITCH_STATUS_FALSE;
 	}
 
+	if (WHEEL) {
+		return wheel_timer_next(timer);
+	}
+
 #ifdef HAVE_TIMERFD_CREATE
 	if (TFD == 2) {
 		return _timerfd_next(timer);
@@ -898,6 +1326,10 @@ static switch_status_t timer_check(switch_timer_t *timer, switch_bool_t step)
 		return SWITCH_STATUS_FALSE;
 	}
 
+	if (WHEEL) {
+		return wheel_timer_check(timer, step);
+	}
+
 #ifdef HAVE_TIMERFD_CREATE
 	if (TFD == 2) {
 		return _timerfd_check(timer, step);
@@ -943,6 +1375,10 @@ static switch_status_t timer_destroy(switch_timer_t *timer)
 		return SWITCH_STATUS_SUCCESS;
 	}
 
+	if (WHEEL) {
+		return wheel_timer_destroy(timer);
+	}
+
 #ifdef HAVE_TIMERFD_CREATE
 	if (TFD == 2) {
 		return _timerfd_destroy(timer);
@@ -1292,6 +1728,8 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 			}
 		}
 
+		wheels_advance(runtime.microseconds_per_tick / 1000);
+
 		if (current_ms == MAX_ELEMENTS) {
 			current_ms = 0;
 		}
@@ -1299,6 +1737,10 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 
 	globals.use_cond_yield = 0;
 
+	for (x = 0; x < WHEELS.count; x++) {
+		wheel_flush(&WHEELS.wheels[x]);
+	}
+
 	for (x = (runtime.microseconds_per_tick / 1000); x <= MAX_ELEMENTS; x += (runtime.microseconds_per_tick / 1000)) {
 		if (TIMER_MATRIX[x].mutex && switch_mutex_trylock(TIMER_MATRIX[x].mutex) == SWITCH_STATUS_SUCCESS) {
 			switch_thread_cond_broadcast(TIMER_MATRIX[x].cond);
@@ -1532,6 +1974,16 @@ SWITCH_MODULE_LOAD_FUNCTION(softtimer_load)
 	timer_interface->timer_check = timer_check;
 	timer_interface->timer_destroy = timer_destroy;
 
+	wheels_init();
+	timer_interface = switch_loadable_module_create_interface(*module_interface, SWITCH_TIMER_INTERFACE);
+	timer_interface->interface_name = "wheel";
+	timer_interface->timer_init = wheel_timer_init;
+	timer_interface->timer_next = wheel_timer_next;
+	timer_interface->timer_step = wheel_timer_step;
+	timer_interface->timer_sync = wheel_timer_sync;
+	timer_interface->timer_check = wheel_timer_check;
+	timer_interface->timer_destroy = wheel_timer_destroy;
+
 	if (!switch_test_flag((&runtime), SCF_USE_CLOCK_RT)) {
 		switch_time_set_nanosleep(SWITCH_FALSE);
 	}
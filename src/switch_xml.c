@@ -176,20 +176,53 @@ struct switch_xml_root {		/* additional data for the root tag */
 	char ***pi;					/* processing instructions */
 	short standalone;			/* non-zero if <?xml standalone="yes"?> */
 	char err[SWITCH_XML_ERRL];	/* error string */
+	switch_hash_t *user_index;	/* user indexes of the tags users were looked up under, while the tree is shared */
+	switch_memory_pool_t *user_index_pool;
+	uint8_t user_indexed;		/* the registry or a cached gateway answer, the trees users are looked up in more than once */
 };
 
 char *SWITCH_XML_NIL[] = { NULL };	/* empty, null terminated array of strings */
 
 struct switch_xml_binding {
 	switch_xml_search_function_t function;
+	switch_xml_async_search_function_t async_function;
 	switch_xml_section_t sections;
+	switch_xml_section_t coalesce_sections;
 	void *user_data;
 	struct switch_xml_binding *next;
 };
 
+/* a lookup started with switch_xml_locate_async(), waiting on the gateways */
+typedef struct xml_locate_request_s {
+	switch_memory_pool_t *pool;
+	char *section;
+	char *tag_name;
+	char *key_name;
+	char *key_value;
+	switch_event_t *params;
+	switch_xml_locate_callback_t callback;
+	void *user_data;
+	int not_found_ms;			/* how long the last "not found" from the gateways may be cached */
+	struct xml_locate_request_s *next;
+} xml_locate_request_t;
+
+/* one fetch handed to an asynchronous gateway, shared by every identical lookup made while it is in flight */
+typedef struct xml_fetch_s {
+	switch_memory_pool_t *pool;
+	char *key;
+	switch_xml_binding_t *binding;
+	switch_thread_cond_t *cond;
+	switch_xml_t xml;
+	int not_found_ms;
+	uint32_t waiting;
+	int done;
+	xml_locate_request_t *requests;
+} xml_fetch_t;
+
 
 static switch_xml_binding_t *BINDINGS = NULL;
 static switch_xml_t MAIN_XML_ROOT = NULL;
+static switch_xml_t PREPROCESSED_ROOT = NULL;	/* MAIN_XML_ROOT, while it is the tree parsed from the last preprocessed root file */
 static switch_memory_pool_t *XML_MEMORY_POOL = NULL;
 
 static switch_thread_rwlock_t *B_RWLOCK = NULL;
@@ -197,6 +230,7 @@ static switch_mutex_t *XML_LOCK = NULL;
 static switch_mutex_t *CACHE_MUTEX = NULL;
 static switch_mutex_t *REFLOCK = NULL;
 static switch_mutex_t *FILE_LOCK = NULL;
+static switch_thread_rwlock_t *USER_INDEX_RWLOCK = NULL;
 
 SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const char **err, void *user_data);
 
@@ -206,6 +240,46 @@ static void *XML_OPEN_ROOT_FUNCTION_USER_DATA = NULL;
 static switch_hash_t *CACHE_HASH = NULL;
 static switch_hash_t *CACHE_EXPIRES_HASH = NULL;
 
+#define XML_CACHE_SECTION_OTHER 7
+
+static const char *XML_CACHE_SECTIONS[] = { "configuration", "directory", "dialplan", "phrases", "languages", "chatplan", "channels", "other" };
+
+/* a gateway answer kept for the lookups that follow, xml is NULL when none of them had one */
+typedef struct xml_cache_entry_s {
+	char *key;
+	switch_xml_t xml;
+	uint32_t section;
+	switch_time_t expires;
+	switch_time_t stale_until;
+	int refreshing;
+	int dropped;
+	char *section_name;
+	char *tag_name;
+	char *key_name;
+	char *key_value;
+	switch_event_t *params;
+	struct xml_cache_entry_s *prev;
+	struct xml_cache_entry_s *next;
+} xml_cache_entry_t;
+
+static struct {
+	switch_hash_t *hash;
+	xml_cache_entry_t *head;
+	xml_cache_entry_t *tail;
+	uint32_t entries;
+	uint32_t max;
+	uint32_t negative_ttl;
+	switch_xml_cache_stats_t stats[XML_CACHE_SECTION_OTHER + 1];
+} XML_CACHE = { 0 };
+
+static void xml_cache_entry_free(xml_cache_entry_t *entry);
+static void xml_cache_result(const char *key, const char *section, const char *tag_name, const char *key_name, const char *key_value,
+							 switch_event_t *params, switch_xml_t xml, int not_found_ms);
+
+static switch_mutex_t *FETCH_MUTEX = NULL;
+static switch_hash_t *FETCH_HASH = NULL;
+static switch_xml_fetch_stats_t FETCH_STATS = { 0 };
+
 struct xml_section_t {
 	const char *name;
 	/* switch_xml_section_t section; */
@@ -317,6 +391,18 @@ SWITCH_DECLARE(void *) switch_xml_get_binding_user_data(switch_xml_binding_t *bi
 	return binding->user_data;
 }
 
+SWITCH_DECLARE(void) switch_xml_set_binding_async_function(switch_xml_binding_t *binding, switch_xml_async_search_function_t function)
+{
+	switch_assert(binding);
+	binding->async_function = function;
+}
+
+SWITCH_DECLARE(void) switch_xml_set_binding_coalesce_sections(switch_xml_binding_t *binding, switch_xml_section_t sections)
+{
+	switch_assert(binding);
+	binding->coalesce_sections = sections;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_xml_bind_search_function_ret(switch_xml_search_function_t function,
 																	switch_xml_section_t sections, void *user_data, switch_xml_binding_t **ret_binding)
 {
@@ -1199,7 +1285,256 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_fd(int fd)
 	return &root->xml;
 }
 
-static char *expand_vars(char *buf, char *ebuf, switch_size_t elen, switch_size_t *newlen, const char **err)
+/* a file that went into the preprocessed root file, so the next reload can tell what changed and copy what did not */
+typedef struct xml_pp_file_s {
+	char *path;
+	switch_time_t mtime;		/* in ns, as fine as the filesystem keeps it */
+	switch_size_t size;
+	uint32_t hash;				/* of the contents, for edits that keep the size within the mtime resolution */
+	switch_event_t *vars;		/* the $${vars} its lines used, with the values they had */
+	uint8_t leaf;				/* no pre-processor commands, so its output is one run of the preprocessed file */
+	long offset;
+	long length;
+	struct xml_pp_file_s *next;
+} xml_pp_file_t;
+
+typedef struct {
+	char *output;				/* the preprocessed file it went into */
+	xml_pp_file_t *head;
+	xml_pp_file_t *tail;
+	switch_hash_t *index;
+	uint32_t files;
+	uint32_t reused;
+} xml_pp_run_t;
+
+/* all under FILE_LOCK */
+static struct {
+	xml_pp_run_t last;			/* what the preprocessed root file is made of */
+	xml_pp_run_t run;			/* the one being preprocessed */
+	xml_pp_file_t *cursor;		/* where the run is in the last one, while they have been the same */
+	FILE *last_fd;				/* the last preprocessed root file, to copy from */
+	uint8_t active;
+	uint8_t changed;
+	switch_xml_reload_stats_t stats;
+} XML_PP;
+
+static void xml_pp_run_clear(xml_pp_run_t *run)
+{
+	xml_pp_file_t *file;
+
+	while ((file = run->head)) {
+		run->head = file->next;
+		if (file->vars) {
+			switch_event_destroy(&file->vars);
+		}
+		free(file->path);
+		free(file);
+	}
+
+	if (run->index) {
+		switch_core_hash_destroy(&run->index);
+	}
+
+	switch_safe_free(run->output);
+	memset(run, 0, sizeof(*run));
+}
+
+/* start recording a run, copying from the last preprocessed root file where nothing changed */
+static void xml_pp_begin(const char *output)
+{
+	if (XML_PP.last.output && strcmp(XML_PP.last.output, output)) {
+		xml_pp_run_clear(&XML_PP.last);		/* another root file */
+	}
+
+	xml_pp_run_clear(&XML_PP.run);
+	XML_PP.run.output = switch_must_strdup(output);
+	XML_PP.cursor = XML_PP.last.head;
+	XML_PP.changed = !XML_PP.last.head;
+	XML_PP.last_fd = XML_PP.last.head ? fopen(output, "r") : NULL;
+	XML_PP.active = 1;
+}
+
+static void xml_pp_end(void)
+{
+	if (XML_PP.cursor) {
+		XML_PP.changed = 1;		/* files that are gone */
+	}
+
+	if (XML_PP.last_fd) {
+		fclose(XML_PP.last_fd);
+		XML_PP.last_fd = NULL;
+	}
+
+	XML_PP.cursor = NULL;
+	XML_PP.active = 0;
+}
+
+static switch_bool_t xml_pp_vars_current(switch_event_t *vars)
+{
+	switch_event_header_t *hp;
+	switch_bool_t same = SWITCH_TRUE;
+
+	for (hp = vars ? vars->headers : NULL; hp && same; hp = hp->next) {
+		char *val = switch_core_get_variable_dup(hp->name);
+
+		same = !strcmp(switch_str_nil(val), hp->value);
+		switch_safe_free(val);
+	}
+
+	return same;
+}
+
+static switch_bool_t xml_pp_vars_same(switch_event_t *a, switch_event_t *b)
+{
+	switch_event_header_t *hp;
+	int count = 0;
+
+	for (hp = a ? a->headers : NULL; hp; hp = hp->next, count++) {
+		const char *val = b ? switch_event_get_header(b, hp->name) : NULL;
+
+		if (!val || strcmp(val, hp->value)) {
+			return SWITCH_FALSE;
+		}
+	}
+
+	for (hp = b ? b->headers : NULL; hp; hp = hp->next) {
+		count--;
+	}
+
+	return !count;
+}
+
+/* fnv-1a of a file's contents */
+static uint32_t xml_pp_file_hash(const char *path)
+{
+	uint32_t hash = 2166136261U;
+	unsigned char buf[4096];
+	size_t len, x;
+	FILE *fd;
+
+	if (!(fd = fopen(path, "rb"))) {
+		return 0;
+	}
+
+	while ((len = fread(buf, 1, sizeof(buf), fd)) > 0) {
+		for (x = 0; x < len; x++) {
+			hash = (hash ^ buf[x]) * 16777619U;
+		}
+	}
+
+	fclose(fd);
+
+	return hash;
+}
+
+static switch_bool_t xml_pp_file_same(xml_pp_file_t *a, xml_pp_file_t *b)
+{
+	return a->mtime == b->mtime && a->size == b->size && a->hash == b->hash;
+}
+
+/* the record of a file preprocessing is starting on, NULL unless it is the root file being preprocessed */
+static xml_pp_file_t *xml_pp_file_begin(const char *path, FILE *write_fd)
+{
+	xml_pp_file_t *file;
+	struct stat st;
+
+	if (!XML_PP.active) {
+		return NULL;
+	}
+
+	switch_zmalloc(file, sizeof(*file));
+	file->path = switch_must_strdup(path);
+	file->leaf = 1;
+	file->offset = ftell(write_fd);
+
+	if (!stat(path, &st)) {
+#if defined(WIN32)
+		file->mtime = (switch_time_t) st.st_mtime * 1000000000;
+#elif defined(__APPLE__)
+		file->mtime = (switch_time_t) st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+		file->mtime = (switch_time_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+		file->size = st.st_size;
+		file->hash = xml_pp_file_hash(path);
+	}
+
+	if (!XML_PP.run.index) {
+		switch_core_hash_init(&XML_PP.run.index);
+	}
+	switch_core_hash_insert(XML_PP.run.index, path, file);
+
+	if (XML_PP.run.tail) {
+		XML_PP.run.tail->next = file;
+	} else {
+		XML_PP.run.head = file;
+	}
+	XML_PP.run.tail = file;
+	XML_PP.run.files++;
+
+	if (!XML_PP.changed && XML_PP.cursor && !strcmp(XML_PP.cursor->path, path)) {
+		XML_PP.cursor = XML_PP.cursor->next;
+	} else {
+		XML_PP.changed = 1;		/* files added, gone or in another order */
+	}
+
+	return file;
+}
+
+/* writes what an unchanged file without pre-processor commands came out as last time, instead of going through it again */
+static switch_bool_t xml_pp_copy_last(xml_pp_file_t *file, FILE *write_fd)
+{
+	xml_pp_file_t *last;
+	char *buf;
+
+	if (!XML_PP.last_fd || !XML_PP.last.index || !(last = switch_core_hash_find(XML_PP.last.index, file->path))) {
+		return SWITCH_FALSE;
+	}
+
+	if (!last->leaf || !xml_pp_file_same(last, file) || !xml_pp_vars_current(last->vars)) {
+		return SWITCH_FALSE;
+	}
+
+	if (last->length > 0) {
+		buf = switch_must_malloc(last->length);
+
+		if (fseek(XML_PP.last_fd, last->offset, SEEK_SET) || fread(buf, 1, last->length, XML_PP.last_fd) != (size_t) last->length) {
+			free(buf);
+			return SWITCH_FALSE;
+		}
+
+		if (fwrite(buf, 1, last->length, write_fd) != (size_t) last->length) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Short write!\n");
+		}
+
+		free(buf);
+	}
+
+	if (last->vars) {
+		switch_event_dup(&file->vars, last->vars);
+	}
+	file->length = last->length;
+	XML_PP.run.reused++;
+
+	return SWITCH_TRUE;
+}
+
+static void xml_pp_file_end(xml_pp_file_t *file, FILE *write_fd)
+{
+	xml_pp_file_t *last = NULL;
+
+	file->length = ftell(write_fd) - file->offset;
+
+	if (XML_PP.last.index) {
+		last = switch_core_hash_find(XML_PP.last.index, file->path);
+	}
+
+	if (!last || !xml_pp_file_same(last, file) || !xml_pp_vars_same(file->vars, last->vars)) {
+		XML_PP.changed = 1;
+	}
+}
+
+static char *expand_vars(char *buf, char *ebuf, switch_size_t elen, switch_size_t *newlen, const char **err, switch_event_t **used)
 {
 	char *var, *val;
 	char *rp = buf;
@@ -1221,7 +1556,16 @@ static char *expand_vars(char *buf, char *ebuf, switch_size_t elen, switch_size_
 				var = rp;
 				*e++ = '\0';
 				rp = e;
-				if ((val = switch_core_get_variable_dup(var))) {
+				val = switch_core_get_variable_dup(var);
+				if (used) {
+					if (!*used) {
+						switch_event_create_plain(used, SWITCH_EVENT_CHANNEL_DATA);
+					}
+					if (!switch_event_get_header(*used, var)) {
+						switch_event_add_header_string(*used, SWITCH_STACK_BOTTOM, var, switch_str_nil(val));
+					}
+				}
+				if (val) {
 					char *p;
 					for (p = val; p && *p && wp <= ep; p++) {
 						*wp++ = *p;
@@ -1362,11 +1706,16 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 	char *tcmd, *targ;
 	int line = 0;
 	switch_size_t len = 0, eblen = 0;
+	xml_pp_file_t *pp;
 
 	if (rlevel > 100) {
 		return -1;
 	}
 
+	if ((pp = xml_pp_file_begin(file, write_fd)) && xml_pp_copy_last(pp, write_fd)) {
+		return 0;
+	}
+
 	if (!(read_fd = fopen(file, "r"))) {
 		const char *reason = strerror(errno);
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Couldn't open %s (%s)\n", file, reason);
@@ -1390,7 +1739,7 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 		ebuf = switch_must_malloc(eblen);
 		memset(ebuf, 0, eblen);
 
-		while (!(bp = expand_vars(buf, ebuf, eblen, &cur, &err))) {
+		while (!(bp = expand_vars(buf, ebuf, eblen, &cur, &err, pp ? &pp->vars : NULL))) {
 			eblen *= 2;
 			ebuf = switch_must_realloc(ebuf, eblen);
 			memset(ebuf, 0, eblen);
@@ -1421,6 +1770,9 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 			if (*(tcmd - 1) != '<') {
 				continue;
 			}
+			if (pp) {
+				pp->leaf = 0;
+			}
 			if ((e = strstr(tcmd, "/>"))) {
 				*e += 2;
 				*e = '\0';
@@ -1493,12 +1845,16 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 				preprocess_glob(cwd, targ, write_fd, rlevel + 1);
 			} else if (!strcasecmp(tcmd, "exec")) {
 				preprocess_exec(cwd, targ, write_fd, rlevel + 1);
+				XML_PP.changed = 1;		/* no telling what a command prints */
 			}
 
 			continue;
 		}
 
 		if ((cmd = strstr(bp, "<!--#"))) {
+			if (pp) {
+				pp->leaf = 0;
+			}
 			if (fwrite(bp, 1, (unsigned) (cmd - bp), write_fd) != (unsigned) (cmd - bp)) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Short write!\n");
 			}
@@ -1553,6 +1909,7 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 					preprocess_glob(cwd, arg, write_fd, rlevel + 1);
 				} else if (!strcasecmp(cmd, "exec")) {
 					preprocess_exec(cwd, arg, write_fd, rlevel + 1);
+					XML_PP.changed = 1;
 				}
 			}
 
@@ -1570,6 +1927,10 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 
 	fclose(read_fd);
 
+	if (pp) {
+		xml_pp_file_end(pp, write_fd);
+	}
+
 	return 0;
 }
 
@@ -1600,7 +1961,9 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file_simple(const char *file)
 	return NULL;
 }
 
-SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
+/* with reload set, preprocessing the root file records what went into it and copies the files that did not change since last time.
+   If nothing did and keep is set as well, it leaves the last preprocessed file as it is and returns NULL with keep still set */
+static switch_xml_t xml_parse_file(const char *file, switch_bool_t reload, switch_bool_t *keep)
 {
 	int fd = -1;
 	FILE *write_fd = NULL;
@@ -1608,6 +1971,8 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 	char *new_file = NULL;
 	char *new_file_tmp = NULL;
 	const char *abs, *absw;
+	switch_bool_t root_file, kept = SWITCH_FALSE;
+	switch_time_t start = switch_micro_time_now();
 
 	abs = strrchr(file, '/');
 	absw = strrchr(file, '\\');
@@ -1617,12 +1982,27 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 		abs = file;
 	}
 
+	root_file = !strcmp(abs, SWITCH_GLOBAL_filenames.conf_name);
+
+	if (!reload || !root_file) {
+		keep = NULL;
+	}
+
 	switch_mutex_lock(FILE_LOCK);
 
 	if (!(new_file = switch_mprintf("%s%s%s.fsxml", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR, abs))) {
 		goto done;
 	}
 
+	if (root_file) {
+		if (reload) {
+			xml_pp_begin(new_file);
+		} else {
+			/* the file is about to be written without keeping track of what is in it */
+			xml_pp_run_clear(&XML_PP.last);
+		}
+	}
+
 	if (!(new_file_tmp = switch_mprintf("%s%s%s.fsxml.tmp", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR, abs))) {
 		goto done;
 	}
@@ -1636,14 +2016,37 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 	if (preprocess(SWITCH_GLOBAL_dirs.conf_dir, file, write_fd, 0) > -1) {
 		fclose(write_fd);
 		write_fd = NULL;
+
+		if (XML_PP.active) {
+			xml_pp_end();
+
+			XML_PP.stats.reloads++;
+			XML_PP.stats.files = XML_PP.run.files;
+			XML_PP.stats.reused = XML_PP.run.reused;
+			XML_PP.stats.preprocess_usec = switch_micro_time_now() - start;
+			XML_PP.stats.parse_usec = 0;
+
+			if (keep && *keep && !XML_PP.changed) {
+				XML_PP.stats.unchanged++;
+				xml_pp_run_clear(&XML_PP.run);
+				unlink(new_file_tmp);
+				kept = SWITCH_TRUE;
+				goto done;
+			}
+		}
+
 		unlink (new_file);
 
 		if ( rename(new_file_tmp,new_file) ) {
+			xml_pp_run_clear(&XML_PP.last);
 			goto done;
 		}
+
+		start = switch_micro_time_now();
+
 		if ((fd = open(new_file, O_RDONLY, 0)) > -1) {
 			if ((xml = switch_xml_parse_fd(fd))) {
-				if (strcmp(abs, SWITCH_GLOBAL_filenames.conf_name)) {
+				if (!root_file) {
 					xml->free_path = new_file;
 					new_file = NULL;
 				}
@@ -1651,12 +2054,36 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 			close(fd);
 			fd = -1;
 		}
+
+		if (root_file && reload) {
+			XML_PP.stats.parse_usec = switch_micro_time_now() - start;
+		}
+
+		if (XML_PP.active) {
+			/* only remember the files once the tree built from them is good, a failed
+			   parse must not let the next unchanged reload keep the old tree */
+			xml_pp_run_clear(&XML_PP.last);
+
+			if (xml && zstr(switch_xml_error(xml))) {
+				XML_PP.last = XML_PP.run;
+				memset(&XML_PP.run, 0, sizeof(XML_PP.run));
+			}
+		}
 	}
 
   done:
 
+	if (XML_PP.active) {
+		xml_pp_end();
+		xml_pp_run_clear(&XML_PP.run);
+	}
+
 	switch_mutex_unlock(FILE_LOCK);
 
+	if (keep) {
+		*keep = kept;
+	}
+
 	if (write_fd) {
 		fclose(write_fd);
 		write_fd = NULL;
@@ -1672,53 +2099,57 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 	return xml;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
-												  const char *tag_name,
-												  const char *key_name,
-												  const char *key_value,
-												  switch_xml_t *root, switch_xml_t *node, switch_event_t *params, switch_bool_t clone)
+SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 {
-	switch_xml_t conf = NULL;
-	switch_xml_t tag = NULL;
-	switch_xml_t xml = NULL;
-	switch_xml_binding_t *binding;
-	uint8_t loops = 0;
-	switch_xml_section_t sections = BINDINGS ? switch_xml_parse_section_string(section) : 0;
+	return xml_parse_file(file, SWITCH_FALSE, NULL);
+}
 
-	switch_thread_rwlock_rdlock(B_RWLOCK);
+SWITCH_DECLARE(void) switch_xml_get_reload_stats(switch_xml_reload_stats_t *stats)
+{
+	switch_mutex_lock(FILE_LOCK);
+	*stats = XML_PP.stats;
+	switch_mutex_unlock(FILE_LOCK);
+}
 
-	for (binding = BINDINGS; binding; binding = binding->next) {
-		if (binding->sections && !(sections & binding->sections)) {
-			continue;
-		}
+/* what a gateway answered, NULL if it was an error or a "not found" result, for which not_found_ms gets how long it may be cached */
+static switch_xml_t xml_binding_result(switch_xml_t xml, int *not_found_ms)
+{
+	switch_xml_t conf, p;
+	const char *err = NULL;
+	const char *aname;
 
-		if ((xml = binding->function(section, tag_name, key_name, key_value, params, binding->user_data))) {
-			const char *err = NULL;
+	if (!xml) {
+		return NULL;
+	}
 
-			err = switch_xml_error(xml);
-			if (zstr(err)) {
-				if ((conf = switch_xml_find_child(xml, "section", "name", "result"))) {
-					switch_xml_t p;
-					const char *aname;
+	err = switch_xml_error(xml);
+	if (!zstr(err)) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error[%s]\n", err);
+		switch_xml_free(xml);
+		return NULL;
+	}
 
-					if ((p = switch_xml_child(conf, "result"))) {
-						aname = switch_xml_attr(p, "status");
-						if (aname && !strcasecmp(aname, "not found")) {
-							switch_xml_free(xml);
-							xml = NULL;
-							continue;
-						}
-					}
-				}
-				break;
-			} else {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error[%s]\n", err);
-				switch_xml_free(xml);
-				xml = NULL;
+	if ((conf = switch_xml_find_child(xml, "section", "name", "result")) && (p = switch_xml_child(conf, "result"))) {
+		aname = switch_xml_attr(p, "status");
+		if (aname && !strcasecmp(aname, "not found")) {
+			if (not_found_ms && (aname = switch_xml_attr(p, "cacheable")) && switch_is_number(aname)) {
+				*not_found_ms = atoi(aname);
 			}
+			switch_xml_free(xml);
+			return NULL;
 		}
 	}
-	switch_thread_rwlock_unlock(B_RWLOCK);
+
+	return xml;
+}
+
+/* find the node in what the gateways returned, else in the core registry */
+static switch_status_t xml_locate_node(switch_xml_t xml, const char *section, const char *tag_name, const char *key_name, const char *key_value,
+									   switch_xml_t *root, switch_xml_t *node, switch_bool_t clone)
+{
+	switch_xml_t conf = NULL;
+	switch_xml_t tag = NULL;
+	uint8_t loops = 0;
 
 	for (;;) {
 		if (!xml) {
@@ -1754,78 +2185,966 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
 	return SWITCH_STATUS_FALSE;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_xml_locate_domain(const char *domain_name, switch_event_t *params, switch_xml_t *root, switch_xml_t *domain)
+/* turns a document owned by one holder into one owned by holders more, each of which frees it, the last one for real */
+static void xml_share(switch_xml_t xml, uint32_t holders)
 {
-	switch_event_t *my_params = NULL;
-	switch_status_t status;
-	*domain = NULL;
+	switch_mutex_lock(REFLOCK);
+	if (switch_test_flag(xml, SWITCH_XML_ROOT)) {
+		xml->refs += holders - 1;
+	} else {
+		switch_set_flag(xml, SWITCH_XML_ROOT);
+		xml->refs = holders;
+	}
+	switch_mutex_unlock(REFLOCK);
+}
 
-	if (!params) {
-		switch_event_create(&my_params, SWITCH_EVENT_REQUEST_PARAMS);
-		switch_assert(my_params);
-		switch_event_add_header_string(my_params, SWITCH_STACK_BOTTOM, "domain", domain_name);
-		params = my_params;
+/* call with FETCH_MUTEX held, returns the fetch to wait on and sets started when the caller has to hand it to the gateway */
+static xml_fetch_t *xml_fetch_join(switch_xml_binding_t *binding, const char *section, const char *tag_name, const char *key_name,
+								   const char *key_value, switch_event_t *params, switch_bool_t *started)
+{
+	switch_memory_pool_t *pool = NULL;
+	xml_fetch_t *fetch = NULL;
+	char *key = NULL;
+
+	if ((binding->coalesce_sections & switch_xml_parse_section_string(section))) {
+		key = switch_mprintf("%p|%s|%s|%s|%s|%s|%s", (void *) binding, section, switch_str_nil(tag_name), switch_str_nil(key_name),
+							 switch_str_nil(key_value), switch_str_nil(params ? switch_event_get_header(params, "action") : NULL),
+							 switch_str_nil(params ? switch_event_get_header(params, "purpose") : NULL));
+
+		if ((fetch = switch_core_hash_find(FETCH_HASH, key))) {
+			FETCH_STATS.coalesced++;
+			*started = SWITCH_FALSE;
+			switch_safe_free(key);
+			return fetch;
+		}
 	}
 
-	status = switch_xml_locate("directory", "domain", "name", domain_name, root, domain, params, SWITCH_FALSE);
-	if (my_params) {
-		switch_event_destroy(&my_params);
+	switch_core_new_memory_pool(&pool);
+	fetch = switch_core_alloc(pool, sizeof(*fetch));
+	fetch->pool = pool;
+	fetch->binding = binding;
+	fetch->not_found_ms = -1;
+	switch_thread_cond_create(&fetch->cond, pool);
+
+	if (key) {
+		fetch->key = switch_core_strdup(pool, key);
+		switch_core_hash_insert(FETCH_HASH, fetch->key, fetch);
+		switch_safe_free(key);
 	}
-	return status;
+
+	FETCH_STATS.fetches++;
+	FETCH_STATS.in_flight++;
+	*started = SWITCH_TRUE;
+
+	return fetch;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_xml_locate_group(const char *group_name,
-														const char *domain_name,
-														switch_xml_t *root, switch_xml_t *domain, switch_xml_t *group, switch_event_t *params)
+static void xml_locate_continue(xml_locate_request_t *request, switch_xml_binding_t *binding);
+
+/* handed to the asynchronous gateways, called once the fetch is answered */
+static void xml_fetch_done(switch_xml_t xml, void *fetch_data)
 {
-	switch_status_t status = SWITCH_STATUS_FALSE;
-	switch_event_t *my_params = NULL;
-	switch_xml_t groups = NULL;
+	xml_fetch_t *fetch = (xml_fetch_t *) fetch_data;
+	switch_xml_binding_t *binding = fetch->binding;
+	xml_locate_request_t *requests, *request;
+	uint32_t holders;
+	int not_found_ms = -1;
 
-	*root = NULL;
-	*group = NULL;
-	*domain = NULL;
+	xml = xml_binding_result(xml, &not_found_ms);
 
-	if (!params) {
-		switch_event_create(&my_params, SWITCH_EVENT_REQUEST_PARAMS);
-		switch_assert(my_params);
-		params = my_params;
-	}
+	switch_mutex_lock(FETCH_MUTEX);
 
-	if (group_name) {
-		switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "group_name", group_name);
+	if (fetch->key) {
+		switch_core_hash_delete(FETCH_HASH, fetch->key);
 	}
 
-	if (domain_name) {
-		switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "domain", domain_name);
+	holders = fetch->waiting;
+	for (request = fetch->requests; request; request = request->next) {
+		holders++;
 	}
 
-	if ((status = switch_xml_locate_domain(domain_name, params, root, domain)) != SWITCH_STATUS_SUCCESS) {
-		goto end;
+	if (xml && holders) {
+		xml_share(xml, holders);
+	} else if (xml) {
+		switch_xml_free(xml);
+		xml = NULL;
 	}
 
-	status = SWITCH_STATUS_FALSE;
+	requests = fetch->requests;
+	fetch->requests = NULL;
+	fetch->xml = xml;
+	fetch->not_found_ms = not_found_ms;
+	fetch->done = 1;
+	FETCH_STATS.in_flight--;
 
-	if ((groups = switch_xml_child(*domain, "groups"))) {
-		if ((*group = switch_xml_find_child(groups, "group", "name", group_name))) {
-			status = SWITCH_STATUS_SUCCESS;
-		}
+	if (fetch->waiting) {
+		switch_thread_cond_broadcast(fetch->cond);
+	} else {
+		switch_core_destroy_memory_pool(&fetch->pool);
 	}
 
-  end:
+	switch_mutex_unlock(FETCH_MUTEX);
 
-	if (my_params) {
-		switch_event_destroy(&my_params);
-	}
+	while ((request = requests)) {
+		requests = request->next;
+		request->next = NULL;
+
+		if (xml) {
+			switch_xml_t root = NULL, node = NULL;
+			switch_memory_pool_t *pool = request->pool;
+
+			xml_cache_result(NULL, request->section, request->tag_name, request->key_name, request->key_value, request->params, xml, -1);
+			xml_locate_node(xml, request->section, request->tag_name, request->key_name, request->key_value, &root, &node, SWITCH_FALSE);
+			request->callback(root, node, request->user_data);
+			switch_event_destroy(&request->params);
+			switch_core_destroy_memory_pool(&pool);
+		} else {
+			if (not_found_ms > 0) {
+				request->not_found_ms = not_found_ms;
+			}
+			xml_locate_continue(request, binding->next);
+		}
+	}
+}
+
+static void xml_fetch_start(xml_fetch_t *fetch, const char *section, const char *tag_name, const char *key_name, const char *key_value,
+							switch_event_t *params)
+{
+	switch_xml_binding_t *binding = fetch->binding;
+
+	if (binding->async_function(section, tag_name, key_name, key_value, params, binding->user_data, xml_fetch_done, fetch) != SWITCH_STATUS_SUCCESS) {
+		xml_fetch_done(NULL, fetch);
+	}
+}
+
+/* ask an asynchronous gateway and wait for it, along with anyone else asking the same */
+static switch_xml_t xml_binding_fetch(switch_xml_binding_t *binding, const char *section, const char *tag_name, const char *key_name,
+									  const char *key_value, switch_event_t *params, int *not_found_ms)
+{
+	xml_fetch_t *fetch;
+	switch_xml_t xml;
+	switch_bool_t started = SWITCH_FALSE;
+
+	switch_mutex_lock(FETCH_MUTEX);
+	fetch = xml_fetch_join(binding, section, tag_name, key_name, key_value, params, &started);
+	fetch->waiting++;
+	switch_mutex_unlock(FETCH_MUTEX);
+
+	if (started) {
+		xml_fetch_start(fetch, section, tag_name, key_name, key_value, params);
+	}
+
+	switch_mutex_lock(FETCH_MUTEX);
+	while (!fetch->done) {
+		switch_thread_cond_wait(fetch->cond, FETCH_MUTEX);
+	}
+
+	xml = fetch->xml;
+
+	if (not_found_ms && fetch->not_found_ms > 0) {
+		*not_found_ms = fetch->not_found_ms;
+	}
+
+	if (!--fetch->waiting) {
+		switch_core_destroy_memory_pool(&fetch->pool);
+	}
+	switch_mutex_unlock(FETCH_MUTEX);
+
+	return xml;
+}
+
+/* walk the bindings from binding on, parking the request on the first asynchronous one */
+static void xml_locate_continue(xml_locate_request_t *request, switch_xml_binding_t *binding)
+{
+	switch_xml_section_t sections = switch_xml_parse_section_string(request->section);
+	switch_xml_t xml = NULL, root = NULL, node = NULL;
+	switch_memory_pool_t *pool = request->pool;
+
+	switch_thread_rwlock_rdlock(B_RWLOCK);
+
+	for (; binding; binding = binding->next) {
+		if (binding->sections && !(sections & binding->sections)) {
+			continue;
+		}
+
+		if (binding->async_function) {
+			xml_fetch_t *fetch;
+			switch_bool_t started = SWITCH_FALSE;
+
+			switch_thread_rwlock_unlock(B_RWLOCK);
+
+			switch_mutex_lock(FETCH_MUTEX);
+			fetch = xml_fetch_join(binding, request->section, request->tag_name, request->key_name, request->key_value, request->params, &started);
+			request->next = fetch->requests;
+			fetch->requests = request;
+			switch_mutex_unlock(FETCH_MUTEX);
+
+			if (started) {
+				xml_fetch_start(fetch, request->section, request->tag_name, request->key_name, request->key_value, request->params);
+			}
+
+			return;
+		}
+
+		if ((xml = xml_binding_result(binding->function(request->section, request->tag_name, request->key_name, request->key_value,
+														request->params, binding->user_data), &request->not_found_ms))) {
+			break;
+		}
+	}
+
+	switch_thread_rwlock_unlock(B_RWLOCK);
+
+	xml_cache_result(NULL, request->section, request->tag_name, request->key_name, request->key_value, request->params, xml, request->not_found_ms);
+	xml_locate_node(xml, request->section, request->tag_name, request->key_name, request->key_value, &root, &node, SWITCH_FALSE);
+	request->callback(root, node, request->user_data);
+	switch_event_destroy(&request->params);
+	switch_core_destroy_memory_pool(&pool);
+}
+
+/* asks the gateways in order until one of them has an answer */
+static switch_xml_t xml_bindings_fetch(const char *section, const char *tag_name, const char *key_name, const char *key_value,
+									   switch_event_t *params, int *not_found_ms)
+{
+	switch_xml_t xml = NULL;
+	switch_xml_binding_t *binding;
+	switch_xml_section_t sections = switch_xml_parse_section_string(section);
+
+	switch_thread_rwlock_rdlock(B_RWLOCK);
+
+	for (binding = BINDINGS; binding; binding = binding->next) {
+		if (binding->sections && !(sections & binding->sections)) {
+			continue;
+		}
+
+		if (binding->async_function) {
+			/* don't hold off binding changes for as long as the gateway takes */
+			switch_thread_rwlock_unlock(B_RWLOCK);
+			xml = xml_binding_fetch(binding, section, tag_name, key_name, key_value, params, not_found_ms);
+			switch_thread_rwlock_rdlock(B_RWLOCK);
+		} else {
+			xml = xml_binding_result(binding->function(section, tag_name, key_name, key_value, params, binding->user_data), not_found_ms);
+		}
+
+		if (xml) {
+			break;
+		}
+	}
+	switch_thread_rwlock_unlock(B_RWLOCK);
+
+	return xml;
+}
+
+/* the ids of the call, the channel or the sip dialog a request is made for, as params or as channel variables */
+static const char *XML_CACHE_CALL_PARAMS[] = { "sip_call_id", "sip_from_tag", "sip_to_tag", "sip_full_via", "sip_via_branch",
+	"sip_auth_nonce", "sip_auth_response", "sip_auth_cnonce", "sip_auth_nc", "sip_auth_qop", "call_uuid", "session_id", NULL };
+
+/* params that change with every request and would keep identical lookups from ever sharing a cache entry */
+static switch_bool_t xml_cache_volatile_param(const char *name)
+{
+	size_t len = strlen(name);
+	int x;
+
+	if (!strncasecmp(name, "Event-", 6) || !strcasecmp(name, "Core-UUID") || switch_stristr("Unique-ID", name) || switch_stristr("UUID", name) ||
+		(len > 5 && !strcasecmp(name + len - 5, "-Time")) || switch_stristr("Timestamp", name) || switch_stristr("_epoch", name)) {
+		return SWITCH_TRUE;
+	}
+
+	if (!strncasecmp(name, "variable_", 9)) {
+		name += 9;
+	}
+
+	for (x = 0; XML_CACHE_CALL_PARAMS[x]; x++) {
+		if (!strcasecmp(name, XML_CACHE_CALL_PARAMS[x])) {
+			return SWITCH_TRUE;
+		}
+	}
+
+	return SWITCH_FALSE;
+}
+
+static int xml_cache_header_cmp(const void *a, const void *b)
+{
+	const switch_event_header_t *ha = *(const switch_event_header_t **) a;
+	const switch_event_header_t *hb = *(const switch_event_header_t **) b;
+
+	return strcasecmp(ha->name, hb->name);
+}
+
+/* the lookup and its params sorted by name, less the volatile ones */
+static char *xml_cache_key(const char *section, const char *tag_name, const char *key_name, const char *key_value, switch_event_t *params)
+{
+	switch_stream_handle_t stream = { 0 };
+	switch_event_header_t *hp, **headers = NULL;
+	int x, count = 0;
+
+	SWITCH_STANDARD_STREAM(stream);
+	stream.write_function(&stream, "%s\n%s\n%s\n%s\n", section, switch_str_nil(tag_name), switch_str_nil(key_name), switch_str_nil(key_value));
+
+	if (params) {
+		for (hp = params->headers; hp; hp = hp->next) {
+			count++;
+		}
+
+		switch_zmalloc(headers, sizeof(*headers) * (count + 1));
+		count = 0;
+
+		for (hp = params->headers; hp; hp = hp->next) {
+			if (!xml_cache_volatile_param(hp->name)) {
+				headers[count++] = hp;
+			}
+		}
+
+		qsort(headers, count, sizeof(*headers), xml_cache_header_cmp);
+
+		for (x = 0; x < count; x++) {
+			stream.write_function(&stream, "%s=%s\n", headers[x]->name, switch_str_nil(headers[x]->value));
+		}
+
+		free(headers);
+	}
+
+	return (char *) stream.data;
+}
+
+static uint32_t xml_cache_section_index(const char *section)
+{
+	uint32_t i;
+
+	for (i = 0; i < XML_CACHE_SECTION_OTHER; i++) {
+		if (!strcasecmp(section, XML_CACHE_SECTIONS[i])) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+/* call with CACHE_MUTEX held */
+static void xml_cache_unlink(xml_cache_entry_t *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		XML_CACHE.head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		XML_CACHE.tail = entry->prev;
+	}
+
+	entry->prev = entry->next = NULL;
+}
+
+/* call with CACHE_MUTEX held */
+static void xml_cache_link_head(xml_cache_entry_t *entry)
+{
+	entry->prev = NULL;
+	entry->next = XML_CACHE.head;
+
+	if (XML_CACHE.head) {
+		XML_CACHE.head->prev = entry;
+	} else {
+		XML_CACHE.tail = entry;
+	}
+
+	XML_CACHE.head = entry;
+}
+
+/* call with CACHE_MUTEX held */
+static void xml_cache_drop(xml_cache_entry_t *entry)
+{
+	xml_cache_unlink(entry);
+	switch_core_hash_delete(XML_CACHE.hash, entry->key);
+	XML_CACHE.stats[entry->section].entries--;
+	XML_CACHE.entries--;
+
+	/* a refresh still running owns it until it is done */
+	entry->dropped = 1;
+	if (!entry->refreshing) {
+		xml_cache_entry_free(entry);
+	}
+}
+
+static void xml_cache_entry_free(xml_cache_entry_t *entry)
+{
+	switch_xml_free(entry->xml);
+	if (entry->params) {
+		switch_event_destroy(&entry->params);
+	}
+	switch_safe_free(entry->key);
+	switch_safe_free(entry->section_name);
+	switch_safe_free(entry->tag_name);
+	switch_safe_free(entry->key_name);
+	switch_safe_free(entry->key_value);
+	free(entry);
+}
+
+/* stores what the gateways answered, xml is NULL for a negative entry */
+static void xml_cache_store(const char *key, const char *section, const char *tag_name, const char *key_name, const char *key_value,
+							switch_event_t *params, switch_xml_t xml, int ttl_ms, int stale_ms)
+{
+	xml_cache_entry_t *entry;
+	switch_time_t now = switch_micro_time_now();
+	uint32_t index = xml_cache_section_index(section);
+
+	switch_zmalloc(entry, sizeof(*entry));
+	entry->key = strdup(key);
+	entry->section = index;
+	entry->expires = ttl_ms > 0 ? now + (switch_time_t) ttl_ms * 1000 : 0;
+	entry->stale_until = entry->expires && stale_ms > 0 ? entry->expires + (switch_time_t) stale_ms * 1000 : entry->expires;
+
+	if (xml) {
+		xml_share(xml, 2);
+		((switch_xml_root_t) xml)->user_indexed = 1;
+		entry->xml = xml;
+	}
+
+	if (entry->stale_until > entry->expires) {
+		/* what a refresh needs to ask again */
+		entry->section_name = strdup(section);
+		entry->tag_name = tag_name ? strdup(tag_name) : NULL;
+		entry->key_name = key_name ? strdup(key_name) : NULL;
+		entry->key_value = key_value ? strdup(key_value) : NULL;
+		if (params) {
+			switch_event_dup(&entry->params, params);
+		}
+	}
+
+	switch_mutex_lock(CACHE_MUTEX);
+
+	if (XML_CACHE.max) {
+		xml_cache_entry_t *old;
+
+		if ((old = switch_core_hash_find(XML_CACHE.hash, key))) {
+			xml_cache_drop(old);
+		}
+
+		while (XML_CACHE.entries >= XML_CACHE.max && XML_CACHE.tail) {
+			XML_CACHE.stats[XML_CACHE.tail->section].evictions++;
+			xml_cache_drop(XML_CACHE.tail);
+		}
+
+		switch_core_hash_insert(XML_CACHE.hash, entry->key, entry);
+		xml_cache_link_head(entry);
+		XML_CACHE.stats[index].entries++;
+		XML_CACHE.stats[index].stores++;
+		XML_CACHE.entries++;
+		entry = NULL;
+	}
+
+	switch_mutex_unlock(CACHE_MUTEX);
+
+	if (entry) {
+		xml_cache_entry_free(entry);
+	}
+}
+
+/* how long a gateway says its answer may be kept */
+static void xml_cache_ttl(switch_xml_t xml, int *ttl_ms, int *stale_ms)
+{
+	const char *val;
+
+	*ttl_ms = -1;
+
+	if ((val = switch_xml_attr(xml, "cacheable"))) {
+		if (!switch_is_number(val)) {
+			/* kept until it is flushed or pushed out, like cacheable users */
+			*ttl_ms = 0;
+		} else if (atoi(val) > 0) {
+			*ttl_ms = atoi(val);
+		}
+
+		*stale_ms = (val = switch_xml_attr(xml, "cache-stale")) && switch_is_number(val) ? atoi(val) : 0;
+	}
+}
+
+/* keeps what the gateways answered for as long as they allow, key is built when NULL */
+static void xml_cache_result(const char *key, const char *section, const char *tag_name, const char *key_name, const char *key_value,
+							 switch_event_t *params, switch_xml_t xml, int not_found_ms)
+{
+	int ttl_ms = -1, stale_ms = 0;
+	char *new_key = NULL;
+
+	if (!XML_CACHE.max) {
+		return;
+	}
+
+	if (xml) {
+		xml_cache_ttl(xml, &ttl_ms, &stale_ms);
+	} else if (not_found_ms > 0) {
+		ttl_ms = not_found_ms;
+	} else if (XML_CACHE.negative_ttl) {
+		ttl_ms = (int) XML_CACHE.negative_ttl;
+	}
+
+	if (ttl_ms < 0) {
+		return;
+	}
+
+	if (!key) {
+		key = new_key = xml_cache_key(section, tag_name, key_name, key_value, params);
+	}
+
+	xml_cache_store(key, section, tag_name, key_name, key_value, params, xml, ttl_ms, stale_ms);
+	switch_safe_free(new_key);
+}
+
+static void *SWITCH_THREAD_FUNC xml_cache_refresh_thread(switch_thread_t *thread, void *obj)
+{
+	xml_cache_entry_t *entry = (xml_cache_entry_t *) obj;
+	switch_xml_t xml;
+	int not_found_ms = -1;
+
+	xml = xml_bindings_fetch(entry->section_name, entry->tag_name, entry->key_name, entry->key_value, entry->params, &not_found_ms);
+	xml_cache_result(entry->key, entry->section_name, entry->tag_name, entry->key_name, entry->key_value, entry->params, xml, not_found_ms);
+	switch_xml_free(xml);
+
+	switch_mutex_lock(CACHE_MUTEX);
+	entry->refreshing = 0;
+	if (entry->dropped) {
+		xml_cache_entry_free(entry);
+	}
+	switch_mutex_unlock(CACHE_MUTEX);
+
+	return NULL;
+}
+
+/* SWITCH_STATUS_SUCCESS with a reference on the cached document, NULL for a negative entry */
+static switch_status_t xml_cache_lookup(const char *key, const char *section, switch_xml_t *xml)
+{
+	xml_cache_entry_t *entry;
+	switch_time_t now;
+	uint32_t index = xml_cache_section_index(section);
+	switch_status_t status = SWITCH_STATUS_NOTFOUND;
+
+	switch_mutex_lock(CACHE_MUTEX);
+
+	if (!(entry = switch_core_hash_find(XML_CACHE.hash, key))) {
+		XML_CACHE.stats[index].misses++;
+		goto end;
+	}
+
+	now = switch_micro_time_now();
+
+	if (entry->stale_until && entry->stale_until < now) {
+		XML_CACHE.stats[index].expired++;
+		XML_CACHE.stats[index].misses++;
+		xml_cache_drop(entry);
+		goto end;
+	}
+
+	if (entry->expires && entry->expires < now) {
+		/* serve it while someone else asks again */
+		XML_CACHE.stats[index].stale_hits++;
+
+		if (!entry->refreshing) {
+			switch_thread_data_t *td;
+
+			entry->refreshing = 1;
+			switch_zmalloc(td, sizeof(*td));
+			td->alloc = 1;
+			td->func = xml_cache_refresh_thread;
+			td->obj = entry;
+			switch_thread_pool_launch_thread(&td);
+		}
+	} else if (entry->xml) {
+		XML_CACHE.stats[index].hits++;
+	} else {
+		XML_CACHE.stats[index].negative_hits++;
+	}
+
+	if (entry->xml) {
+		xml_share(entry->xml, 2);
+	}
+
+	xml_cache_unlink(entry);
+	xml_cache_link_head(entry);
+
+	*xml = entry->xml;
+	status = SWITCH_STATUS_SUCCESS;
+
+  end:
+	switch_mutex_unlock(CACHE_MUTEX);
+
+	return status;
+}
+
+SWITCH_DECLARE(void) switch_xml_cache_set_max(uint32_t max)
+{
+	switch_mutex_lock(CACHE_MUTEX);
+	XML_CACHE.max = max;
+
+	while (XML_CACHE.entries > XML_CACHE.max && XML_CACHE.tail) {
+		XML_CACHE.stats[XML_CACHE.tail->section].evictions++;
+		xml_cache_drop(XML_CACHE.tail);
+	}
+	switch_mutex_unlock(CACHE_MUTEX);
+}
+
+SWITCH_DECLARE(void) switch_xml_cache_set_negative_ttl(uint32_t ms)
+{
+	XML_CACHE.negative_ttl = ms;
+}
+
+SWITCH_DECLARE(uint32_t) switch_xml_cache_flush(void)
+{
+	uint32_t r;
+
+	switch_mutex_lock(CACHE_MUTEX);
+	r = XML_CACHE.entries;
+
+	while (XML_CACHE.head) {
+		xml_cache_drop(XML_CACHE.head);
+	}
+	switch_mutex_unlock(CACHE_MUTEX);
+
+	return r;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_cache_get_stats(uint32_t index, switch_xml_cache_stats_t *stats)
+{
+	if (index > XML_CACHE_SECTION_OTHER) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_lock(CACHE_MUTEX);
+	*stats = XML_CACHE.stats[index];
+	switch_mutex_unlock(CACHE_MUTEX);
+
+	stats->section = XML_CACHE_SECTIONS[index];
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_locate_async(const char *section,
+														const char *tag_name,
+														const char *key_name,
+														const char *key_value,
+														switch_event_t *params, switch_xml_locate_callback_t callback, void *user_data)
+{
+	switch_memory_pool_t *pool = NULL;
+	xml_locate_request_t *request;
+	switch_xml_binding_t *binding;
+	switch_xml_t xml = NULL, root = NULL, node = NULL;
+
+	switch_assert(callback);
+
+	if (XML_CACHE.max && XML_CACHE.entries) {
+		char *key = xml_cache_key(section, tag_name, key_name, key_value, params);
+		switch_status_t status = xml_cache_lookup(key, section, &xml);
+
+		free(key);
+
+		if (status == SWITCH_STATUS_SUCCESS) {
+			xml_locate_node(xml, section, tag_name, key_name, key_value, &root, &node, SWITCH_FALSE);
+			callback(root, node, user_data);
+			return SWITCH_STATUS_SUCCESS;
+		}
+	}
+
+	if (switch_core_new_memory_pool(&pool) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_MEMERR;
+	}
+
+	request = switch_core_alloc(pool, sizeof(*request));
+	request->pool = pool;
+	request->section = switch_core_strdup(pool, section);
+	request->tag_name = tag_name ? switch_core_strdup(pool, tag_name) : NULL;
+	request->key_name = key_name ? switch_core_strdup(pool, key_name) : NULL;
+	request->key_value = key_value ? switch_core_strdup(pool, key_value) : NULL;
+	request->callback = callback;
+	request->user_data = user_data;
+	request->not_found_ms = -1;
+
+	if (params) {
+		switch_event_dup(&request->params, params);
+	}
+
+	switch_mutex_lock(FETCH_MUTEX);
+	FETCH_STATS.async_locates++;
+	switch_mutex_unlock(FETCH_MUTEX);
+
+	switch_thread_rwlock_rdlock(B_RWLOCK);
+	binding = BINDINGS;
+	switch_thread_rwlock_unlock(B_RWLOCK);
+
+	xml_locate_continue(request, binding);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_xml_get_fetch_stats(switch_xml_fetch_stats_t *stats)
+{
+	switch_mutex_lock(FETCH_MUTEX);
+	*stats = FETCH_STATS;
+	switch_mutex_unlock(FETCH_MUTEX);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
+												  const char *tag_name,
+												  const char *key_name,
+												  const char *key_value,
+												  switch_xml_t *root, switch_xml_t *node, switch_event_t *params, switch_bool_t clone)
+{
+	switch_xml_t xml = NULL;
+	char *key = NULL;
+	int not_found_ms = -1;
+
+	if (!BINDINGS) {
+		return xml_locate_node(NULL, section, tag_name, key_name, key_value, root, node, clone);
+	}
+
+	/* nothing to build a key for until something was cached */
+	if (XML_CACHE.max && XML_CACHE.entries) {
+		key = xml_cache_key(section, tag_name, key_name, key_value, params);
+
+		if (xml_cache_lookup(key, section, &xml) == SWITCH_STATUS_SUCCESS) {
+			free(key);
+			return xml_locate_node(xml, section, tag_name, key_name, key_value, root, node, clone);
+		}
+	}
+
+	xml = xml_bindings_fetch(section, tag_name, key_name, key_value, params, &not_found_ms);
+	xml_cache_result(key, section, tag_name, key_name, key_value, params, xml, not_found_ms);
+	switch_safe_free(key);
+
+	return xml_locate_node(xml, section, tag_name, key_name, key_value, root, node, clone);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_locate_domain(const char *domain_name, switch_event_t *params, switch_xml_t *root, switch_xml_t *domain)
+{
+	switch_event_t *my_params = NULL;
+	switch_status_t status;
+	*domain = NULL;
+
+	if (!params) {
+		switch_event_create(&my_params, SWITCH_EVENT_REQUEST_PARAMS);
+		switch_assert(my_params);
+		switch_event_add_header_string(my_params, SWITCH_STACK_BOTTOM, "domain", domain_name);
+		params = my_params;
+	}
+
+	status = switch_xml_locate("directory", "domain", "name", domain_name, root, domain, params, SWITCH_FALSE);
+	if (my_params) {
+		switch_event_destroy(&my_params);
+	}
+	return status;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_locate_group(const char *group_name,
+														const char *domain_name,
+														switch_xml_t *root, switch_xml_t *domain, switch_xml_t *group, switch_event_t *params)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	switch_event_t *my_params = NULL;
+	switch_xml_t groups = NULL;
+
+	*root = NULL;
+	*group = NULL;
+	*domain = NULL;
+
+	if (!params) {
+		switch_event_create(&my_params, SWITCH_EVENT_REQUEST_PARAMS);
+		switch_assert(my_params);
+		params = my_params;
+	}
+
+	if (group_name) {
+		switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "group_name", group_name);
+	}
+
+	if (domain_name) {
+		switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "domain", domain_name);
+	}
+
+	if ((status = switch_xml_locate_domain(domain_name, params, root, domain)) != SWITCH_STATUS_SUCCESS) {
+		goto end;
+	}
+
+	status = SWITCH_STATUS_FALSE;
+
+	if ((groups = switch_xml_child(*domain, "groups"))) {
+		if ((*group = switch_xml_find_child(groups, "group", "name", group_name))) {
+			status = SWITCH_STATUS_SUCCESS;
+		}
+	}
+
+  end:
+
+	if (my_params) {
+		switch_event_destroy(&my_params);
+	}
 
 	return status;
 }
 
+typedef struct {
+	switch_xml_t user;
+	uint32_t pos;
+} xml_user_ref_t;
+
+/* the users right under one tag, by the attributes they are looked up with */
+typedef struct {
+	switch_hash_t *ids;
+	switch_hash_t *aliases;
+	switch_hash_t *ips;
+	xml_user_ref_t *typed;		/* the first user with a type other than pointer, which a lookup with the default user_type matches too */
+} xml_user_index_t;
+
+static void xml_user_index_destroy(switch_xml_root_t root)
+{
+	switch_hash_index_t *hi;
+	xml_user_index_t *idx;
+	void *val;
+
+	for (hi = switch_core_hash_first(root->user_index); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		idx = (xml_user_index_t *) val;
+		switch_core_hash_destroy(&idx->ids);
+		switch_core_hash_destroy(&idx->aliases);
+		switch_core_hash_destroy(&idx->ips);
+	}
+
+	switch_core_hash_destroy(&root->user_index);
+	switch_core_destroy_memory_pool(&root->user_index_pool);
+}
+
+/* the root of a tree that stays around for more than one lookup, the registry or a cached gateway answer */
+static switch_xml_root_t xml_shared_root(switch_xml_t xml)
+{
+	while (xml && xml->parent) {
+		xml = xml->parent;
+	}
+
+	return xml && switch_test_flag(xml, SWITCH_XML_ROOT) && ((switch_xml_root_t) xml)->user_indexed ? (switch_xml_root_t) xml : NULL;
+}
+
+static void xml_user_index_add(switch_hash_t *hash, const char *val, switch_xml_t user, uint32_t pos, switch_memory_pool_t *pool)
+{
+	xml_user_ref_t *ref;
+
+	/* the first one in the document is the one a walk would find */
+	if (!val || switch_core_hash_find(hash, val)) {
+		return;
+	}
+
+	ref = switch_core_alloc(pool, sizeof(*ref));
+	ref->user = user;
+	ref->pos = pos;
+	switch_core_hash_insert(hash, val, ref);
+}
+
+/* call with USER_INDEX_RWLOCK held for writing */
+static xml_user_index_t *xml_user_index_build(switch_xml_root_t root, switch_xml_t tag, const char *index_key)
+{
+	xml_user_index_t *idx;
+	switch_xml_t x_user;
+	const char *type;
+	uint32_t pos = 0;
+
+	if (!root->user_index) {
+		switch_core_new_memory_pool(&root->user_index_pool);
+		switch_core_hash_init(&root->user_index);
+	}
+
+	idx = switch_core_alloc(root->user_index_pool, sizeof(*idx));
+	switch_core_hash_init_nocase(&idx->ids);
+	switch_core_hash_init_nocase(&idx->aliases);
+	switch_core_hash_init_nocase(&idx->ips);
+
+	for (x_user = switch_xml_child(tag, "user"); x_user; x_user = x_user->next, pos++) {
+		xml_user_index_add(idx->ids, switch_xml_attr(x_user, "id"), x_user, pos, root->user_index_pool);
+		xml_user_index_add(idx->aliases, switch_xml_attr(x_user, "number-alias"), x_user, pos, root->user_index_pool);
+		xml_user_index_add(idx->ips, switch_xml_attr(x_user, "ip"), x_user, pos, root->user_index_pool);
+
+		if (!idx->typed && (type = switch_xml_attr(x_user, "type")) && strcasecmp(type, "pointer")) {
+			idx->typed = switch_core_alloc(root->user_index_pool, sizeof(*idx->typed));
+			idx->typed->user = x_user;
+			idx->typed->pos = pos;
+		}
+	}
+
+	switch_core_hash_insert(root->user_index, index_key, idx);
+
+	return idx;
+}
+
+static void xml_user_index_pick(switch_hash_t *hash, const char *val, xml_user_ref_t **best)
+{
+	xml_user_ref_t *ref;
+
+	if (val && (ref = switch_core_hash_find(hash, val)) && (!*best || ref->pos < (*best)->pos)) {
+		*best = ref;
+	}
+}
+
+/* what find_user_in_tag() would walk to, from the index of the tag, built the first time it is asked.
+   SWITCH_STATUS_NOTIMPL when the tree goes away after the lookup or the lookup is not one it keeps */
+static switch_status_t xml_user_index_find(switch_xml_t tag, const char *ip, const char *user_name, const char *key, const char *type, switch_xml_t *user)
+{
+	switch_xml_root_t root;
+	xml_user_index_t *idx;
+	xml_user_ref_t *best = NULL, *typed;
+	char index_key[32];
+
+	if ((type && strcasecmp(type, "!pointer")) || (user_name && strcasecmp(key, "id") && strcasecmp(key, "number-alias"))) {
+		return SWITCH_STATUS_NOTIMPL;
+	}
+
+	if (!(root = xml_shared_root(tag))) {
+		return SWITCH_STATUS_NOTIMPL;
+	}
+
+	switch_snprintf(index_key, sizeof(index_key), "%p", (void *) tag);
+
+	switch_thread_rwlock_rdlock(USER_INDEX_RWLOCK);
+
+	if (!root->user_index || !(idx = switch_core_hash_find(root->user_index, index_key))) {
+		switch_thread_rwlock_unlock(USER_INDEX_RWLOCK);
+		switch_thread_rwlock_wrlock(USER_INDEX_RWLOCK);
+
+		if (!root->user_index || !(idx = switch_core_hash_find(root->user_index, index_key))) {
+			idx = xml_user_index_build(root, tag, index_key);
+		}
+	}
+
+	typed = type ? idx->typed : NULL;
+
+	if (ip) {
+		xml_user_index_pick(idx->ips, ip, &best);
+		if (typed && (!best || typed->pos < best->pos)) {
+			best = typed;
+		}
+	}
+
+	if (!best && user_name) {
+		if (!strcasecmp(key, "id")) {
+			xml_user_index_pick(idx->ids, user_name, &best);
+		}
+		xml_user_index_pick(idx->aliases, user_name, &best);
+		if (typed && (!best || typed->pos < best->pos)) {
+			best = typed;
+		}
+	}
+
+	switch_thread_rwlock_unlock(USER_INDEX_RWLOCK);
+
+	if (best) {
+		*user = best->user;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	return SWITCH_STATUS_FALSE;
+}
+
 static switch_status_t find_user_in_tag(switch_xml_t tag, const char *ip, const char *user_name,
 										const char *key, switch_event_t *params, switch_xml_t *user)
 {
 	const char *type = "!pointer";
 	const char *val;
+	switch_status_t status;
 
 	if (params && (val = switch_event_get_header(params, "user_type"))) {
 		if (!strcasecmp(val, "any")) {
@@ -1835,6 +3154,10 @@ static switch_status_t find_user_in_tag(switch_xml_t tag, const char *ip, const
 		}
 	}
 
+	if ((status = xml_user_index_find(tag, ip, user_name, key, type, user)) != SWITCH_STATUS_NOTIMPL) {
+		return status;
+	}
+
 	if (ip) {
 		if ((*user = switch_xml_find_child_multi(tag, "user", "ip", ip, "type", type, NULL))) {
 			return SWITCH_STATUS_SUCCESS;
@@ -2242,7 +3565,7 @@ SWITCH_DECLARE(void) switch_xml_free_in_thread(switch_xml_t xml, int stacksize)
 
 static char not_so_threadsafe_error_buffer[256] = "";
 
-SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main)
+static switch_status_t xml_set_root(switch_xml_t new_main, switch_bool_t preprocessed)
 {
 	switch_xml_t old_root = NULL;
 
@@ -2250,7 +3573,9 @@ SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main)
 
 	old_root = MAIN_XML_ROOT;
 	MAIN_XML_ROOT = new_main;
+	PREPROCESSED_ROOT = preprocessed ? new_main : NULL;
 	switch_set_flag(MAIN_XML_ROOT, SWITCH_XML_ROOT);
+	((switch_xml_root_t) MAIN_XML_ROOT)->user_indexed = 1;
 	MAIN_XML_ROOT->refs++;
 
 	if (old_root) {
@@ -2268,6 +3593,11 @@ SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main)
+{
+	return xml_set_root(new_main, SWITCH_FALSE);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_xml_set_open_root_function(switch_xml_open_root_function_t func, void *user_data)
 {
 	if (XML_LOCK) {
@@ -2312,6 +3642,7 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 	char path_buf[1024];
 	uint8_t errcnt = 0;
 	switch_xml_t new_main, r = NULL;
+	switch_bool_t keep;
 
 	if (MAIN_XML_ROOT) {
 		if (!reload) {
@@ -2320,8 +3651,11 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 		}
 	}
 
+	/* the tree in use can stay when none of the files it came from changed */
+	keep = MAIN_XML_ROOT && MAIN_XML_ROOT == PREPROCESSED_ROOT;
+
 	switch_snprintf(path_buf, sizeof(path_buf), "%s%s%s", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_GLOBAL_filenames.conf_name);
-	if ((new_main = switch_xml_parse_file(path_buf))) {
+	if ((new_main = xml_parse_file(path_buf, SWITCH_TRUE, &keep))) {
 		*err = switch_xml_error(new_main);
 		switch_copy_string(not_so_threadsafe_error_buffer, *err, sizeof(not_so_threadsafe_error_buffer));
 		*err = not_so_threadsafe_error_buffer;
@@ -2331,9 +3665,11 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 			errcnt++;
 		} else {
 			*err = "Success";
-			switch_xml_set_root(new_main);
+			xml_set_root(new_main, SWITCH_TRUE);
 
 		}
+	} else if (keep) {
+		*err = "Success";
 	} else {
 		*err = "Cannot Open log directory or XML Root!";
 		errcnt++;
@@ -2370,8 +3706,13 @@ SWITCH_DECLARE(switch_status_t) switch_xml_init(switch_memory_pool_t *pool, cons
 	switch_mutex_init(&XML_LOCK, SWITCH_MUTEX_NESTED, XML_MEMORY_POOL);
 	switch_mutex_init(&REFLOCK, SWITCH_MUTEX_NESTED, XML_MEMORY_POOL);
 	switch_mutex_init(&FILE_LOCK, SWITCH_MUTEX_NESTED, XML_MEMORY_POOL);
+	switch_thread_rwlock_create(&USER_INDEX_RWLOCK, XML_MEMORY_POOL);
 	switch_core_hash_init(&CACHE_HASH);
 	switch_core_hash_init(&CACHE_EXPIRES_HASH);
+	switch_mutex_init(&FETCH_MUTEX, SWITCH_MUTEX_NESTED, XML_MEMORY_POOL);
+	switch_core_hash_init(&FETCH_HASH);
+	switch_core_hash_init(&XML_CACHE.hash);
+	XML_CACHE.max = 1000;
 
 	switch_thread_rwlock_create(&B_RWLOCK, XML_MEMORY_POOL);
 
@@ -2396,6 +3737,7 @@ SWITCH_DECLARE(switch_status_t) switch_xml_destroy(void)
 	if (MAIN_XML_ROOT) {
 		switch_xml_t xml = MAIN_XML_ROOT;
 		MAIN_XML_ROOT = NULL;
+		PREPROCESSED_ROOT = NULL;
 		switch_xml_free(xml);
 		status = SWITCH_STATUS_SUCCESS;
 	}
@@ -2403,9 +3745,17 @@ SWITCH_DECLARE(switch_status_t) switch_xml_destroy(void)
 	switch_mutex_unlock(XML_LOCK);
 	switch_mutex_unlock(REFLOCK);
 
+	switch_mutex_lock(FILE_LOCK);
+	xml_pp_run_clear(&XML_PP.last);
+	memset(&XML_PP.stats, 0, sizeof(XML_PP.stats));
+	switch_mutex_unlock(FILE_LOCK);
+
 	switch_xml_clear_user_cache(NULL, NULL, NULL);
+	switch_xml_cache_flush();
 
 	switch_core_hash_destroy(&CACHE_HASH);
+	switch_core_hash_destroy(&XML_CACHE.hash);
+	switch_core_hash_destroy(&FETCH_HASH);
 
 	return status;
 }
@@ -2796,6 +4146,8 @@ SWITCH_DECLARE(void) switch_xml_free(switch_xml_t xml)
 			free(root->m);		/* malloced xml data */
 		if (root->u)
 			free(root->u);		/* utf8 conversion */
+		if (root->user_index)
+			xml_user_index_destroy(root);
 	}
 
 	switch_xml_free_attr(xml->attr);	/* tag attributes */
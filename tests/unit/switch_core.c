@@ -34,6 +34,30 @@
 
 #include <test/switch_test.h>
 
+#define BENCH_POOLS 2000
+#define BENCH_POOL_ALLOCS 8
+
+/* what a short session does with its pool, under a tag of its own */
+static switch_time_t bench_pools(switch_memory_pool_t **pools)
+{
+	switch_time_t start = switch_time_now();
+	int x, i;
+
+	for (x = 0; x < BENCH_POOLS; x++) {
+		switch_core_perform_new_memory_pool(&pools[x], "bench_pools", __SWITCH_FUNC__, 1);
+
+		for (i = 0; i < BENCH_POOL_ALLOCS; i++) {
+			switch_core_alloc(pools[x], 512);
+		}
+	}
+
+	for (x = 0; x < BENCH_POOLS; x++) {
+		switch_core_destroy_memory_pool(&pools[x]);
+	}
+
+	return switch_time_now() - start;
+}
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_ivr_originate)
@@ -82,6 +106,87 @@ FST_CORE_BEGIN("./conf")
 			switch_safe_free(var_default_password);
 		}
 		FST_TEST_END()
+
+		FST_TEST_BEGIN(memory_pool_recycle)
+		{
+			switch_memory_pool_t *pools[BENCH_POOLS];
+			switch_memory_pool_stats_t stats = { 0 };
+			switch_time_t fresh, recycled;
+			uint32_t i;
+
+			switch_core_memory_pool_set_stats(SWITCH_TRUE);
+			switch_core_memory_pool_set_recycle(BENCH_POOLS);
+			switch_core_memory_reclaim();
+
+			fresh = bench_pools(pools);
+
+			/* destroyed pools are cleared for reuse a second after, by the pool thread */
+			switch_yield(3000000);
+
+			recycled = bench_pools(pools);
+
+			for (i = 0; switch_core_memory_pool_get_stats(i, &stats) == SWITCH_STATUS_SUCCESS; i++) {
+				if (!strcmp(stats.tag, "bench_pools:1")) {
+					break;
+				}
+			}
+
+			fst_check_string_equals(stats.tag, "bench_pools:1");
+			fst_check(stats.created == BENCH_POOLS * 2);
+			fst_check(stats.recycled >= BENCH_POOLS);
+			fst_check(stats.live == 0);
+			fst_check(stats.allocs == BENCH_POOLS * BENCH_POOL_ALLOCS * 2);
+			fst_check(stats.bytes == BENCH_POOLS * BENCH_POOL_ALLOCS * 2 * 512);
+
+			printf("%d pools: %.2f us each created, %.2f us each recycled\n", BENCH_POOLS, fresh / (double) BENCH_POOLS, recycled / (double) BENCH_POOLS);
+
+			switch_core_memory_pool_set_recycle(100);
+			switch_core_memory_pool_set_stats(SWITCH_FALSE);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(g711_packet_energy)
+		{
+			const char *names[] = { "PCMU", "PCMA" };
+			int16_t linear[160], decoded[160];
+			uint8_t encoded[160];
+			uint32_t encoded_len, decoded_len, rate, flag, expected, energy;
+			switch_frame_t frame = { 0 };
+			switch_codec_t codec = { 0 };
+			int i, n;
+
+			for (i = 0; i < 160; i++) {
+				linear[i] = (int16_t) ((i % 2 ? -1 : 1) * (i * 97 % 4000));
+			}
+
+			for (n = 0; n < 2; n++) {
+				fst_requires(switch_core_codec_init(&codec, names[n], NULL, NULL, 8000, 20, 1,
+													SWITCH_CODEC_FLAG_ENCODE | SWITCH_CODEC_FLAG_DECODE, NULL, fst_pool) == SWITCH_STATUS_SUCCESS);
+
+				encoded_len = sizeof(encoded);
+				flag = 0;
+				switch_core_codec_encode(&codec, NULL, linear, sizeof(linear), 8000, encoded, &encoded_len, &rate, &flag);
+				decoded_len = sizeof(decoded);
+				flag = 0;
+				switch_core_codec_decode(&codec, NULL, encoded, encoded_len, 8000, decoded, &decoded_len, &rate, &flag);
+
+				for (i = 0, expected = 0; i < 160; i++) {
+					expected += abs(decoded[i]);
+				}
+				expected /= 160;
+
+				/* the packet level matches the decoded audio without decoding it */
+				frame.codec = &codec;
+				frame.data = encoded;
+				frame.datalen = encoded_len;
+				fst_check(switch_core_codec_control(&codec, SCC_AUDIO_PACKET_ENERGY, SCCT_NONE, &frame, SCCT_INT, &energy, NULL, NULL) == SWITCH_STATUS_SUCCESS);
+				fst_check_int_equals(energy, expected);
+				fst_check(energy > 1000);
+
+				switch_core_codec_destroy(&codec);
+			}
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 }
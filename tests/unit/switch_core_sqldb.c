@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <switch.h>
+#include <test/switch_test.h>
+
+#define BENCH_ROWS 20000
+#define QUEUE_DSN "test_sqldb_queue"
+#define POOL_DSN "sqlite://:memory:"
+#define POOL_THREADS 16
+#define POOL_LOOPS 2000
+
+static int count_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+  int *count = (int *) pArg;
+
+  (*count)++;
+  return 0;
+}
+
+static int rows_in(switch_cache_db_handle_t *dbh, const char *table)
+{
+  char sql[128], res[32] = "";
+
+  switch_snprintf(sql, sizeof(sql), "select count(*) from %s", table);
+  switch_cache_db_execute_sql2str(dbh, sql, res, sizeof(res), NULL);
+
+  return atoi(res);
+}
+
+/* the same inserts once printed into the text and once bound to one prepared statement */
+static switch_time_t bench_inserts(switch_cache_db_handle_t *dbh, switch_bool_t params)
+{
+  switch_time_t start = switch_time_now();
+  char id[32], name[64];
+  const char *argv[3] = { id, name, NULL };
+  int x;
+
+  switch_cache_db_execute_sql(dbh, "begin", NULL);
+
+  for (x = 0; x < BENCH_ROWS; x++) {
+    switch_snprintf(id, sizeof(id), "%d", x);
+    switch_snprintf(name, sizeof(name), "channel-%d", x);
+
+    if (params) {
+      switch_cache_db_execute_sql_params(dbh, "insert into bench (id, name, extra) values (?, ?, ?)", 3, argv, NULL, NULL, NULL);
+    } else {
+      char *sql = switch_mprintf("insert into bench (id, name, extra) values ('%q', '%q', NULL)", id, name);
+
+      switch_cache_db_execute_sql(dbh, sql, NULL);
+      switch_safe_free(sql);
+    }
+  }
+
+  switch_cache_db_execute_sql(dbh, "commit", NULL);
+
+  return switch_time_now() - start;
+}
+
+/* pushes BENCH_ROWS single row inserts, one of them a duplicate key, with other statements mixed in */
+static switch_time_t bench_queue(uint32_t bulk_rows, int *rows, int *others)
+{
+  switch_sql_queue_manager_t *qm = NULL;
+  switch_cache_db_handle_t *dbh = NULL;
+  switch_time_t start;
+  int x;
+
+  if (switch_cache_db_get_db_handle_dsn(&dbh, QUEUE_DSN) != SWITCH_STATUS_SUCCESS) {
+    return 0;
+  }
+
+  switch_cache_db_execute_sql(dbh, "drop table if exists queued", NULL);
+  switch_cache_db_execute_sql(dbh, "create table queued (id integer primary key, name varchar(64))", NULL);
+  switch_cache_db_execute_sql(dbh, "drop table if exists other", NULL);
+  switch_cache_db_execute_sql(dbh, "create table other (id integer)", NULL);
+
+  switch_sql_queue_manager_init_name("bench", &qm, 1, QUEUE_DSN, 1000, NULL, NULL, NULL, NULL);
+  switch_sql_queue_manager_set_bulk_rows(qm, bulk_rows);
+  switch_sql_queue_manager_start(qm);
+  switch_sleep(500000);
+
+  start = switch_time_now();
+
+  for (x = 0; x < BENCH_ROWS; x++) {
+    switch_sql_queue_manager_push(qm, switch_mprintf("insert into queued (id, name) values (%d, 'channel-%d');", x == 500 ? 499 : x, x), 0, SWITCH_FALSE);
+
+    if (x % 1000 == 0) {
+      switch_sql_queue_manager_push(qm, "insert into other values (1)", 0, SWITCH_TRUE);
+    }
+  }
+
+  for (x = 0; x < 1000 && (*rows = rows_in(dbh, "queued")) < BENCH_ROWS - 1; x++) {
+    switch_yield(10000);
+  }
+
+  start = switch_time_now() - start;
+
+  *others = rows_in(dbh, "other");
+
+  switch_sql_queue_manager_destroy(&qm);
+  switch_cache_db_release_db_handle(&dbh);
+
+  return start;
+}
+
+/* a thread doing what a request handler does: get a handle, run a query and give it back */
+static void *SWITCH_THREAD_FUNC pool_thread(switch_thread_t *thread, void *obj)
+{
+  int *done = (int *) obj;
+  switch_cache_db_handle_t *dbh = NULL;
+  char res[32];
+  int x;
+
+  for (x = 0; x < POOL_LOOPS; x++) {
+    if (switch_cache_db_get_db_handle_dsn(&dbh, POOL_DSN) != SWITCH_STATUS_SUCCESS) {
+      continue;
+    }
+
+    if (switch_cache_db_execute_sql2str(dbh, "select 1", res, sizeof(res), NULL) && !strcmp(res, "1")) {
+      (*done)++;
+    }
+
+    switch_cache_db_release_db_handle(&dbh);
+  }
+
+  return NULL;
+}
+
+static void *SWITCH_THREAD_FUNC hold_thread(switch_thread_t *thread, void *obj)
+{
+  switch_cache_db_handle_t **held = (switch_cache_db_handle_t **) obj;
+  switch_cache_db_handle_t *dbh = NULL;
+
+  if (switch_cache_db_get_db_handle_dsn(&dbh, POOL_DSN) == SWITCH_STATUS_SUCCESS) {
+    *held = dbh;
+    switch_yield(200000);
+    switch_cache_db_release_db_handle(&dbh);
+  }
+
+  return NULL;
+}
+
+FST_CORE_BEGIN("./conf")
+
+FST_SUITE_BEGIN(switch_core_sqldb)
+
+FST_SETUP_BEGIN()
+{
+}
+FST_SETUP_END()
+
+FST_TEARDOWN_BEGIN()
+{
+}
+FST_TEARDOWN_END()
+
+FST_TEST_BEGIN(prepared_statements)
+{
+  switch_cache_db_handle_t *dbh = NULL;
+  switch_stream_handle_t stream = { 0 };
+  const char *row1[] = { "1", "it's", NULL };
+  const char *row2[] = { "2", "two", "x" };
+  const char *where[] = { "it's" };
+  int count = 0;
+
+  fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, "sqlite://:memory:") == SWITCH_STATUS_SUCCESS);
+
+  fst_check(switch_cache_db_execute_sql(dbh, "create table params (id integer, name varchar(64), extra varchar(64))", NULL) == SWITCH_STATUS_SUCCESS);
+  fst_check(switch_cache_db_execute_sql_params(dbh, "insert into params values (?, ?, ?)", 3, row1, NULL, NULL, NULL) == SWITCH_STATUS_SUCCESS);
+  fst_check(switch_cache_db_execute_sql_params(dbh, "insert into params values (?, ?, ?)", 3, row2, NULL, NULL, NULL) == SWITCH_STATUS_SUCCESS);
+
+  fst_check(switch_cache_db_execute_sql_params(dbh, "select * from params where name = ? and extra is null", 1, where, count_callback, &count, NULL) == SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(count, 1);
+  fst_check_int_equals(rows_in(dbh, "params"), 2);
+
+  /* a bad statement is reported and not cached */
+  fst_check(switch_cache_db_execute_sql_params(dbh, "select * from missing where id = ?", 1, row1, NULL, NULL, NULL) != SWITCH_STATUS_SUCCESS);
+
+  SWITCH_STANDARD_STREAM(stream);
+  switch_cache_db_status(&stream);
+  fst_check(strstr((char *) stream.data, "Prepared: 2 cached, 1 hits, 3 misses") != NULL);
+  switch_safe_free(stream.data);
+
+  switch_cache_db_release_db_handle(&dbh);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(handle_pool)
+{
+  switch_cache_db_handle_t *first = NULL, *again = NULL, *nested = NULL, *held = NULL;
+  switch_thread_t *threads[POOL_THREADS];
+  switch_threadattr_t *thd_attr = NULL;
+  switch_stream_handle_t stream = { 0 };
+  switch_status_t st;
+  switch_time_t start;
+  int done[POOL_THREADS] = { 0 };
+  int x, total = 0;
+
+  /* released and asked for again by the same thread, it gets the same connection back */
+  fst_requires(switch_cache_db_get_db_handle_dsn(&first, POOL_DSN) == SWITCH_STATUS_SUCCESS);
+  again = first;
+  switch_cache_db_release_db_handle(&first);
+  fst_requires(switch_cache_db_get_db_handle_dsn(&first, POOL_DSN) == SWITCH_STATUS_SUCCESS);
+  fst_check(first == again);
+
+  /* and while it still holds it too */
+  fst_requires(switch_cache_db_get_db_handle_dsn(&nested, POOL_DSN) == SWITCH_STATUS_SUCCESS);
+  fst_check(nested == first);
+  switch_cache_db_release_db_handle(&nested);
+  switch_cache_db_release_db_handle(&first);
+
+  /* another thread holding it does not share it */
+  switch_threadattr_create(&thd_attr, fst_pool);
+  switch_thread_create(&threads[0], thd_attr, hold_thread, &held, fst_pool);
+  for (x = 0; x < 100 && !held; x++) {
+    switch_yield(10000);
+  }
+  fst_requires(switch_cache_db_get_db_handle_dsn(&first, POOL_DSN) == SWITCH_STATUS_SUCCESS);
+  fst_check(held && first != held);
+  switch_cache_db_release_db_handle(&first);
+  switch_thread_join(&st, threads[0]);
+
+  start = switch_time_now();
+
+  for (x = 0; x < POOL_THREADS; x++) {
+    switch_thread_create(&threads[x], thd_attr, pool_thread, &done[x], fst_pool);
+  }
+
+  for (x = 0; x < POOL_THREADS; x++) {
+    switch_thread_join(&st, threads[x]);
+    total += done[x];
+  }
+
+  printf("%d threads: %d handle round trips, %.2f us each\n", POOL_THREADS, total, (switch_time_now() - start) / (double) total);
+  fst_check_int_equals(total, POOL_THREADS * POOL_LOOPS);
+
+  SWITCH_STANDARD_STREAM(stream);
+  switch_cache_db_status(&stream);
+  fst_check(strstr((char *) stream.data, "by the same thread") != NULL);
+  switch_safe_free(stream.data);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_prepared_inserts)
+{
+  switch_cache_db_handle_t *dbh = NULL;
+  switch_time_t text, params;
+
+  fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, "sqlite://:memory:") == SWITCH_STATUS_SUCCESS);
+
+  switch_cache_db_execute_sql(dbh, "create table bench (id integer, name varchar(64), extra varchar(64))", NULL);
+
+  text = bench_inserts(dbh, SWITCH_FALSE);
+  params = bench_inserts(dbh, SWITCH_TRUE);
+
+  fst_check_int_equals(rows_in(dbh, "bench"), BENCH_ROWS * 2);
+
+  printf("%d inserts: %.2f us each as text, %.2f us each prepared\n", BENCH_ROWS, text / (double) BENCH_ROWS, params / (double) BENCH_ROWS);
+
+  switch_cache_db_release_db_handle(&dbh);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(queue_bulk_insert_bad_row)
+{
+  switch_sql_queue_manager_t *qm = NULL;
+  switch_cache_db_handle_t *dbh = NULL;
+  char path[1024], res[32] = "";
+  int x, rows = 0;
+
+  fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, QUEUE_DSN) == SWITCH_STATUS_SUCCESS);
+  switch_cache_db_execute_sql(dbh, "drop table if exists queued", NULL);
+  switch_cache_db_execute_sql(dbh, "create table queued (id integer primary key, name varchar(64))", NULL);
+  switch_cache_db_execute_sql(dbh, "drop table if exists other", NULL);
+  switch_cache_db_execute_sql(dbh, "create table other (id integer)", NULL);
+
+  switch_sql_queue_manager_init_name("bad_row", &qm, 1, QUEUE_DSN, 1000, NULL, NULL, NULL, NULL);
+  switch_sql_queue_manager_set_bulk_rows(qm, 10);
+  switch_sql_queue_manager_start(qm);
+  switch_sleep(500000);
+
+  /* queued while paused so the ten inserts go out as one statement, the sixth repeats the fifth's key */
+  switch_sql_queue_manager_pause(qm, SWITCH_FALSE);
+  for (x = 0; x < 10; x++) {
+    switch_sql_queue_manager_push(qm, switch_mprintf("insert into queued (id, name) values (%d, 'channel-%d');", x == 5 ? 4 : x, x), 0, SWITCH_FALSE);
+  }
+  switch_sql_queue_manager_push(qm, "insert into other values (1)", 0, SWITCH_TRUE);
+  switch_sql_queue_manager_resume(qm);
+
+  for (x = 0; x < 200 && rows_in(dbh, "other") < 1; x++) {
+    switch_yield(10000);
+  }
+
+  /* the other rows of the batch and the statement behind it still make it in */
+  rows = rows_in(dbh, "queued");
+  fst_check_int_equals(rows, 9);
+  fst_check_int_equals(rows_in(dbh, "other"), 1);
+  switch_cache_db_execute_sql2str(dbh, "select name from queued where id = 4", res, sizeof(res), NULL);
+  fst_check_string_equals(res, "channel-4");
+
+  switch_sql_queue_manager_destroy(&qm);
+  switch_cache_db_release_db_handle(&dbh);
+
+  switch_snprintf(path, sizeof(path), "%s%s%s.db", SWITCH_GLOBAL_dirs.db_dir, SWITCH_PATH_SEPARATOR, QUEUE_DSN);
+  unlink(path);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_queue_bulk_inserts)
+{
+  switch_time_t single, bulk;
+  int single_rows = 0, bulk_rows = 0, single_others = 0, bulk_others = 0;
+  char path[1024];
+
+  single = bench_queue(0, &single_rows, &single_others);
+  bulk = bench_queue(100, &bulk_rows, &bulk_others);
+
+  /* the duplicate key only costs its own row */
+  fst_check_int_equals(single_rows, BENCH_ROWS - 1);
+  fst_check_int_equals(bulk_rows, BENCH_ROWS - 1);
+  fst_check_int_equals(single_others, BENCH_ROWS / 1000);
+  fst_check_int_equals(bulk_others, BENCH_ROWS / 1000);
+
+  printf("%d queued inserts: %.2f us each one by one, %.2f us each coalesced\n", BENCH_ROWS, single / (double) BENCH_ROWS, bulk / (double) BENCH_ROWS);
+
+  switch_snprintf(path, sizeof(path), "%s%s%s.db", SWITCH_GLOBAL_dirs.db_dir, SWITCH_PATH_SEPARATOR, QUEUE_DSN);
+  unlink(path);
+}
+FST_TEST_END()
+
+FST_SUITE_END()
+
+FST_CORE_END()
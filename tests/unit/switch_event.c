@@ -4,7 +4,17 @@
 
 // #define BENCHMARK 1
 
-FST_MINCORE_BEGIN()
+static int delivered = 0;
+
+static void count_event(switch_event_t *event)
+{
+  /* the core fires its own events through the ALL binding too, only count ours */
+  if (switch_event_get_header(event, "Test-Benchmark")) {
+    delivered++;
+  }
+}
+
+FST_CORE_BEGIN("./conf")
 
 FST_SUITE_BEGIN(switch_event)
 
@@ -107,9 +117,251 @@ FST_TEST_BEGIN(benchmark)
 }
 FST_TEST_END()
 
+FST_TEST_BEGIN(benchmark_deliver)
+{
+  switch_event_t *event = NULL;
+  switch_time_t start_ts, end_ts;
+  int loops = 10000, bindings = 100, x = 0;
+  char subclass[80] = "";
+  unsigned long long micro_total = 0;
+  double micro_per = 0;
+  double rate_per_sec = 0;
+
+  /* a box with lots of custom subclass consumers, a couple of catch-all ones and a file: filter */
+  for (x = 0; x < bindings; x++) {
+    switch_snprintf(subclass, sizeof(subclass), "test::bench::%d", x);
+    fst_requires(switch_event_bind("test", SWITCH_EVENT_CUSTOM, subclass, count_event, NULL) == SWITCH_STATUS_SUCCESS);
+  }
+  fst_requires(switch_event_bind("test", SWITCH_EVENT_CUSTOM, SWITCH_EVENT_SUBCLASS_ANY, count_event, NULL) == SWITCH_STATUS_SUCCESS);
+  fst_requires(switch_event_bind("test", SWITCH_EVENT_ALL, SWITCH_EVENT_SUBCLASS_ANY, count_event, NULL) == SWITCH_STATUS_SUCCESS);
+  fst_requires(switch_event_bind("test", SWITCH_EVENT_CUSTOM, "file:switch_event.c", count_event, NULL) == SWITCH_STATUS_SUCCESS);
+
+  /* exact subclass + custom catch-all + ALL, the file: filter does not match (no file header) */
+  delivered = 0;
+  switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::bench::42");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Benchmark", "true");
+  switch_event_deliver(&event);
+  fst_check_int_equals(delivered, 3);
+
+  /* unknown subclass only reaches the catch-all consumers and the matching file: filter */
+  delivered = 0;
+  switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::bench::unbound");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Benchmark", "true");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "file", "switch_event.c");
+  switch_event_deliver(&event);
+  fst_check_int_equals(delivered, 3);
+
+  /* non custom events only see the ALL consumer */
+  delivered = 0;
+  switch_event_create(&event, SWITCH_EVENT_MESSAGE);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Benchmark", "true");
+  switch_event_deliver(&event);
+  fst_check_int_equals(delivered, 1);
+
+  delivered = 0;
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::bench::42");
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Benchmark", "true");
+    switch_event_deliver(&event);
+  }
+  end_ts = switch_time_now();
+  fst_check_int_equals(delivered, loops * 3);
+
+  switch_event_unbind_callback(count_event);
+
+  micro_total = end_ts - start_ts;
+  micro_per = micro_total / (double) loops;
+  rate_per_sec = 1000000 / micro_per;
+  printf("switch_event deliver with %d bindings: Total %lluus / %d loops, %.2f us per loop, %.0f loops per second\n",
+       bindings + 3, micro_total, loops, micro_per, rate_per_sec);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_create)
+{
+  switch_event_t *event = NULL, *clone = NULL;
+  switch_time_t start_ts, end_ts;
+  int loops = 10000, headers = 40, x = 0, y = 0;
+  char name[80] = "";
+  unsigned long long micro_total = 0;
+  double micro_per = 0;
+  double rate_per_sec = 0;
+
+  /* short names and values are stored inline, long ones still go to the heap */
+  switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "short", "value");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "long",
+    "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789");
+  switch_event_add_header(event, SWITCH_STACK_BOTTOM, "formatted", "%d-%s", 42, "fortytwo");
+  fst_check_string_equals(switch_event_get_header(event, "short"), "value");
+  fst_check_string_equals(switch_event_get_header(event, "formatted"), "42-fortytwo");
+  fst_check(strlen(switch_event_get_header(event, "long")) == 100);
+
+  /* replacing a unique header with its own value must not read released memory */
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "short", switch_event_get_header(event, "short"));
+  fst_check_string_equals(switch_event_get_header(event, "short"), "value");
+
+  /* an inline value turns into an array */
+  switch_event_add_header_string(event, SWITCH_STACK_PUSH, "short", "other");
+  fst_check_string_equals(switch_event_get_header(event, "short"), "ARRAY::value|:other");
+  fst_check_string_equals(switch_event_get_header_idx(event, "short", 1), "other");
+
+  switch_event_rename_header(event, "short", "a-much-longer-header-name");
+  fst_check_string_equals(switch_event_get_header_idx(event, "a-much-longer-header-name", 0), "value");
+  switch_event_destroy(&event);
+
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_create(&event, SWITCH_EVENT_CHANNEL_STATE);
+    for (y = 0; y < headers; y++) {
+      switch_snprintf(name, sizeof(name), "Channel-Header-%d", y);
+      switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, name, "b0ed4a4c-4a41-4da4-8fe0-a4e1bd6ccbd8");
+    }
+    switch_event_dup(&clone, event);
+    switch_event_destroy(&clone);
+    switch_event_destroy(&event);
+  }
+  end_ts = switch_time_now();
+
+  micro_total = end_ts - start_ts;
+  micro_per = micro_total / (double) loops;
+  rate_per_sec = 1000000 / micro_per;
+  printf("switch_event create/dup/destroy with %d headers: Total %lluus / %d loops, %.2f us per loop, %.0f loops per second\n",
+       headers, micro_total, loops, micro_per, rate_per_sec);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_share)
+{
+  switch_event_t *event = NULL, *clone = NULL;
+  switch_event_shared_t *shared[20] = { 0 };
+  switch_time_t start_ts, end_ts;
+  int loops = 1000, consumers = 20, x = 0, y = 0;
+  char *str = NULL;
+  const char *plain = NULL;
+  unsigned long long dup_total = 0, share_total = 0;
+
+  /* every consumer gets the same copy and the same rendering */
+  switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Share", "true");
+  shared[0] = switch_event_share(event);
+  shared[1] = switch_event_share(event);
+  fst_requires(shared[0]);
+  fst_check(shared[0] == shared[1]);
+  switch_event_destroy(&event);
+
+  fst_check_string_equals(switch_event_get_header(switch_event_shared_get_event(shared[0]), "Test-Share"), "true");
+  plain = switch_event_shared_serialize(shared[0], SWITCH_EVENT_SERIAL_PLAIN);
+  fst_requires(plain);
+  fst_check(plain == switch_event_shared_serialize(shared[1], SWITCH_EVENT_SERIAL_PLAIN));
+  fst_check(strstr(plain, "Test-Share: true") != NULL);
+  fst_check(strstr(switch_event_shared_serialize(shared[0], SWITCH_EVENT_SERIAL_JSON), "\"Test-Share\"") != NULL);
+  fst_check(strstr(switch_event_shared_serialize(shared[0], SWITCH_EVENT_SERIAL_XML), "<Test-Share>") != NULL);
+  switch_event_shared_release(&shared[0]);
+  fst_check(shared[0] == NULL);
+  switch_event_shared_release(&shared[1]);
+
+  /* fanning one event out to many plain consumers, copy per consumer vs one shared copy */
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Share", "true");
+    for (y = 0; y < consumers; y++) {
+      switch_event_dup(&clone, event);
+      switch_event_serialize(clone, &str, SWITCH_TRUE);
+      switch_safe_free(str);
+      switch_event_destroy(&clone);
+    }
+    switch_event_destroy(&event);
+  }
+  end_ts = switch_time_now();
+  dup_total = end_ts - start_ts;
+
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Test-Share", "true");
+    for (y = 0; y < consumers; y++) {
+      shared[y] = switch_event_share(event);
+    }
+    switch_event_destroy(&event);
+    for (y = 0; y < consumers; y++) {
+      switch_event_shared_serialize(shared[y], SWITCH_EVENT_SERIAL_PLAIN);
+      switch_event_shared_release(&shared[y]);
+    }
+  }
+  end_ts = switch_time_now();
+  share_total = end_ts - start_ts;
+
+  printf("switch_event fan out to %d consumers: dup %lluus, shared %lluus / %d loops\n",
+       consumers, dup_total, share_total, loops);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_get_header)
+{
+  switch_event_t *event = NULL;
+  switch_event_header_t *hp;
+  switch_time_t start_ts, end_ts;
+  int loops = 100000, headers = 200, x = 0;
+  char name[80] = "";
+  unsigned long long micro_total = 0;
+  double micro_per = 0;
+  double rate_per_sec = 0;
+
+  /* a channel variable sized event, big enough to be indexed */
+  switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA);
+  for (x = 0; x < headers; x++) {
+    switch_snprintf(name, sizeof(name), "variable_bench_%d", x);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, name, "value");
+  }
+  fst_requires(event->header_index);
+  fst_check_string_equals(switch_event_get_header(event, "VARIABLE_BENCH_199"), "value");
+  fst_check(switch_event_get_header(event, "variable_bench_200") == NULL);
+
+  /* the first header of a name wins until it's deleted */
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "dup", "bottom");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "dup", "later");
+  fst_check_string_equals(switch_event_get_header(event, "dup"), "bottom");
+  switch_event_add_header_string(event, SWITCH_STACK_TOP, "dup", "top");
+  fst_check_string_equals(switch_event_get_header(event, "dup"), "top");
+  switch_event_del_header_val(event, "dup", "top");
+  fst_check_string_equals(switch_event_get_header(event, "dup"), "bottom");
+  switch_event_del_header(event, "dup");
+  fst_check(switch_event_get_header(event, "dup") == NULL);
+
+  for (x = 0; x < headers; x += 2) {
+    switch_snprintf(name, sizeof(name), "variable_bench_%d", x);
+    switch_event_del_header(event, name);
+  }
+  fst_check(switch_event_get_header(event, "variable_bench_100") == NULL);
+  fst_check_string_equals(switch_event_get_header(event, "variable_bench_101"), "value");
+  for (hp = event->headers, x = 0; hp; hp = hp->next) x++;
+  fst_check(event->header_count == (uint32_t) x);
+
+  switch_event_rename_header(event, "variable_bench_101", "renamed");
+  fst_check(switch_event_get_header(event, "variable_bench_101") == NULL);
+  fst_check_string_equals(switch_event_get_header(event, "renamed"), "value");
+
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_get_header(event, "variable_bench_199");
+  }
+  end_ts = switch_time_now();
+  switch_event_destroy(&event);
+
+  micro_total = end_ts - start_ts;
+  micro_per = micro_total / (double) loops;
+  rate_per_sec = 1000000 / micro_per;
+  printf("switch_event get_header with %d headers: Total %lluus / %d loops, %.2f us per loop, %.0f loops per second\n",
+       headers / 2, micro_total, loops, micro_per, rate_per_sec);
+}
+FST_TEST_END()
+
 FST_SUITE_END()
 
-FST_MINCORE_END()
+FST_CORE_END()
 
 
 
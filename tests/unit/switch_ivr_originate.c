@@ -67,6 +67,61 @@ static switch_state_handler_table_t state_handlers = {
     SSH_FLAG_STICKY
 };
 
+static int registry_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	switch_channel_t *channel = (switch_channel_t *) pArg;
+
+	/* stop the walk on the channel itself */
+	return !strcmp(columnNames[0], "uuid") && !strcmp(argv[0], switch_channel_get_uuid(channel)) &&
+		!strcmp(columnNames[4], "name") && !strcmp(argv[4], switch_channel_get_name(channel));
+}
+
+/* the registry follows the channel events, give the dispatch threads a moment to catch up */
+static switch_bool_t registry_has_channel(const char *uuid, switch_bool_t expected)
+{
+	switch_channel_registry_filter_t filter = { 0 };
+	int x;
+
+	filter.like = uuid;
+
+	for (x = 0; x < 50; x++) {
+		if ((switch_core_channel_registry_query(SCR_VIEW_CHANNELS, &filter, NULL, NULL) == 1) == expected) {
+			break;
+		}
+		switch_sleep(20000);
+	}
+
+	return switch_core_channel_registry_query(SCR_VIEW_CHANNELS, &filter, NULL, NULL) == 1;
+}
+
+static switch_bool_t registry_has_rows(switch_channel_registry_view_t view, const switch_channel_registry_filter_t *filter, uint32_t expected)
+{
+	int x;
+
+	for (x = 0; x < 50; x++) {
+		if (switch_core_channel_registry_query(view, filter, NULL, NULL) == expected) {
+			return SWITCH_TRUE;
+		}
+		switch_sleep(20000);
+	}
+
+	return SWITCH_FALSE;
+}
+
+static void registry_fire_bridge(switch_event_types_t event_id, const char *a_uuid, const char *b_uuid)
+{
+	switch_event_t *event;
+
+	if (switch_event_create(&event, event_id) == SWITCH_STATUS_SUCCESS) {
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Unique-ID", a_uuid);
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Caller-Unique-ID", a_uuid);
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Bridge-A-Unique-ID", a_uuid);
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Bridge-B-Unique-ID", b_uuid);
+		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-Call-UUID", a_uuid);
+		switch_event_fire(&event);
+	}
+}
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_ivr_originate)
@@ -133,6 +188,135 @@ FST_CORE_BEGIN("./conf")
 			fst_check(destroy == 2);
 		}
 		FST_TEST_END()
+
+		FST_TEST_BEGIN(originate_test_channel_registry)
+		{
+			switch_core_session_t *session = NULL;
+			switch_channel_t *channel = NULL;
+			switch_status_t status;
+			switch_call_cause_t cause;
+			char uuid[SWITCH_UUID_FORMATTED_LENGTH + 1];
+			switch_channel_registry_filter_t filter = { 0 };
+			uint32_t rows;
+
+			status = switch_ivr_originate(NULL, &session, &cause, "null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+			fst_requires(session);
+			fst_check(status == SWITCH_STATUS_SUCCESS);
+
+			channel = switch_core_session_get_channel(session);
+			fst_requires(channel);
+			switch_copy_string(uuid, switch_channel_get_uuid(channel), sizeof(uuid));
+
+			fst_check(registry_has_channel(uuid, SWITCH_TRUE));
+			filter.like = uuid;
+
+			/* a walk stopped by the callback counts the rows up to that one */
+			rows = switch_core_channel_registry_query(SCR_VIEW_CHANNELS, NULL, registry_callback, channel);
+			fst_check(rows > 0 && rows <= switch_core_channel_registry_query(SCR_VIEW_CHANNELS, NULL, NULL, NULL));
+
+			/* not bridged, listed in basic_calls on its own */
+			fst_check(switch_core_channel_registry_query(SCR_VIEW_BASIC_CALLS, &filter, NULL, NULL) == 1);
+
+			switch_channel_hangup(channel, SWITCH_CAUSE_NORMAL_CLEARING);
+			switch_core_session_rwunlock(session);
+
+			fst_check(!registry_has_channel(uuid, SWITCH_FALSE));
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(originate_test_channel_registry_index)
+		{
+			switch_core_session_t *a_session = NULL, *b_session = NULL;
+			switch_call_cause_t cause;
+			char a_uuid[SWITCH_UUID_FORMATTED_LENGTH + 1];
+			char b_uuid[SWITCH_UUID_FORMATTED_LENGTH + 1];
+			switch_channel_registry_filter_t filter = { 0 };
+
+			switch_ivr_originate(NULL, &a_session, &cause, "{presence_id=registry-a@example.com}null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+			fst_requires(a_session);
+			switch_ivr_originate(NULL, &b_session, &cause, "{presence_id=registry-b@example.com}null/+15553335555", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+			fst_requires(b_session);
+			switch_copy_string(a_uuid, switch_core_session_get_uuid(a_session), sizeof(a_uuid));
+			switch_copy_string(b_uuid, switch_core_session_get_uuid(b_session), sizeof(b_uuid));
+
+			filter.presence_id = "registry-a@example.com";
+			fst_check(registry_has_rows(SCR_VIEW_CHANNELS, &filter, 1));
+			filter.presence_id = "registry-nobody@example.com";
+			fst_check(switch_core_channel_registry_query(SCR_VIEW_CHANNELS, &filter, NULL, NULL) == 0);
+
+			/* an unbridged channel is its own call */
+			filter.presence_id = NULL;
+			filter.call_uuid = b_uuid;
+			fst_check(registry_has_rows(SCR_VIEW_CHANNELS, &filter, 1));
+
+			/* once bridged both legs share the a leg's call_uuid and the call is listed once */
+			registry_fire_bridge(SWITCH_EVENT_CHANNEL_BRIDGE, a_uuid, b_uuid);
+			filter.call_uuid = a_uuid;
+			fst_check(registry_has_rows(SCR_VIEW_CHANNELS, &filter, 2));
+			filter.bridged_only = SWITCH_TRUE;
+			fst_check(switch_core_channel_registry_query(SCR_VIEW_BASIC_CALLS, &filter, NULL, NULL) == 1);
+			filter.bridged_only = SWITCH_FALSE;
+			filter.call_uuid = b_uuid;
+			fst_check(switch_core_channel_registry_query(SCR_VIEW_CHANNELS, &filter, NULL, NULL) == 0);
+
+			/* and each leg gets its own call_uuid back on unbridge */
+			registry_fire_bridge(SWITCH_EVENT_CHANNEL_UNBRIDGE, a_uuid, b_uuid);
+			fst_check(registry_has_rows(SCR_VIEW_CHANNELS, &filter, 1));
+			filter.call_uuid = a_uuid;
+			fst_check(switch_core_channel_registry_query(SCR_VIEW_CHANNELS, &filter, NULL, NULL) == 1);
+			filter.bridged_only = SWITCH_TRUE;
+			fst_check(switch_core_channel_registry_query(SCR_VIEW_BASIC_CALLS, &filter, NULL, NULL) == 0);
+
+			switch_channel_hangup(switch_core_session_get_channel(a_session), SWITCH_CAUSE_NORMAL_CLEARING);
+			switch_channel_hangup(switch_core_session_get_channel(b_session), SWITCH_CAUSE_NORMAL_CLEARING);
+			switch_core_session_rwunlock(a_session);
+			switch_core_session_rwunlock(b_session);
+
+			fst_check(!registry_has_channel(a_uuid, SWITCH_FALSE));
+			fst_check(!registry_has_channel(b_uuid, SWITCH_FALSE));
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(originate_test_session_shards)
+		{
+			switch_core_session_t *session = NULL;
+			switch_status_t status;
+			switch_call_cause_t cause;
+			switch_session_shard_stats_t stats;
+			uint32_t x, sessions = 0;
+			uint64_t writes = 0;
+			char uuid[SWITCH_UUID_FORMATTED_LENGTH + 1];
+
+			status = switch_ivr_originate(NULL, &session, &cause, "null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+			fst_requires(session);
+			fst_check(status == SWITCH_STATUS_SUCCESS);
+			switch_copy_string(uuid, switch_core_session_get_uuid(session), sizeof(uuid));
+
+			for (x = 0; x < switch_core_session_shard_count(); x++) {
+				fst_requires(switch_core_session_get_shard_stats(x, &stats) == SWITCH_STATUS_SUCCESS);
+				sessions += stats.sessions;
+				writes += stats.writes;
+			}
+			fst_check(switch_core_session_get_shard_stats(x, &stats) != SWITCH_STATUS_SUCCESS);
+
+			/* every session is in exactly one shard */
+			fst_check(sessions == switch_core_session_count());
+			fst_check(writes > 0);
+
+			switch_channel_hangup(switch_core_session_get_channel(session), SWITCH_CAUSE_NORMAL_CLEARING);
+			switch_core_session_rwunlock(session);
+
+			/* gone from its shard once it is destroyed */
+			for (x = 0; x < 50; x++) {
+				if (!(session = switch_core_session_locate(uuid))) {
+					break;
+				}
+				switch_core_session_rwunlock(session);
+				switch_sleep(20000);
+			}
+			fst_check(session == NULL);
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 }
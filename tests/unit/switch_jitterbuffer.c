@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <switch.h>
+#include <test/switch_test.h>
+
+#define BENCH_FRAMES 2000
+#define BENCH_FRAME_PACKETS 50
+#define BENCH_PAYLOAD 100
+#define RENACK_WAIT 120000
+
+static void jb_put(switch_jb_t *jb, uint16_t seq, uint32_t ts, int m)
+{
+  switch_rtp_packet_t packet;
+
+  memset(&packet.header, 0, sizeof(packet.header));
+  memset(packet.body, seq & 0xff, BENCH_PAYLOAD);
+  packet.header.version = 2;
+  packet.header.seq = htons(seq);
+  packet.header.ts = htonl(ts);
+  packet.header.m = m;
+
+  switch_jb_put_packet(jb, &packet, 12 + BENCH_PAYLOAD);
+}
+
+/* video frames of BENCH_FRAME_PACKETS packets, neighbours swapped and about 1% lost, read as they become ready */
+static int bench_receive(switch_memory_pool_t *pool, switch_bool_t ring, uint32_t *nacks)
+{
+  switch_jb_t *jb = NULL;
+  switch_rtp_packet_t packet;
+  switch_size_t len;
+  switch_time_t start;
+  uint16_t seq = 1000;
+  uint32_t ts = 90000;
+  int f, i, received = 0;
+
+  switch_jb_create(&jb, SJB_VIDEO, 2, 50, pool);
+  if (ring) {
+    switch_jb_set_flag(jb, SJB_RING);
+  }
+
+  *nacks = 0;
+  srand(42);
+  start = switch_time_now();
+
+  for (f = 0; f < BENCH_FRAMES; f++) {
+    for (i = 0; i < BENCH_FRAME_PACKETS; i++) {
+      int x = i ^ 1;
+
+      if (x >= BENCH_FRAME_PACKETS || rand() % 100 == 0) {
+        continue;
+      }
+
+      jb_put(jb, (uint16_t)(seq + x), ts, x == BENCH_FRAME_PACKETS - 1);
+    }
+
+    seq += BENCH_FRAME_PACKETS;
+    ts += 3000;
+
+    while (switch_jb_pop_nack(jb)) {
+      (*nacks)++;
+    }
+
+    len = sizeof(packet);
+    while (switch_jb_get_packet(jb, &packet, &len) == SWITCH_STATUS_SUCCESS) {
+      received++;
+      len = sizeof(packet);
+    }
+  }
+
+  printf("%s: %d frames of %d packets, %d read, %u nacks, %.2f us per packet\n", ring ? "ring" : "list",
+         BENCH_FRAMES, BENCH_FRAME_PACKETS, received, *nacks, (switch_time_now() - start) / (double) (BENCH_FRAMES * BENCH_FRAME_PACKETS));
+
+  switch_jb_destroy(&jb);
+
+  return received;
+}
+
+/* the outbound nack queue with one packet per frame, every put past its size drops the oldest frame */
+static int bench_nack_queue(switch_memory_pool_t *pool, switch_bool_t ring)
+{
+  switch_jb_t *jb = NULL;
+  switch_rtp_packet_t packet;
+  switch_size_t len;
+  switch_time_t start;
+  uint16_t seq = 60000;
+  uint32_t ts = 90000;
+  int f, found = 0;
+
+  switch_jb_create(&jb, SJB_VIDEO, 100, 100, pool);
+  switch_jb_set_flag(jb, SJB_QUEUE_ONLY);
+  if (ring) {
+    switch_jb_set_flag(jb, SJB_RING);
+  }
+
+  start = switch_time_now();
+
+  for (f = 0; f < BENCH_FRAMES * BENCH_FRAME_PACKETS; f++) {
+    jb_put(jb, seq++, ts, 1);
+    ts += 3000;
+
+    len = sizeof(packet);
+    if (switch_jb_get_packet_by_seq(jb, htons((uint16_t)(seq - 50)), &packet, &len) == SWITCH_STATUS_SUCCESS) {
+      found++;
+    }
+  }
+
+  printf("%s nack queue: %d packets, %d retransmits found, %.2f us per packet\n", ring ? "ring" : "list",
+         f, found, (switch_time_now() - start) / (double) f);
+
+  switch_jb_destroy(&jb);
+
+  return found;
+}
+
+FST_CORE_BEGIN("./conf")
+
+FST_SUITE_BEGIN(switch_jitterbuffer)
+
+FST_SETUP_BEGIN()
+{
+}
+FST_SETUP_END()
+
+FST_TEARDOWN_BEGIN()
+{
+}
+FST_TEARDOWN_END()
+
+FST_TEST_BEGIN(ring_lookup_across_wrap)
+{
+  int r;
+
+  for (r = 0; r < 2; r++) {
+    switch_jb_t *jb = NULL;
+    switch_rtp_packet_t packet;
+    switch_size_t len;
+    int i, found = 0;
+
+    switch_jb_create(&jb, SJB_VIDEO, 100, 100, fst_pool);
+    switch_jb_set_flag(jb, SJB_QUEUE_ONLY);
+    if (r) {
+      switch_jb_set_flag(jb, SJB_RING);
+    }
+
+    for (i = 0; i < 80; i++) {
+      jb_put(jb, (uint16_t)(65500 + (i ^ 1)), 1000, 0);
+    }
+
+    for (i = 0; i < 80; i++) {
+      uint16_t seq = (uint16_t)(65500 + i);
+
+      len = sizeof(packet);
+      if (switch_jb_get_packet_by_seq(jb, htons(seq), &packet, &len) == SWITCH_STATUS_SUCCESS && ntohs(packet.header.seq) == seq) {
+        found++;
+      }
+    }
+
+    fst_check_int_equals(found, 80);
+
+    len = sizeof(packet);
+    fst_check(switch_jb_get_packet_by_seq(jb, htons(100), &packet, &len) != SWITCH_STATUS_SUCCESS);
+
+    switch_jb_destroy(&jb);
+  }
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(ring_nack_gaps)
+{
+  int r;
+
+  for (r = 0; r < 2; r++) {
+    switch_jb_t *jb = NULL;
+    switch_rtp_packet_t packet;
+    switch_size_t len = sizeof(packet);
+    uint32_t nack;
+    uint16_t seq;
+
+    switch_jb_create(&jb, SJB_VIDEO, 1, 100, fst_pool);
+    if (r) {
+      switch_jb_set_flag(jb, SJB_RING);
+    }
+
+    /* one complete frame read out so there is a read position to nack from */
+    jb_put(jb, 1, 1000, 1);
+    jb_put(jb, 2, 4000, 0);
+    fst_requires(switch_jb_get_packet(jb, &packet, &len) == SWITCH_STATUS_SUCCESS);
+
+    for (seq = 3; seq <= 30; seq++) {
+      if (seq == 11 || seq == 25 || seq == 26) continue;
+      jb_put(jb, seq, 4000, 0);
+    }
+
+    /* the oldest gap, with the ones up to 16 seqs after it in the bitmask */
+    nack = switch_jb_pop_nack(jb);
+    fst_check_int_equals(ntohs(nack & 0xffff), 11);
+    fst_check_int_equals(ntohs(nack >> 16), (1 << 13) | (1 << 14));
+
+    /* all of them were just nacked */
+    fst_check_int_equals(switch_jb_pop_nack(jb), 0);
+
+    /* a late arrival is no longer nacked once the renack time is up */
+    jb_put(jb, 11, 4000, 0);
+    switch_yield(RENACK_WAIT);
+    nack = switch_jb_pop_nack(jb);
+    fst_check_int_equals(ntohs(nack & 0xffff), 25);
+    fst_check_int_equals(ntohs(nack >> 16), 1);
+
+    switch_jb_destroy(&jb);
+  }
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_reorder_loss)
+{
+  uint32_t list_nacks, ring_nacks;
+  int list, ring;
+
+  list = bench_receive(fst_pool, SWITCH_FALSE, &list_nacks);
+  ring = bench_receive(fst_pool, SWITCH_TRUE, &ring_nacks);
+
+  fst_check(list > 0);
+  fst_check_int_equals(ring, list);
+  fst_check(ring_nacks > 0);
+
+  list = bench_nack_queue(fst_pool, SWITCH_FALSE);
+  ring = bench_nack_queue(fst_pool, SWITCH_TRUE);
+
+  fst_check(list > 0);
+  fst_check_int_equals(ring, list);
+}
+FST_TEST_END()
+
+FST_SUITE_END()
+
+FST_CORE_END()
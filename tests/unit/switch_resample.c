@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <switch.h>
+#include <test/switch_test.h>
+
+// #define BENCHMARK 1
+
+#define BENCH_FRAMES 20000
+#define BENCH_SAMPLES 960
+#define BENCH_MEMBERS 8
+
+static const char *kernel_names[] = { "sse2", "avx2", "neon" };
+
+static void fill(int16_t *data, uint32_t len, int seed)
+{
+  uint32_t i;
+
+  srand(seed);
+  for (i = 0; i < len; i++) {
+    data[i] = (int16_t) (rand() - RAND_MAX / 2);
+  }
+}
+
+/* one conference tick: every member into the mix and the mix back out, less its own audio, for each of them */
+static void mix_tick(int16_t members[][BENCH_SAMPLES], int32_t *mix, int16_t *out)
+{
+  int m;
+
+  memset(mix, 0, sizeof(int32_t) * BENCH_SAMPLES);
+
+  for (m = 0; m < BENCH_MEMBERS; m++) {
+    switch_mix_accumulate(mix, members[m], BENCH_SAMPLES);
+  }
+
+  for (m = 0; m < BENCH_MEMBERS; m++) {
+    switch_mix_pack(out + m * BENCH_SAMPLES, mix, members[m], BENCH_SAMPLES);
+  }
+}
+
+#ifdef BENCHMARK
+static switch_time_t bench_mix(const char *name)
+{
+  static int16_t members[BENCH_MEMBERS][BENCH_SAMPLES];
+  static int16_t out[BENCH_MEMBERS * BENCH_SAMPLES];
+  int32_t mix[BENCH_SAMPLES];
+  switch_time_t start;
+  int m, f;
+
+  for (m = 0; m < BENCH_MEMBERS; m++) {
+    fill(members[m], BENCH_SAMPLES, m);
+  }
+
+  switch_audio_kernels_set(name);
+  start = switch_time_now();
+
+  for (f = 0; f < BENCH_FRAMES; f++) {
+    mix_tick(members, mix, out);
+  }
+
+  return switch_time_now() - start;
+}
+
+static switch_time_t bench_helpers(const char *name)
+{
+  int16_t data[BENCH_SAMPLES * 2], other[BENCH_SAMPLES * 2];
+  switch_time_t start;
+  int f;
+
+  fill(data, BENCH_SAMPLES * 2, 1);
+  fill(other, BENCH_SAMPLES * 2, 2);
+
+  switch_audio_kernels_set(name);
+  start = switch_time_now();
+
+  for (f = 0; f < BENCH_FRAMES; f++) {
+    switch_merge_sln(data, BENCH_SAMPLES, other, BENCH_SAMPLES, 1);
+    switch_unmerge_sln(data, BENCH_SAMPLES, other, BENCH_SAMPLES, 1);
+    switch_change_sln_volume_granular(data, BENCH_SAMPLES, (f % 2) ? 2 : -2);
+    switch_mux_channels(data, BENCH_SAMPLES, 1, 2);
+    switch_mux_channels(data, BENCH_SAMPLES, 2, 1);
+  }
+
+  return switch_time_now() - start;
+}
+#endif
+
+FST_MINCORE_BEGIN()
+
+FST_SUITE_BEGIN(switch_resample)
+
+FST_SETUP_BEGIN()
+{
+}
+FST_SETUP_END()
+
+FST_TEARDOWN_BEGIN()
+{
+  switch_audio_kernels_set(NULL);
+}
+FST_TEARDOWN_END()
+
+FST_TEST_BEGIN(kernels_match_scalar)
+{
+  int16_t members[BENCH_MEMBERS][BENCH_SAMPLES];
+  int16_t expected[BENCH_MEMBERS * BENCH_SAMPLES], out[BENCH_MEMBERS * BENCH_SAMPLES];
+  int16_t data[BENCH_SAMPLES * 2 + 14] = { 0 }, other[BENCH_SAMPLES * 2 + 14], scalar[BENCH_SAMPLES * 2 + 14];
+  int32_t mix[BENCH_SAMPLES];
+  int m, k, vol;
+
+  for (m = 0; m < BENCH_MEMBERS; m++) {
+    fill(members[m], BENCH_SAMPLES, m);
+  }
+
+  fst_requires(switch_audio_kernels_set("scalar") == SWITCH_STATUS_SUCCESS);
+  fst_check_string_equals(switch_audio_kernels_name(), "scalar");
+  mix_tick(members, mix, expected);
+
+  for (k = 0; k < (int) (sizeof(kernel_names) / sizeof(kernel_names[0])); k++) {
+    uint32_t len = BENCH_SAMPLES + 7;
+
+    if (switch_audio_kernels_set(kernel_names[k]) != SWITCH_STATUS_SUCCESS) {
+      continue;
+    }
+
+    mix_tick(members, mix, out);
+    fst_check(!memcmp(out, expected, sizeof(out)));
+
+    /* odd lengths so the vector loops leave a tail for the scalar one */
+    for (vol = -12; vol <= 12; vol++) {
+      fill(other, len, 3);
+      fill(data, len, vol + 100);
+      memcpy(scalar, data, sizeof(data));
+
+      switch_audio_kernels_set("scalar");
+      switch_merge_sln(scalar, len, other, len, 1);
+      switch_change_sln_volume_granular(scalar, len, vol);
+      switch_change_sln_volume(scalar, len, vol / 3);
+      switch_unmerge_sln(scalar, len, other, len, 1);
+      switch_mux_channels(scalar, len, 1, 2);
+      switch_mux_channels(scalar, len, 2, 1);
+
+      switch_audio_kernels_set(kernel_names[k]);
+      switch_merge_sln(data, len, other, len, 1);
+      switch_change_sln_volume_granular(data, len, vol);
+      switch_change_sln_volume(data, len, vol / 3);
+      switch_unmerge_sln(data, len, other, len, 1);
+      switch_mux_channels(data, len, 1, 2);
+      switch_mux_channels(data, len, 2, 1);
+
+      fst_check(!memcmp(data, scalar, sizeof(data)));
+    }
+  }
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(mux_channels)
+{
+  int16_t data[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 32767, 32767, -32768, -32768, 0, 0, 0, 0 };
+  int x;
+
+  /* stereo to mono sums the channels and clips */
+  switch_mux_channels(data, 6, 2, 1);
+  fst_check_int_equals(data[0], 3);
+  fst_check_int_equals(data[3], 15);
+  fst_check_int_equals(data[4], 32767);
+  fst_check_int_equals(data[5], -32768);
+
+  for (x = 0; x < 8; x++) {
+    data[x] = (int16_t) x;
+  }
+
+  switch_mux_channels(data, 8, 1, 2);
+  for (x = 0; x < 16; x++) {
+    fst_check_int_equals(data[x], x / 2);
+  }
+}
+FST_TEST_END()
+
+#ifdef BENCHMARK
+FST_TEST_BEGIN(benchmark)
+{
+  switch_time_t scalar_mix, scalar_helpers, best_mix, best_helpers;
+  const char *best;
+
+  switch_audio_kernels_set(NULL);
+  best = switch_audio_kernels_name();
+
+  scalar_mix = bench_mix("scalar");
+  scalar_helpers = bench_helpers("scalar");
+  best_mix = bench_mix(best);
+  best_helpers = bench_helpers(best);
+
+  printf("%d ticks of a %d member mix: %.2f us each scalar, %.2f us each %s\n", BENCH_FRAMES, BENCH_MEMBERS,
+         scalar_mix / (double) BENCH_FRAMES, best_mix / (double) BENCH_FRAMES, best);
+  printf("%d frames through merge, volume and mux: %.2f us each scalar, %.2f us each %s\n", BENCH_FRAMES,
+         scalar_helpers / (double) BENCH_FRAMES, best_helpers / (double) BENCH_FRAMES, best);
+}
+FST_TEST_END()
+#endif
+
+FST_SUITE_END()
+
+FST_MINCORE_END()
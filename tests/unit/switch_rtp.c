@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <switch.h>
+#include <test/switch_test.h>
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#define BENCH_CALLS 50
+#define BENCH_PACKETS 100
+#define BENCH_START_PORT 25000
+
+typedef struct {
+  switch_rtp_t *rtp;
+  int sent;
+  int received;
+} bench_call_t;
+
+/* one timed audio call looping its rtp back to itself, like a session thread would read and write it */
+static void *SWITCH_THREAD_FUNC bench_call_thread(switch_thread_t *thread, void *obj)
+{
+  bench_call_t *call = (bench_call_t *) obj;
+  char data[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+  uint32_t len;
+  switch_payload_t pt = 0;
+  switch_frame_flag_t flags = SFF_NONE;
+  int x;
+
+  for (x = 0; x < BENCH_PACKETS; x++) {
+    flags = SFF_NONE;
+    if (switch_rtp_write_manual(call->rtp, data, 160, 0, 0, 160, &flags) > 0) {
+      call->sent++;
+    }
+
+    len = sizeof(data);
+    flags = SFF_NONE;
+    if (switch_rtp_read(call->rtp, data, &len, &pt, &flags, SWITCH_IO_FLAG_NONE) == SWITCH_STATUS_SUCCESS && len && !(flags & SFF_CNG)) {
+      call->received++;
+    }
+  }
+
+  return NULL;
+}
+
+static int64_t bench_cpu_usec(void)
+{
+#ifndef WIN32
+  struct rusage ru;
+
+  getrusage(RUSAGE_SELF, &ru);
+  return (int64_t) (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+#else
+  return 0;
+#endif
+}
+
+static int bench_calls(switch_memory_pool_t *pool, uint32_t io_threads, const char *name)
+{
+  bench_call_t calls[BENCH_CALLS] = { { 0 } };
+  switch_thread_t *threads[BENCH_CALLS] = { 0 };
+  switch_threadattr_t *thd_attr = NULL;
+  switch_rtp_flag_t rtp_flags[SWITCH_RTP_FLAG_INVALID] = { 0 };
+  switch_rtp_io_stats_t before, after;
+  switch_status_t st;
+  const char *err = NULL;
+  int64_t cpu;
+  int x, received = 0;
+
+  switch_rtp_set_io_threads(io_threads);
+  switch_rtp_get_io_stats(&before);
+
+  rtp_flags[SWITCH_RTP_FLAG_USE_TIMER] = 1;
+
+  for (x = 0; x < BENCH_CALLS; x++) {
+    switch_port_t port = (switch_port_t) (BENCH_START_PORT + x * 2);
+
+    calls[x].rtp = switch_rtp_new("127.0.0.1", port, "127.0.0.1", port, 0, 160, 20 * 1000, rtp_flags, "soft", &err, pool);
+    if (!calls[x].rtp) {
+      printf("%s: cannot create rtp session on port %d: %s\n", name, port, switch_str_nil(err));
+      return -1;
+    }
+  }
+
+  cpu = bench_cpu_usec();
+
+  switch_threadattr_create(&thd_attr, pool);
+  for (x = 0; x < BENCH_CALLS; x++) {
+    switch_thread_create(&threads[x], thd_attr, bench_call_thread, &calls[x], pool);
+  }
+
+  for (x = 0; x < BENCH_CALLS; x++) {
+    switch_thread_join(&st, threads[x]);
+    received += calls[x].received;
+  }
+
+  cpu = bench_cpu_usec() - cpu;
+  switch_rtp_get_io_stats(&after);
+
+  for (x = 0; x < BENCH_CALLS; x++) {
+    switch_rtp_destroy(&calls[x].rtp);
+  }
+
+  printf("%s: %d calls, %d packets received, %.2f us cpu per packet", name, BENCH_CALLS, received, received ? cpu / (double) received : 0);
+  if (io_threads) {
+    uint64_t syscalls = (after.polls - before.polls) + (after.recv_calls - before.recv_calls);
+
+    printf(", %llu polls + %llu batched reads for %llu packets, %.2f syscalls per packet",
+         (unsigned long long) (after.polls - before.polls), (unsigned long long) (after.recv_calls - before.recv_calls),
+         (unsigned long long) (after.packets - before.packets),
+         after.packets > before.packets ? syscalls / (double) (after.packets - before.packets) : 0);
+  } else {
+    printf(", a poll and a recvfrom per packet");
+  }
+  printf("\n");
+
+  return received;
+}
+
+/* drain a non blocking socket, returns how many datagrams were waiting */
+static int bench_drain(switch_socket_t *sock, switch_sockaddr_t *from)
+{
+  char buf[SWITCH_RTP_MAX_BUF_LEN];
+  switch_size_t len;
+  int count = 0;
+
+  for (;;) {
+    len = sizeof(buf);
+    if (switch_socket_recvfrom(from, sock, 0, buf, &len) != SWITCH_STATUS_SUCCESS || !len) {
+      break;
+    }
+    count++;
+  }
+
+  return count;
+}
+
+static switch_status_t bench_send_video(switch_rtp_t *rtp, uint16_t seq, uint32_t ts, int marker)
+{
+  struct {
+    switch_rtp_hdr_t header;
+    char body[100];
+  } packet;
+  switch_size_t bytes = sizeof(packet);
+
+  memset(&packet, 0, sizeof(packet));
+  packet.header.version = 2;
+  packet.header.pt = 96;
+  packet.header.m = marker;
+  packet.header.seq = htons(seq);
+  packet.header.ts = htonl(ts);
+  packet.header.ssrc = htonl(1234);
+
+  return switch_rtp_write_raw(rtp, &packet, &bytes, SWITCH_FALSE);
+}
+
+FST_CORE_BEGIN("./conf")
+
+FST_SUITE_BEGIN(switch_rtp)
+
+FST_SETUP_BEGIN()
+{
+}
+FST_SETUP_END()
+
+FST_TEARDOWN_BEGIN()
+{
+}
+FST_TEARDOWN_END()
+
+FST_TEST_BEGIN(benchmark_io_engine)
+{
+  switch_rtp_io_stats_t stats;
+  int legacy, engine;
+
+  legacy = bench_calls(fst_pool, 0, "session threads");
+  engine = bench_calls(fst_pool, 2, "io engine");
+
+  fst_check(legacy > 0);
+  fst_check(engine > 0);
+
+  switch_rtp_get_io_stats(&stats);
+  fst_check(stats.threads > 0);
+  fst_check(stats.packets > 0);
+  fst_check(stats.sessions == 0);
+
+  switch_rtp_set_io_threads(0);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(socket_batched_send_and_receive)
+{
+  switch_socket_t *sock = NULL;
+  switch_sockaddr_t *addr = NULL;
+  switch_socket_msg_t msgs[8];
+  char bufs[8][32];
+  uint32_t count = 8, x;
+
+  fst_requires(switch_sockaddr_info_get(&addr, "127.0.0.1", SWITCH_UNSPEC, BENCH_START_PORT - 2, 0, fst_pool) == SWITCH_STATUS_SUCCESS);
+  fst_requires(switch_socket_create(&sock, AF_INET, SOCK_DGRAM, 0, fst_pool) == SWITCH_STATUS_SUCCESS);
+  fst_requires(switch_socket_bind(sock, addr) == SWITCH_STATUS_SUCCESS);
+
+  for (x = 0; x < 8; x++) {
+    switch_snprintf(bufs[x], sizeof(bufs[x]), "packet %u", x);
+    msgs[x].buf = bufs[x];
+    msgs[x].len = strlen(bufs[x]) + 1;
+    msgs[x].addr = addr;
+  }
+
+  fst_check(switch_socket_sendmmsg(sock, msgs, &count) == SWITCH_STATUS_SUCCESS);
+  fst_check(count == 8);
+
+  for (x = 0; x < 8; x++) {
+    memset(bufs[x], 0, sizeof(bufs[x]));
+    msgs[x].len = sizeof(bufs[x]);
+    switch_sockaddr_create(&msgs[x].addr, fst_pool);
+  }
+
+  count = 8;
+  fst_check(switch_socket_recvmmsg(sock, msgs, &count) == SWITCH_STATUS_SUCCESS);
+  fst_check(count == 8);
+  fst_check_string_equals(bufs[0], "packet 0");
+  fst_check_string_equals(bufs[7], "packet 7");
+
+  switch_socket_close(sock);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(video_tx_batch_flush)
+{
+  switch_rtp_flag_t rtp_flags[SWITCH_RTP_FLAG_INVALID] = { 0 };
+  switch_socket_t *sock = NULL;
+  switch_sockaddr_t *addr = NULL, *from = NULL;
+  switch_rtp_t *rtp = NULL;
+  const char *err = NULL;
+
+  fst_requires(switch_sockaddr_info_get(&addr, "127.0.0.1", SWITCH_UNSPEC, BENCH_START_PORT - 4, 0, fst_pool) == SWITCH_STATUS_SUCCESS);
+  fst_requires(switch_socket_create(&sock, AF_INET, SOCK_DGRAM, 0, fst_pool) == SWITCH_STATUS_SUCCESS);
+  fst_requires(switch_socket_bind(sock, addr) == SWITCH_STATUS_SUCCESS);
+  switch_socket_opt_set(sock, SWITCH_SO_NONBLOCK, TRUE);
+  switch_sockaddr_create(&from, fst_pool);
+
+  rtp_flags[SWITCH_RTP_FLAG_VIDEO] = 1;
+  rtp_flags[SWITCH_RTP_FLAG_TX_BATCH] = 1;
+  rtp = switch_rtp_new("127.0.0.1", BENCH_START_PORT - 6, "127.0.0.1", BENCH_START_PORT - 4, 96, 1, 90000, rtp_flags, NULL, &err, fst_pool);
+  fst_requires(rtp);
+
+  /* nothing leaves before the marker */
+  fst_check(bench_send_video(rtp, 1, 3000, 0) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_send_video(rtp, 2, 3000, 0) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_send_video(rtp, 3, 3000, 0) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_drain(sock, from) == 0);
+
+  fst_check(bench_send_video(rtp, 4, 3000, 1) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_drain(sock, from) == 4);
+
+  /* a frame that never gets its marker goes out once it is too old */
+  fst_check(bench_send_video(rtp, 5, 6000, 0) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_send_video(rtp, 6, 6000, 0) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_drain(sock, from) == 0);
+  switch_yield(50000);
+  fst_check(bench_send_video(rtp, 7, 6000, 0) == SWITCH_STATUS_SUCCESS);
+  fst_check(bench_drain(sock, from) == 2);
+
+  /* and whatever is left is sent on destroy */
+  switch_rtp_destroy(&rtp);
+  fst_check(bench_drain(sock, from) == 1);
+
+  switch_socket_close(sock);
+}
+FST_TEST_END()
+
+FST_SUITE_END()
+
+FST_CORE_END()
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <switch.h>
+#include <test/switch_test.h>
+
+// #define BENCHMARK 1
+
+#define BENCH_TICKS 25
+#define BENCH_WARMUP 5
+#define BENCH_INTERVAL 20
+
+typedef struct {
+  const char *timer_name;
+  int ok;
+  switch_time_t jitter_sum;
+  switch_time_t jitter_max;
+  int samples;
+} bench_timer_t;
+
+/* one session's worth of timer, how far each wake lands from the 20ms grid it started on */
+static void *SWITCH_THREAD_FUNC bench_timer_thread(switch_thread_t *thread, void *obj)
+{
+  bench_timer_t *bt = (bench_timer_t *) obj;
+  switch_timer_t timer = { 0 };
+  switch_time_t first = 0;
+  int x;
+
+  if (switch_core_timer_init(&timer, bt->timer_name, BENCH_INTERVAL, 160, NULL) != SWITCH_STATUS_SUCCESS) {
+    return NULL;
+  }
+
+  bt->ok = 1;
+
+  for (x = 0; x < BENCH_TICKS; x++) {
+    switch_time_t now, jitter;
+
+    if (switch_core_timer_next(&timer) != SWITCH_STATUS_SUCCESS) {
+      break;
+    }
+
+    now = switch_time_ref();
+
+    if (x == BENCH_WARMUP) {
+      first = now;
+    } else if (x > BENCH_WARMUP) {
+      jitter = now - (first + (switch_time_t) (x - BENCH_WARMUP) * BENCH_INTERVAL * 1000);
+      if (jitter < 0) {
+        jitter = -jitter;
+      }
+
+      bt->jitter_sum += jitter;
+      bt->samples++;
+      if (jitter > bt->jitter_max) {
+        bt->jitter_max = jitter;
+      }
+    }
+  }
+
+  switch_core_timer_destroy(&timer);
+
+  return NULL;
+}
+
+static int bench_timers(switch_memory_pool_t *pool, const char *timer_name, int count)
+{
+  bench_timer_t *timers = switch_core_alloc(pool, sizeof(*timers) * count);
+  switch_thread_t **threads = switch_core_alloc(pool, sizeof(*threads) * count);
+  switch_threadattr_t *thd_attr = NULL;
+  switch_time_t sum = 0, max = 0;
+  switch_status_t st;
+  int x, started = 0, ok = 0, samples = 0;
+
+  switch_threadattr_create(&thd_attr, pool);
+  switch_threadattr_stacksize_set(thd_attr, 128 * 1024);
+
+  for (x = 0; x < count; x++) {
+    timers[x].timer_name = timer_name;
+    if (switch_thread_create(&threads[x], thd_attr, bench_timer_thread, &timers[x], pool) != SWITCH_STATUS_SUCCESS) {
+      break;
+    }
+    started++;
+  }
+
+  for (x = 0; x < started; x++) {
+    switch_thread_join(&st, threads[x]);
+    ok += timers[x].ok;
+    sum += timers[x].jitter_sum;
+    samples += timers[x].samples;
+    if (timers[x].jitter_max > max) {
+      max = timers[x].jitter_max;
+    }
+  }
+
+  printf("%s: %d timers (%d running), wake jitter %.1f us avg, %.1f ms max\n", timer_name, count, ok,
+         samples ? sum / (double) samples : 0, max / 1000.0);
+
+  return ok;
+}
+
+FST_CORE_BEGIN("./conf")
+
+FST_SUITE_BEGIN(switch_time)
+
+FST_SETUP_BEGIN()
+{
+}
+FST_SETUP_END()
+
+FST_TEARDOWN_BEGIN()
+{
+}
+FST_TEARDOWN_END()
+
+FST_TEST_BEGIN(wheel_timer_steps)
+{
+  switch_timer_t timer = { 0 };
+  switch_time_t start;
+  int x;
+
+  fst_requires(switch_core_timer_init(&timer, "wheel", BENCH_INTERVAL, 160, fst_pool) == SWITCH_STATUS_SUCCESS);
+
+  start = switch_time_ref();
+  for (x = 0; x < 10; x++) {
+    fst_check(switch_core_timer_next(&timer) == SWITCH_STATUS_SUCCESS);
+  }
+
+  /* ten 20ms ticks, the first one may come early like it does on the soft timer */
+  fst_check(switch_time_ref() - start >= 170000);
+  fst_check(timer.samplecount >= 160 * 10);
+
+  /* just woken, so due now, and one step ahead of the clock after that */
+  fst_check(switch_core_timer_check(&timer, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS);
+  fst_check(timer.diff == 0);
+  fst_check(switch_core_timer_step(&timer) == SWITCH_STATUS_SUCCESS);
+  fst_check(switch_core_timer_check(&timer, SWITCH_FALSE) == SWITCH_STATUS_FALSE);
+  fst_check(timer.diff == 1);
+  fst_check(switch_core_timer_sync(&timer) == SWITCH_STATUS_SUCCESS);
+
+  switch_core_timer_destroy(&timer);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_wake_jitter)
+{
+#ifdef BENCHMARK
+  int counts[] = { 1000, 5000, 10000 };
+#else
+  int counts[] = { 10 };
+#endif
+  int x;
+
+  for (x = 0; x < (int) (sizeof(counts) / sizeof(counts[0])); x++) {
+    fst_check(bench_timers(fst_pool, "wheel", counts[x]) > 0);
+    fst_check(bench_timers(fst_pool, "soft", counts[x]) > 0);
+  }
+}
+FST_TEST_END()
+
+FST_SUITE_END()
+
+FST_CORE_END()
@@ -63,6 +63,64 @@ FST_TEST_BEGIN(benchmark)
 }
 FST_TEST_END()
 
+FST_TEST_BEGIN(regex_cache)
+{
+    switch_regex_cache_stats_t before, after;
+    switch_regex_t *re = NULL;
+    switch_time_t start;
+    int ovector[30];
+    int x, loops = 10000, proceed;
+    char substituted[64] = "";
+    const char *extensions[] = { "^1000$", "^(10[01][0-9])$", "^(\\d{4})$", "^\\+?1?(\\d{10})$", "^9(\\d+)$", "/^conference_(\\w+)$/i" };
+    switch_time_t cached, uncached;
+
+    switch_regex_cache_get_stats(&before);
+
+    proceed = switch_regex_perform("5551234", "^555(\\d+)$", &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
+    fst_check(proceed == 2);
+    switch_perform_substitution(re, proceed, "$1", "5551234", substituted, sizeof(substituted), ovector);
+    fst_check_string_equals(substituted, "1234");
+    switch_regex_safe_free(re);
+
+    /* the pattern stays compiled after the caller let go of it */
+    proceed = switch_regex_perform("5559876", "^555(\\d+)$", &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
+    fst_check(proceed == 2);
+    switch_regex_safe_free(re);
+
+    fst_check(switch_regex_perform("1234", "^555(\\d+)$", &re, ovector, sizeof(ovector) / sizeof(ovector[0])) == 0);
+    fst_check(re == NULL);
+    fst_check(switch_regex_match("CONFERENCE_room", "/^conference_\\w+$/i") == SWITCH_STATUS_SUCCESS);
+    fst_check(switch_regex_match("conference_room", "^conference_\\d+$") != SWITCH_STATUS_SUCCESS);
+
+    switch_regex_cache_get_stats(&after);
+    fst_check(after.misses - before.misses == 3);
+    fst_check(after.hits - before.hits == 2);
+
+    /* a routing pass through a few extensions, compiled once and then every time */
+    start = switch_time_now();
+    for (x = 0; x < loops; x++) {
+        proceed = switch_regex_perform("18005551234", extensions[x % 6], &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
+        switch_regex_safe_free(re);
+    }
+    cached = switch_time_now() - start;
+
+    switch_regex_cache_set_max(0);
+    start = switch_time_now();
+    for (x = 0; x < loops; x++) {
+        proceed = switch_regex_perform("18005551234", extensions[x % 6], &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
+        switch_regex_safe_free(re);
+    }
+    uncached = switch_time_now() - start;
+    switch_regex_cache_set_max(before.max);
+
+    switch_regex_cache_get_stats(&after);
+    fst_check(after.entries == 0);
+    fst_check(after.evictions > before.evictions);
+
+    printf("regex: %d conditions, %.3f us each cached, %.3f us each compiled every time\n", loops, cached / (double) loops, uncached / (double) loops);
+}
+FST_TEST_END()
+
 FST_SUITE_END()
 
 FST_MINCORE_END()
@@ -0,0 +1,581 @@
+#include <stdio.h>
+#include <switch.h>
+#include <test/switch_test.h>
+
+#define FETCH_THREADS 10
+#define FETCH_DELAY 200000
+#define BENCH_DOMAINS 50
+#define BENCH_USERS 200
+#define INDEX_USERS 50000
+#define INDEX_LOOKUPS 500
+
+static char domain_xml[] =
+  "<document type=\"freeswitch/xml\"><section name=\"directory\">"
+  "<domain name=\"async.test\"><user id=\"1000\"/></domain>"
+  "</section></document>";
+
+static char not_found_xml[] =
+  "<document type=\"freeswitch/xml\"><section name=\"result\">"
+  "<result status=\"not found\" cacheable=\"60000\"/>"
+  "</section></document>";
+
+static int gateway_calls = 0;
+static int not_found_calls = 0;
+
+typedef struct {
+  switch_xml_fetch_callback_t callback;
+  void *fetch_data;
+} gateway_fetch_t;
+
+/* answers a while later from another thread, the way a gateway waiting on the network would */
+static void *SWITCH_THREAD_FUNC gateway_thread(switch_thread_t *thread, void *obj)
+{
+  gateway_fetch_t *fetch = (gateway_fetch_t *) obj;
+
+  switch_yield(FETCH_DELAY);
+  fetch->callback(switch_xml_parse_str_dup(domain_xml), fetch->fetch_data);
+  free(fetch);
+
+  return NULL;
+}
+
+static switch_xml_t gateway_search(const char *section, const char *tag_name, const char *key_name, const char *key_value,
+                                   switch_event_t *params, void *user_data)
+{
+  return NULL;
+}
+
+static switch_status_t gateway_search_async(const char *section, const char *tag_name, const char *key_name, const char *key_value,
+                                            switch_event_t *params, void *user_data, switch_xml_fetch_callback_t callback, void *fetch_data)
+{
+  switch_thread_data_t *td;
+  gateway_fetch_t *fetch;
+
+  if (strcmp(switch_str_nil(key_value), "async.test")) {
+    not_found_calls++;
+    callback(switch_xml_parse_str_dup(not_found_xml), fetch_data);
+    return SWITCH_STATUS_SUCCESS;
+  }
+
+  gateway_calls++;
+
+  switch_zmalloc(fetch, sizeof(*fetch));
+  fetch->callback = callback;
+  fetch->fetch_data = fetch_data;
+
+  switch_zmalloc(td, sizeof(*td));
+  td->alloc = 1;
+  td->func = gateway_thread;
+  td->obj = fetch;
+  switch_thread_pool_launch_thread(&td);
+
+  return SWITCH_STATUS_SUCCESS;
+}
+
+static void *SWITCH_THREAD_FUNC locate_thread(switch_thread_t *thread, void *obj)
+{
+  int *found = (int *) obj;
+  switch_xml_t root = NULL, domain = NULL;
+
+  if (switch_xml_locate_domain("async.test", NULL, &root, &domain) == SWITCH_STATUS_SUCCESS) {
+    *found = switch_xml_find_child(domain, "user", "id", "1000") != NULL;
+    switch_xml_free(root);
+  }
+
+  return NULL;
+}
+
+static switch_mutex_t *located_mutex = NULL;
+static int located = -1;
+
+static void locate_callback(switch_xml_t root, switch_xml_t node, void *user_data)
+{
+  switch_mutex_lock(located_mutex);
+  located = node && !strcmp(switch_xml_attr_soft(node, "name"), "async.test");
+  switch_mutex_unlock(located_mutex);
+
+  switch_xml_free(root);
+}
+
+static int cache_calls = 0;
+
+/* answers configuration lookups, cacheable for 200ms and served stale for a second after */
+static switch_xml_t cache_search(const char *section, const char *tag_name, const char *key_name, const char *key_value,
+                                 switch_event_t *params, void *user_data)
+{
+  char *xml;
+  switch_xml_t result;
+
+  cache_calls++;
+
+  if (!strcmp(switch_str_nil(key_value), "missing.conf")) {
+    xml = switch_mprintf("<document type=\"freeswitch/xml\"><section name=\"result\"><result status=\"not found\" cacheable=\"60000\"/></section></document>");
+  } else {
+    xml = switch_mprintf("<document type=\"freeswitch/xml\" cacheable=\"200\" cache-stale=\"1000\"><section name=\"configuration\">"
+                         "<configuration name=\"%s\"><settings><param name=\"call\" value=\"%d\"/></settings></configuration>"
+                         "</section></document>", key_value, cache_calls);
+  }
+
+  result = switch_xml_parse_str_dup(xml);
+  free(xml);
+
+  return result;
+}
+
+static int cached_call(const char *name, const char *uuid)
+{
+  switch_event_t *params = NULL;
+  switch_xml_t root = NULL, cfg = NULL, param;
+  int call = 0;
+
+  switch_event_create(&params, SWITCH_EVENT_REQUEST_PARAMS);
+  switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "Unique-ID", uuid);
+  switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "Channel-Call-UUID", uuid);
+  switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "variable_sip_call_id", uuid);
+  switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "variable_sip_from_tag", uuid);
+  switch_event_add_header_string(params, SWITCH_STACK_BOTTOM, "profile", "internal");
+
+  if (switch_xml_locate("configuration", "configuration", "name", name, &root, &cfg, params, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS) {
+    if ((param = switch_xml_find_child(switch_xml_child(cfg, "settings"), "param", "name", "call"))) {
+      call = atoi(switch_xml_attr_soft(param, "value"));
+    }
+    switch_xml_free(root);
+  }
+
+  switch_event_destroy(&params);
+
+  return call;
+}
+
+/* a root file with a directory made of one file per domain */
+static switch_status_t write_bench_root(switch_memory_pool_t *pool)
+{
+  char path[1024];
+  FILE *f;
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_directory", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+  switch_dir_make_recursive(path, SWITCH_DEFAULT_DIR_PERMS, pool);
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_root.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+
+  if (!(f = fopen(path, "w"))) {
+    return SWITCH_STATUS_FALSE;
+  }
+
+  fprintf(f, "<?xml version=\"1.0\"?>\n<document type=\"freeswitch/xml\">\n"
+          "  <X-PRE-PROCESS cmd=\"set\" data=\"default_password=1234\"/>\n"
+          "  <section name=\"directory\">\n"
+          "    <X-PRE-PROCESS cmd=\"include\" data=\"bench_directory/*.xml\"/>\n"
+          "  </section>\n</document>\n");
+  fclose(f);
+
+  return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t write_bench_domain(int d, const char *version)
+{
+  char path[1024];
+  FILE *f;
+  int x;
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_directory%sbench_%d.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_PATH_SEPARATOR, d);
+
+  if (!(f = fopen(path, "w"))) {
+    return SWITCH_STATUS_FALSE;
+  }
+
+  fprintf(f, "<include>\n<domain name=\"bench%d.test\" version=\"%s\">\n", d, version);
+
+  for (x = 0; x < BENCH_USERS; x++) {
+    fprintf(f, "<user id=\"%d\"><params><param name=\"password\" value=\"$${default_password}\"/><param name=\"vm-password\" value=\"%d\"/></params>"
+            "<variables><variable name=\"user_context\" value=\"default\"/><variable name=\"effective_caller_id_name\" value=\"Extension %d\"/></variables></user>\n",
+            1000 + x, 1000 + x, 1000 + x);
+  }
+
+  fprintf(f, "</domain>\n</include>\n");
+  fclose(f);
+
+  return SWITCH_STATUS_SUCCESS;
+}
+
+/* a big domain, every other user with an alias and every hundredth with an ip, and a group pointing at one of them */
+static switch_status_t write_index_domain(void)
+{
+  char path[1024];
+  FILE *f;
+  int x;
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_directory%sbench_index.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_PATH_SEPARATOR);
+
+  if (!(f = fopen(path, "w"))) {
+    return SWITCH_STATUS_FALSE;
+  }
+
+  fprintf(f, "<include>\n<domain name=\"index.test\">\n"
+          "<groups><group name=\"sales\"><users><user id=\"100005\" type=\"pointer\"/></users></group></groups>\n<users>\n");
+
+  for (x = 0; x < INDEX_USERS; x++) {
+    fprintf(f, "<user id=\"%d\"", 100000 + x);
+    if (x % 2 == 0) {
+      fprintf(f, " number-alias=\"%d\"", 200000 + x);
+    }
+    if (x % 100 == 0) {
+      fprintf(f, " ip=\"10.1.%d.%d\"", x / 256, x % 256);
+    }
+    fprintf(f, "><params><param name=\"password\" value=\"$${default_password}\"/></params></user>\n");
+  }
+
+  fprintf(f, "</users>\n</domain>\n</include>\n");
+  fclose(f);
+
+  return SWITCH_STATUS_SUCCESS;
+}
+
+static const char *located_user(const char *user_name, const char *ip, switch_bool_t *in_group)
+{
+  static char id[32];
+  switch_xml_t root = NULL, domain = NULL, user = NULL, group = NULL;
+
+  *id = '\0';
+
+  if (switch_xml_locate_user("id", user_name, "index.test", ip, &root, &domain, &user, &group, NULL) == SWITCH_STATUS_SUCCESS) {
+    switch_copy_string(id, switch_xml_attr_soft(user, "id"), sizeof(id));
+    *in_group = group != NULL;
+    switch_xml_free(root);
+  }
+
+  return id;
+}
+
+static void remove_bench_directory(void)
+{
+  char path[1024];
+  int d;
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_directory%sbench_index.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_PATH_SEPARATOR);
+  unlink(path);
+
+  for (d = 0; d < BENCH_DOMAINS; d++) {
+    switch_snprintf(path, sizeof(path), "%s%sbench_directory%sbench_%d.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_PATH_SEPARATOR, d);
+    unlink(path);
+  }
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_directory", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+  rmdir(path);
+}
+
+static switch_time_t timed_reload(switch_xml_reload_stats_t *stats)
+{
+  const char *err = NULL;
+  switch_time_t start = switch_time_now();
+
+  switch_xml_reload(&err);
+  start = switch_time_now() - start;
+  switch_xml_get_reload_stats(stats);
+
+  return start;
+}
+
+static const char *domain_version(const char *name)
+{
+  static char version[32];
+  switch_xml_t root = NULL, domain = NULL;
+
+  *version = '\0';
+
+  if (switch_xml_locate_domain(name, NULL, &root, &domain) == SWITCH_STATUS_SUCCESS) {
+    switch_copy_string(version, switch_xml_attr_soft(domain, "version"), sizeof(version));
+    switch_xml_free(root);
+  }
+
+  return version;
+}
+
+FST_CORE_BEGIN("./conf")
+
+FST_SUITE_BEGIN(switch_xml)
+
+FST_SETUP_BEGIN()
+{
+}
+FST_SETUP_END()
+
+FST_TEARDOWN_BEGIN()
+{
+}
+FST_TEARDOWN_END()
+
+FST_TEST_BEGIN(async_fetch_coalesced)
+{
+  switch_xml_binding_t *binding = NULL;
+  switch_xml_fetch_stats_t before, after;
+  switch_thread_t *threads[FETCH_THREADS];
+  switch_threadattr_t *thd_attr = NULL;
+  switch_xml_t root = NULL, domain = NULL;
+  switch_status_t st;
+  int found[FETCH_THREADS] = { 0 };
+  int x, total = 0;
+
+  fst_requires(switch_xml_bind_search_function_ret(gateway_search, switch_xml_parse_section_string("directory"), NULL, &binding) == SWITCH_STATUS_SUCCESS);
+  switch_xml_set_binding_async_function(binding, gateway_search_async);
+  switch_xml_set_binding_coalesce_sections(binding, switch_xml_parse_section_string("directory"));
+
+  switch_xml_get_fetch_stats(&before);
+
+  /* everyone asking while the first fetch is still out gets its answer */
+  switch_threadattr_create(&thd_attr, fst_pool);
+  for (x = 0; x < FETCH_THREADS; x++) {
+    switch_thread_create(&threads[x], thd_attr, locate_thread, &found[x], fst_pool);
+  }
+
+  for (x = 0; x < FETCH_THREADS; x++) {
+    switch_thread_join(&st, threads[x]);
+    total += found[x];
+  }
+
+  switch_xml_get_fetch_stats(&after);
+
+  fst_check_int_equals(total, FETCH_THREADS);
+  fst_check_int_equals(gateway_calls, 1);
+  fst_check(after.fetches - before.fetches == 1);
+  fst_check(after.coalesced - before.coalesced == FETCH_THREADS - 1);
+  fst_check(after.in_flight == 0);
+
+  /* a not found answer falls through to the core registry */
+  fst_check(switch_xml_locate("configuration", "configuration", "name", "modules.conf", &root, &domain, NULL, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS);
+  switch_xml_free(root);
+  fst_check(switch_xml_locate_domain("missing.test", NULL, &root, &domain) != SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(not_found_calls, 1);
+
+  /* and remembered for as long as the gateway says */
+  fst_check(switch_xml_locate_domain("missing.test", NULL, &root, &domain) != SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(not_found_calls, 1);
+
+  /* without waiting for it */
+  switch_mutex_init(&located_mutex, SWITCH_MUTEX_NESTED, fst_pool);
+  fst_check(switch_xml_locate_async("directory", "domain", "name", "async.test", NULL, locate_callback, NULL) == SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(located, -1);
+
+  for (x = 0; x < 100 && located == -1; x++) {
+    switch_yield(10000);
+  }
+
+  fst_check_int_equals(located, 1);
+  fst_check_int_equals(gateway_calls, 2);
+
+  /* what an asynchronous lookup was told is remembered too */
+  located = -1;
+  fst_check(switch_xml_locate_async("directory", "domain", "name", "gone.test", NULL, locate_callback, NULL) == SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(located, 0);
+  fst_check_int_equals(not_found_calls, 2);
+  fst_check(switch_xml_locate("directory", "domain", "name", "gone.test", &root, &domain, NULL, SWITCH_FALSE) != SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(not_found_calls, 2);
+
+  switch_xml_unbind_search_function(&binding);
+  switch_xml_cache_flush();
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(gateway_cache)
+{
+  switch_xml_binding_t *binding = NULL;
+  switch_xml_cache_stats_t stats;
+  switch_xml_t root = NULL, cfg = NULL;
+  int x;
+
+  fst_requires(switch_xml_bind_search_function_ret(cache_search, switch_xml_parse_section_string("configuration"), NULL, &binding) == SWITCH_STATUS_SUCCESS);
+
+  /* the request's own ids don't keep it from being shared */
+  fst_check_int_equals(cached_call("cache.conf", "uuid-1"), 1);
+  fst_check_int_equals(cached_call("cache.conf", "uuid-2"), 1);
+  fst_check_int_equals(cached_call("other.conf", "uuid-1"), 2);
+  fst_check_int_equals(cache_calls, 2);
+
+  /* a not found answer is remembered and the core registry answers */
+  fst_check(switch_xml_locate("configuration", "configuration", "name", "missing.conf", &root, &cfg, NULL, SWITCH_FALSE) != SWITCH_STATUS_SUCCESS);
+  fst_check(switch_xml_locate("configuration", "configuration", "name", "missing.conf", &root, &cfg, NULL, SWITCH_FALSE) != SWITCH_STATUS_SUCCESS);
+  fst_check_int_equals(cache_calls, 3);
+
+  /* once expired it is still served while it is asked for again */
+  switch_yield(300000);
+  fst_check_int_equals(cached_call("cache.conf", "uuid-3"), 1);
+
+  for (x = 0; x < 100 && cache_calls < 4; x++) {
+    switch_yield(10000);
+  }
+  switch_yield(10000);
+
+  fst_check_int_equals(cache_calls, 4);
+  fst_check_int_equals(cached_call("cache.conf", "uuid-4"), 4);
+
+  fst_check(switch_xml_cache_get_stats(0, &stats) == SWITCH_STATUS_SUCCESS);
+  fst_check_string_equals(stats.section, "configuration");
+  fst_check(stats.hits == 2);
+  fst_check(stats.stale_hits == 1);
+  fst_check(stats.negative_hits == 1);
+  fst_check(stats.entries == 3);
+
+  /* the least recently used goes first */
+  switch_xml_cache_set_max(1);
+  switch_xml_cache_get_stats(0, &stats);
+  fst_check(stats.entries == 1);
+  fst_check(stats.evictions == 2);
+  fst_check_int_equals(cached_call("cache.conf", "uuid-5"), 4);
+
+  fst_check_int_equals(switch_xml_cache_flush(), 1);
+  switch_xml_cache_set_max(1000);
+  fst_check_int_equals(cached_call("cache.conf", "uuid-6"), 5);
+
+  switch_xml_unbind_search_function(&binding);
+  switch_xml_cache_flush();
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_reload)
+{
+  switch_xml_reload_stats_t stats;
+  switch_xml_t before, after;
+  switch_time_t full, same, one;
+  char *conf_name = SWITCH_GLOBAL_filenames.conf_name;
+  char path[1024];
+  const char *err = NULL;
+  uint64_t unchanged;
+  FILE *f;
+  int d;
+
+  fst_requires(write_bench_root(fst_pool) == SWITCH_STATUS_SUCCESS);
+  SWITCH_GLOBAL_filenames.conf_name = "bench_root.xml";
+
+  for (d = 0; d < BENCH_DOMAINS; d++) {
+    fst_requires(write_bench_domain(d, "1") == SWITCH_STATUS_SUCCESS);
+  }
+
+  full = timed_reload(&stats);
+  fst_check_int_equals(stats.files, BENCH_DOMAINS + 1);
+  fst_check_int_equals(stats.reused, 0);
+  fst_check_string_equals(domain_version("bench0.test"), "1");
+  printf("%d users in %d files: %.2f ms to reload, %.2f ms preprocessing, %.2f ms parsing\n", BENCH_DOMAINS * BENCH_USERS, BENCH_DOMAINS,
+         full / 1000.0, stats.preprocess_usec / 1000.0, stats.parse_usec / 1000.0);
+
+  /* nothing changed, the tree in use stays */
+  unchanged = stats.unchanged;
+  before = switch_xml_root();
+  same = timed_reload(&stats);
+  after = switch_xml_root();
+  fst_check(stats.unchanged == unchanged + 1);
+  fst_check_int_equals(stats.reused, BENCH_DOMAINS);
+  fst_check(before == after);
+  switch_xml_free(before);
+  switch_xml_free(after);
+  printf("nothing changed: %.2f ms to reload\n", same / 1000.0);
+
+  /* one file changed, the others are copied from the last preprocessed file */
+  fst_requires(write_bench_domain(0, "22") == SWITCH_STATUS_SUCCESS);
+  one = timed_reload(&stats);
+  fst_check_int_equals(stats.reused, BENCH_DOMAINS - 1);
+  fst_check_string_equals(domain_version("bench0.test"), "22");
+  fst_check_string_equals(domain_version("bench1.test"), "1");
+  printf("one file changed: %.2f ms to reload, %.2f ms preprocessing, %.2f ms parsing\n", one / 1000.0, stats.preprocess_usec / 1000.0, stats.parse_usec / 1000.0);
+
+  /* an edit that keeps the size, right after the last one */
+  fst_requires(write_bench_domain(0, "33") == SWITCH_STATUS_SUCCESS);
+  timed_reload(&stats);
+  fst_check_int_equals(stats.reused, BENCH_DOMAINS - 1);
+  fst_check_string_equals(domain_version("bench0.test"), "33");
+
+  /* a file that does not parse keeps failing until it is fixed */
+  switch_snprintf(path, sizeof(path), "%s%sbench_directory%sbench_0.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_PATH_SEPARATOR);
+  fst_requires((f = fopen(path, "w")));
+  fprintf(f, "<include>\n<domain name=\"bench0.test\" version=\"44\">\n</include>\n");
+  fclose(f);
+  switch_xml_reload(&err);
+  fst_check(strcmp(err, "Success"));
+  switch_xml_reload(&err);
+  fst_check(strcmp(err, "Success"));
+  fst_requires(write_bench_domain(0, "55") == SWITCH_STATUS_SUCCESS);
+  switch_xml_reload(&err);
+  fst_check_string_equals(err, "Success");
+  fst_check_string_equals(domain_version("bench0.test"), "55");
+
+  /* and so are files that are gone */
+  remove_bench_directory();
+  timed_reload(&stats);
+  fst_check_int_equals(stats.files, 1);
+  fst_check_string_equals(domain_version("bench1.test"), "");
+
+  SWITCH_GLOBAL_filenames.conf_name = conf_name;
+  timed_reload(&stats);
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_root.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+  unlink(path);
+  switch_snprintf(path, sizeof(path), "%s%sbench_root.xml.fsxml", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR);
+  unlink(path);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(benchmark_user_index)
+{
+  switch_xml_reload_stats_t stats;
+  switch_xml_t root = NULL, domain = NULL, users;
+  switch_time_t indexed, walked;
+  switch_bool_t in_group = SWITCH_FALSE;
+  char *conf_name = SWITCH_GLOBAL_filenames.conf_name;
+  char path[1024], name[32];
+  int x, found = 0;
+
+  fst_requires(write_bench_root(fst_pool) == SWITCH_STATUS_SUCCESS);
+  fst_requires(write_index_domain() == SWITCH_STATUS_SUCCESS);
+  SWITCH_GLOBAL_filenames.conf_name = "bench_root.xml";
+  timed_reload(&stats);
+
+  /* the same users a walk finds */
+  fst_check_string_equals(located_user("100007", NULL, &in_group), "100007");
+  fst_check(!in_group);
+  fst_check_string_equals(located_user("200010", NULL, &in_group), "100010");
+  fst_check_string_equals(located_user("100011", NULL, &in_group), "100011");
+  fst_check_string_equals(located_user("200011", NULL, &in_group), "");
+  fst_check_string_equals(located_user("100005", NULL, &in_group), "100005");
+  fst_check(in_group);
+  fst_check_string_equals(located_user(NULL, "10.1.16.104", &in_group), "104200");
+  fst_check_string_equals(located_user("100300", "10.9.9.9", &in_group), "100300");
+  fst_check_string_equals(located_user("999", NULL, &in_group), "");
+
+  fst_requires(switch_xml_locate_domain("index.test", NULL, &root, &domain) == SWITCH_STATUS_SUCCESS);
+  users = switch_xml_child(domain, "users");
+
+  indexed = switch_time_now();
+  for (x = 0; x < INDEX_LOOKUPS; x++) {
+    switch_snprintf(name, sizeof(name), "%d", 100000 + (x * 7919) % INDEX_USERS);
+    found += !strcmp(located_user(name, NULL, &in_group), name);
+  }
+  indexed = switch_time_now() - indexed;
+
+  /* the walk each of them was before, without the rest of the lookup */
+  walked = switch_time_now();
+  for (x = 0; x < INDEX_LOOKUPS; x++) {
+    switch_snprintf(name, sizeof(name), "%d", 100000 + (x * 7919) % INDEX_USERS);
+    found += switch_xml_find_child_multi(users, "user", "id", name, "number-alias", name, "type", "!pointer", NULL) != NULL;
+  }
+  walked = switch_time_now() - walked;
+
+  switch_xml_free(root);
+
+  fst_check_int_equals(found, INDEX_LOOKUPS * 2);
+  printf("%d users: %.2f us per lookup indexed, %.2f us per lookup walking them\n", INDEX_USERS,
+         indexed / (double) INDEX_LOOKUPS, walked / (double) INDEX_LOOKUPS);
+  fst_check(indexed < walked);
+
+  remove_bench_directory();
+  SWITCH_GLOBAL_filenames.conf_name = conf_name;
+  timed_reload(&stats);
+
+  switch_snprintf(path, sizeof(path), "%s%sbench_root.xml", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR);
+  unlink(path);
+  switch_snprintf(path, sizeof(path), "%s%sbench_root.xml.fsxml", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR);
+  unlink(path);
+}
+FST_TEST_END()
+
+FST_SUITE_END()
+
+FST_CORE_END()